@@ -13,7 +13,9 @@
 #include <gdbuspp/proxy/utils.hpp>
 #include <sstream>
 #include <exception>
-#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <glib-unix.h>
 
 // Needs to be included before openvpn3-core library
@@ -34,12 +36,25 @@
 #include "log/proxy-log.hpp"
 #include "netcfg/netcfg-changeevent.hpp"
 #include "netcfg/proxy-netcfg-mgr.hpp"
+#include "route-worker.hpp"
 
 using namespace openvpn;
 
 #define OPENVPN3_AWS_CONFIG "/etc/openvpn3/openvpn3-aws.json"
 #define OPENVPN3_AWS_CERTS "/etc/openvpn3/awscerts"
 
+/**
+ *  How long the instance information and role credentials retrieved
+ *  from the instance metadata service are reused.  The role credentials
+ *  are rotated well before they expire, so this is kept short.
+ */
+constexpr std::chrono::minutes AWS_CREDENTIALS_TTL{10};
+
+/**
+ *  Number of VPC route changes sent to the EC2 API in parallel
+ */
+constexpr unsigned int AWS_ROUTE_WORKERS = 4;
+
 /**
  * Helper class to tackle log signals sent by the AWSObject
  *
@@ -98,7 +113,13 @@ class AWSObject : public DBus::Object::Base
 
         log->LogInfo("Fetching credentials from role '" + role_name + "'");
 
-        auto route_context = prepare_route_context(role_name);
+        credentials = InstanceInfoCache::Create(
+            [this]()
+            {
+                return query_instance_info();
+            },
+            AWS_CREDENTIALS_TTL);
+        auto route_context = prepare_route_context();
         AWS::Route::Info route_info{*route_context};
         route_table_id = route_info.route_table_id;
         network_interface_id = route_info.network_interface_id;
@@ -108,6 +129,17 @@ class AWSObject : public DBus::Object::Base
 
         log->LogInfo("Running on instance " + route_context->instance_id() + ", route table " + route_table_id);
 
+        route_worker = VPC::RouteWorker::Create(
+            [this](const VPC::Action action, const VPC::Route &route)
+            {
+                program_route(action, route);
+            },
+            [this](const VPC::Action action, const VPC::Route &route, const std::string &error)
+            {
+                report_route(action, route, error);
+            },
+            AWS_ROUTE_WORKERS);
+
         subscr_mgr->Subscribe(signals_target, "NetworkChange", [=](DBus::Signals::Event::Ptr &event)
                               {
                                   process_network_change(event);
@@ -125,28 +157,17 @@ class AWSObject : public DBus::Object::Base
         // before we start cleaning up.
         netcfg_mgr->NotificationUnsubscribe();
 
-        // Retrieve AWS credentials and remove routes we are responsible
-        // for from VPC
-        auto route_context = prepare_route_context(role_name);
-
-        for (auto route : vpc_routes)
+        // Complete the pending route changes and remove the
+        // routes we are responsible for from VPC
+        route_worker->Flush();
+        for (const auto &route : route_worker->GetAddedRoutes())
         {
-            try
-            {
-                AWS::Route::delete_route(*route_context,
-                                         route_table_id,
-                                         route.first,
-                                         route.second);
-
-                log->LogInfo("Removed route " + route.first);
-            }
-            catch (const std::exception &ex)
-            {
-                log->LogError("Error removing route: " + std::string(ex.what()));
-            }
+            route_worker->Queue(VPC::Action::REMOVE, route);
         }
+        route_worker->Flush();
 
-        vpc_routes.clear();
+        // Stop the worker threads while the logging is still available
+        route_worker.reset();
     }
 
     const bool Authorize(const DBus::Authz::Request::Ptr request) override
@@ -172,45 +193,14 @@ class AWSObject : public DBus::Object::Base
             return;
         }
 
-        try
-        {
-            const std::string cidr = ev.details["subnet"] + "/" + ev.details["prefix"];
-            const bool ipv6 = ev.details["ip_version"] == "6";
-            auto route_context = prepare_route_context(role_name);
-
-            if (ev.type == NetCfgChangeType::ROUTE_ADDED)
-            {
-                AWS::Route::replace_create_route(*route_context,
-                                                 route_table_id,
-                                                 cidr,
-                                                 AWS::Route::RouteTargetType::INSTANCE_ID,
-                                                 route_context->instance_id(),
-                                                 ipv6);
-
-                vpc_routes.emplace(cidr, ipv6);
-
-                log->LogInfo("Added route " + cidr);
-            }
-            else
-            {
-                AWS::Route::delete_route(*route_context,
-                                         route_table_id,
-                                         cidr,
-                                         ipv6);
-
-                auto it = vpc_routes.find(VpcRoute(cidr, ipv6));
-                if (it != vpc_routes.end())
-                {
-                    vpc_routes.erase(it);
-                }
-
-                log->LogInfo("Removed route " + cidr);
-            }
-        }
-        catch (const std::exception &ex)
-        {
-            log->LogError("Error updating VPC routing: " + std::string(ex.what()));
-        }
+        // The route change is applied by the route worker threads,
+        // so the D-Bus signal handling is not blocked by the EC2 API calls
+        VPC::Route route{ev.details["subnet"] + "/" + ev.details["prefix"],
+                         ev.details["ip_version"] == "6"};
+        route_worker->Queue((ev.type == NetCfgChangeType::ROUTE_ADDED
+                                 ? VPC::Action::ADD
+                                 : VPC::Action::REMOVE),
+                            route);
     }
 
   private:
@@ -221,8 +211,23 @@ class AWSObject : public DBus::Object::Base
     std::string role_name;
     std::string network_interface_id;
     std::string route_table_id;
-    typedef std::pair<std::string, bool> VpcRoute;
-    std::set<VpcRoute> vpc_routes;
+
+    using InstanceInfoCache = VPC::CredentialsCache<AWS::PCQuery::Info>;
+    InstanceInfoCache::Ptr credentials;
+
+    /**
+     *  EC2 API context of a route worker thread, kept until the
+     *  cached credentials change
+     */
+    struct WorkerContext
+    {
+        uint64_t generation = 0;
+        std::unique_ptr<AWS::Route::Context> context;
+    };
+    std::mutex worker_contexts_mtx;
+    std::map<std::thread::id, WorkerContext> worker_contexts;
+
+    VPC::RouteWorker::Ptr route_worker;
 
     AWSLog::Ptr log;
 
@@ -240,7 +245,11 @@ class AWSObject : public DBus::Object::Base
         }
     }
 
-    std::unique_ptr<AWS::Route::Context> prepare_route_context(const std::string &role_name)
+    /**
+     *  Retrieve the instance information and the role credentials
+     *  from the instance metadata service
+     */
+    AWS::PCQuery::Info query_instance_info()
     {
         StrongRandomAPI::Ptr rng(new SSLLib::RandomAPI());
         AWS::PCQuery::Info ii;
@@ -259,9 +268,130 @@ class AWSObject : public DBus::Object::Base
                                        },
                                        nullptr,
                                        rng.get());
+        return ii;
+    }
 
+    /**
+     *  Prepare a context for the EC2 API calls, using the cached
+     *  instance information and role credentials.  The context is not
+     *  thread-safe, each route worker thread needs its own.
+     */
+    std::unique_ptr<AWS::Route::Context> prepare_route_context()
+    {
+        StrongRandomAPI::Ptr rng(new SSLLib::RandomAPI());
+        AWS::PCQuery::Info ii = credentials->Get();
         return std::unique_ptr<AWS::Route::Context>(new AWS::Route::Context(ii, ii.creds, rng, nullptr, 0));
     }
+
+    /**
+     *  Retrieve the EC2 API context of the calling route worker thread.
+     *  A new context is only prepared when the thread does not have one
+     *  yet or when the cached credentials have changed.
+     */
+    AWS::Route::Context &worker_route_context()
+    {
+        WorkerContext *wctx = nullptr;
+        {
+            // std::map does not move its elements, so the entry can
+            // be used without holding the lock
+            std::lock_guard<std::mutex> guard(worker_contexts_mtx);
+            wctx = &worker_contexts[std::this_thread::get_id()];
+        }
+
+        uint64_t generation = credentials->Generation();
+        if (!wctx->context || wctx->generation != generation)
+        {
+            wctx->context = prepare_route_context();
+            wctx->generation = generation;
+        }
+        return *wctx->context;
+    }
+
+    /**
+     *  Check if an EC2 API error was caused by rejected or expired
+     *  role credentials, which may be solved by fetching fresh ones
+     */
+    static bool is_credentials_error(const std::string &error)
+    {
+        for (const auto &code : {"AuthFailure",
+                                 "ExpiredToken",
+                                 "InvalidClientTokenId",
+                                 "RequestExpired"})
+        {
+            if (error.find(code) != std::string::npos)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     *  Apply a single route change to the VPC route table.  Called by
+     *  the route worker threads.
+     */
+    void program_route(const VPC::Action action, const VPC::Route &route)
+    {
+        for (unsigned int attempt = 0;; ++attempt)
+        {
+            try
+            {
+                auto &route_context = worker_route_context();
+                if (VPC::Action::ADD == action)
+                {
+                    AWS::Route::replace_create_route(route_context,
+                                                     route_table_id,
+                                                     route.cidr,
+                                                     AWS::Route::RouteTargetType::INSTANCE_ID,
+                                                     route_context.instance_id(),
+                                                     route.ipv6);
+                }
+                else
+                {
+                    AWS::Route::delete_route(route_context,
+                                             route_table_id,
+                                             route.cidr,
+                                             route.ipv6);
+                }
+                return;
+            }
+            catch (const std::exception &excp)
+            {
+                // Don't reuse a context which may have been left in
+                // an unknown state by the failed call
+                {
+                    std::lock_guard<std::mutex> guard(worker_contexts_mtx);
+                    worker_contexts.erase(std::this_thread::get_id());
+                }
+
+                if (attempt > 0 || !is_credentials_error(excp.what()))
+                {
+                    throw;
+                }
+                // The cached role credentials may have been rotated;
+                // retry once with fresh credentials
+                credentials->Invalidate();
+            }
+        }
+    }
+
+    void report_route(const VPC::Action action,
+                      const VPC::Route &route,
+                      const std::string &error)
+    {
+        if (!error.empty())
+        {
+            log->LogError("Error updating VPC routing: " + error);
+        }
+        else if (VPC::Action::ADD == action)
+        {
+            log->LogInfo("Added route " + route.cidr);
+        }
+        else
+        {
+            log->LogInfo("Removed route " + route.cidr);
+        }
+    }
 };
 
 
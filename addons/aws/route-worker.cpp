@@ -0,0 +1,184 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   route-worker.cpp
+ *
+ * @brief  Implementation of VPC::RouteWorker
+ */
+
+#include <algorithm>
+#include <exception>
+
+#include "route-worker.hpp"
+
+
+namespace VPC {
+
+RouteWorker::Ptr RouteWorker::Create(Executor exec,
+                                     Reporter report,
+                                     const unsigned int parallel)
+{
+    return RouteWorker::Ptr(new RouteWorker(std::move(exec),
+                                            std::move(report),
+                                            parallel));
+}
+
+
+RouteWorker::RouteWorker(Executor exec,
+                         Reporter report,
+                         const unsigned int parallel)
+    : executor(std::move(exec)), reporter(std::move(report))
+{
+    for (unsigned int i = 0; i < std::max(parallel, 1u); ++i)
+    {
+        workers.emplace_back(&RouteWorker::worker_loop, this);
+    }
+}
+
+
+RouteWorker::~RouteWorker() noexcept
+{
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        running = false;
+    }
+    work_cv.notify_all();
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+}
+
+
+void RouteWorker::Queue(const Action action, const Route &route)
+{
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = pending.find(route);
+        if (pending.end() == it)
+        {
+            pending.emplace(route, action);
+            order.push_back(route);
+        }
+        else if (it->second != action && 0 == in_flight.count(route)
+                 && (Action::ADD == action) == (added.count(route) > 0))
+        {
+            // The waiting change is cancelled by this change, as the
+            // VPC route table would end up as it is right now
+            pending.erase(it);
+        }
+        else
+        {
+            it->second = action;
+        }
+    }
+    work_cv.notify_one();
+}
+
+
+void RouteWorker::Flush()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    idle_cv.wait(lock,
+                 [this]()
+                 {
+                     return pending.empty() && in_flight.empty();
+                 });
+}
+
+
+std::vector<Route> RouteWorker::GetAddedRoutes() const
+{
+    std::lock_guard<std::mutex> guard(mtx);
+    return std::vector<Route>(added.begin(), added.end());
+}
+
+
+bool RouteWorker::next_change(Route &route, Action &action)
+{
+    // The order list may contain routes where the change was cancelled
+    // or already picked up; those are removed here
+    for (auto it = order.begin(); it != order.end();)
+    {
+        auto p = pending.find(*it);
+        if (pending.end() == p)
+        {
+            it = order.erase(it);
+            continue;
+        }
+        if (in_flight.count(*it) > 0)
+        {
+            ++it;
+            continue;
+        }
+        route = p->first;
+        action = p->second;
+        pending.erase(p);
+        order.erase(it);
+        in_flight.insert(route);
+        return true;
+    }
+    return false;
+}
+
+
+void RouteWorker::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        Route route;
+        Action action = Action::ADD;
+        if (!next_change(route, action))
+        {
+            if (!running)
+            {
+                return;
+            }
+            work_cv.wait(lock);
+            continue;
+        }
+        lock.unlock();
+
+        std::string error;
+        try
+        {
+            executor(action, route);
+        }
+        catch (const std::exception &excp)
+        {
+            error = excp.what();
+            if (error.empty())
+            {
+                error = "Unknown error";
+            }
+        }
+        reporter(action, route, error);
+
+        lock.lock();
+        in_flight.erase(route);
+        if (error.empty())
+        {
+            if (Action::ADD == action)
+            {
+                added.insert(route);
+            }
+            else
+            {
+                added.erase(route);
+            }
+        }
+
+        // A change of this route may have been waiting for this one
+        work_cv.notify_all();
+        idle_cv.notify_all();
+    }
+}
+
+} // namespace VPC
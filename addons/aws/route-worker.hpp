@@ -0,0 +1,247 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   route-worker.hpp
+ *
+ * @brief  Queues VPC route changes and applies them from a pool of
+ *         worker threads, outside of the D-Bus signal handling
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+
+namespace VPC {
+
+/**
+ *  A route in the VPC route table
+ */
+struct Route
+{
+    std::string cidr;
+    bool ipv6 = false;
+
+    bool operator<(const Route &r) const
+    {
+        return std::tie(cidr, ipv6) < std::tie(r.cidr, r.ipv6);
+    }
+};
+
+
+enum class Action
+{
+    ADD,
+    REMOVE
+};
+
+
+
+/**
+ *  Caches a value which is expensive to retrieve, like the instance
+ *  information and role credentials from the instance metadata service,
+ *  for a limited time.
+ *
+ *  Concurrent callers of Get() share a single retrieval of the value.
+ *
+ * @tparam T  Type of the cached value; must be copyable
+ */
+template <typename T>
+class CredentialsCache
+{
+  public:
+    using Ptr = std::shared_ptr<CredentialsCache<T>>;
+    using Fetcher = std::function<T()>;
+
+    /**
+     *  Create a new cache
+     *
+     * @param fetch  Fetcher function retrieving a fresh value.  It may
+     *               throw an exception, which is passed on to the
+     *               caller of Get().
+     * @param ttl    How long a retrieved value is used
+     * @return CredentialsCache<T>::Ptr
+     */
+    [[nodiscard]] static Ptr Create(Fetcher fetch,
+                                    const std::chrono::steady_clock::duration ttl)
+    {
+        return Ptr(new CredentialsCache<T>(std::move(fetch), ttl));
+    }
+
+    /**
+     *  Retrieve the cached value, fetching a fresh value if it is
+     *  missing or too old
+     *
+     * @return T
+     */
+    T Get()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        refresh();
+        return value;
+    }
+
+    /**
+     *  Retrieve the generation of the cached value, fetching a fresh
+     *  value if it is missing or too old.  The generation changes each
+     *  time a fresh value has been fetched, which allows callers to
+     *  keep objects derived from the value until it changes.
+     *
+     * @return uint64_t
+     */
+    uint64_t Generation()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        refresh();
+        return generation;
+    }
+
+    /**
+     *  Discard the cached value, typically when it was rejected.  The
+     *  next Get() call will fetch a fresh value.
+     */
+    void Invalidate() noexcept
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        valid = false;
+    }
+
+
+  private:
+    const Fetcher fetch;
+    const std::chrono::steady_clock::duration ttl;
+    std::mutex mtx{};
+    T value{};
+    bool valid = false;
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point expires{};
+
+    CredentialsCache(Fetcher fetch_, const std::chrono::steady_clock::duration ttl_)
+        : fetch(std::move(fetch_)), ttl(ttl_)
+    {
+    }
+
+    /**
+     *  Fetch a fresh value if needed.  Must be called with mtx locked.
+     */
+    void refresh()
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (!valid || now >= expires)
+        {
+            value = fetch();
+            expires = now + ttl;
+            valid = true;
+            ++generation;
+        }
+    }
+};
+
+
+
+/**
+ *  Applies the queued route changes from a pool of worker threads.
+ *
+ *  Only the most recent change of each route is kept while it is
+ *  waiting.  A route which is added and removed again before the worker
+ *  threads got to it is not touched at all, unless it was already
+ *  added to the VPC earlier.  Changes to the same route are never
+ *  applied concurrently.
+ */
+class RouteWorker
+{
+  public:
+    using Ptr = std::shared_ptr<RouteWorker>;
+
+    /**
+     *  Applies a single route change.  Errors are reported by throwing
+     *  an exception.  This is called from the worker threads.
+     */
+    using Executor = std::function<void(const Action action, const Route &route)>;
+
+    /**
+     *  Called from the worker threads after a route change has been
+     *  applied.  The error string is empty if it succeeded.
+     */
+    using Reporter = std::function<void(const Action action,
+                                        const Route &route,
+                                        const std::string &error)>;
+
+    /**
+     *  Create a new RouteWorker and start its worker threads
+     *
+     * @param exec      Executor applying the route changes
+     * @param report    Reporter called with the result of each change
+     * @param parallel  unsigned int with the number of worker threads
+     * @return RouteWorker::Ptr
+     */
+    [[nodiscard]] static Ptr Create(Executor exec,
+                                    Reporter report,
+                                    const unsigned int parallel);
+
+    /**
+     *  Stops the worker threads after all the queued route changes
+     *  have been applied
+     */
+    ~RouteWorker() noexcept;
+
+    /**
+     *  Queue a route change.  This returns immediately.
+     *
+     * @param action  Action to do with the route
+     * @param route   Route to change
+     */
+    void Queue(const Action action, const Route &route);
+
+    /**
+     *  Wait until all the queued route changes have been applied
+     */
+    void Flush();
+
+    /**
+     *  Retrieve the routes which have been successfully added to the
+     *  VPC and not removed again
+     *
+     * @return std::vector<Route>
+     */
+    std::vector<Route> GetAddedRoutes() const;
+
+
+  private:
+    const Executor executor;
+    const Reporter reporter;
+
+    mutable std::mutex mtx{};
+    std::condition_variable work_cv{};
+    std::condition_variable idle_cv{};
+    std::deque<Route> order{};
+    std::map<Route, Action> pending{};
+    std::set<Route> in_flight{};
+    std::set<Route> added{};
+    bool running = true;
+    std::vector<std::thread> workers{};
+
+    RouteWorker(Executor exec, Reporter report, const unsigned int parallel);
+    bool next_change(Route &route, Action &action);
+    void worker_loop();
+};
+
+} // namespace VPC
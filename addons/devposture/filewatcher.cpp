@@ -0,0 +1,147 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#include <cerrno>
+#include <filesystem>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <glib-unix.h>
+
+#include "filewatcher.hpp"
+
+
+namespace DevPosture {
+
+FileWatcher::Ptr FileWatcher::Create(const std::vector<std::string> &files,
+                                     Callback callback)
+{
+    return FileWatcher::Ptr(new FileWatcher(files, std::move(callback)));
+}
+
+
+FileWatcher::FileWatcher(const std::vector<std::string> &files, Callback callback)
+    : callback_(std::move(callback)), files_(files.begin(), files.end())
+{
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0)
+    {
+        return;
+    }
+
+    std::set<std::string> dirs;
+    for (const auto &f : files_)
+    {
+        dirs.insert(std::filesystem::path(f).parent_path());
+    }
+    for (const auto &d : dirs)
+    {
+        int wd = inotify_add_watch(inotify_fd_,
+                                   d.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM
+                                       | IN_CREATE | IN_DELETE | IN_ATTRIB);
+        if (wd >= 0)
+        {
+            dirs_[wd] = d;
+        }
+    }
+    if (dirs_.empty())
+    {
+        stop();
+        return;
+    }
+    watch_id_ = g_unix_fd_add(inotify_fd_, G_IO_IN, cb_inotify, this);
+}
+
+
+FileWatcher::~FileWatcher() noexcept
+{
+    stop();
+}
+
+
+void FileWatcher::stop() noexcept
+{
+    if (watch_id_ > 0)
+    {
+        g_source_remove(watch_id_);
+        watch_id_ = 0;
+    }
+    if (inotify_fd_ >= 0)
+    {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+
+gboolean FileWatcher::cb_inotify(gint fd, GIOCondition cond, gpointer data)
+{
+    auto self = static_cast<FileWatcher *>(data);
+    if (!self->process_events())
+    {
+        self->watch_id_ = 0;
+        self->stop();
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+
+bool FileWatcher::process_events()
+{
+    alignas(struct inotify_event) char buf[4096];
+    std::set<std::string> changed;
+    while (true)
+    {
+        ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+        if (len < 0)
+        {
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                break;
+            }
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        for (char *p = buf; p < buf + len;)
+        {
+            auto ev = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                // Events were lost; report all the files as changed
+                changed.insert(files_.begin(), files_.end());
+                continue;
+            }
+
+            auto dir = dirs_.find(ev->wd);
+            if (dir == dirs_.end() || 0 == ev->len)
+            {
+                continue;
+            }
+            std::string file = dir->second + "/" + ev->name;
+            if (files_.count(file) > 0)
+            {
+                changed.insert(file);
+            }
+        }
+    }
+
+    for (const auto &file : changed)
+    {
+        callback_(file);
+    }
+    return true;
+}
+
+} // namespace DevPosture
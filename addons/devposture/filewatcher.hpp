@@ -0,0 +1,77 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#pragma once
+
+/**
+ * @file filewatcher.hpp
+ *
+ * @brief Reports changes to a set of files via inotify
+ */
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+
+namespace DevPosture {
+
+/**
+ *  Watches a set of files for changes, using inotify on the directories
+ *  containing them.  Watching the directory catches files being replaced
+ *  (written to a temporary file, then renamed) as well as files which
+ *  does not exist yet.
+ *
+ *  The callback is called from the main loop thread.  If inotify cannot
+ *  be set up, IsActive() returns false and no changes are reported.
+ */
+class FileWatcher
+{
+  public:
+    using Ptr = std::shared_ptr<FileWatcher>;
+
+    /**
+     *  Called with the full path of the changed file
+     */
+    using Callback = std::function<void(const std::string &file)>;
+
+    [[nodiscard]] static FileWatcher::Ptr Create(const std::vector<std::string> &files,
+                                                 Callback callback);
+    ~FileWatcher() noexcept;
+
+    /**
+     *  Check if changes to the files are being watched
+     *
+     * @return bool
+     */
+    bool IsActive() const noexcept
+    {
+        return watch_id_ > 0;
+    }
+
+  private:
+    Callback callback_;
+    int inotify_fd_ = -1;
+    guint watch_id_ = 0;
+
+    /// inotify watch descriptor -> directory path
+    std::map<int, std::string> dirs_;
+    /// All watched files, with the full path
+    std::set<std::string> files_;
+
+    FileWatcher(const std::vector<std::string> &files, Callback callback);
+    void stop() noexcept;
+    bool process_events();
+    static gboolean cb_inotify(gint fd, GIOCondition cond, gpointer data);
+};
+
+} // namespace DevPosture
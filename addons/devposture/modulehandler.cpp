@@ -18,10 +18,10 @@ namespace DevPosture {
 ModuleHandler::ModuleHandler(Module::UPtr mod, const bool external)
     : DBus::Object::Base(PATH_DEVPOSTURE + "/modules/" + mod->name(),
                          Constants::GenInterface("devicecheck")),
-      module_(std::move(mod)),
-      prop_name_(module_->name()),
-      prop_type_(module_->type()),
-      prop_version_(module_->version()),
+      module_(CachedModule::Create(std::move(mod))),
+      prop_name_(module_->GetModule().name()),
+      prop_type_(module_->GetModule().type()),
+      prop_version_(module_->GetModule().version()),
       prop_external_(external)
 
 {
@@ -9,7 +9,7 @@
 #include <gdbuspp/service.hpp>
 #include <gdbuspp/connection.hpp>
 
-#include "modules/module-interface.hpp"
+#include "modules/cached-module.hpp"
 
 
 namespace DevPosture {
@@ -54,8 +54,19 @@ class ModuleHandler : public DBus::Object::Base
         return module_->Run(input);
     }
 
+    /**
+     *  Retrieve the device posture check module, including its
+     *  result cache
+     *
+     * @return CachedModule::Ptr
+     */
+    CachedModule::Ptr GetCachedModule() const noexcept
+    {
+        return module_;
+    }
+
   private:
-    const Module::UPtr module_ = nullptr; ///< Device check module
+    const CachedModule::Ptr module_ = nullptr; ///< Device check module
     std::string prop_name_ = "";          ///< Name of the device posture check
     std::string prop_type_ = "";          ///< Device posture check categorization
     uint16_t prop_version_ = 0;           ///< Version of the device posture check
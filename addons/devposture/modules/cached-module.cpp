@@ -0,0 +1,60 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#include "cached-module.hpp"
+
+
+namespace DevPosture {
+
+CachedModule::Ptr CachedModule::Create(Module::UPtr mod)
+{
+    return CachedModule::Ptr(new CachedModule(std::move(mod)));
+}
+
+
+CachedModule::CachedModule(Module::UPtr mod)
+    : module_(std::move(mod)), ttl_(module_->cache_ttl())
+{
+}
+
+
+Module::Dictionary CachedModule::Run(const Module::Dictionary &input)
+{
+    // The lock is also held while running the module, so concurrent
+    // callers share a single run instead of running it in parallel
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (!input.empty() || ttl_.count() <= 0)
+    {
+        return module_->Run(input);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!valid_ || now >= expires_)
+    {
+        result_ = module_->Run(input);
+        expires_ = now + ttl_;
+        valid_ = true;
+    }
+    return result_;
+}
+
+
+bool CachedModule::IsCached() const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    return valid_ && std::chrono::steady_clock::now() < expires_;
+}
+
+
+void CachedModule::Invalidate() noexcept
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    valid_ = false;
+}
+
+} // namespace DevPosture
@@ -0,0 +1,83 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#pragma once
+
+/**
+ * @file cached-module.hpp
+ *
+ * @brief Wraps a device posture module and caches its results
+ */
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "module-interface.hpp"
+
+
+namespace DevPosture {
+
+/**
+ *  Keeps the result of a device posture module for as long as the
+ *  module's cache_ttl() allows it, or until Invalidate() is called.
+ *  Modules with a cache_ttl() of 0 are run on each call.
+ *
+ *  Only results of runs without any input are cached.
+ */
+class CachedModule
+{
+  public:
+    using Ptr = std::shared_ptr<CachedModule>;
+
+    [[nodiscard]] static CachedModule::Ptr Create(Module::UPtr mod);
+
+    /**
+     *  Retrieve the wrapped device posture module
+     *
+     * @return const Module&
+     */
+    const Module &GetModule() const noexcept
+    {
+        return *module_;
+    }
+
+    /**
+     *  Run the device posture module, or return the cached result
+     *  if it is still valid
+     *
+     * @param input         See Module::Run()
+     * @return Module::Dictionary
+     */
+    Module::Dictionary Run(const Module::Dictionary &input = {});
+
+    /**
+     *  Check if a valid result is cached, so Run() will not need to run
+     *  the module
+     *
+     * @return bool
+     */
+    bool IsCached() const;
+
+    /**
+     *  Discard the cached result
+     */
+    void Invalidate() noexcept;
+
+  private:
+    const Module::UPtr module_;
+    const std::chrono::steady_clock::duration ttl_;
+    mutable std::mutex mtx_;
+    Module::Dictionary result_;
+    std::chrono::steady_clock::time_point expires_{};
+    bool valid_ = false;
+
+    CachedModule(Module::UPtr mod);
+};
+
+} // namespace DevPosture
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -81,6 +82,18 @@ class Module
      * @return uint16_t
      */
     virtual uint16_t version() const = 0;
+
+    /**
+     *  Retrieve how long the result of Run() may be reused.  Modules
+     *  reporting values which change at any time, like the clock,
+     *  must return 0, which is the default.
+     *
+     * @return std::chrono::seconds
+     */
+    virtual std::chrono::seconds cache_ttl() const
+    {
+        return std::chrono::seconds(0);
+    }
 };
 
 } // namespace DevPosture
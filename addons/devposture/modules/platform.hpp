@@ -36,6 +36,16 @@ class PlatformModule : public Module
     {
         return 1;
     }
+
+    /**
+     *  The uname() details only change after a reboot, and the service
+     *  invalidates the cached result when os-release is modified.  The
+     *  TTL only limits how long a missed change can go unnoticed.
+     */
+    std::chrono::seconds cache_ttl() const override
+    {
+        return std::chrono::hours(1);
+    }
 };
 
 } // namespace DevPosture
@@ -0,0 +1,376 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#include "profile-index.hpp"
+
+
+namespace DevPosture {
+
+/**
+ * Composes a Json::Value (JsonCPP) JSON object, by replacing all
+ * macros in result_mapping with the corresponding value in the
+ * dict key -> value container. For example, if result_mapping
+ * contains { "type": "uname_sysname" }, and dict has a [key, value]
+ * element where key == "uname_sysname" and value == "Linux", then
+ * the resulting JSON will have { "type": "Linux" }.
+ *
+ * @param dict            key -> value "macro" association container.
+ * @param result_mapping  A "raw" JSON where "macros" need substitution.
+ *
+ * @return Json::Value    A JSON where all the macros have been
+ *                        substituted.
+ */
+static Json::Value compose_json(const Module::Dictionary &dict, const Json::Value &result_mapping)
+{
+    Json::Value ret;
+
+    for (auto it = result_mapping.begin(); it != result_mapping.end(); ++it)
+    {
+        if (!it->isObject())
+        {
+            std::string val;
+            auto dict_it = dict.find(it->asString());
+
+            if (dict_it != dict.end())
+                val = dict_it->second;
+
+            ret[it.key().asString()] = val;
+        }
+        else
+        {
+            ret[it.key().asString()] = compose_json(dict, *it);
+        }
+    }
+
+    return ret;
+}
+
+
+/**
+ *  Generates a human-readable date/timestamp used in the dpc_response
+ *  back to the server
+ *
+ * @return std::string
+ */
+static std::string generate_timestamp()
+{
+    using namespace std::chrono;
+
+    const auto now = system_clock::now();
+    const auto now_time_t = system_clock::to_time_t(now);
+    const auto ms = time_point_cast<milliseconds>(now).time_since_epoch().count() % 1000;
+
+    tm utc_time{};
+
+    gmtime_r(&now_time_t, &utc_time);
+
+    std::stringstream ss;
+
+    ss << std::put_time(&utc_time, "%a %b %d %T.") << std::setfill('0')
+       << std::setw(3) << ms << std::put_time(&utc_time, " %Y");
+
+    return ss.str();
+}
+
+
+
+ProfileIndex::Ptr ProfileIndex::Create(ModuleLookup lookup)
+{
+    return ProfileIndex::Ptr(new ProfileIndex(std::move(lookup)));
+}
+
+
+ProfileIndex::ProfileIndex(ModuleLookup lookup)
+    : lookup_(std::move(lookup))
+{
+}
+
+
+void ProfileIndex::Load(const std::string &profile_dir)
+{
+    namespace fs = std::filesystem;
+
+    try
+    {
+        for (const auto &entry : fs::directory_iterator(profile_dir))
+        {
+            auto p = entry.path();
+
+            if (p.extension() == ".json")
+            {
+                std::ifstream profile_stream(p, std::ios::in | std::ios::binary);
+                Json::Value profile_json;
+
+                profile_stream >> profile_json;
+
+                add_profile(p.stem(), profile_json);
+            }
+        }
+    }
+    catch (...)
+    {
+        rebuild_protocol_index();
+        throw;
+    }
+    rebuild_protocol_index();
+}
+
+
+void ProfileIndex::AddProfile(const std::string &enterprise_id, const Json::Value &profile)
+{
+    add_profile(enterprise_id, profile);
+    rebuild_protocol_index();
+}
+
+
+std::string ProfileIndex::LookupProtocol(const std::string &enterprise_id) const
+{
+    auto it = appcontrol_ids_.find(enterprise_id);
+    return (it != appcontrol_ids_.end() ? it->second : "");
+}
+
+
+std::string ProfileIndex::RunChecks(const std::string &protocol,
+                                    const std::string &request) const
+{
+    Json::Value request_json;
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+
+    std::string errors;
+    std::istringstream instr(request);
+
+    if (!Json::parseFromStream(builder, instr, &request_json, &errors))
+    {
+        throw InvalidRequest("devposture: invalid request JSON: " + request);
+    }
+
+    std::string correlation_id;
+    std::string version;
+
+    std::set<std::string> checks;
+
+    const auto &req_data = request_json["dpc_request"];
+
+    for (auto cit = req_data.begin(); cit != req_data.end(); ++cit)
+    {
+        const std::string key = cit.key().asString();
+
+        if (key == "correlation_id")
+        {
+            correlation_id = cit->asString();
+        }
+        else if (key == "ver")
+        {
+            version = cit->asString();
+        }
+        else if (key != "timestamp")
+        {
+            if (cit->isBool() && cit->asBool())
+            {
+                checks.insert(key);
+            }
+        }
+    }
+
+    auto prof_it = protocols_.find({protocol, version});
+    if (prof_it == protocols_.end())
+    {
+        // All the profiles of a protocol are sorted after the
+        // empty version of the protocol
+        auto proto_it = protocols_.lower_bound({protocol, ""});
+        if (proto_it == protocols_.end() || proto_it->first.first != protocol)
+        {
+            throw CheckException("protocol '" + protocol
+                                 + "' not supported [correlation_id: "
+                                 + correlation_id + "]");
+        }
+        throw CheckException("requested version '" + version
+                             + "' not supported [correlation_id: "
+                             + correlation_id + "]");
+    }
+    const Profile &profile = *prof_it->second;
+
+    // Collect the modules needed by the requested checks
+    std::vector<const std::pair<const std::string, Control> *> controls;
+    std::map<std::string, CachedModule::Ptr> modules;
+    for (const auto &check : checks)
+    {
+        auto ctrl_it = profile.controls.find(check);
+        if (ctrl_it == profile.controls.end())
+        {
+            continue;
+        }
+        controls.push_back(&(*ctrl_it));
+        for (const auto &mapping : ctrl_it->second.mappings)
+        {
+            if (modules.find(mapping.module) == modules.end())
+            {
+                modules[mapping.module] = lookup_(mapping.module);
+            }
+        }
+    }
+
+    // The modules are independent of each other, so those without a
+    // cached result are run concurrently
+    std::map<std::string, Module::Dictionary> results;
+    std::vector<std::pair<std::string, std::future<Module::Dictionary>>> running;
+    std::vector<std::pair<std::string, CachedModule::Ptr>> uncached;
+    for (const auto &[path, mod] : modules)
+    {
+        if (!mod)
+        {
+            continue;
+        }
+        if (mod->IsCached())
+        {
+            results[path] = mod->Run();
+        }
+        else
+        {
+            uncached.emplace_back(path, mod);
+        }
+    }
+    for (size_t i = 1; i < uncached.size(); ++i)
+    {
+        auto mod = uncached[i].second;
+        running.emplace_back(uncached[i].first,
+                             std::async(std::launch::async,
+                                        [mod]()
+                                        {
+                                            return mod->Run();
+                                        }));
+    }
+    if (!uncached.empty())
+    {
+        results[uncached[0].first] = uncached[0].second->Run();
+    }
+    for (auto &[path, result] : running)
+    {
+        results[path] = result.get();
+    }
+
+    Json::Value ret_payload_json;
+    for (const auto *ctrl : controls)
+    {
+        Json::Value result_json;
+        for (const auto &mapping : ctrl->second.mappings)
+        {
+            auto res_it = results.find(mapping.module);
+            if (res_it == results.end())
+            {
+                continue;
+            }
+            Json::Value mapped_json = compose_json(res_it->second, mapping.result_mapping);
+            if (!ctrl->second.merged)
+            {
+                result_json = mapped_json;
+            }
+            else if (!mapped_json.empty())
+            {
+                for (auto it = mapped_json.begin(); it != mapped_json.end(); ++it)
+                {
+                    result_json[it.key().asString()] = *it;
+                }
+            }
+        }
+        ret_payload_json[ctrl->first] = result_json;
+    }
+
+    if (ret_payload_json.empty())
+    {
+        throw CheckException("no supported checks found [correlation_id: "
+                             + correlation_id + "]");
+    }
+
+    Json::Value ret_json;
+    auto &dpc_response = ret_json["dpc_response"];
+
+    dpc_response["ver"] = version;
+    dpc_response["correlation_id"] = correlation_id;
+    dpc_response["timestamp"] = generate_timestamp();
+
+    for (auto it = ret_payload_json.begin(); it != ret_payload_json.end(); ++it)
+    {
+        dpc_response[it.key().asString()] = *it;
+    }
+
+    Json::StreamWriterBuilder writer;
+    writer.settings_["indentation"] = "";
+    return Json::writeString(writer, ret_json);
+}
+
+
+void ProfileIndex::add_profile(const std::string &enterprise_id, const Json::Value &profile)
+{
+    auto prof = std::make_shared<Profile>();
+
+    const std::string appcontrol_id = profile["appcontrol_id"].asString();
+    std::string::size_type start = 0;
+    while (true)
+    {
+        auto end = appcontrol_id.find(':', start);
+        prof->protocols.push_back(appcontrol_id.substr(start, end - start));
+        if (std::string::npos == end)
+        {
+            break;
+        }
+        start = end + 1;
+    }
+
+    prof->version = profile["ver"].asString();
+
+    const auto &mappings = profile["control_mapping"];
+    for (auto it = mappings.begin(); it != mappings.end(); ++it)
+    {
+        Control ctrl;
+        ctrl.merged = it->isArray();
+        if (ctrl.merged)
+        {
+            for (const auto &elem : *it)
+            {
+                ctrl.mappings.push_back({elem["module"].asString(), elem["result_mapping"]});
+            }
+        }
+        else
+        {
+            ctrl.mappings.push_back({(*it)["module"].asString(), (*it)["result_mapping"]});
+        }
+        prof->controls[it.key().asString()] = std::move(ctrl);
+    }
+
+    appcontrol_ids_[enterprise_id] = appcontrol_id;
+    profiles_[enterprise_id] = prof;
+}
+
+
+void ProfileIndex::rebuild_protocol_index()
+{
+    // If more profiles support the same protocol and version, the
+    // first profile sorted by the enterprise profile ID is used
+    protocols_.clear();
+    for (const auto &[enterprise_id, profile] : profiles_)
+    {
+        for (const auto &proto : profile->protocols)
+        {
+            protocols_.emplace(std::make_pair(proto, profile->version), profile);
+        }
+    }
+}
+
+} // namespace DevPosture
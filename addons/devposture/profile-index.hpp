@@ -0,0 +1,161 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#pragma once
+
+/**
+ * @file profile-index.hpp
+ *
+ * @brief The device posture protocol profiles, pre-processed for
+ *        running the device posture checks
+ */
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <json/json.h>
+
+#include "modules/cached-module.hpp"
+
+
+namespace DevPosture {
+
+/**
+ *  Errors from ProfileIndex::RunChecks() about a request which could
+ *  not be handled by any of the protocol profiles
+ */
+class CheckException : public std::runtime_error
+{
+  public:
+    CheckException(const std::string &err)
+        : std::runtime_error(err)
+    {
+    }
+};
+
+
+/**
+ *  The request passed to ProfileIndex::RunChecks() is not valid JSON
+ */
+class InvalidRequest : public std::runtime_error
+{
+  public:
+    InvalidRequest(const std::string &err)
+        : std::runtime_error(err)
+    {
+    }
+};
+
+
+/**
+ *  Keeps all the loaded device posture protocol profiles, indexed by
+ *  each of the protocols listed in their 'appcontrol_id' and the
+ *  profile version.  The control
+ *  mappings of the profiles are parsed once, when they are added, so
+ *  running a check only needs a single lookup.
+ */
+class ProfileIndex
+{
+  public:
+    using Ptr = std::shared_ptr<ProfileIndex>;
+
+    /**
+     *  Looks up the device posture module for a module D-Bus path used
+     *  in the profiles.  Returns nullptr for unknown modules.
+     */
+    using ModuleLookup = std::function<CachedModule::Ptr(const std::string &path)>;
+
+    [[nodiscard]] static ProfileIndex::Ptr Create(ModuleLookup lookup);
+
+    /**
+     *  Loads all the device posture protocol profiles (*.json) in a
+     *  directory.  The profile name (enterprise profile ID) is the
+     *  file name without the .json extension.  Profiles parsed before
+     *  an error was found are kept.
+     *
+     * @param profile_dir  std::string with the directory to load from
+     * @throws std::exception on errors reading or parsing the profiles
+     */
+    void Load(const std::string &profile_dir);
+
+    /**
+     *  Adds a single device posture protocol profile
+     *
+     * @param enterprise_id  std::string with the profile name
+     * @param profile        Json::Value with the parsed profile
+     */
+    void AddProfile(const std::string &enterprise_id, const Json::Value &profile);
+
+    /**
+     *  Retrieve the 'appcontrol_id' of an enterprise profile
+     *
+     * @param enterprise_id  std::string with the profile name
+     * @return std::string with the appcontrol_id; empty if the profile
+     *         was not found
+     */
+    std::string LookupProtocol(const std::string &enterprise_id) const;
+
+    /**
+     *  Run the device posture checks of a request.  The modules needed
+     *  are run concurrently, unless their results are cached.
+     *
+     * @param protocol  std::string with the device posture protocol
+     * @param request   std::string with the JSON dpc_request object
+     * @return std::string with the JSON dpc_response object
+     *
+     * @throws InvalidRequest if the request cannot be parsed
+     * @throws CheckException if the request cannot be handled
+     */
+    std::string RunChecks(const std::string &protocol,
+                          const std::string &request) const;
+
+
+  private:
+    /**
+     *  A module to run and the JSON template to put its results in
+     */
+    struct Mapping
+    {
+        std::string module;
+        Json::Value result_mapping;
+    };
+
+    /**
+     *  A single check in a profile's control_mapping.  Results of
+     *  checks defined as an array of mappings are merged.
+     */
+    struct Control
+    {
+        bool merged = false;
+        std::vector<Mapping> mappings;
+    };
+
+    struct Profile
+    {
+        std::vector<std::string> protocols;
+        std::string version;
+        std::map<std::string, Control> controls;
+    };
+
+    ModuleLookup lookup_;
+    std::map<std::string, std::string> appcontrol_ids_;
+    std::map<std::string, std::shared_ptr<const Profile>> profiles_;
+
+    /// Profiles indexed by protocol and profile version
+    std::map<std::pair<std::string, std::string>, std::shared_ptr<const Profile>> protocols_;
+
+    ProfileIndex(ModuleLookup lookup);
+    void add_profile(const std::string &enterprise_id, const Json::Value &profile);
+    void rebuild_protocol_index();
+};
+
+} // namespace DevPosture
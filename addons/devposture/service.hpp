@@ -13,7 +13,9 @@
 
 #include <dbus/constants.hpp>
 #include "devposture-signals.hpp"
-#include "modules/module-interface.hpp"
+#include "filewatcher.hpp"
+#include "modules/cached-module.hpp"
+#include "profile-index.hpp"
 
 
 namespace DevPosture {
@@ -45,22 +47,6 @@ class Handler : public DBus::Object::Base
     void LoadProtocolProfiles(const std::string &profile_dir);
 
   private:
-    /**
-     * Composes a Json::Value (JsonCPP) JSON object, by replacing all
-     * macros in result_mapping with the corresponding value in the
-     * dict key -> value container. For example, if result_mapping
-     * contains { "type": "uname_sysname" }, and dict has a [key, value]
-     * element where key == "uname_sysname" and value == "Linux", then
-     * the resulting JSON will have { "type": "Linux" }.
-     *
-     * @param dict            key -> value "macro" association container.
-     * @param result_mapping  A "raw" JSON where "macros" need substitution.
-     *
-     * @return Json::Value    A JSON where all the macros have been
-     *                        substituted.
-     */
-    Json::Value compose_json(const Module::Dictionary &dict, const Json::Value &result_mapping) const;
-
     /**
      *  D-Bus method: net.openvpn.v3.devposture.GetRegisteredModules
      *
@@ -128,46 +114,10 @@ class Handler : public DBus::Object::Base
      */
     void method_run_checks(DBus::Object::Method::Arguments::Ptr args) const;
 
-    /**
-     *  Generates a human-readable date/timestamp used in the dpc_response
-     *  back to the server
-     *
-     * @return std::string
-     */
-    static std::string generate_timestamp();
-
-    /**
-     *  Uses the module specified in mapping_data to compose a JSON
-     *  by using the module's dictionary output and the "result_mapping"
-     *  sub-JSON of mapping_data as parameters to compose_json().
-     *
-     * @param mapping_data  A "parent" JSON with information about a
-     *                      module to use for retrieving information,
-     *                      and a sub-JSON that needs to have its
-     *                      macros substituted.
-     *
-     * @return Json::Value  A JSON with all the macros substituted.
-     */
-    Json::Value create_mapped_json(const Json::Value &mapping_data) const;
-
-    /**
-     *  Uses the create_mapped_json() member function for each element
-     *  of the arr_mapping_data array, then merges the results into
-     *  the returned value.
-     *
-     * @param mapping_data  An array of "parent" JSONs, each with
-     *                      information about a module to use for
-     *                      retrieving information, and a sub-JSON
-     *                      that needs to have its macros substituted.
-     *
-     * @return Json::Value  A JSON with all the macros substituted.
-     */
-    Json::Value create_merged_mapped_json(const Json::Value &arr_mapping_data) const;
-
   private:
     DBus::Object::Manager::Ptr object_manager_;
     DevPosture::Log::Ptr signals_;
-    std::map<std::string, Json::Value> profiles_;
+    ProfileIndex::Ptr index_;
 };
 
 
@@ -201,6 +151,8 @@ class Service : public DBus::Service
     LogWriter::Ptr logwr_;
     uint8_t log_level_;
     Handler::Ptr handler_ = nullptr;
+    std::vector<CachedModule::Ptr> modules_;
+    FileWatcher::Ptr os_release_watcher_ = nullptr;
 };
 
 } // end of namespace DevPosture
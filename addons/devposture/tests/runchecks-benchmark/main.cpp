@@ -0,0 +1,119 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   main.cpp
+ *
+ * @brief  Benchmark of the latency of the device posture RunChecks()
+ *         processing, with and without cached module results.  This
+ *         runs the built-in modules directly, without any D-Bus calls.
+ *
+ *         Usage: runchecks-benchmark [--json] PROFILE-DIR PROTOCOL [ITERATIONS]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "constants.hpp"
+#include "modules/built-in.hpp"
+#include "profile-index.hpp"
+
+#include "benchmark-utils.hpp"
+
+
+using namespace DevPosture;
+
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    std::vector<std::string> params;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ("--json" == arg)
+        {
+            json = true;
+        }
+        else
+        {
+            params.push_back(arg);
+        }
+    }
+    uint64_t iterations = (params.size() > 2 ? std::strtoull(params[2].c_str(), nullptr, 10) : 1000);
+    if (params.size() < 2 || params.size() > 3 || 0 == iterations)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--json] PROFILE-DIR PROTOCOL [ITERATIONS]" << std::endl;
+        return 1;
+    }
+    const std::string protocol = params[1];
+
+    std::map<std::string, CachedModule::Ptr> modules;
+    for (auto mod : {CachedModule::Create(Module::Create<PlatformModule>()),
+                     CachedModule::Create(Module::Create<DateTimeModule>())})
+    {
+        modules[PATH_DEVPOSTURE + "/modules/" + mod->GetModule().name()] = mod;
+    }
+
+    auto index = ProfileIndex::Create(
+        [&modules](const std::string &path) -> CachedModule::Ptr
+        {
+            auto it = modules.find(path);
+            return (it != modules.end() ? it->second : nullptr);
+        });
+    try
+    {
+        index->Load(params[0]);
+    }
+    catch (const std::exception &excp)
+    {
+        std::cerr << "Error parsing protocol profiles: " << excp.what() << std::endl;
+        return 2;
+    }
+
+    const std::string request = "{\"dpc_request\": {\"ver\": \"1.0\", "
+                                "\"correlation_id\": \"0889817969045489535\", "
+                                "\"client_info\": true, \"localtime\": true}}";
+    try
+    {
+        const std::string response = index->RunChecks(protocol, request);
+        if (!json)
+        {
+            std::cout << response << std::endl;
+        }
+    }
+    catch (const std::exception &excp)
+    {
+        std::cerr << "RunChecks() failed: " << excp.what() << std::endl;
+        return 3;
+    }
+
+    Benchmark::Runner bench("devposture-runchecks", json);
+    bench.RunLatency("uncached modules",
+                     iterations,
+                     [&]()
+                     {
+                         for (const auto &[path, mod] : modules)
+                         {
+                             mod->Invalidate();
+                         }
+                         index->RunChecks(protocol, request);
+                     });
+    bench.RunLatency("cached modules",
+                     iterations,
+                     [&]()
+                     {
+                         index->RunChecks(protocol, request);
+                     });
+    bench.Finish();
+    return 0;
+}
@@ -102,10 +102,15 @@ class BackendSignals : public LogSender
         // Default targets for D-Bus signals are the
         // Session Manager (net.openvpn.v3.sessions) and the
         // Log service (net.openvpn.v3.log).
-        auto creds = DBus::Credentials::Query::Create(conn);
-        auto sessmgr_busn = creds->GetUniqueBusName(Constants::GenServiceName("sessions"));
+        //
+        // The signals are sent to the well-known bus names and not the
+        // unique bus names of the current owners.  The D-Bus daemon
+        // delivers them to whichever process owns the name when the
+        // signal is sent, so a restarted session manager which has
+        // re-adopted this session will still receive them.
+        const std::string sessmgr_busn = Constants::GenServiceName("sessions");
         AddTarget(sessmgr_busn);
-        AddTarget(creds->GetUniqueBusName(Constants::GenServiceName("log")));
+        AddTarget(Constants::GenServiceName("log"));
 
         // Prepare the RegistrationRequest signal; this is only to be sent
         // to the Session Manager (net.openvpn.v3.sessions).  A dedicated signal
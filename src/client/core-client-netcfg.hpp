@@ -20,11 +20,138 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glib.h>
+
+#include "common/timeline.hpp"
 #include "netcfg/proxy-netcfg-device.hpp"
 #include "netcfg/proxy-netcfg-mgr.hpp"
 #include "backend-signals.hpp"
 
 
+#ifdef ENABLE_OVPNDCO
+/**
+ *  Collects the key and keepalive changes reported by the Core library
+ *  and sends them to the netcfg service from the main loop.
+ *
+ *  The Core library reports the changes of a rekey through separate tun
+ *  builder hooks, called right after each other, and gives no indication
+ *  of when a rekey is complete.  Changes reported before the main loop
+ *  has sent the previous ones are merged into the same UpdateKeys call,
+ *  like a new primary key and the keepalive settings following it.  The
+ *  main loop sends the changes as soon as it runs, so a new key is never
+ *  held back waiting for a later hook.
+ */
+class DcoKeyUpdateQueue : public std::enable_shared_from_this<DcoKeyUpdateQueue>
+{
+  public:
+    using Ptr = std::shared_ptr<DcoKeyUpdateQueue>;
+
+    [[nodiscard]] static Ptr Create(NetCfgProxy::DCO::Ptr dco,
+                                    BackendSignals::Ptr signals)
+    {
+        return Ptr(new DcoKeyUpdateQueue(dco, signals));
+    }
+
+
+    /**
+     *  Queue a change, to be sent by the main loop
+     *
+     * @param upd  NetCfgProxy::DCO::KeyUpdate with the change
+     */
+    void Queue(const NetCfgProxy::DCO::KeyUpdate &upd)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (pending.empty() || !pending.back().Merge(upd))
+        {
+            pending.push_back(upd);
+        }
+        if (!scheduled)
+        {
+            // The idle source keeps the queue alive until it has run
+            scheduled = true;
+            g_idle_add_full(G_PRIORITY_DEFAULT,
+                            cb_send,
+                            new Ptr(shared_from_this()),
+                            [](gpointer data)
+                            {
+                                delete static_cast<Ptr *>(data);
+                            });
+        }
+    }
+
+
+    /**
+     *  Send the queued changes right away.  This is used before other
+     *  DCO operations, which must not overtake the queued changes.
+     */
+    void Flush() noexcept
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        send_pending();
+    }
+
+
+    /**
+     *  Send the queued changes right away and stop using the DCO device
+     */
+    void Close() noexcept
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        send_pending();
+        dco.reset();
+    }
+
+
+  private:
+    std::mutex mtx{};
+    NetCfgProxy::DCO::Ptr dco = nullptr;
+    BackendSignals::Ptr signals = nullptr;
+    std::vector<NetCfgProxy::DCO::KeyUpdate> pending{};
+    bool scheduled = false;
+
+    DcoKeyUpdateQueue(NetCfgProxy::DCO::Ptr dco_, BackendSignals::Ptr signals_)
+        : dco(dco_), signals(signals_)
+    {
+    }
+
+
+    static gboolean cb_send(gpointer data)
+    {
+        auto self = *static_cast<Ptr *>(data);
+        std::lock_guard<std::mutex> guard(self->mtx);
+        self->scheduled = false;
+        self->send_pending();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    void send_pending() noexcept
+    {
+        for (const auto &upd : pending)
+        {
+            if (!dco)
+            {
+                break;
+            }
+            try
+            {
+                dco->UpdateKeys(upd);
+            }
+            catch (const std::exception &excp)
+            {
+                signals->LogError("Updating the DCO keys failed: "
+                                  + std::string(excp.what()));
+            }
+        }
+        pending.clear();
+    }
+};
+#endif // ENABLE_OVPNDCO
+
+
 template <class T>
 class NetCfgTunBuilder : public T
 {
@@ -59,6 +186,13 @@ class NetCfgTunBuilder : public T
 
     ~NetCfgTunBuilder()
     {
+#ifdef ENABLE_OVPNDCO
+        if (dco_keys)
+        {
+            dco_keys->Close();
+        }
+#endif
+
         // Explicitly call cleanup
         try
         {
@@ -86,9 +220,18 @@ class NetCfgTunBuilder : public T
 
     bool tun_builder_new() override
     {
+        networks.clear();
+        if (device && reconnect_prepared)
+        {
+            // The device is kept by the netcfg service; the new
+            // configuration is compared with the current one when
+            // the device is established
+            reconnect_prepared = false;
+            return true;
+        }
+
         // Cleanup the old things
         tun_builder_teardown(true);
-        networks.clear();
 
         return create_device();
     }
@@ -343,7 +486,14 @@ class NetCfgTunBuilder : public T
 
         try
         {
-            return device->Establish();
+            set_queueing();
+            int fd = -1;
+            {
+                ConnectTimeline::Scope phase(timeline, "netcfg.establish");
+                fd = device->Establish();
+            }
+            import_establish_timeline();
+            return fd;
         }
         catch (const DBus::Exception &excp)
         {
@@ -376,9 +526,18 @@ class NetCfgTunBuilder : public T
             return;
         }
 
+        // DCO devices are always disabled on reconnect
+        bool reusable = true;
 #ifdef ENABLE_OVPNDCO
+        reusable = !dco;
+        if (dco_keys)
+        {
+            dco_keys->Close();
+            dco_keys.reset();
+        }
         dco.reset();
 #endif
+        reconnect_prepared = false;
 
         if (disconnect)
         {
@@ -397,7 +556,14 @@ class NetCfgTunBuilder : public T
         {
             try
             {
-                device->Disable();
+                if (reusable)
+                {
+                    reconnect_prepared = device->PrepareReconnect();
+                }
+                else
+                {
+                    device->Disable();
+                }
             }
             catch (const DBus::Exception &excp)
             {
@@ -486,6 +652,7 @@ class NetCfgTunBuilder : public T
             if (!dco)
             {
                 dco.reset(device->EnableDCO(dev_name));
+                dco_keys = DcoKeyUpdateQueue::Create(dco, signals);
             }
             return dco->GetPipeFD();
         }
@@ -506,9 +673,10 @@ class NetCfgTunBuilder : public T
     {
         if (!dco)
         {
-            NetCfgProxyException(__func__, "Lost link to DCO device");
+            throw NetCfgProxyException(__func__, "Lost link to DCO device");
         }
 
+        dco_keys->Flush();
         dco->NewPeer(peer_id, transport_fd, sa, salen, vpn4, vpn6);
     }
 
@@ -518,10 +686,14 @@ class NetCfgTunBuilder : public T
     {
         if (!dco)
         {
-            NetCfgProxyException(__func__, "Lost link to DCO device");
+            throw NetCfgProxyException(__func__, "Lost link to DCO device");
         }
 
-        dco->NewKey(key_slot, kc);
+        NetCfgProxy::DCO::KeyUpdate upd;
+        upd.peer_id = kc->remote_peer_id;
+        upd.key_config = NetCfgProxy::DCO::EncodeKeyConfig(kc);
+        upd.key_slot = key_slot;
+        dco_keys->Queue(upd);
     }
 
 
@@ -534,7 +706,7 @@ class NetCfgTunBuilder : public T
 
         if (!dco)
         {
-            NetCfgProxyException(__func__, "Lost link to DCO device");
+            throw NetCfgProxyException(__func__, "Lost link to DCO device");
         }
 
         try
@@ -550,6 +722,7 @@ class NetCfgTunBuilder : public T
             signals->LogCritical(msg.str());
         }
 
+        dco_keys->Flush();
         device->EstablishDCO();
     }
 
@@ -558,10 +731,13 @@ class NetCfgTunBuilder : public T
     {
         if (!dco)
         {
-            NetCfgProxyException(__func__, "Lost link to DCO device");
+            throw NetCfgProxyException(__func__, "Lost link to DCO device");
         }
 
-        dco->SwapKeys(peer_id);
+        NetCfgProxy::DCO::KeyUpdate upd;
+        upd.peer_id = peer_id;
+        upd.swap_keys = true;
+        dco_keys->Queue(upd);
     }
 
 
@@ -571,10 +747,15 @@ class NetCfgTunBuilder : public T
     {
         if (!dco)
         {
-            NetCfgProxyException(__func__, "Lost link to DCO device");
+            throw NetCfgProxyException(__func__, "Lost link to DCO device");
         }
 
-        dco->SetPeer(peer_id, keepalive_interval, keepalive_timeout);
+        NetCfgProxy::DCO::KeyUpdate upd;
+        upd.peer_id = peer_id;
+        upd.set_keepalive = true;
+        upd.keepalive_interval = keepalive_interval;
+        upd.keepalive_timeout = keepalive_timeout;
+        dco_keys->Queue(upd);
     }
 #endif // ENABLE_OVPNDCO
 
@@ -582,9 +763,57 @@ class NetCfgTunBuilder : public T
   protected:
     bool disabled_dns_config;
     std::string dns_scope = "global";
+    std::string tun_qdisc{};
+    uint16_t tun_txqueuelen = 0;
+    ConnectTimeline::Ptr timeline = nullptr;
     BackendSignals::Ptr signals;
 
   private:
+    /**
+     *  Adds the phases recorded by the netcfg service while establishing
+     *  the device
+     */
+    void import_establish_timeline() noexcept
+    {
+        if (!timeline)
+        {
+            return;
+        }
+        try
+        {
+            GVariant *phases = device->GetEstablishTimeline();
+            timeline->Import(phases);
+            g_variant_unref(phases);
+        }
+        catch (const DBus::Exception &)
+        {
+            // An older netcfg service without this property
+        }
+    }
+
+
+    void set_queueing()
+    {
+        // Invalid values are reported, but do not stop the connection
+        try
+        {
+            if (!tun_qdisc.empty())
+            {
+                device->SetQdisc(tun_qdisc);
+            }
+            if (tun_txqueuelen > 0)
+            {
+                device->SetTxQueueLen(tun_txqueuelen);
+            }
+        }
+        catch (const DBus::Exception &excp)
+        {
+            signals->LogError("Failed setting tun device queueing: "
+                              + std::string(excp.GetRawError()));
+        }
+    }
+
+
     bool create_device()
     {
         if (device)
@@ -614,8 +843,10 @@ class NetCfgTunBuilder : public T
 
     std::vector<NetCfgProxy::Network> networks;
     NetCfgProxy::Device::Ptr device;
+    bool reconnect_prepared = false;
 #ifdef ENABLE_OVPNDCO
     NetCfgProxy::DCO::Ptr dco;
+    DcoKeyUpdateQueue::Ptr dco_keys = nullptr;
 #endif
     NetCfgProxy::Manager::Ptr netcfgmgr = nullptr;
     std::string session_token;
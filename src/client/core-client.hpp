@@ -22,6 +22,7 @@
 #include "build-config.h"
 
 #include <iostream>
+#include <map>
 #include <string>
 #include <thread>
 #include <mutex>
@@ -54,6 +55,7 @@
 #include "client/statistics.hpp"
 #include "common/core-extensions.hpp"
 #include "common/requiresqueue.hpp"
+#include "common/timeline.hpp"
 #include "backend-signals.hpp"
 
 #include "core-client-netcfg.hpp"
@@ -150,6 +152,9 @@ class DummyTunBuilder : public ClientAPI::OpenVPNClient
   protected:
     bool disabled_dns_config;
     std::string dns_scope = "global";
+    std::string tun_qdisc{};
+    uint16_t tun_txqueuelen = 0;
+    ConnectTimeline::Ptr timeline = nullptr;
 
 
   private:
@@ -207,6 +212,25 @@ class CoreVPNClient : public CLIENTBASECLASS
     }
 
 
+    void set_tun_queueing(const std::string &qdisc, const uint16_t txqueuelen)
+    {
+        tun_qdisc = qdisc;
+        tun_txqueuelen = txqueuelen;
+    }
+
+
+    /**
+     *  Records the phases of the connection, as reported by the core
+     *  library events, in the given time line
+     *
+     * @param tl  ConnectTimeline::Ptr to record the phases in
+     */
+    void set_connect_timeline(ConnectTimeline::Ptr tl)
+    {
+        timeline = tl;
+    }
+
+
     void disable_dns_config(bool val)
     {
         disabled_dns_config = val;
@@ -299,6 +323,59 @@ class CoreVPNClient : public CLIENTBASECLASS
     uint32_t auth_pending_timeout = 0;
     DevPosture::Proxy::Handler::Ptr devposture;
     std::string devposture_protocols;
+    std::string core_phase{};
+
+
+    /**
+     *  Updates the connect time line based on the core library events.
+     *  Each event starting a new phase ends the previous one; the
+     *  CONNECTED event also ends the "connect" phase started when the
+     *  Connect method was called.
+     *
+     * @param evname  std::string with the core library event name
+     */
+    void track_core_phase(const std::string &evname)
+    {
+        static const std::map<std::string, std::string> phases = {
+            {"RESOLVE", "core.resolve"},
+            {"WAIT", "core.transport"},
+            {"WAIT_PROXY", "core.transport"},
+            {"CONNECTING", "core.tls_auth"},
+            {"GET_CONFIG", "core.get_config"},
+            {"ASSIGN_IP", "core.tun_setup"}};
+
+        if (!timeline)
+        {
+            return;
+        }
+
+        auto next = phases.find(evname);
+        if (next != phases.end())
+        {
+            if (next->second == core_phase)
+            {
+                return;
+            }
+            if (!core_phase.empty())
+            {
+                timeline->End(core_phase);
+            }
+            core_phase = next->second;
+            timeline->Begin(core_phase);
+        }
+        else if ("CONNECTED" == evname
+                 || "DISCONNECTED" == evname
+                 || "AUTH_FAILED" == evname
+                 || "CONNECTION_TIMEOUT" == evname)
+        {
+            if (!core_phase.empty())
+            {
+                timeline->End(core_phase);
+                core_phase.clear();
+            }
+            timeline->End("connect");
+        }
+    }
 
 
     bool socket_protect(int socket, std::string remote, bool ipv6) override
@@ -323,6 +400,7 @@ class CoreVPNClient : public CLIENTBASECLASS
     void event(const ClientAPI::Event &ev) override
     {
         evntcount++;
+        track_core_phase(ev.name);
 
 #ifdef DEBUG_CORE_EVENTS
         std::stringstream entry;
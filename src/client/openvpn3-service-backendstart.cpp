@@ -259,7 +259,7 @@ class BackendStarterHandler : public DBus::Object::Base
             char **env = {0};
             if (client_envvars.size() > 0)
             {
-                env = (char **)std::calloc(client_envvars.size(), sizeof(char *));
+                env = (char **)std::calloc(client_envvars.size() + 1, sizeof(char *));
                 unsigned int idx = 0;
                 for (const auto &ev : client_envvars)
                 {
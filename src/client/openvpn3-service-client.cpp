@@ -44,6 +44,7 @@
 
 #include "common/machineid.hpp"
 #include "common/requiresqueue.hpp"
+#include "common/timeline.hpp"
 #include "common/utils.hpp"
 #include "common/cmdargparser.hpp"
 #include "common/platforminfo.hpp"
@@ -221,7 +222,8 @@ class BackendClientObject : public DBus::Object::Base
                                "UserInputQueueGetTypeGroup",
                                "UserInputQueueFetch",
                                "UserInputQueueCheck",
-                               "UserInputProvide");
+                               "UserInputProvide",
+                               "UserInputQueueFetchAll");
         auto cb_auth_pending = [this]()
         {
             if (this->vpnclient && this->userinputq
@@ -356,6 +358,12 @@ class BackendClientObject : public DBus::Object::Base
         };
         AddPropertyBySpec("last_log_line", "a{sv}", prop_last_log);
 
+        auto prop_connect_timeline = [this](const DBus::Object::Property::BySpec &prop)
+        {
+            return timeline->GetGVariant();
+        };
+        AddPropertyBySpec("connect_timeline", "a(sstt)", prop_connect_timeline);
+
         // Send the registration request to the session manager
         signal->RegistrationRequest(bus_name, session_token, getpid());
         signal->LogVerb1("Initializing VPN client session, token "
@@ -493,11 +501,14 @@ class BackendClientObject : public DBus::Object::Base
     bool disabled_socket_protect;
     std::string dns_scope = "global";
     bool ignore_dns_cfg{false};
+    std::string tun_qdisc{};
+    uint16_t tun_txqueuelen{0};
     std::shared_ptr<std::thread> client_thread{nullptr};
     ClientAPI::Config vpnconfig{};
     ClientAPI::EvalConfig cfgeval{};
     ClientAPI::ProvideCreds creds{};
     RequiresQueue::Ptr userinputq{nullptr};
+    ConnectTimeline::Ptr timeline = ConnectTimeline::Create("client");
     std::mutex connect_guard{};
     DBus::Object::Path session_path = "/__unknown";
     const std::vector<std::string> restricted_acl_prop_get{
@@ -505,7 +516,8 @@ class BackendClientObject : public DBus::Object::Base
         "net.openvpn.v3.backends.stats",
         "net.openvpn.v3.backends.device_name",
         "net.openvpn.v3.backends.session_name",
-        "net.openvpn.v3.backends.last_log_line"};
+        "net.openvpn.v3.backends.last_log_line",
+        "net.openvpn.v3.backends.connect_timeline"};
     const std::vector<std::string> restricted_acl_prop_set{
         "net.openvpn.v3.backends.log_level",
         "net.openvpn.v3.backends.dco"};
@@ -579,7 +591,9 @@ class BackendClientObject : public DBus::Object::Base
             // Fetch the configuration from the config-manager.
             // Since the configuration may be set up for single-use
             // only, we must keep this config as long as we're running
+            uint64_t start = ConnectTimeline::Now();
             std::string config_name = fetch_configuration();
+            timeline->Record("fetch_configuration", start, ConnectTimeline::Now());
             GVariant *ret = glib2::Value::CreateTupleWrapped(config_name);
 
             try
@@ -587,7 +601,9 @@ class BackendClientObject : public DBus::Object::Base
                 // Sets initial state, which also allows us to early
                 // report back back if more data is required to be
                 // sent by the front-end interface.
+                start = ConnectTimeline::Now();
                 initialize_client();
+                timeline->Record("initialize_client", start, ConnectTimeline::Now());
             }
             catch (ClientException &excp)
             {
@@ -685,7 +701,9 @@ class BackendClientObject : public DBus::Object::Base
 
         try
         {
+            uint64_t start = ConnectTimeline::Now();
             initialize_client();
+            timeline->Record("initialize_client", start, ConnectTimeline::Now());
         }
         catch (ClientException &excp)
         {
@@ -703,6 +721,7 @@ class BackendClientObject : public DBus::Object::Base
                                   "Required user input not provided");
         }
         signal->LogInfo("Starting connection");
+        timeline->Begin("connect");
         connect();
     }
 
@@ -989,6 +1008,8 @@ class BackendClientObject : public DBus::Object::Base
         vpnclient.reset(new CoreVPNClient(dbusconn, signal, userinputq, session_token, enterprise_id));
         vpnclient->disable_socket_protect(disabled_socket_protect);
         vpnclient->disable_dns_config(ignore_dns_cfg);
+        vpnclient->set_tun_queueing(tun_qdisc, tun_txqueuelen);
+        vpnclient->set_connect_timeline(timeline);
 
         vpnconfig.appCustomProtocols = vpnclient->DevicePostureProtocols();
 
@@ -1291,6 +1312,20 @@ class BackendClientObject : public DBus::Object::Base
                     valid_override = true;
                 }
             }
+            else if (override.override.key == "tun-qdisc")
+            {
+                tun_qdisc = override.strValue;
+                valid_override = true;
+            }
+            else if (override.override.key == "tun-txqueuelen")
+            {
+                int qlen = std::atoi(override.strValue.c_str());
+                if (qlen > 0 && qlen <= UINT16_MAX)
+                {
+                    tun_txqueuelen = static_cast<uint16_t>(qlen);
+                    valid_override = true;
+                }
+            }
             else if (override.override.key == "dns-sync-lookup")
             {
                 vpnconfig.synchronousDnsLookup = override.boolValue;
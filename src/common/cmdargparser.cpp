@@ -13,6 +13,7 @@
  */
 
 #include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -756,14 +757,27 @@ RegisterParsedArgs::Ptr SingleCommand::parse_commandline(const std::string &arg0
 
     RegisterParsedArgs::Ptr cmd_args;
     cmd_args = RegisterParsedArgs::Create(arg0);
+
+    // The same process may parse several command lines, like in the
+    // openvpn3 --batch mode, so getopt_long() is fully reinitialised by
+    // setting optind to 0.  It will then always start parsing at argv[1],
+    // so the arguments to skip are removed first.
+    std::vector<char *> parse_argv = {argv[0]};
+    for (int i = 1 + skip; i < argc; ++i)
+    {
+        parse_argv.push_back(argv[i]);
+    }
+    parse_argv.push_back(nullptr);
+    const int parse_argc = static_cast<int>(parse_argv.size()) - 1;
+
     int c;
-    optind = 1 + skip; // Skip argv[0] which contains this command name
+    optind = 0;
     try
     {
         while (1)
         {
             int optidx = 0;
-            c = getopt_long(argc, argv, shortopts.c_str(), long_opts, &optidx);
+            c = getopt_long(parse_argc, parse_argv.data(), shortopts.c_str(), long_opts, &optidx);
             if (-1 == c) // Are we done?
             {
                 break;
@@ -817,13 +831,13 @@ RegisterParsedArgs::Ptr SingleCommand::parse_commandline(const std::string &arg0
         }
 
         // If there are still arguments not parsed, gather them all.
-        if (optind < argc)
+        if (optind < parse_argc)
         {
             // All additional arguments gets saved for further
             // processing inside the function to be called
-            while (optind < argc)
+            while (optind < parse_argc)
             {
-                cmd_args->register_extra_args(argv[optind++]);
+                cmd_args->register_extra_args(parse_argv[optind++]);
             }
         }
         cmd_args->set_completed();
@@ -919,7 +933,15 @@ std::string SingleCommand::gen_help(const std::string arg0)
 
 void Commands::RegisterCommand(const SingleCommand::Ptr cmd)
 {
-    commands.push_back(cmd);
+    commands.push_back({cmd->GetCommand(), cmd->GetAliasCommand(), nullptr, cmd});
+}
+
+
+void Commands::RegisterCommand(const std::string &command,
+                               PrepareCommand prepare,
+                               const std::string &alias)
+{
+    commands.push_back({command, alias, std::move(prepare), nullptr});
 }
 
 
@@ -951,11 +973,15 @@ int Commands::ProcessCommandLine(int argc, char **argv)
 
     // Find the proper registered command and let that object
     // continue the command line parsing and run the callback function
-    for (auto &c : commands)
+    for (auto &entry : commands)
     {
         // If we found our command ...
-        if (c->CheckCommandName(cmd))
+        if (cmd == entry.command
+            || (!entry.alias.empty() && cmd == entry.alias))
         {
+            // Only the invoked command is prepared
+            SingleCommand::Ptr c = get_command(entry);
+
             // Copy over the arguments, skip argv[0] and build another one
             // instead.  Ideally, this should not be needed - but
             // getopt_long() needs it for its error reporting.  And
@@ -1010,7 +1036,30 @@ int Commands::ProcessCommandLine(int argc, char **argv)
 
 std::vector<SingleCommand::Ptr> Commands::GetAllCommandObjects()
 {
-    return commands;
+    std::vector<SingleCommand::Ptr> ret;
+    for (auto &entry : commands)
+    {
+        ret.push_back(get_command(entry));
+    }
+    return ret;
+}
+
+
+SingleCommand::Ptr Commands::get_command(CommandEntry &entry)
+{
+    if (!entry.cmd)
+    {
+        entry.cmd = entry.prepare();
+        if (!entry.cmd
+            || entry.cmd->GetCommand() != entry.command
+            || entry.cmd->GetAliasCommand() != entry.alias)
+        {
+            entry.cmd = nullptr;
+            throw CommandException(entry.command,
+                                   "Internal error: command registration mismatch");
+        }
+    }
+    return entry.cmd;
 }
 
 
@@ -1028,7 +1077,7 @@ void Commands::print_generic_help(std::string &arg0)
               << " - This help screen"
               << std::endl;
 
-    for (auto &cmd : commands)
+    for (auto &cmd : GetAllCommandObjects())
     {
         std::cout << "    " << cmd->GetCommandHelp(width);
     }
@@ -1039,3 +1088,76 @@ void Commands::print_generic_help(std::string &arg0)
               << std::endl;
     std::cout << std::endl;
 }
+
+
+
+std::vector<std::string> SplitCommandLine(const std::string &line)
+{
+    std::vector<std::string> ret;
+    std::string arg;
+    bool in_arg = false;
+    char quote = 0;
+
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+        const char c = line[i];
+        if ('\'' == quote)
+        {
+            if ('\'' == c)
+            {
+                quote = 0;
+            }
+            else
+            {
+                arg += c;
+            }
+        }
+        else if ('\\' == c && i + 1 < line.size()
+                 && (!quote || '"' == line[i + 1] || '\\' == line[i + 1]))
+        {
+            // Within double quotes, only \" and \\ are escapes
+            arg += line[++i];
+            in_arg = true;
+        }
+        else if ('"' == quote)
+        {
+            if ('"' == c)
+            {
+                quote = 0;
+            }
+            else
+            {
+                arg += c;
+            }
+        }
+        else if ('\'' == c || '"' == c)
+        {
+            quote = c;
+            in_arg = true;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            if (in_arg)
+            {
+                ret.push_back(arg);
+                arg.clear();
+                in_arg = false;
+            }
+        }
+        else
+        {
+            arg += c;
+            in_arg = true;
+        }
+    }
+
+    if (quote)
+    {
+        throw CommandArgBaseException("Unterminated quote in command line");
+    }
+    if (in_arg)
+    {
+        ret.push_back(arg);
+    }
+    return ret;
+}
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -942,6 +943,7 @@ class Commands
 {
   public:
     using Ptr = std::shared_ptr<Commands>;
+    using PrepareCommand = std::function<SingleCommand::Ptr()>;
 
     /**
      *  Instantiate the Commands container
@@ -956,7 +958,7 @@ class Commands
         // will automatically build up the 'shell-completion' command,
         // based on the commands and options being added.
         shellcompl = std::make_shared<ShellCompletion>();
-        commands.push_back(shellcompl);
+        RegisterCommand(shellcompl);
     }
 
 
@@ -970,6 +972,24 @@ class Commands
     void RegisterCommand(const SingleCommand::Ptr cmd);
 
 
+    /**
+     *  Register a new command which is only prepared when needed.  The
+     *  prepare function is only called if this command is invoked, or if
+     *  all commands are needed for the generic help screen or the shell
+     *  completion.  This avoids building the options of all the commands
+     *  on each program start.
+     *
+     * @param command  std::string with the command name, which must
+     *                 match the name of the prepared SingleCommand
+     * @param prepare  PrepareCommand function creating the SingleCommand
+     * @param alias    std::string with the alias of the command, if the
+     *                 prepared SingleCommand sets one
+     */
+    void RegisterCommand(const std::string &command,
+                         PrepareCommand prepare,
+                         const std::string &alias = {});
+
+
     /**
      *  Starts the command line processing, which will on success run
      *  the proper callback function according to the command being called.
@@ -1082,8 +1102,47 @@ class Commands
     void print_generic_help(std::string &arg0);
 
 
+    /**
+     *  A registered command, which may not be prepared yet
+     */
+    struct CommandEntry
+    {
+        std::string command;
+        std::string alias;
+        PrepareCommand prepare;
+        SingleCommand::Ptr cmd;
+    };
+
+    /**
+     *  Retrieve the SingleCommand object of a registered command,
+     *  preparing it if needed
+     *
+     * @param entry  CommandEntry of the command
+     * @return SingleCommand::Ptr
+     *
+     * @throws CommandException if the prepared command does not match
+     *         the registered command name
+     */
+    SingleCommand::Ptr get_command(CommandEntry &entry);
+
+
     const std::string progname;
     const std::string description;
-    std::vector<SingleCommand::Ptr> commands;
+    std::vector<CommandEntry> commands;
     ShellCompletion::Ptr shellcompl;
 }; // class Commands
+
+
+
+/**
+ *  Split a command line into separate arguments, like a POSIX shell
+ *  does without any expansions.  Arguments are separated by white space.
+ *  Single quotes preserves everything literally, double quotes and
+ *  backslash escapes prevents the white space from separating arguments.
+ *
+ * @param line  std::string with the command line to split
+ * @return std::vector<std::string> with the arguments
+ *
+ * @throws CommandArgBaseException on unterminated quotes
+ */
+std::vector<std::string> SplitCommandLine(const std::string &line);
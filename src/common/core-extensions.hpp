@@ -278,7 +278,7 @@ class OptionListJSON : public openvpn::OptionList
     }
 
 
-    std::string string_export()
+    std::string string_export() const
     {
         std::stringstream cfgstr;
 
@@ -95,7 +95,7 @@ void RequiresQueue::Callbacks::RunCallback(const CallbackType type) const
  */
 
 RequiresQueue::RequiresQueue()
-    : reqids()
+    : reqids(), reqids_order()
 {
 }
 
@@ -109,7 +109,8 @@ void RequiresQueue::QueueSetup(DBus::Object::Base *object_ptr,
                                const std::string &meth_qchktypegr,
                                const std::string &meth_queuefetch,
                                const std::string &meth_queuechk,
-                               const std::string &meth_provideresp)
+                               const std::string &meth_provideresp,
+                               const std::string &meth_fetchall)
 {
     if (!object_ptr)
     {
@@ -161,6 +162,17 @@ void RequiresQueue::QueueSetup(DBus::Object::Base *object_ptr,
     prov_resp->AddInput("group", glib2::DataType::DBus<ClientAttentionGroup>());
     prov_resp->AddInput("id", glib2::DataType::DBus<uint32_t>());
     prov_resp->AddInput("value", glib2::DataType::DBus<std::string>());
+
+    if (!meth_fetchall.empty())
+    {
+        auto fetch_all = object_ptr->AddMethod(meth_fetchall,
+                                               [this](DBus::Object::Method::Arguments::Ptr args)
+                                               {
+                                                   auto r = this->QueueFetchAllGVariant();
+                                                   args->SetMethodReturn(r);
+                                               });
+        fetch_all->AddOutput("slots", "a(uuussb)");
+    }
 }
 
 
@@ -173,6 +185,8 @@ void RequiresQueue::AddCallback(const CallbackType type, Callbacks::CBFunction f
 void RequiresQueue::ClearAll() noexcept
 {
     reqids.clear();
+    reqids_order.clear();
+    pending_total = 0;
     slots.clear();
     try
     {
@@ -193,17 +207,32 @@ uint32_t RequiresQueue::RequireAdd(ClientAttentionType type,
                                    std::string descr,
                                    bool hidden_input)
 {
+    const uint32_t key = get_reqid_index(type, group);
+    auto [it, added] = reqids.try_emplace(key);
+    TypeGroupIndex &idx = it->second;
+    if (added)
+    {
+        idx.type = type;
+        idx.group = group;
+        reqids_order.push_back(key);
+    }
+
     struct RequiresSlot elmt;
-    elmt.id = reqids[get_reqid_index(type, group)]++;
+    elmt.id = static_cast<uint32_t>(idx.slot_pos.size());
     elmt.type = type;
     elmt.group = group;
     elmt.name = name;
     elmt.user_description = descr;
     elmt.provided = false;
     elmt.hidden_input = hidden_input;
-    slots.push_back(elmt);
 
-    return elmt.id;
+    idx.slot_pos.push_back(slots.size());
+    idx.names.emplace(name, slots.size()); // The first slot wins on duplicates
+    ++idx.pending;
+    ++pending_total;
+    slots.push_back(std::move(elmt));
+
+    return slots.back().id;
 }
 
 
@@ -215,33 +244,71 @@ GVariant *RequiresQueue::QueueFetchGVariant(GVariant *parameters) const
     uint32_t id = glib2::Value::Extract<uint32_t>(parameters, 2);
 
     // Fetch the requested slot id
-    for (auto &e : slots)
+    size_t pos = find_slot(type, group, id);
+    if (SLOT_NOT_FOUND == pos)
     {
-        if (id == e.id)
+        throw RequiresQueueException("net.openvpn.v3.element-not-found",
+                                     "No requires queue element found");
+    }
+
+    const RequiresSlot &e = slots[pos];
+    if (e.provided)
+    {
+        throw RequiresQueueException("net.openvpn.v3.already-provided",
+                                     "User input already provided");
+    }
+
+    GVariant *elmt = g_variant_new("(uuussb)",
+                                   e.type,
+                                   e.group,
+                                   e.id,
+                                   e.name.c_str(),
+                                   e.user_description.c_str(),
+                                   e.hidden_input);
+    callbacks.RunCallback(CallbackType::QUEUE_FETCH);
+    return elmt;
+}
+
+
+std::vector<RequiresSlot> RequiresQueue::QueueFetchAll() const
+{
+    std::vector<RequiresSlot> ret;
+    ret.reserve(pending_total);
+    for (const auto &key : reqids_order)
+    {
+        const TypeGroupIndex &idx = reqids.at(key);
+        if (0 == idx.pending)
+        {
+            continue;
+        }
+        for (const auto &pos : idx.slot_pos)
         {
-            if (e.type == type
-                && e.group == group)
+            if (!slots[pos].provided)
             {
-                if (e.provided)
-                {
-                    throw RequiresQueueException("net.openvpn.v3.already-provided",
-                                                 "User input already provided");
-                }
-
-                GVariant *elmt = g_variant_new("(uuussb)",
-                                               e.type,
-                                               e.group,
-                                               e.id,
-                                               e.name.c_str(),
-                                               e.user_description.c_str(),
-                                               e.hidden_input);
-                callbacks.RunCallback(CallbackType::QUEUE_FETCH);
-                return elmt;
+                ret.push_back(slots[pos]);
             }
         }
     }
-    throw RequiresQueueException("net.openvpn.v3.element-not-found",
-                                 "No requires queue element found");
+    return ret;
+}
+
+
+GVariant *RequiresQueue::QueueFetchAllGVariant() const
+{
+    GVariantBuilder *bld = glib2::Builder::Create("a(uuussb)");
+    for (const auto &e : QueueFetchAll())
+    {
+        glib2::Builder::Add(bld,
+                            g_variant_new("(uuussb)",
+                                          e.type,
+                                          e.group,
+                                          e.id,
+                                          e.name.c_str(),
+                                          e.user_description.c_str(),
+                                          e.hidden_input));
+    }
+    callbacks.RunCallback(CallbackType::QUEUE_FETCH);
+    return glib2::Builder::FinishWrapped(bld);
 }
 
 
@@ -255,30 +322,26 @@ void RequiresQueue::UpdateEntry(ClientAttentionType type,
         throw RequiresQueueException("User input not required");
     }
 
-    for (auto &e : slots)
+    size_t pos = find_slot(type, group, id);
+    if (SLOT_NOT_FOUND == pos)
     {
-        if (e.type == type
-            && e.group == group
-            && e.id == id)
-        {
-            if (!e.provided)
-            {
-                e.provided = true;
-                e.value = newvalue;
+        throw RequiresQueueException("net.openvpn.v3.invalid-input",
+                                     "No matching entry found in the request queue");
+    }
 
-                callbacks.RunCallback(CallbackType::PROVIDE_RESPONSE);
-                return;
-            }
-            else
-            {
-                throw RequiresQueueException("net.openvpn.v3.error.input-already-provided",
-                                             "Request ID " + std::to_string(id)
-                                                 + " has already been provided");
-            }
-        }
+    RequiresSlot &e = slots[pos];
+    if (e.provided)
+    {
+        throw RequiresQueueException("net.openvpn.v3.error.input-already-provided",
+                                     "Request ID " + std::to_string(id)
+                                         + " has already been provided");
     }
-    throw RequiresQueueException("net.openvpn.v3.invalid-input",
-                                 "No matching entry found in the request queue");
+    e.provided = true;
+    e.value = newvalue;
+    --reqids[get_reqid_index(type, group)].pending;
+    --pending_total;
+
+    callbacks.RunCallback(CallbackType::PROVIDE_RESPONSE);
 }
 
 
@@ -309,16 +372,20 @@ void RequiresQueue::ResetValue(ClientAttentionType type,
                                ClientAttentionGroup group,
                                uint32_t id)
 {
-    for (auto &e : slots)
+    size_t pos = find_slot(type, group, id);
+    if (SLOT_NOT_FOUND == pos)
     {
-        if (e.type == type && e.group == group && e.id == id)
-        {
-            e.provided = false;
-            e.value = "";
-            return;
-        }
+        throw RequiresQueueException("No matching entry found in the request queue");
     }
-    throw RequiresQueueException("No matching entry found in the request queue");
+
+    RequiresSlot &e = slots[pos];
+    if (e.provided)
+    {
+        ++reqids[get_reqid_index(type, group)].pending;
+        ++pending_total;
+    }
+    e.provided = false;
+    e.value = "";
 }
 
 
@@ -326,18 +393,16 @@ const std::string RequiresQueue::GetResponse(ClientAttentionType type,
                                              ClientAttentionGroup group,
                                              uint32_t id) const
 {
-    for (auto &e : slots)
+    size_t pos = find_slot(type, group, id);
+    if (SLOT_NOT_FOUND == pos)
     {
-        if (e.type == type && e.group == group && e.id == id)
-        {
-            if (!e.provided)
-            {
-                throw RequiresQueueException("Request never provided by front-end");
-            }
-            return e.value;
-        }
+        throw RequiresQueueException("No matching entry found in the request queue");
     }
-    throw RequiresQueueException("No matching entry found in the request queue");
+    if (!slots[pos].provided)
+    {
+        throw RequiresQueueException("Request never provided by front-end");
+    }
+    return slots[pos].value;
 }
 
 
@@ -345,33 +410,26 @@ const std::string RequiresQueue::GetResponse(ClientAttentionType type,
                                              ClientAttentionGroup group,
                                              const std::string &name) const
 {
-    for (auto &e : slots)
+    const TypeGroupIndex *idx = find_index(type, group);
+    if (!idx || 0 == idx->names.count(name))
     {
-        if (e.type == type && e.group == group && e.name == name)
-        {
-            if (!e.provided)
-            {
-                throw RequiresQueueException("Request never provided by front-end");
-            }
-            return e.value;
-        }
+        throw RequiresQueueException("No matching entry found in the request queue");
     }
-    throw RequiresQueueException("No matching entry found in the request queue");
+
+    const RequiresSlot &e = slots[idx->names.at(name)];
+    if (!e.provided)
+    {
+        throw RequiresQueueException("Request never provided by front-end");
+    }
+    return e.value;
 }
 
 
 uint32_t RequiresQueue::QueueCount(ClientAttentionType type,
                                    ClientAttentionGroup group) const noexcept
 {
-    uint32_t ret = 0;
-    for (auto &e : slots)
-    {
-        if (type == e.type && group == e.group)
-        {
-            ret++;
-        }
-    }
-    return ret;
+    const TypeGroupIndex *idx = find_index(type, group);
+    return (idx ? static_cast<uint32_t>(idx->slot_pos.size()) : 0);
 }
 
 
@@ -379,28 +437,12 @@ std::vector<RequiresQueue::ClientAttTypeGroup> RequiresQueue::QueueCheckTypeGrou
 {
     std::vector<RequiresQueue::ClientAttTypeGroup> ret;
 
-    for (auto &e : slots)
+    for (const auto &key : reqids_order)
     {
-        if (!e.provided)
+        const TypeGroupIndex &idx = reqids.at(key);
+        if (idx.pending > 0)
         {
-            // Check if we've already spotted this type/group
-            bool found = false;
-            for (auto &r : ret)
-            {
-                ClientAttentionType t;
-                ClientAttentionGroup g;
-                std::tie(t, g) = r;
-                if (t == e.type && g == e.group)
-                {
-                    // yes, we have
-                    found = true;
-                    break;
-                }
-            }
-            if (!found)
-            {
-                ret.push_back(std::make_tuple(e.type, e.group));
-            }
+            ret.push_back(std::make_tuple(idx.type, idx.group));
         }
     }
     callbacks.RunCallback(CallbackType::CHECK_TYPE_GROUP);
@@ -434,13 +476,16 @@ std::vector<uint32_t> RequiresQueue::QueueCheck(ClientAttentionType type,
                                                 ClientAttentionGroup group) const noexcept
 {
     std::vector<uint32_t> ret;
-    for (auto &e : slots)
+    const TypeGroupIndex *idx = find_index(type, group);
+    if (idx && idx->pending > 0)
     {
-        if (type == e.type
-            && group == e.group
-            && !e.provided)
+        ret.reserve(idx->pending);
+        for (const auto &pos : idx->slot_pos)
         {
-            ret.push_back(e.id);
+            if (!slots[pos].provided)
+            {
+                ret.push_back(slots[pos].id);
+            }
         }
     }
     callbacks.RunCallback(CallbackType::QUEUE_CHECK);
@@ -464,20 +509,14 @@ GVariant *RequiresQueue::QueueCheckGVariant(GVariant *parameters) const noexcept
 
 bool RequiresQueue::QueueAllDone() const noexcept
 {
-    for (auto &e : slots)
-    {
-        if (!e.provided)
-        {
-            return false;
-        }
-    }
-    return true;
+    return 0 == pending_total;
 }
 
 
 bool RequiresQueue::QueueDone(ClientAttentionType type, ClientAttentionGroup group)
 {
-    return QueueCheck(type, group).size() == 0;
+    const TypeGroupIndex *idx = find_index(type, group);
+    return !idx || 0 == idx->pending;
 }
 
 
@@ -489,5 +528,26 @@ bool RequiresQueue::QueueDone(GVariant *parameters)
     ClientAttentionGroup group = glib2::Value::Extract<ClientAttentionGroup>(parameters, 1);
 
     // Check if there are any elements needing attentions in that slot ID
-    return QueueCheck(type, group).size() == 0;
+    return QueueDone(type, group);
+}
+
+
+size_t RequiresQueue::find_slot(ClientAttentionType type,
+                                ClientAttentionGroup group,
+                                uint32_t id) const noexcept
+{
+    const TypeGroupIndex *idx = find_index(type, group);
+    if (!idx || id >= idx->slot_pos.size())
+    {
+        return SLOT_NOT_FOUND;
+    }
+    return idx->slot_pos[id];
+}
+
+
+const RequiresQueue::TypeGroupIndex *RequiresQueue::find_index(ClientAttentionType type,
+                                                               ClientAttentionGroup group) const noexcept
+{
+    auto it = reqids.find(get_reqid_index(type, group));
+    return (reqids.end() != it ? &it->second : nullptr);
 }
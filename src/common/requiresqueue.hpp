@@ -18,7 +18,9 @@
  */
 
 #pragma once
+#include <cstdint>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <glib.h>
 #include <gio/gio.h>
@@ -142,12 +144,16 @@ class RequiresQueue
      *                           unprocessed queued items
      * @param meth_provideresp   Method name for providing the user's
      *                           respose to a queued item.
+     * @param meth_fetchall      Method name for fetching all unprocessed
+     *                           queued items in a single call.  If empty,
+     *                           this method is not added.
      */
     void QueueSetup(DBus::Object::Base *object_ptr,
                     const std::string &meth_qchktypegr,
                     const std::string &meth_queuefetch,
                     const std::string &meth_queuechk,
-                    const std::string &meth_provideresp);
+                    const std::string &meth_provideresp,
+                    const std::string &meth_fetchall = "");
 
 
     /**
@@ -209,6 +215,26 @@ class RequiresQueue
      **/
     GVariant *QueueFetchGVariant(GVariant *parameters) const;
 
+    /**
+     *  Retrieve all the require slots which have not yet received any
+     *  user responses, across all request types and groups.  The slots
+     *  are ordered by type and group, in the order they were added.
+     *
+     * @return std::vector<RequiresSlot> of all unresolved slots
+     */
+    std::vector<RequiresSlot> QueueFetchAll() const;
+
+    /**
+     *  A GVariant version of QueueFetchAll().  This gives a front-end
+     *  all the information QueueCheckTypeGroup(), QueueCheck() and
+     *  QueueFetch() would provide, in a single D-Bus call.
+     *
+     * @return GVariant container object with the '(a(uuussb))' data
+     *         type.  Each element carries the same information as the
+     *         QueueFetchGVariant() result.
+     */
+    GVariant *QueueFetchAllGVariant() const;
+
     /**
      *  Updates the value for a RequiresSlot item
      *
@@ -397,8 +423,34 @@ class RequiresQueue
     bool QueueDone(GVariant *parameters);
 
   protected:
-    ///< Index counter map for type:group pairs; see get_reqid_index() for details
-    std::map<uint32_t, uint32_t> reqids;
+    /**
+     *  Lookup index of all the slots of a single type:group pair.  The
+     *  slot IDs are assigned sequentially per type:group, starting at 0,
+     *  so the slot ID is the position in the slot_pos vector.
+     */
+    struct TypeGroupIndex
+    {
+        ClientAttentionType type = ClientAttentionType::UNSET;
+        ClientAttentionGroup group = ClientAttentionGroup::UNSET;
+
+        ///< Position in the slots vector, indexed by slot ID
+        std::vector<size_t> slot_pos{};
+
+        ///< Slot variable name to the position in the slots vector
+        std::unordered_map<std::string, size_t> names{};
+
+        ///< Number of slots not yet provided by the front-end
+        uint32_t pending = 0;
+    };
+
+    ///< Index for type:group pairs; see get_reqid_index() for details
+    std::unordered_map<uint32_t, TypeGroupIndex> reqids;
+
+    ///< Keys to reqids, in the order the type:group pairs were added
+    std::vector<uint32_t> reqids_order;
+
+    ///< Number of slots across all type:groups not yet provided
+    uint32_t pending_total = 0;
 
     ///< All gathered requests needed to be satisfied
     std::vector<struct RequiresSlot> slots;
@@ -414,11 +466,36 @@ class RequiresQueue
      * @return  Returns a unique index based on the two input arguments
      */
     uint32_t get_reqid_index(ClientAttentionType type,
-                             ClientAttentionGroup group)
+                             ClientAttentionGroup group) const noexcept
     {
         return ((uint32_t)type * 100) + (uint32_t)group;
     }
 
+    ///< Returned by find_slot() if the slot was not found
+    static constexpr size_t SLOT_NOT_FOUND = SIZE_MAX;
+
+    /**
+     *  Look up a require slot by its type, group and ID
+     *
+     * @param type   ClientAttentionType of the slot
+     * @param group  ClientAttentionGroup of the slot
+     * @param id     Slot ID within the type:group
+     *
+     * @return Position of the slot in the slots vector or SLOT_NOT_FOUND
+     */
+    size_t find_slot(ClientAttentionType type,
+                     ClientAttentionGroup group,
+                     uint32_t id) const noexcept;
+
+    /**
+     *  Look up the index of a type:group pair
+     *
+     * @return Pointer to the TypeGroupIndex or nullptr if no slots of
+     *         this type:group have been added
+     */
+    const TypeGroupIndex *find_index(ClientAttentionType type,
+                                     ClientAttentionGroup group) const noexcept;
+
 
     RequiresQueue();
 
@@ -0,0 +1,255 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   timeline.cpp
+ *
+ * @brief  Implementation of ConnectTimeline
+ */
+
+#include <algorithm>
+#include <map>
+#include <time.h>
+#include <json/json.h>
+#include <gdbuspp/glib2/utils.hpp>
+
+#include "timeline.hpp"
+
+
+ConnectTimeline::Ptr ConnectTimeline::Create(const std::string &source)
+{
+    return ConnectTimeline::Ptr(new ConnectTimeline(source));
+}
+
+
+ConnectTimeline::ConnectTimeline(const std::string &source_)
+    : source(source_)
+{
+}
+
+
+uint64_t ConnectTimeline::Now() noexcept
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000
+           + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+
+void ConnectTimeline::Begin(const std::string &name)
+{
+    add_phase(Phase{name, source, Now(), 0});
+}
+
+
+void ConnectTimeline::End(const std::string &name)
+{
+    const uint64_t now = Now();
+    std::lock_guard<std::mutex> guard(mtx);
+    for (auto it = phases.rbegin(); it != phases.rend(); ++it)
+    {
+        if (it->name == name && it->source == source && 0 == it->end_usec)
+        {
+            it->end_usec = std::max(now, it->start_usec);
+            return;
+        }
+    }
+}
+
+
+void ConnectTimeline::Record(const std::string &name,
+                             const uint64_t start_usec,
+                             const uint64_t end_usec)
+{
+    add_phase(Phase{name, source, start_usec, std::max(start_usec, end_usec)});
+}
+
+
+void ConnectTimeline::Import(GVariant *data)
+{
+    for (auto &phase : Parse(data))
+    {
+        add_phase(std::move(phase));
+    }
+}
+
+
+void ConnectTimeline::Clear() noexcept
+{
+    std::lock_guard<std::mutex> guard(mtx);
+    phases.clear();
+}
+
+
+/**
+ *  Sort phases by their start time, keeping the order of phases
+ *  started at the same time
+ */
+static void sort_phases(ConnectTimeline::PhaseList &phases)
+{
+    std::stable_sort(phases.begin(),
+                     phases.end(),
+                     [](const ConnectTimeline::Phase &a, const ConnectTimeline::Phase &b)
+                     {
+                         return a.start_usec < b.start_usec;
+                     });
+}
+
+
+ConnectTimeline::PhaseList ConnectTimeline::GetPhases() const
+{
+    PhaseList ret;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        ret = phases;
+    }
+    sort_phases(ret);
+    return ret;
+}
+
+
+GVariant *ConnectTimeline::GetGVariant() const
+{
+    return Serialize(GetPhases());
+}
+
+
+GVariant *ConnectTimeline::Serialize(PhaseList phases)
+{
+    sort_phases(phases);
+    GVariantBuilder *b = glib2::Builder::Create("a(sstt)");
+    for (const auto &p : phases)
+    {
+        g_variant_builder_add(b,
+                              "(sstt)",
+                              p.name.c_str(),
+                              p.source.c_str(),
+                              static_cast<guint64>(p.start_usec),
+                              static_cast<guint64>(p.end_usec));
+    }
+    return glib2::Builder::Finish(b);
+}
+
+
+ConnectTimeline::PhaseList ConnectTimeline::Parse(GVariant *data)
+{
+    PhaseList ret;
+    if (!data || !g_variant_is_of_type(data, G_VARIANT_TYPE("a(sstt)")))
+    {
+        return ret;
+    }
+
+    GVariantIter *iter = nullptr;
+    g_variant_get(data, "a(sstt)", &iter);
+    gchar *name = nullptr;
+    gchar *src = nullptr;
+    guint64 start = 0;
+    guint64 end = 0;
+    while (g_variant_iter_next(iter, "(sstt)", &name, &src, &start, &end))
+    {
+        ret.push_back(Phase{name, src, start, end});
+        g_free(name);
+        g_free(src);
+    }
+    g_variant_iter_free(iter);
+    return ret;
+}
+
+
+std::string ConnectTimeline::ChromeTrace(const PhaseList &phases,
+                                         const std::string &trace_id)
+{
+    uint64_t first = UINT64_MAX;
+    for (const auto &p : phases)
+    {
+        first = std::min(first, p.start_usec);
+    }
+
+    Json::Value events(Json::arrayValue);
+    std::map<std::string, unsigned int> pids;
+    for (const auto &p : phases)
+    {
+        auto [it, added] = pids.emplace(p.source, pids.size() + 1);
+        if (added)
+        {
+            Json::Value meta;
+            meta["name"] = "process_name";
+            meta["ph"] = "M";
+            meta["pid"] = it->second;
+            meta["args"]["name"] = p.source;
+            events.append(meta);
+        }
+
+        Json::Value ev;
+        ev["name"] = p.name;
+        ev["cat"] = "connect";
+        ev["pid"] = it->second;
+        ev["tid"] = 1;
+        ev["ts"] = static_cast<Json::UInt64>(p.start_usec - first);
+        if (p.end_usec > 0)
+        {
+            ev["ph"] = "X";
+            ev["dur"] = static_cast<Json::UInt64>(p.end_usec - p.start_usec);
+        }
+        else
+        {
+            // Not completed; shown as a single point in time
+            ev["ph"] = "i";
+            ev["s"] = "p";
+        }
+        events.append(ev);
+    }
+
+    Json::Value trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    trace["otherData"]["trace_id"] = trace_id;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    return Json::writeString(builder, trace) + "\n";
+}
+
+
+ConnectTimeline::Scope::Scope(ConnectTimeline::Ptr timeline_,
+                              const std::string &name_)
+    : timeline(timeline_), name(name_)
+{
+    if (timeline)
+    {
+        timeline->Begin(name);
+    }
+}
+
+
+ConnectTimeline::Scope::~Scope() noexcept
+{
+    try
+    {
+        if (timeline)
+        {
+            timeline->End(name);
+        }
+    }
+    catch (...)
+    {
+        // Losing the end time of a phase is not critical
+    }
+}
+
+
+void ConnectTimeline::add_phase(Phase &&phase)
+{
+    std::lock_guard<std::mutex> guard(mtx);
+    if (phases.size() >= MAX_PHASES)
+    {
+        phases.erase(phases.begin());
+    }
+    phases.push_back(std::move(phase));
+}
@@ -0,0 +1,187 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   timeline.hpp
+ *
+ * @brief  Records how long each phase of establishing a VPN session
+ *         takes, across all the services involved
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glib.h>
+
+
+/**
+ *  Keeps the start and end time of each phase of a VPN connection
+ *  handled by one service.  The timestamps are microseconds of the
+ *  CLOCK_MONOTONIC clock, which is the same for all the processes on
+ *  the host.  This way the phases recorded by the session manager, the
+ *  backend client and the netcfg service can be put on a single time
+ *  line.
+ *
+ *  The phases are passed between the services as a GVariant array of
+ *  (name, source, start_usec, end_usec) tuples, using the 'a(sstt)'
+ *  D-Bus data type.  A phase which has not ended yet has end_usec
+ *  set to 0.
+ */
+class ConnectTimeline
+{
+  public:
+    using Ptr = std::shared_ptr<ConnectTimeline>;
+
+    struct Phase
+    {
+        std::string name;
+        std::string source;
+        uint64_t start_usec = 0;
+        uint64_t end_usec = 0;
+    };
+    using PhaseList = std::vector<Phase>;
+
+    /**
+     *  Maximum number of phases kept.  Older phases are removed first.
+     */
+    static constexpr size_t MAX_PHASES = 256;
+
+
+    /**
+     *  Create a new timeline for phases recorded by a service
+     *
+     * @param source  std::string with the name of the service recording
+     *                the phases, like "sessionmgr" or "client"
+     * @return ConnectTimeline::Ptr
+     */
+    [[nodiscard]] static ConnectTimeline::Ptr Create(const std::string &source);
+
+    /**
+     *  Retrieve the current time of the clock used by the timeline
+     *
+     * @return uint64_t with the CLOCK_MONOTONIC time in microseconds
+     */
+    static uint64_t Now() noexcept;
+
+
+    /**
+     *  Start a new phase
+     *
+     * @param name  std::string with the name of the phase
+     */
+    void Begin(const std::string &name);
+
+    /**
+     *  End the most recently started phase with the given name.  If
+     *  no such phase is running, nothing happens.
+     *
+     * @param name  std::string with the name of the phase
+     */
+    void End(const std::string &name);
+
+    /**
+     *  Add a phase which has already completed
+     *
+     * @param name        std::string with the name of the phase
+     * @param start_usec  uint64_t with the start time, from Now()
+     * @param end_usec    uint64_t with the end time, from Now()
+     */
+    void Record(const std::string &name,
+                const uint64_t start_usec,
+                const uint64_t end_usec);
+
+    /**
+     *  Add the phases recorded by another service, typically retrieved
+     *  via D-Bus.  The source of the imported phases is kept.
+     *
+     * @param phases  GVariant object with the 'a(sstt)' data type
+     */
+    void Import(GVariant *phases);
+
+    /**
+     *  Remove all the recorded phases
+     */
+    void Clear() noexcept;
+
+    /**
+     *  Retrieve all the recorded phases, ordered by start time
+     *
+     * @return ConnectTimeline::PhaseList
+     */
+    PhaseList GetPhases() const;
+
+    /**
+     *  Retrieve all the recorded phases as a GVariant object
+     *
+     * @return GVariant object with the 'a(sstt)' data type
+     */
+    GVariant *GetGVariant() const;
+
+
+    /**
+     *  Parse the phases of a GVariant object from GetGVariant()
+     *
+     * @param phases  GVariant object with the 'a(sstt)' data type
+     * @return ConnectTimeline::PhaseList
+     */
+    static PhaseList Parse(GVariant *phases);
+
+    /**
+     *  Create a GVariant object of a list of phases, ordered by start
+     *  time.  Used to combine the phases of several services.
+     *
+     * @param phases  ConnectTimeline::PhaseList to serialize
+     * @return GVariant object with the 'a(sstt)' data type
+     */
+    static GVariant *Serialize(PhaseList phases);
+
+    /**
+     *  Format the phases in the Chrome trace event format, which can
+     *  be loaded by chrome://tracing, Perfetto and similar tools.  Each
+     *  service (source) is shown as a separate process.  The timestamps
+     *  are relative to the start of the first phase.
+     *
+     * @param phases    ConnectTimeline::PhaseList to format
+     * @param trace_id  std::string identifying the traced session
+     * @return std::string with the JSON document
+     */
+    static std::string ChromeTrace(const PhaseList &phases,
+                                   const std::string &trace_id);
+
+
+    /**
+     *  Begins a phase when created and ends it when destroyed, so the
+     *  phase is also ended if the timed operation throws an exception
+     */
+    class Scope
+    {
+      public:
+        Scope(ConnectTimeline::Ptr timeline, const std::string &name);
+        ~Scope() noexcept;
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        ConnectTimeline::Ptr timeline;
+        const std::string name;
+    };
+
+
+  private:
+    const std::string source;
+    mutable std::mutex mtx{};
+    PhaseList phases{};
+
+    ConnectTimeline(const std::string &source);
+    void add_phase(Phase &&phase);
+};
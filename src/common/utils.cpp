@@ -167,11 +167,12 @@ int stop_handler(void *loop)
  *  is used to mask password input.
  *
  * @param echo  Boolean, if true the console input will be echoed to console
+ * @param fd    File descriptor of the terminal, stdin by default
  */
-void set_console_echo(bool echo)
+void set_console_echo(bool echo, int fd)
 {
     struct termios console;
-    tcgetattr(STDIN_FILENO, &console);
+    tcgetattr(fd, &console);
     if (echo)
     {
         console.c_lflag |= ECHO;
@@ -180,7 +181,7 @@ void set_console_echo(bool echo)
     {
         console.c_lflag &= ~ECHO;
     }
-    tcsetattr(STDIN_FILENO, TCSANOW, &console);
+    tcsetattr(fd, TCSANOW, &console);
 }
 
 
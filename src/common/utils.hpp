@@ -30,7 +30,7 @@ void drop_root();
 std::string get_version(std::string component);
 const std::string get_guiversion();
 int stop_handler(void *loop);
-void set_console_echo(bool echo);
+void set_console_echo(bool echo, int fd = 0);
 
 static inline std::string simple_basename(const std::string filename)
 {
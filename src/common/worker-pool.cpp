@@ -0,0 +1,170 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   worker-pool.cpp
+ *
+ * @brief  Implementation of the WorkerPool
+ */
+
+#include <algorithm>
+#include <glib.h>
+
+#include "worker-pool.hpp"
+
+
+WorkerPool::Ptr WorkerPool::Create(const unsigned int threads,
+                                   const size_t max_queue)
+{
+    return WorkerPool::Ptr(new WorkerPool(threads, max_queue));
+}
+
+
+WorkerPool::WorkerPool(const unsigned int threads, const size_t max_q)
+    : max_queue(max_q)
+{
+    if (0 == threads)
+    {
+        throw WorkerPoolException("At least one worker thread is required");
+    }
+
+    stats.threads = threads;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([this]()
+                             {
+                                 worker_thread();
+                             });
+    }
+}
+
+
+WorkerPool::~WorkerPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        running = false;
+    }
+    queue_cv.notify_all();
+
+    for (auto &w : workers)
+    {
+        if (w.joinable())
+        {
+            w.join();
+        }
+    }
+}
+
+
+std::future<void> WorkerPool::Submit(std::function<void()> task)
+{
+    Task t{std::packaged_task<void()>(std::move(task)), clock::now()};
+    std::future<void> result = t.fn.get_future();
+
+    {
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        if (!running)
+        {
+            throw WorkerPoolException("Worker pool is shutting down");
+        }
+        if (queue.size() >= max_queue)
+        {
+            ++stats.rejected;
+            throw WorkerPoolException("Worker pool queue is full");
+        }
+        queue.push_back(std::move(t));
+        stats.queue_depth_max = std::max<uint64_t>(stats.queue_depth_max,
+                                                   queue.size());
+    }
+    queue_cv.notify_one();
+    return result;
+}
+
+
+void WorkerPool::RunLimited(std::function<void()> task)
+{
+    Submit(std::move(task)).get();
+}
+
+
+WorkerPool::Statistics WorkerPool::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(queue_mtx);
+    Statistics ret = stats;
+    ret.queue_depth = queue.size();
+    if (stats.executed > 0)
+    {
+        ret.wait_avg_usec = wait_total_usec / stats.executed;
+        ret.exec_avg_usec = exec_total_usec / stats.executed;
+    }
+    return ret;
+}
+
+
+GVariant *WorkerPool::StatisticsGVariant(const WorkerPool::Ptr pool)
+{
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{st}"));
+    if (pool)
+    {
+        auto s = pool->GetStatistics();
+        g_variant_builder_add(b, "{st}", "threads", s.threads);
+        g_variant_builder_add(b, "{st}", "queue_depth", s.queue_depth);
+        g_variant_builder_add(b, "{st}", "queue_depth_max", s.queue_depth_max);
+        g_variant_builder_add(b, "{st}", "executed", s.executed);
+        g_variant_builder_add(b, "{st}", "rejected", s.rejected);
+        g_variant_builder_add(b, "{st}", "wait_avg_usec", s.wait_avg_usec);
+        g_variant_builder_add(b, "{st}", "wait_max_usec", s.wait_max_usec);
+        g_variant_builder_add(b, "{st}", "exec_avg_usec", s.exec_avg_usec);
+        g_variant_builder_add(b, "{st}", "exec_max_usec", s.exec_max_usec);
+    }
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
+
+
+void WorkerPool::worker_thread()
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mtx);
+            queue_cv.wait(lock,
+                          [this]()
+                          {
+                              return !running || !queue.empty();
+                          });
+            if (queue.empty())
+            {
+                // Only reached when the pool is shutting down
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        auto started = clock::now();
+        task.fn();
+        auto finished = clock::now();
+
+        uint64_t wait = duration_cast<microseconds>(started - task.queued).count();
+        uint64_t exec = duration_cast<microseconds>(finished - started).count();
+
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        ++stats.executed;
+        wait_total_usec += wait;
+        exec_total_usec += exec;
+        stats.wait_max_usec = std::max(stats.wait_max_usec, wait);
+        stats.exec_max_usec = std::max(stats.exec_max_usec, exec);
+    }
+}
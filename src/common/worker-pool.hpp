@@ -0,0 +1,160 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   worker-pool.hpp
+ *
+ * @brief  Bounded thread pool, used by the D-Bus services to limit how
+ *         many expensive method calls run at the same time
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glib.h>
+
+
+class WorkerPoolException : public std::runtime_error
+{
+  public:
+    WorkerPoolException(const std::string &msg)
+        : std::runtime_error(msg)
+    {
+    }
+};
+
+
+/**
+ *  A fixed number of worker threads processing tasks from a bounded
+ *  FIFO queue.  When the queue is full, new tasks are rejected instead
+ *  of piling up.
+ *
+ *  The pool keeps a few counters about the queue depth and how long tasks
+ *  have been waiting in the queue and running, which is exposed via the
+ *  D-Bus services using this pool.
+ */
+class WorkerPool
+{
+  public:
+    using Ptr = std::shared_ptr<WorkerPool>;
+
+    struct Statistics
+    {
+        uint64_t threads = 0;
+        uint64_t queue_depth = 0;
+        uint64_t queue_depth_max = 0;
+        uint64_t executed = 0;
+        uint64_t rejected = 0;
+        uint64_t wait_avg_usec = 0;
+        uint64_t wait_max_usec = 0;
+        uint64_t exec_avg_usec = 0;
+        uint64_t exec_max_usec = 0;
+    };
+
+
+    /**
+     *  Start a new worker pool
+     *
+     * @param threads    unsigned int with the number of worker threads
+     * @param max_queue  size_t with the maximum number of tasks waiting
+     *                   to be executed
+     *
+     * @return WorkerPool::Ptr
+     */
+    [[nodiscard]] static WorkerPool::Ptr Create(const unsigned int threads,
+                                                const size_t max_queue = 64);
+    ~WorkerPool() noexcept;
+
+    /**
+     *  Queue a task to be run by one of the worker threads
+     *
+     * @param task   std::function<void()> to execute
+     * @return std::future<void> which becomes ready when the task has
+     *         completed.  Exceptions thrown by the task are re-thrown
+     *         by std::future::get()
+     *
+     * @throws WorkerPoolException if the queue is full or the pool is
+     *         shutting down
+     */
+    std::future<void> Submit(std::function<void()> task);
+
+    /**
+     *  Run a task in the worker pool and block the calling thread until
+     *  it has completed.  Exceptions thrown by the task are re-thrown
+     *  to the caller.
+     *
+     *  This does not free the calling thread; it is a concurrency
+     *  limiter.  The D-Bus method callbacks are already dispatched
+     *  outside of the main loop thread, and gdbuspp sends the reply
+     *  when the callback returns.  Running the expensive part of a
+     *  method call here limits how many of them run at the same time
+     *  to the number of worker threads.  When the queue is full, the
+     *  call is rejected instead of adding more load.
+     *
+     *  The task must keep the objects it uses alive, as they may be
+     *  removed by other method calls while the task is running.
+     *
+     * @param task   std::function<void()> to execute
+     *
+     * @throws WorkerPoolException if the task could not be queued
+     */
+    void RunLimited(std::function<void()> task);
+
+    /**
+     *  Retrieve the current queue and latency counters
+     *
+     * @return WorkerPool::Statistics
+     */
+    Statistics GetStatistics() const;
+
+    /**
+     *  Retrieve the current queue and latency counters as a D-Bus
+     *  dictionary (a{st}), used by the worker_statistics property
+     *  in the D-Bus services.  If pool is nullptr, an empty dictionary
+     *  is returned.
+     *
+     * @param pool   WorkerPool::Ptr to the pool to report
+     * @return GVariant *
+     */
+    static GVariant *StatisticsGVariant(const WorkerPool::Ptr pool);
+
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        std::packaged_task<void()> fn;
+        clock::time_point queued;
+    };
+
+    const size_t max_queue;
+    std::vector<std::thread> workers{};
+    std::deque<Task> queue{};
+    mutable std::mutex queue_mtx{};
+    std::condition_variable queue_cv{};
+    bool running = true;
+    Statistics stats{};
+    uint64_t wait_total_usec = 0;
+    uint64_t exec_total_usec = 0;
+
+    WorkerPool(const unsigned int threads, const size_t max_queue);
+
+    void worker_thread();
+};
@@ -0,0 +1,233 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   compact-options.cpp
+ *
+ * @brief  Implementation of ConfigManager::CompactOptionStore and
+ *         ConfigManager::CompactOptionList
+ */
+
+#include "build-config.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef USE_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+#include "compact-options.hpp"
+
+
+namespace ConfigManager {
+
+std::string ContentDigest(const char type, const std::string &content)
+{
+#ifdef USE_OPENSSL
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if (nullptr != ctx
+        && EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr)
+        && EVP_DigestUpdate(ctx, &type, 1)
+        && EVP_DigestUpdate(ctx, content.data(), content.size())
+        && EVP_DigestFinal_ex(ctx, hash, &len))
+    {
+        EVP_MD_CTX_free(ctx);
+        return std::string(reinterpret_cast<const char *>(hash), len);
+    }
+    EVP_MD_CTX_free(ctx);
+#endif
+    // Without a hash implementation, the content itself is used as the
+    // key; the type prefix keeps the keys distinct.
+    return std::string(1, type) + content;
+}
+
+
+
+CompactOptionStore::Ptr CompactOptionStore::Create()
+{
+    return CompactOptionStore::Ptr(new CompactOptionStore());
+}
+
+
+uint32_t CompactOptionStore::InternName(const std::string &name)
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto [it, added] = name_ids_.try_emplace(name, names_.size());
+    if (added)
+    {
+        // The unordered_map keys are not moved on rehashing
+        names_.push_back(&it->first);
+    }
+    return it->second;
+}
+
+
+const std::string &CompactOptionStore::GetName(const uint32_t id) const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (id >= names_.size())
+    {
+        throw std::out_of_range("Invalid option name identifier");
+    }
+    return *names_[id];
+}
+
+
+CompactOptionStore::Blob CompactOptionStore::InternBlob(const std::string &data)
+{
+    const std::string key = ContentDigest('b', data);
+
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto &entry = blobs_[key];
+    if (auto blob = entry.lock())
+    {
+        return blob;
+    }
+    auto blob = std::make_shared<const std::string>(data);
+    entry = blob;
+    prune_blobs();
+    return blob;
+}
+
+
+CompactOptionStore::Statistics CompactOptionStore::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    Statistics ret;
+    ret.names = names_.size();
+    for (const auto &[key, entry] : blobs_)
+    {
+        if (auto blob = entry.lock())
+        {
+            ++ret.blobs;
+            ret.blob_bytes += blob->size();
+        }
+    }
+    return ret;
+}
+
+
+void CompactOptionStore::prune_blobs()
+{
+    // Only look for released blobs when the index has doubled in size
+    // since the last time, to keep the cost per added blob constant
+    if (blobs_.size() < 2 * blobs_pruned_size_)
+    {
+        return;
+    }
+    for (auto it = blobs_.begin(); it != blobs_.end();)
+    {
+        it = (it->second.expired() ? blobs_.erase(it) : std::next(it));
+    }
+    blobs_pruned_size_ = std::max<size_t>(blobs_.size(), 16);
+}
+
+
+
+CompactOptionList::CompactOptionList(const openvpn::OptionList &options,
+                                     CompactOptionStore::Ptr store)
+    : store_(std::move(store))
+{
+    size_t arena_size = 0;
+    size_t arg_count = 0;
+    for (const auto &opt : options)
+    {
+        if (opt.size() < 2 || is_blob(opt))
+        {
+            continue;
+        }
+        for (size_t i = 1; i < opt.size(); ++i)
+        {
+            arena_size += opt.ref(i).size();
+        }
+        arg_count += opt.size() - 1;
+    }
+    if (arena_size > UINT32_MAX || arg_count > UINT32_MAX)
+    {
+        throw std::length_error("Configuration profile is too large");
+    }
+    arena_.reserve(arena_size);
+    arguments_.reserve(arg_count);
+    entries_.reserve(options.size());
+
+    for (const auto &opt : options)
+    {
+        if (opt.empty())
+        {
+            continue;
+        }
+
+        Entry e{store_->InternName(opt.ref(0)),
+                static_cast<uint32_t>(arguments_.size()),
+                0,
+                NO_BLOB};
+        size_t last_arg = opt.size();
+        if (is_blob(opt))
+        {
+            e.blob = static_cast<uint32_t>(blobs_.size());
+            blobs_.push_back(store_->InternBlob(opt.ref(1)));
+            last_arg = 1;
+        }
+        for (size_t i = 1; i < last_arg; ++i)
+        {
+            const std::string &arg = opt.ref(i);
+            arguments_.push_back({static_cast<uint32_t>(arena_.size()),
+                                  static_cast<uint32_t>(arg.size())});
+            arena_.append(arg);
+        }
+        e.args = static_cast<uint32_t>(arguments_.size()) - e.first_arg;
+        entries_.push_back(e);
+    }
+
+    entries_.shrink_to_fit();
+    blobs_.shrink_to_fit();
+}
+
+
+openvpn::OptionListJSON CompactOptionList::Materialize() const
+{
+    openvpn::OptionListJSON ret;
+    ret.reserve(entries_.size());
+    for (const auto &e : entries_)
+    {
+        openvpn::Option opt;
+        opt.push_back(store_->GetName(e.name));
+        for (uint32_t i = e.first_arg; i < e.first_arg + e.args; ++i)
+        {
+            opt.push_back(arena_.substr(arguments_[i].offset, arguments_[i].length));
+        }
+        if (NO_BLOB != e.blob)
+        {
+            opt.push_back(*blobs_[e.blob]);
+        }
+        ret.add_item(opt);
+    }
+    return ret;
+}
+
+
+bool CompactOptionList::is_blob(const openvpn::Option &opt)
+{
+    return 2 == opt.size() && openvpn::optparser_inline_file(opt.ref(0));
+}
+
+
+size_t CompactOptionList::MemoryUsage() const noexcept
+{
+    return sizeof(*this)
+           + entries_.capacity() * sizeof(Entry)
+           + arguments_.capacity() * sizeof(Argument)
+           + arena_.capacity()
+           + blobs_.capacity() * sizeof(CompactOptionStore::Blob);
+}
+
+} // namespace ConfigManager
@@ -0,0 +1,180 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   compact-options.hpp
+ *
+ * @brief  Memory compact storage of parsed configuration profile options,
+ *         used instead of keeping an OptionListJSON object per profile
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/core-extensions.hpp>
+
+
+namespace ConfigManager {
+
+/**
+ *  Calculate the key used to index profile content.  This is a SHA-256
+ *  digest of the type byte followed by the content.  If no hash
+ *  implementation is available, the type byte and the content itself
+ *  is returned.
+ *
+ * @param type     char identifying the kind of content
+ * @param content  std::string with the content
+ * @return std::string with the binary digest
+ */
+std::string ContentDigest(const char type, const std::string &content);
+
+
+
+/**
+ *  Data shared between all the CompactOptionList objects.  Option names
+ *  are interned into a single table and the inline files (certificates,
+ *  keys, ...) are stored once, regardless of how many profiles contain
+ *  the same data.  A typical example is a CA bundle shared by all the
+ *  profiles of a VPN service.
+ *
+ *  The inline files are reference counted; an inline file is released
+ *  when the last profile using it is released.
+ *
+ *  This class is thread safe.
+ */
+class CompactOptionStore
+{
+  public:
+    using Ptr = std::shared_ptr<CompactOptionStore>;
+    using Blob = std::shared_ptr<const std::string>;
+
+    struct Statistics
+    {
+        uint64_t names = 0;
+        uint64_t blobs = 0;
+        uint64_t blob_bytes = 0;
+    };
+
+    [[nodiscard]] static CompactOptionStore::Ptr Create();
+
+    /**
+     *  Look up the identifier of an option name, adding it to the
+     *  name table if needed
+     *
+     * @param name  std::string with the option name
+     * @return uint32_t with the name identifier
+     */
+    uint32_t InternName(const std::string &name);
+
+    /**
+     *  Retrieve an option name from its identifier
+     *
+     * @param id  uint32_t with the identifier from InternName()
+     * @return const std::string&
+     */
+    const std::string &GetName(const uint32_t id) const;
+
+    /**
+     *  Retrieve the shared copy of an inline file, adding it to the
+     *  store if not already present
+     *
+     * @param data  std::string with the content of the inline file
+     * @return CompactOptionStore::Blob
+     */
+    Blob InternBlob(const std::string &data);
+
+    Statistics GetStatistics() const;
+
+  private:
+    mutable std::mutex mtx_;
+
+    /// Option name identifiers; the names_ vector points at the keys
+    std::unordered_map<std::string, uint32_t> name_ids_;
+    std::vector<const std::string *> names_;
+
+    /// Inline files still in use, indexed by the content digest
+    std::unordered_map<std::string, std::weak_ptr<const std::string>> blobs_;
+    size_t blobs_pruned_size_ = 0;
+
+    CompactOptionStore() = default;
+
+    void prune_blobs();
+};
+
+
+
+/**
+ *  The options of a parsed configuration profile, stored in a compact
+ *  form.  All the option arguments are packed into a single string
+ *  buffer, the option names are stored as identifiers from the
+ *  CompactOptionStore name table and the inline files are shared via
+ *  the CompactOptionStore.
+ *
+ *  The OptionListJSON object needed to export the profile is created
+ *  on demand by Materialize().
+ */
+class CompactOptionList
+{
+  public:
+    CompactOptionList(const openvpn::OptionList &options,
+                      CompactOptionStore::Ptr store);
+
+    /**
+     *  Recreate the OptionListJSON object of the profile
+     *
+     * @return openvpn::OptionListJSON
+     */
+    openvpn::OptionListJSON Materialize() const;
+
+    /**
+     *  Calculate the memory used by this object, not including the
+     *  data shared via the CompactOptionStore
+     *
+     * @return size_t with the number of bytes
+     */
+    size_t MemoryUsage() const noexcept;
+
+  private:
+    struct Entry
+    {
+        uint32_t name;
+        uint32_t first_arg;
+        uint32_t args;
+
+        /// Index in blobs_ of an inline file, appended after the
+        /// arguments; NO_BLOB if not an inline file
+        uint32_t blob;
+    };
+
+    static constexpr uint32_t NO_BLOB = UINT32_MAX;
+
+    struct Argument
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    CompactOptionStore::Ptr store_;
+    std::vector<Entry> entries_;
+    std::vector<Argument> arguments_;
+    std::string arena_;
+    std::vector<CompactOptionStore::Blob> blobs_;
+
+    /**
+     *  Check if an option is an inline file, which is stored in the
+     *  CompactOptionStore instead of the arena
+     */
+    static bool is_blob(const openvpn::Option &opt);
+};
+
+} // namespace ConfigManager
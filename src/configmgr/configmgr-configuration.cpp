@@ -27,7 +27,7 @@ Configuration::Configuration(DBus::Connection::Ptr dbuscon,
                              const DBus::Object::Path &config_path,
                              const std::string &state_dir,
                              const std::string &name,
-                             const std::string &config_str,
+                             ParsedProfile::Ptr profile,
                              bool single_use,
                              bool persistent,
                              uid_t owner,
@@ -37,7 +37,7 @@ Configuration::Configuration(DBus::Connection::Ptr dbuscon,
       object_manager_(object_manager), creds_qry_(creds_qry),
       sig_configmgr_(sig_configmgr), state_dir_(state_dir), prop_name_(name),
       prop_persistent_(persistent), prop_single_use_(single_use),
-      prop_import_timestamp_(std::time(nullptr))
+      prop_import_timestamp_(std::time(nullptr)), profile_(std::move(profile))
 {
     using namespace openvpn;
     using namespace std::string_literals;
@@ -53,15 +53,6 @@ Configuration::Configuration(DBus::Connection::Ptr dbuscon,
     // Prepare the object handling access control lists
     object_acl_ = GDBusPP::Object::Extension::ACL::Create(dbuscon, owner);
 
-    // Parse the options from the imported configuration
-    OptionList::Limits limits("profile is too large",
-                              ProfileParseLimits::MAX_PROFILE_SIZE,
-                              ProfileParseLimits::OPT_OVERHEAD,
-                              ProfileParseLimits::TERM_OVERHEAD,
-                              ProfileParseLimits::MAX_LINE_SIZE,
-                              ProfileParseLimits::MAX_DIRECTIVE_SIZE);
-    options_.parse_from_config(config_str, &limits);
-    options_.parse_meta_from_config(config_str, "OVPN_ACCESS_SERVER", &limits);
     validate_profile();
 
     signals_->LogInfo("Parsed"s + (persistent ? " persistent" : "")
@@ -87,11 +78,13 @@ Configuration::Configuration(DBus::Connection::Ptr dbuscon,
                              ::Signals::ConfigurationManagerEvent::Ptr sig_configmgr,
                              const std::string &filename,
                              Json::Value profile,
+                             ParsedProfile::Ptr options,
                              uint8_t loglevel,
                              LogWriter::Ptr logwr)
     : DBus::Object::Base(profile["object_path"].asString(), INTERFACE_CONFIGMGR),
       object_manager_(object_manager), creds_qry_(creds_qry),
-      sig_configmgr_(sig_configmgr), persistent_file_(filename)
+      sig_configmgr_(sig_configmgr), persistent_file_(filename),
+      profile_(std::move(options))
 {
     prop_persistent_ = !persistent_file_.empty();
 
@@ -149,8 +142,6 @@ Configuration::Configuration(DBus::Connection::Ptr dbuscon,
         }
     }
 
-    // Parse the options from the imported configuration
-    options_.json_import(profile["profile"]);
     validate_profile();
 
     add_methods();
@@ -396,6 +387,7 @@ void Configuration::add_methods()
                     return;
                 }
 
+                std::lock_guard<std::recursive_mutex> guard(state_mtx_);
                 prop_used_count_++;
                 prop_last_used_timestamp_ = std::time(nullptr);
                 update_persistent_file();
@@ -407,7 +399,30 @@ void Configuration::add_methods()
     auto fj_args = AddMethod("FetchJSON",
                              [this](DBus::Object::Method::Arguments::Ptr args)
                              {
-                                 method_fetch(args, true);
+                                 if (!worker_pool_)
+                                 {
+                                     method_fetch(args, true);
+                                     return;
+                                 }
+
+                                 // A Remove call may run while the task is
+                                 // running; the task keeps this object alive
+                                 auto self = object_manager_->GetObject<Configuration>(GetPath());
+                                 if (!self)
+                                 {
+                                     throw DBus::Object::Method::Exception("Configuration profile not found");
+                                 }
+                                 try
+                                 {
+                                     worker_pool_->RunLimited([self, args]()
+                                                              {
+                                                                  self->method_fetch(args, true);
+                                                              });
+                                 }
+                                 catch (const WorkerPoolException &excp)
+                                 {
+                                     throw DBus::Object::Method::Exception("Service is busy, try again later");
+                                 }
                              });
 
     fj_args->AddOutput("config_json", glib2::DataType::DBus<std::string>());
@@ -519,6 +534,7 @@ void Configuration::add_properties()
                       "a{sv}",
                       [=](const DBus::Object::Property::BySpec &prop)
                       {
+                          std::lock_guard<std::recursive_mutex> guard(state_mtx_);
                           GVariantBuilder *b = glib2::Builder::Create("a{sv}");
 
                           for (const auto &o : override_list_)
@@ -572,6 +588,8 @@ void Configuration::add_properties()
  */
 Json::Value Configuration::Export() const
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     Json::Value ret;
 
     ret["object_path"] = GetPath();
@@ -594,7 +612,7 @@ Json::Value Configuration::Export() const
     ret["single_use"] = prop_single_use_;
     ret["used_count"] = prop_used_count_;
     ret["valid"] = prop_valid_;
-    ret["profile"] = options_.json_export();
+    ret["profile"] = profile_->GetOptions()->json_export();
     ret["dco"] = prop_dco_;
 
     ret["public_access"] = object_acl_->GetPublicAccess();
@@ -638,6 +656,12 @@ bool Configuration::CheckACL(const std::string &caller) const noexcept
 }
 
 
+void Configuration::SetWorkerPool(WorkerPool::Ptr pool)
+{
+    worker_pool_ = pool;
+}
+
+
 void Configuration::update_persistent_file()
 {
     if (persistent_file_.empty())
@@ -656,67 +680,30 @@ void Configuration::update_persistent_file()
 
 std::string Configuration::validate_profile() noexcept
 {
-    bool client_configured = false;
-    bool remote_found = false;
-    bool ca_found = false;
-    bool dev_found = false;
-    for (const auto &opt : options_)
-    {
-        try
-        {
-            if ("setenv" == opt.get(0, 32))
-            {
-                if ("GENERIC_CONFIG" == opt.get(1, 32))
-                {
-                    prop_valid_ = false;
-                    return "Server locked profiles are unsupported";
-                }
-            }
-            else if ("remote" == opt.get(0, 32))
-            {
-                remote_found = true;
-            }
-            else if ("ca" == opt.get(0, 32))
-            {
-                ca_found = true;
-            }
-            else if ("dev" == opt.get(0, 32))
-            {
-                dev_found = true;
-            }
-            else if ("client" == opt.get(0, 32)
-                     || "tls-client" == opt.get(0, 32))
-            {
-                client_configured = true;
-            }
-        }
-        catch (const std::exception &excp)
-        {
-            signals_->LogError("Failed validating profile: "
-                               + std::string(excp.what()));
-        }
-    }
-    if (!client_configured || !dev_found || !remote_found || !ca_found)
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
+    for (const auto &warning : profile_->GetValidationWarnings())
     {
-        prop_valid_ = false;
-        return "Configration profile is missing required options";
+        signals_->LogError("Failed validating profile: " + warning);
     }
-    prop_valid_ = true;
-    return "";
+    prop_valid_ = profile_->Valid();
+    return profile_->GetValidationError();
 }
 
 
 void Configuration::method_fetch(DBus::Object::Method::Arguments::Ptr args, bool json)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     std::stringstream config;
 
     if (json)
     {
-        config << options_.json_export();
+        config << profile_->GetOptions()->json_export();
     }
     else
     {
-        config << options_.string_export();
+        config << profile_->GetOptions()->string_export();
     }
 
     args->SetMethodReturn(glib2::Value::CreateTupleWrapped(config.str()));
@@ -725,6 +712,8 @@ void Configuration::method_fetch(DBus::Object::Method::Arguments::Ptr args, bool
 
 void Configuration::method_add_tag(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     auto tag = glib2::Value::Extract<std::string>(params, 0);
@@ -751,6 +740,8 @@ void Configuration::method_add_tag(DBus::Object::Method::Arguments::Ptr args)
 
 void Configuration::method_remove_tag(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     auto tag = glib2::Value::Extract<std::string>(params, 0);
@@ -779,6 +770,8 @@ void Configuration::method_remove_tag(DBus::Object::Method::Arguments::Ptr args)
 
 void Configuration::method_set_override(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     auto name = glib2::Value::Extract<std::string>(params, 0);
@@ -804,6 +797,8 @@ void Configuration::method_set_override(DBus::Object::Method::Arguments::Ptr arg
 
 void Configuration::method_unset_override(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     auto name = glib2::Value::Extract<std::string>(params, 0);
@@ -826,6 +821,8 @@ void Configuration::method_unset_override(DBus::Object::Method::Arguments::Ptr a
 
 void Configuration::method_access_grant(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     uid_t uid = glib2::Value::Extract<uid_t>(params, 0);
@@ -847,6 +844,8 @@ void Configuration::method_access_grant(DBus::Object::Method::Arguments::Ptr arg
 
 void Configuration::method_access_revoke(DBus::Object::Method::Arguments::Ptr args)
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     GVariant *params = args->GetMethodParameters();
 
     uid_t uid = glib2::Value::Extract<uid_t>(params, 0);
@@ -868,6 +867,8 @@ void Configuration::method_access_revoke(DBus::Object::Method::Arguments::Ptr ar
 
 void Configuration::method_seal()
 {
+    std::lock_guard<std::recursive_mutex> guard(state_mtx_);
+
     if (!prop_valid_)
         throw DBus::Object::Method::Exception("Configuration is not currently valid");
 
@@ -19,12 +19,15 @@
 #include <log/logwriter.hpp>
 #include <common/utils.hpp>
 #include <common/core-extensions.hpp>
+#include <common/worker-pool.hpp>
 #include <ctime>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "configmgr-exceptions.hpp"
 #include "configmgr-signals.hpp"
 #include "overrides.hpp"
+#include "profile-cache.hpp"
 
 
 namespace ConfigManager {
@@ -54,7 +57,8 @@ class Configuration : public DBus::Object::Base
      * @param config_path D-Bus path for this object
      * @param state_dir Directory used to store persistent configurations in
      * @param name User-friendly name for the configuration
-     * @param config_str A parsable string representation of the configuration
+     * @param profile The parsed configuration profile, which may be shared
+     *                with other Configuration objects
      * @param single_use If this is true, this is a one-shot configuration,
      *                   to be discarded after use
      * @param persistent If this is true, this configuration will be saved to
@@ -71,7 +75,7 @@ class Configuration : public DBus::Object::Base
                   const DBus::Object::Path &config_path,
                   const std::string &state_dir,
                   const std::string &name,
-                  const std::string &config_str,
+                  ParsedProfile::Ptr profile,
                   bool single_use,
                   bool persistent,
                   uid_t owner,
@@ -89,6 +93,8 @@ class Configuration : public DBus::Object::Base
      * @param filename File to save the configuration to on updates (if this
      *                 configuration is persistent)
      * @param profile JSON representation of the configuration settings
+     * @param options The parsed "profile" element of the JSON representation,
+     *                which may be shared with other Configuration objects
      * @param loglevel Logging level
      * @param logwr Log helper object
      */
@@ -98,6 +104,7 @@ class Configuration : public DBus::Object::Base
                   ::Signals::ConfigurationManagerEvent::Ptr sig_configmgr,
                   const std::string &filename,
                   Json::Value profile,
+                  ParsedProfile::Ptr options,
                   uint8_t loglevel,
                   LogWriter::Ptr logwr);
 
@@ -150,6 +157,7 @@ class Configuration : public DBus::Object::Base
      */
     bool CheckForTag(const std::string &tag) const noexcept
     {
+        std::lock_guard<std::recursive_mutex> guard(state_mtx_);
         return std::find(prop_tags_.begin(), prop_tags_.end(), tag) != prop_tags_.end();
     }
 
@@ -172,16 +180,23 @@ class Configuration : public DBus::Object::Base
      */
     bool CheckACL(const std::string &caller) const noexcept;
 
+    /**
+     *  Sets the worker pool limiting how many FetchJSON method calls run
+     *  at the same time.  If nullptr, there is no such limit.
+     *
+     * @param pool  WorkerPool::Ptr to use
+     */
+    void SetWorkerPool(WorkerPool::Ptr pool);
+
   private:
     void add_methods();
     void add_properties();
     void update_persistent_file();
 
     /**
-     *  Very simple validation of the configuration profile.
-     *  Currently only checks if --dev, --remote, --ca and
-     *  --client or --tls-client is present in the configuration profile
-     *  and that the 'GENERIC_PROFILE' setting is absent ("server locked")
+     *  Very simple validation of the configuration profile.  The
+     *  validation is done once when the profile is parsed; see
+     *  ParsedProfile::Valid() for the details.
      *
      * @return std::string  Returns an empty string on success and sets the
      *         prop_valid_ property to true.  Otherwise a reason why it failed
@@ -276,6 +291,7 @@ class Configuration : public DBus::Object::Base
             [&](const DBus::Object::Property::BySpec &prop,
                 GVariant *value)
             {
+                std::lock_guard<std::recursive_mutex> guard(state_mtx_);
                 property_var = glib2::Value::Get<T>(value);
 
                 auto upd = prop.PrepareUpdate();
@@ -312,8 +328,16 @@ class Configuration : public DBus::Object::Base
     unsigned int prop_used_count_{0};
     bool prop_valid_{false};
     std::string persistent_file_;
-    openvpn::OptionListJSON options_;
+    ParsedProfile::Ptr profile_;
     std::vector<OverrideValue> override_list_;
+    WorkerPool::Ptr worker_pool_{nullptr};
+
+    /**
+     *  Protects the mutable object state, as methods may be called from
+     *  both the main loop thread and the worker pool threads.  This is a
+     *  recursive mutex, since update_persistent_file() calls Export().
+     */
+    mutable std::recursive_mutex state_mtx_;
 };
 
 } // namespace ConfigManager
@@ -15,6 +15,8 @@
  * @brief Implementation of the net.openvpn.v3.configuration D-Bus service
  */
 
+#include <fstream>
+#include <unistd.h>
 #include <common/lookup.hpp>
 #include <dbus/path.hpp>
 #include "configmgr-service.hpp"
@@ -24,6 +26,25 @@
 
 namespace ConfigManager {
 
+/**
+ *  Retrieve the resident set size of this process
+ *
+ * @return uint64_t with the RSS in bytes, 0 if not available
+ */
+static uint64_t get_process_rss()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+
+
 // ConfigHandler
 
 ConfigHandler::ConfigHandler(DBus::Connection::Ptr dbuscon,
@@ -51,7 +72,10 @@ ConfigHandler::ConfigHandler(DBus::Connection::Ptr dbuscon,
     auto import_args = AddMethod("Import",
                                  [this](DBus::Object::Method::Arguments::Ptr args)
                                  {
-                                     method_import(args);
+                                     helper_run_limited([this, args]()
+                                                    {
+                                                        method_import(args);
+                                                    });
                                  });
 
     import_args->AddInput("name", glib2::DataType::DBus<std::string>());
@@ -105,6 +129,27 @@ ConfigHandler::ConfigHandler(DBus::Connection::Ptr dbuscon,
     to_args->AddInput("new_owner_uid", glib2::DataType::DBus<uint32_t>());
 
     AddProperty("version", prop_version_, /* readwrite */ false);
+
+    AddPropertyBySpec("worker_statistics",
+                      "a{st}",
+                      [this](const DBus::Object::Property::BySpec &prop)
+                      {
+                          return WorkerPool::StatisticsGVariant(worker_pool_);
+                      });
+
+    AddPropertyBySpec("profile_cache_statistics",
+                      "a{st}",
+                      [this](const DBus::Object::Property::BySpec &prop)
+                      {
+                          return ProfileCache::StatisticsGVariant(profile_cache_);
+                      });
+
+    AddPropertyBySpec("memory_statistics",
+                      "a{st}",
+                      [this](const DBus::Object::Property::BySpec &prop)
+                      {
+                          return helper_memory_statistics();
+                      });
 }
 
 
@@ -158,6 +203,55 @@ void ConfigHandler::SetStateDirectory(const std::string &state_dir)
 }
 
 
+void ConfigHandler::SetWorkerPool(WorkerPool::Ptr pool)
+{
+    worker_pool_ = pool;
+
+    // Configuration profiles already loaded from the state directory
+    // must also use the worker pool
+    for (auto &config : helper_retrieve_configs("",
+                                                [](Configuration::Ptr obj)
+                                                {
+                                                    return true;
+                                                }))
+    {
+        config->SetWorkerPool(worker_pool_);
+    }
+}
+
+
+void ConfigHandler::SetProfileCacheSize(const size_t max_unused)
+{
+    profile_cache_->SetMaxUnused(max_unused);
+}
+
+
+void ConfigHandler::SetCompactProfiles(const bool compact)
+{
+    profile_cache_->SetCompact(compact);
+}
+
+
+void ConfigHandler::helper_run_limited(std::function<void()> fn)
+{
+    if (!worker_pool_)
+    {
+        fn();
+        return;
+    }
+
+    try
+    {
+        worker_pool_->RunLimited(std::move(fn));
+    }
+    catch (const WorkerPoolException &excp)
+    {
+        signals_->LogWarn("Method call rejected: " + std::string(excp.what()));
+        throw ConfigManager::Exception("Service is busy, try again later");
+    }
+}
+
+
 std::vector<std::string> ConfigHandler::get_persistent_config_file_list(const std::string &directory)
 {
     DIR *dirfd = nullptr;
@@ -232,14 +326,16 @@ void ConfigHandler::import_persistent_configuration(const std::string &fname)
     Json::Value data;
     statefile >> data;
 
-    object_manager_->CreateObject<Configuration>(dbuscon_,
-                                                 object_manager_,
-                                                 creds_qry_,
-                                                 sig_configmgr_event_,
-                                                 fname,
-                                                 data,
-                                                 signals_->GetLogLevel(),
-                                                 logwr_);
+    auto config = object_manager_->CreateObject<Configuration>(dbuscon_,
+                                                               object_manager_,
+                                                               creds_qry_,
+                                                               sig_configmgr_event_,
+                                                               fname,
+                                                               data,
+                                                               profile_cache_->Import(data["profile"]),
+                                                               signals_->GetLogLevel(),
+                                                               logwr_);
+    config->SetWorkerPool(worker_pool_);
 }
 
 
@@ -261,19 +357,20 @@ void ConfigHandler::method_import(DBus::Object::Method::Arguments::Ptr args)
         const std::string caller = args->GetCallerBusName();
         uid_t owner = creds_qry_->GetUID(caller);
 
-        object_manager_->CreateObject<Configuration>(dbuscon_,
-                                                     object_manager_,
-                                                     creds_qry_,
-                                                     sig_configmgr_event_,
-                                                     config_path,
-                                                     state_dir_,
-                                                     name,
-                                                     config_str,
-                                                     single_use,
-                                                     persistent,
-                                                     owner,
-                                                     signals_->GetLogLevel(),
-                                                     logwr_);
+        auto config = object_manager_->CreateObject<Configuration>(dbuscon_,
+                                                                   object_manager_,
+                                                                   creds_qry_,
+                                                                   sig_configmgr_event_,
+                                                                   config_path,
+                                                                   state_dir_,
+                                                                   name,
+                                                                   profile_cache_->Parse(config_str),
+                                                                   single_use,
+                                                                   persistent,
+                                                                   owner,
+                                                                   signals_->GetLogLevel(),
+                                                                   logwr_);
+        config->SetWorkerPool(worker_pool_);
 
         sig_configmgr_event_->Send(config_path, EventType::CFG_CREATED, owner);
 
@@ -401,6 +498,33 @@ void ConfigHandler::method_transfer_ownership(DBus::Object::Method::Arguments::P
 }
 
 
+GVariant *ConfigHandler::helper_memory_statistics() const
+{
+    const uint64_t configs = helper_retrieve_configs("",
+                                                     [](Configuration::Ptr obj)
+                                                     {
+                                                         return true;
+                                                     })
+                                 .size();
+    const uint64_t rss = get_process_rss();
+    const auto cache_stats = profile_cache_->GetStatistics();
+    const auto mem = profile_cache_->GetMemoryUsage();
+
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{st}"));
+    g_variant_builder_add(b, "{st}", "rss_bytes", rss);
+    g_variant_builder_add(b, "{st}", "configurations", configs);
+    g_variant_builder_add(b, "{st}", "rss_per_configuration", (configs > 0 ? rss / configs : 0));
+    g_variant_builder_add(b, "{st}", "unique_profiles", cache_stats.entries);
+    g_variant_builder_add(b, "{st}", "profile_bytes", mem.profile_bytes);
+    g_variant_builder_add(b, "{st}", "profile_bytes_per_configuration", (configs > 0 ? mem.profile_bytes / configs : 0));
+    g_variant_builder_add(b, "{st}", "shared_blobs", mem.shared_blobs);
+    g_variant_builder_add(b, "{st}", "shared_blob_bytes", mem.shared_blob_bytes);
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
+
+
 ConfigHandler::ConfigCollection
 ConfigHandler::helper_retrieve_configs(const std::string &caller,
                                        fn_search_filter &&filter_fn) const
@@ -487,4 +611,25 @@ void Service::SetStateDirectory(const std::string &stdir)
 }
 
 
+void Service::SetWorkerThreads(unsigned int threads)
+{
+    if (threads > 0)
+    {
+        config_handler_->SetWorkerPool(WorkerPool::Create(threads));
+    }
+}
+
+
+void Service::SetProfileCacheSize(const size_t max_unused)
+{
+    config_handler_->SetProfileCacheSize(max_unused);
+}
+
+
+void Service::SetCompactProfiles(const bool compact)
+{
+    config_handler_->SetCompactProfiles(compact);
+}
+
+
 } // namespace ConfigManager
@@ -27,10 +27,12 @@
 #include <log/proxy-log.hpp>
 #include <common/core-extensions.hpp>
 #include <common/utils.hpp>
+#include <common/worker-pool.hpp>
 #include <string>
 #include <vector>
 #include "configmgr-configuration.hpp"
 #include "configmgr-signals.hpp"
+#include "profile-cache.hpp"
 
 
 namespace ConfigManager {
@@ -91,6 +93,35 @@ class ConfigHandler : public DBus::Object::Base
      */
     void SetStateDirectory(const std::string &state_dir);
 
+    /**
+     *  Enables the worker pool limiting how many of the expensive D-Bus
+     *  methods (Import in this object, FetchJSON in the configuration
+     *  objects) run at the same time.  Without a worker pool, there is
+     *  no such limit.
+     *
+     * @param pool  WorkerPool::Ptr to use for the limited methods
+     */
+    void SetWorkerPool(WorkerPool::Ptr pool);
+
+    /**
+     *  Sets the number of parsed configuration profiles no longer in use
+     *  to keep in memory, making imports of identical profiles cheaper.
+     *  Profiles in use are always shared, regardless of this setting.
+     *
+     * @param max_unused  size_t with the number of profiles to keep
+     */
+    void SetProfileCacheSize(const size_t max_unused);
+
+    /**
+     *  Enables the compact storage of the parsed configuration profiles,
+     *  where the option names are interned and inline files are shared
+     *  between all profiles.  This must be called before any profiles
+     *  are imported or loaded from the state directory.
+     *
+     * @param compact  bool, true enables the compact storage
+     */
+    void SetCompactProfiles(const bool compact);
+
   private:
     /**
      *  Get a list (std::vector<std::string>) of all persistent configuration
@@ -122,6 +153,23 @@ class ConfigHandler : public DBus::Object::Base
      */
     void import_persistent_configuration(const std::string &fname);
 
+    /**
+     *  Runs a method call handler via WorkerPool::RunLimited(), which
+     *  limits how many handlers run at the same time, if the worker pool
+     *  is enabled.  Otherwise the handler is run directly.
+     *
+     * @param fn   std::function<void()> with the method call handler
+     */
+    void helper_run_limited(std::function<void()> fn);
+
+    /**
+     *  Collects the memory usage of the service and the configuration
+     *  profiles, for the memory_statistics D-Bus property
+     *
+     * @return GVariant* with an a{st} dictionary
+     */
+    GVariant *helper_memory_statistics() const;
+
     void method_import(DBus::Object::Method::Arguments::Ptr args);
     void method_fetch_available_configs(DBus::Object::Method::Arguments::Ptr args);
     void method_lookup_config_name(DBus::Object::Method::Arguments::Ptr args);
@@ -150,6 +198,8 @@ class ConfigHandler : public DBus::Object::Base
     ::Signals::ConfigurationManagerEvent::Ptr sig_configmgr_event_;
     std::string state_dir_;
     LogWriter::Ptr logwr_;
+    WorkerPool::Ptr worker_pool_{nullptr};
+    ProfileCache::Ptr profile_cache_{ProfileCache::Create()};
 };
 
 
@@ -184,6 +234,30 @@ class Service : public DBus::Service
      */
     void SetStateDirectory(const std::string &stdir);
 
+    /**
+     *  Enables the worker pool limiting how many of the expensive D-Bus
+     *  methods run at the same time.
+     *
+     * @param threads  unsigned int with the number of worker threads.
+     *                 If 0, the worker pool is not enabled.
+     */
+    void SetWorkerThreads(unsigned int threads);
+
+    /**
+     *  Sets the number of parsed configuration profiles no longer in
+     *  use to keep in memory.
+     *
+     * @param max_unused  size_t with the number of profiles to keep
+     */
+    void SetProfileCacheSize(const size_t max_unused);
+
+    /**
+     *  Enables the compact storage of the parsed configuration profiles
+     *
+     * @param compact  bool, true enables the compact storage
+     */
+    void SetCompactProfiles(const bool compact);
+
   private:
     DBus::Connection::Ptr con_;
     LogWriter::Ptr logwr_;
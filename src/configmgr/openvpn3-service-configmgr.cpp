@@ -82,6 +82,23 @@ static int config_manager(ParsedArgs::Ptr args)
     }
     configmgr_srv->SetLogLevel(log_level);
 
+    // The worker pool must be enabled before the persistent
+    // configuration profiles are loaded from the state directory
+    if (args->Present("worker-threads"))
+    {
+        configmgr_srv->SetWorkerThreads(std::atoi(args->GetValue("worker-threads", 0).c_str()));
+    }
+
+    if (args->Present("profile-cache"))
+    {
+        configmgr_srv->SetProfileCacheSize(std::atoi(args->GetValue("profile-cache", 0).c_str()));
+    }
+
+    if (args->Present("compact-profiles"))
+    {
+        configmgr_srv->SetCompactProfiles(true);
+    }
+
     if (args->Present("state-dir"))
     {
         configmgr_srv->SetStateDirectory(args->GetValue("state-dir", 0));
@@ -118,6 +135,20 @@ int main(int argc, char **argv)
                         "DIRECTORY",
                         true,
                         "Directory where to save persistent data");
+    argparser.AddOption("worker-threads",
+                        "NUM",
+                        true,
+                        "Run at most NUM expensive D-Bus methods at the "
+                        "same time (Default: 0, no limit)");
+    argparser.AddOption("profile-cache",
+                        "NUM",
+                        true,
+                        "Keep up to NUM parsed configuration profiles no longer "
+                        "in use, for faster re-imports (Default: 64)");
+    argparser.AddOption("compact-profiles",
+                        0,
+                        "Store configuration profiles in a memory compact form, "
+                        "sharing identical inline certificates and keys");
 
     try
     {
@@ -110,6 +110,13 @@ const ValidOverride configProfileOverrides[] = {
     {"dns-sync-lookup", OverrideType::boolean,
      "Use synchronous DNS Lookups"},
 
+    {"tun-qdisc", OverrideType::string,
+     "Queueing discipline for the tun device, as KIND[:PARAM=VALUE,...]",
+     [] {return std::string("fq fq_codel codel pfifo_fast noqueue");}},
+
+    {"tun-txqueuelen", OverrideType::string,
+     "Transmit queue length of the tun device"},
+
     {"auth-fail-retry", OverrideType::boolean,
      "Should failed authentication be considered a temporary error"},
 
@@ -0,0 +1,335 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   profile-cache.cpp
+ *
+ * @brief  Implementation of ConfigManager::ProfileCache
+ */
+
+#include "build-config.h"
+
+#include <cctype>
+#include <iterator>
+
+#include "profile-cache.hpp"
+
+
+namespace ConfigManager {
+
+/**
+ *  Calculate the heap memory used by a std::string, not counting
+ *  strings stored within the std::string object itself
+ */
+static size_t string_heap_usage(const std::string &str) noexcept
+{
+    const char *data = str.data();
+    const char *obj = reinterpret_cast<const char *>(&str);
+    return (data >= obj && data < obj + sizeof(str)) ? 0 : str.capacity() + 1;
+}
+
+
+
+ParsedProfile::ParsedProfile(openvpn::OptionListJSON &&opts,
+                             CompactOptionStore::Ptr store)
+{
+    validate(opts);
+    if (store)
+    {
+        compact_ = std::make_unique<const CompactOptionList>(opts, store);
+    }
+    else
+    {
+        options_ = std::make_shared<const openvpn::OptionListJSON>(std::move(opts));
+    }
+}
+
+
+ParsedProfile::Options ParsedProfile::GetOptions() const
+{
+    if (compact_)
+    {
+        return std::make_shared<const openvpn::OptionListJSON>(compact_->Materialize());
+    }
+    return options_;
+}
+
+
+size_t ParsedProfile::MemoryUsage() const noexcept
+{
+    if (compact_)
+    {
+        return sizeof(*this) + compact_->MemoryUsage();
+    }
+
+    // The OptionList name index is not included
+    size_t ret = sizeof(*this) + sizeof(*options_)
+                 + options_->capacity() * sizeof(openvpn::Option);
+    for (const auto &opt : *options_)
+    {
+        for (size_t i = 0; i < opt.size(); ++i)
+        {
+            ret += sizeof(std::string) + string_heap_usage(opt.ref(i));
+        }
+    }
+    return ret;
+}
+
+
+void ParsedProfile::validate(const openvpn::OptionListJSON &options)
+{
+    bool client_configured = false;
+    bool remote_found = false;
+    bool ca_found = false;
+    bool dev_found = false;
+    for (const auto &opt : options)
+    {
+        try
+        {
+            if ("setenv" == opt.get(0, 32))
+            {
+                if ("GENERIC_CONFIG" == opt.get(1, 32))
+                {
+                    validation_error_ = "Server locked profiles are unsupported";
+                    return;
+                }
+            }
+            else if ("remote" == opt.get(0, 32))
+            {
+                remote_found = true;
+            }
+            else if ("ca" == opt.get(0, 32))
+            {
+                ca_found = true;
+            }
+            else if ("dev" == opt.get(0, 32))
+            {
+                dev_found = true;
+            }
+            else if ("client" == opt.get(0, 32)
+                     || "tls-client" == opt.get(0, 32))
+            {
+                client_configured = true;
+            }
+        }
+        catch (const std::exception &excp)
+        {
+            validation_warnings_.push_back(excp.what());
+        }
+    }
+    if (!client_configured || !dev_found || !remote_found || !ca_found)
+    {
+        validation_error_ = "Configration profile is missing required options";
+    }
+}
+
+
+
+ProfileCache::Ptr ProfileCache::Create(const size_t max_unused)
+{
+    return ProfileCache::Ptr(new ProfileCache(max_unused));
+}
+
+
+ProfileCache::ProfileCache(const size_t max_unused)
+    : max_unused_(max_unused)
+{
+}
+
+
+ParsedProfile::Ptr ProfileCache::Parse(const std::string &config_str)
+{
+    const std::string normalized = Normalize(config_str);
+    const std::string key = ContentDigest('t', normalized);
+    if (auto profile = lookup(key))
+    {
+        return profile;
+    }
+
+    // Parse the profile without holding the lock; if the same profile
+    // is parsed in parallel, the first one inserted is used
+    openvpn::OptionList::Limits limits("profile is too large",
+                                       ProfileParseLimits::MAX_PROFILE_SIZE,
+                                       ProfileParseLimits::OPT_OVERHEAD,
+                                       ProfileParseLimits::TERM_OVERHEAD,
+                                       ProfileParseLimits::MAX_LINE_SIZE,
+                                       ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+    openvpn::OptionListJSON options;
+    options.parse_from_config(normalized, &limits);
+    options.parse_meta_from_config(normalized, "OVPN_ACCESS_SERVER", &limits);
+    return insert(key, std::make_shared<const ParsedProfile>(std::move(options), get_compact_store()));
+}
+
+
+ParsedProfile::Ptr ProfileCache::Import(const Json::Value &profile)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    const std::string key = ContentDigest('j', Json::writeString(builder, profile));
+    if (auto parsed = lookup(key))
+    {
+        return parsed;
+    }
+
+    openvpn::OptionListJSON options;
+    options.json_import(profile);
+    return insert(key, std::make_shared<const ParsedProfile>(std::move(options), get_compact_store()));
+}
+
+
+void ProfileCache::SetMaxUnused(const size_t max_unused)
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    max_unused_ = max_unused;
+    evict_unused();
+}
+
+
+void ProfileCache::SetCompact(const bool compact)
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    if (!compact)
+    {
+        compact_store_ = nullptr;
+    }
+    else if (!compact_store_)
+    {
+        compact_store_ = CompactOptionStore::Create();
+    }
+}
+
+
+ProfileCache::Statistics ProfileCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    Statistics ret = stats_;
+    ret.entries = entries_.size();
+    return ret;
+}
+
+
+ProfileCache::MemoryUsage ProfileCache::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    MemoryUsage ret;
+    for (const auto &[key, entry] : entries_)
+    {
+        ret.profile_bytes += entry.profile->MemoryUsage();
+    }
+    if (compact_store_)
+    {
+        auto store_stats = compact_store_->GetStatistics();
+        ret.shared_blobs = store_stats.blobs;
+        ret.shared_blob_bytes = store_stats.blob_bytes;
+    }
+    return ret;
+}
+
+
+GVariant *ProfileCache::StatisticsGVariant(const ProfileCache::Ptr cache)
+{
+    GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{st}"));
+    if (cache)
+    {
+        auto s = cache->GetStatistics();
+        g_variant_builder_add(b, "{st}", "entries", s.entries);
+        g_variant_builder_add(b, "{st}", "hits", s.hits);
+        g_variant_builder_add(b, "{st}", "misses", s.misses);
+        g_variant_builder_add(b, "{st}", "evictions", s.evictions);
+    }
+    GVariant *ret = g_variant_builder_end(b);
+    g_variant_builder_unref(b);
+    return ret;
+}
+
+
+std::string ProfileCache::Normalize(const std::string &config_str)
+{
+    // Skip the leading lines containing only white space
+    size_t start = 0;
+    for (size_t i = 0; i < config_str.size() && std::isspace(static_cast<unsigned char>(config_str[i])); ++i)
+    {
+        if ('\n' == config_str[i])
+        {
+            start = i + 1;
+        }
+    }
+
+    size_t end = config_str.size();
+    while (end > start && std::isspace(static_cast<unsigned char>(config_str[end - 1])))
+    {
+        --end;
+    }
+    return config_str.substr(start, end - start);
+}
+
+
+CompactOptionStore::Ptr ProfileCache::get_compact_store() const
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    return compact_store_;
+}
+
+
+ParsedProfile::Ptr ProfileCache::lookup(const std::string &key)
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto it = entries_.find(key);
+    if (entries_.end() == it)
+    {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    return it->second.profile;
+}
+
+
+ParsedProfile::Ptr ProfileCache::insert(const std::string &key, ParsedProfile::Ptr profile)
+{
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto it = entries_.find(key);
+    if (entries_.end() != it)
+    {
+        return it->second.profile;
+    }
+
+    lru_.push_front(key);
+    entries_[key] = {profile, lru_.begin()};
+    evict_unused();
+    return profile;
+}
+
+
+void ProfileCache::evict_unused()
+{
+    // Count the entries only referenced by the cache itself, and remove
+    // the least recently used of these until the limit is reached.
+    size_t unused = 0;
+    for (const auto &[key, entry] : entries_)
+    {
+        unused += (1 == entry.profile.use_count());
+    }
+
+    for (auto it = lru_.rbegin(); unused > max_unused_ && it != lru_.rend();)
+    {
+        auto entry = entries_.find(*it);
+        if (1 != entry->second.profile.use_count())
+        {
+            ++it;
+            continue;
+        }
+        entries_.erase(entry);
+        it = std::make_reverse_iterator(lru_.erase(std::next(it).base()));
+        --unused;
+        ++stats_.evictions;
+    }
+}
+
+} // namespace ConfigManager
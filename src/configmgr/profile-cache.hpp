@@ -0,0 +1,266 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   profile-cache.hpp
+ *
+ * @brief  Content addressed cache of parsed and validated configuration
+ *         profiles, shared between the Configuration objects
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glib.h>
+#include <json/json.h>
+#include <openvpn/log/logsimple.hpp>
+#include <common/core-extensions.hpp>
+#include "compact-options.hpp"
+
+
+namespace ConfigManager {
+
+/**
+ *  An immutable parsed configuration profile, together with the result
+ *  of the profile validation.  The same object is shared by all the
+ *  Configuration objects with identical profile content.
+ *
+ *  In the compact mode, the options are stored in a CompactOptionList
+ *  and the OptionListJSON object is only recreated when needed.
+ */
+class ParsedProfile
+{
+  public:
+    using Ptr = std::shared_ptr<const ParsedProfile>;
+    using Options = std::shared_ptr<const openvpn::OptionListJSON>;
+
+    /**
+     *  Validate a parsed configuration profile and keep the result
+     *
+     * @param opts   openvpn::OptionListJSON with the parsed profile
+     * @param store  CompactOptionStore::Ptr to use for the compact
+     *               storage of the options.  If nullptr, the
+     *               OptionListJSON object is kept as is.
+     */
+    ParsedProfile(openvpn::OptionListJSON &&opts,
+                  CompactOptionStore::Ptr store = nullptr);
+
+    /**
+     *  Retrieve the parsed options of the profile.  In the compact
+     *  mode, a new OptionListJSON object is created on each call; the
+     *  caller should not keep it longer than needed.
+     *
+     * @return ParsedProfile::Options
+     */
+    Options GetOptions() const;
+
+    /**
+     *  Check if the options are kept in the compact form
+     *
+     * @return bool
+     */
+    bool Compact() const noexcept
+    {
+        return nullptr != compact_;
+    }
+
+    /**
+     *  Calculate the memory used by the parsed options.  Inline files
+     *  shared via the CompactOptionStore are not included.
+     *
+     *  For the OptionListJSON objects, this is an estimate based on the
+     *  sizes of the option strings and their containers.
+     *
+     * @return size_t with the number of bytes
+     */
+    size_t MemoryUsage() const noexcept;
+
+    /**
+     *  Check if the profile passed the validation.
+     *
+     *  Only checks if --dev, --remote, --ca and --client or --tls-client
+     *  is present in the configuration profile and that the
+     *  'GENERIC_PROFILE' setting is absent ("server locked")
+     *
+     * @return bool
+     */
+    bool Valid() const noexcept
+    {
+        return validation_error_.empty();
+    }
+
+    /**
+     *  Retrieve the reason the profile did not pass the validation
+     *
+     * @return const std::string&, empty if the profile is valid
+     */
+    const std::string &GetValidationError() const noexcept
+    {
+        return validation_error_;
+    }
+
+    /**
+     *  Retrieve errors found while validating the profile, which did
+     *  not cause the validation to fail
+     *
+     * @return const std::vector<std::string>&
+     */
+    const std::vector<std::string> &GetValidationWarnings() const noexcept
+    {
+        return validation_warnings_;
+    }
+
+  private:
+    Options options_{nullptr};
+    std::unique_ptr<const CompactOptionList> compact_{nullptr};
+    std::string validation_error_{};
+    std::vector<std::string> validation_warnings_{};
+
+    void validate(const openvpn::OptionListJSON &options);
+};
+
+
+
+/**
+ *  Keeps the parsed configuration profiles, indexed by a SHA-256 hash
+ *  of the normalized profile content.  Importing a profile identical to
+ *  one already imported, by any user, returns the already parsed
+ *  ParsedProfile object.
+ *
+ *  Profiles used by a Configuration object are always kept.  In
+ *  addition, up to max_unused profiles no longer in use are kept, so
+ *  profiles imported repeatedly as single-use profiles or removed and
+ *  imported again are not parsed again.  The least recently used are
+ *  removed first.
+ *
+ *  This class is thread safe.
+ */
+class ProfileCache
+{
+  public:
+    using Ptr = std::shared_ptr<ProfileCache>;
+
+    struct Statistics
+    {
+        uint64_t entries = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    struct MemoryUsage
+    {
+        /// Memory used by the parsed options of all the cached profiles
+        uint64_t profile_bytes = 0;
+
+        /// Inline files shared via the CompactOptionStore
+        uint64_t shared_blobs = 0;
+        uint64_t shared_blob_bytes = 0;
+    };
+
+    [[nodiscard]] static ProfileCache::Ptr Create(const size_t max_unused = 64);
+
+    /**
+     *  Retrieve the parsed profile of a configuration profile in the
+     *  text format, parsing it if needed
+     *
+     * @param config_str  std::string with the configuration profile
+     * @return ParsedProfile::Ptr
+     *
+     * @throws openvpn::option_error if the profile could not be parsed
+     */
+    ParsedProfile::Ptr Parse(const std::string &config_str);
+
+    /**
+     *  Retrieve the parsed profile of a configuration profile in the
+     *  JSON format used by the persistent configuration files, parsing
+     *  it if needed
+     *
+     * @param profile  Json::Value with the "profile" element
+     * @return ParsedProfile::Ptr
+     */
+    ParsedProfile::Ptr Import(const Json::Value &profile);
+
+    /**
+     *  Change the number of unused profiles to keep
+     *
+     * @param max_unused  size_t with the new limit; 0 only keeps the
+     *                    profiles in use
+     */
+    void SetMaxUnused(const size_t max_unused);
+
+    /**
+     *  Enable or disable the compact storage of the parsed profiles.
+     *  This only applies to profiles parsed after this call.
+     *
+     * @param compact  bool, true enables the compact storage
+     */
+    void SetCompact(const bool compact);
+
+    Statistics GetStatistics() const;
+
+    /**
+     *  Calculate the memory used by the parsed profiles in the cache.
+     *  Each profile is only counted once, regardless of how many
+     *  Configuration objects are using it.
+     *
+     * @return ProfileCache::MemoryUsage
+     */
+    MemoryUsage GetMemoryUsage() const;
+
+    /**
+     *  Retrieve the cache statistics as an a{st} GVariant dictionary
+     *
+     * @param cache  ProfileCache::Ptr to retrieve the statistics from;
+     *               may be nullptr, which returns an empty dictionary
+     * @return GVariant*
+     */
+    static GVariant *StatisticsGVariant(const ProfileCache::Ptr cache);
+
+    /**
+     *  Normalize the configuration profile text before hashing it.
+     *  Leading empty lines and trailing white space are removed, which
+     *  does not change the parsed result.  Comments are kept, as these
+     *  may carry meta data used by the parser.
+     *
+     * @param config_str  std::string with the configuration profile
+     * @return std::string
+     */
+    static std::string Normalize(const std::string &config_str);
+
+  private:
+    struct Entry
+    {
+        ParsedProfile::Ptr profile;
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    mutable std::mutex mtx_;
+    size_t max_unused_;
+    std::unordered_map<std::string, Entry> entries_;
+
+    /// Cache keys, the most recently used first
+    std::list<std::string> lru_;
+    Statistics stats_{};
+    CompactOptionStore::Ptr compact_store_{nullptr};
+
+    ProfileCache(const size_t max_unused);
+
+    CompactOptionStore::Ptr get_compact_store() const;
+    ParsedProfile::Ptr lookup(const std::string &key);
+    ParsedProfile::Ptr insert(const std::string &key, ParsedProfile::Ptr profile);
+    void evict_unused();
+};
+
+} // namespace ConfigManager
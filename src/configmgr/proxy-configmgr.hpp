@@ -19,6 +19,7 @@
 #include <gdbuspp/proxy/utils.hpp>
 
 #include "dbus/constants.hpp"
+#include "dbus/service-probe.hpp"
 #include "common/utils.hpp"
 #include "configmgr/overrides.hpp"
 
@@ -69,8 +70,7 @@ class OpenVPN3ConfigurationProxy
                                DBus::Object::Path object_path,
                                bool force_feature_load = false)
     {
-        auto prxqry = DBus::Proxy::Utils::DBusServiceQuery::Create(con);
-        prxqry->CheckServiceAvail(Constants::GenServiceName("configuration"));
+        ServiceProbe::CheckServiceAvail(con, Constants::GenServiceName("configuration"));
 
         proxy = DBus::Proxy::Client::Create(con,
                                             Constants::GenServiceName("configuration"));
@@ -83,8 +83,9 @@ class OpenVPN3ConfigurationProxy
         // when accessing the main management object
         if ((Constants::GenPath("configuration") == object_path) || force_feature_load)
         {
-            set_feature_flags(proxy_qry->ServiceVersion(Constants::GenPath("configuration"),
-                                                        Constants::GenInterface("configuration")));
+            set_feature_flags(ServiceProbe::ServiceVersion(proxy,
+                                                           Constants::GenPath("configuration"),
+                                                           Constants::GenInterface("configuration")));
         }
 
         // If not a configuration manager service path, check that the object
@@ -142,9 +143,9 @@ class OpenVPN3ConfigurationProxy
     {
         if (features == CfgMgrFeatures::UNDEFINED)
         {
-            auto service = DBus::Proxy::Utils::Query::Create(proxy);
-            set_feature_flags(service->ServiceVersion(Constants::GenPath("configuration"),
-                                                      Constants::GenInterface("configuration")));
+            set_feature_flags(ServiceProbe::ServiceVersion(proxy,
+                                                           Constants::GenPath("configuration"),
+                                                           Constants::GenInterface("configuration")));
         }
         return features & feat;
     }
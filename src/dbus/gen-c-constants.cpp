@@ -131,6 +131,7 @@ int main(int argc, char **argv)
     std::vector<ConstantMapping<SessionManager::EventType>> smgrev;
     MAP(SessionManager::EventType, smgrev, "SESS_CREATED", SESS_CREATED);
     MAP(SessionManager::EventType, smgrev, "SESS_DESTROYED", SESS_DESTROYED);
+    MAP(SessionManager::EventType, smgrev, "SESS_START_FAILED", SESS_START_FAILED);
     Generator("SessionManagerEventType", "SMET", smgrev);
 
     std::vector<ConstantMapping<ClientAttentionType>> client_att_type;
@@ -102,6 +102,19 @@ const bool ACL::CheckACL(const std::string &caller,
         // consider it an authz failure
         return false;
     }
+    return CheckACL(caller_uid, extra_acl, true);
+}
+
+
+const bool ACL::CheckACL(const uid_t caller_uid,
+                         const ACLList &extra_acl,
+                         const bool ignore_public_access) const noexcept
+{
+    if (!ignore_public_access && acl_public)
+    {
+        // Everyone is granted access
+        return true;
+    }
 
     ACLList acl_check = acl_list;
     acl_check.insert(acl_check.end(), extra_acl.begin(), extra_acl.end());
@@ -131,6 +131,25 @@ class ACL
                                       const ACLList &extra_acl = {},
                                       const bool ignore_public_access = false) const;
 
+    /**
+     *  Validates if a user (uid) should be granted access or not
+     *
+     *  This is the same check as the D-Bus caller variant, but for callers
+     *  where the uid is already known, such as via SO_PEERCRED on
+     *  a local socket.
+     *
+     * @param caller_uid            uid_t of the calling user
+     * @param extra_acl             Optional, ACLList with additional uids to
+     *                              give access
+     * @param ignore_public_access  Optional, boolean flag (default diabled) to
+     *                              do a full ACL check regardless of the public
+     *                              access flag
+     * @return true if the caller should be granted access, otherwise false
+     */
+    [[nodiscard]] const bool CheckACL(const uid_t caller_uid,
+                                      const ACLList &extra_acl = {},
+                                      const bool ignore_public_access = false) const noexcept;
+
     /**
      *  Checks if the D-Bus caller is the owner of this object or not
      *
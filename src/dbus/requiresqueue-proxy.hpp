@@ -51,6 +51,9 @@ class DBusRequiresQueueProxy
      *                                 QueueCheck method
      * @param method_providereponse    String containing the name of the
      *                                 QueueProvideResponse method
+     * @param method_fetchall          String containing the name of the
+     *                                 QueueFetchAll method.  If empty,
+     *                                 FetchAll() will use the other methods.
      *
      * The method names must match the defined introspection of the service
      * side.
@@ -62,11 +65,13 @@ class DBusRequiresQueueProxy
                            const std::string &method_quechktypegroup,
                            const std::string &method_queuefetch,
                            const std::string &method_queuecheck,
-                           const std::string &method_providereponse)
+                           const std::string &method_providereponse,
+                           const std::string &method_fetchall = "")
         : method_quechktypegroup(method_quechktypegroup),
           method_queuefetch(method_queuefetch),
           method_queuecheck(method_queuecheck),
-          method_provideresponse(method_providereponse)
+          method_provideresponse(method_providereponse),
+          method_fetchall(method_fetchall)
     {
         proxy = DBus::Proxy::Client::Create(dbuscon, destination);
         target = DBus::Proxy::TargetPreset::Create(objpath, interface);
@@ -85,6 +90,9 @@ class DBusRequiresQueueProxy
      *                                 QueueCheck method
      * @param method_providereponse    String containing the name of the
      *                                 QueueProvideResponse method
+     * @param method_fetchall          String containing the name of the
+     *                                 QueueFetchAll method.  If empty,
+     *                                 FetchAll() will use the other methods.
      *
      * The method names must match the defined introspection of the service
      * side.
@@ -92,11 +100,13 @@ class DBusRequiresQueueProxy
     DBusRequiresQueueProxy(const std::string &method_quechktypegroup,
                            const std::string &method_queuefetch,
                            const std::string &method_queuecheck,
-                           const std::string &method_providereponse)
+                           const std::string &method_providereponse,
+                           const std::string &method_fetchall = "")
         : method_quechktypegroup(method_quechktypegroup),
           method_queuefetch(method_queuefetch),
           method_queuecheck(method_queuecheck),
-          method_provideresponse(method_providereponse)
+          method_provideresponse(method_providereponse),
+          method_fetchall(method_fetchall)
     {
     }
 
@@ -169,6 +179,63 @@ class DBusRequiresQueueProxy
     }
 
 
+    /**
+     *  Retrieves all unresolved RequiresSlot records, across all
+     *  ClientAttentionTypes and ClientAttentionGroups.
+     *
+     *  If the service provides the QueueFetchAll method, this is done in
+     *  a single D-Bus call.  Otherwise, or if the service is too old to
+     *  know about this method, QueueCheckTypeGroup(), QueueCheck() and
+     *  QueueFetch() are used instead.
+     *
+     * @return  Returns a std::vector<RequiresSlot> of all unresolved slots
+     *
+     * @throws DBus::Exception if the QueueFetchAll call fails for any
+     *         other reason than the method not being available
+     */
+    std::vector<struct RequiresSlot> FetchAll()
+    {
+        if (!method_fetchall.empty())
+        {
+            try
+            {
+                GVariant *res = proxy->Call(target, method_fetchall);
+                GVariantIter *ar_slots = nullptr;
+                g_variant_get(res, "(a(uuussb))", &ar_slots);
+
+                GVariant *e = nullptr;
+                std::vector<struct RequiresSlot> ret;
+                while ((e = g_variant_iter_next_value(ar_slots)))
+                {
+                    ret.push_back(deserialize(e));
+                    g_variant_unref(e);
+                }
+                g_variant_iter_free(ar_slots);
+                g_variant_unref(res);
+                return ret;
+            }
+            catch (const DBus::Exception &excp)
+            {
+                // Only a service without the method falls back to the
+                // per-slot calls below; other errors are passed on
+                std::string err(excp.what());
+                if (err.find("org.freedesktop.DBus.Error.UnknownMethod") == std::string::npos)
+                {
+                    throw;
+                }
+                method_fetchall.clear();
+            }
+        }
+
+        std::vector<struct RequiresSlot> ret;
+        for (const auto &[type, group] : QueueCheckTypeGroup())
+        {
+            QueueFetchAll(ret, type, group);
+        }
+        return ret;
+    }
+
+
     /**
      *  Retrieves a RequiresQueue::ClientAttTypeGroup tuple containing all
      *  unresolved ClientAttentionTypes and ClientAttentionGroups.
@@ -244,6 +311,7 @@ class DBusRequiresQueueProxy
     std::string method_queuefetch;
     std::string method_queuecheck;
     std::string method_provideresponse;
+    std::string method_fetchall;
 
 
     /**
@@ -0,0 +1,101 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   service-probe.cpp
+ *
+ * @brief  Implementation of ServiceProbe
+ */
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <gdbuspp/proxy/utils.hpp>
+
+#include "dbus/service-probe.hpp"
+
+
+namespace {
+
+std::mutex probe_mtx;
+bool probe_cache_enabled = false;
+
+/// Services found available, indexed by the connection unique bus name
+/// and the service name
+std::set<std::string> probe_services;
+
+/// Service versions, indexed by the service, object path and interface
+std::map<std::string, std::string> probe_versions;
+
+} // namespace
+
+
+
+void ServiceProbe::EnableCache(const bool enable)
+{
+    std::lock_guard<std::mutex> guard(probe_mtx);
+    probe_cache_enabled = enable;
+    if (!enable)
+    {
+        probe_services.clear();
+        probe_versions.clear();
+    }
+}
+
+
+bool ServiceProbe::CheckServiceAvail(DBus::Connection::Ptr conn,
+                                     const std::string &service)
+{
+    const std::string key = conn->GetUniqueBusName() + " " + service;
+    {
+        std::lock_guard<std::mutex> guard(probe_mtx);
+        if (probe_cache_enabled && probe_services.count(key) > 0)
+        {
+            return true;
+        }
+    }
+
+    auto srvqry = DBus::Proxy::Utils::DBusServiceQuery::Create(conn);
+    if (!srvqry->CheckServiceAvail(service))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(probe_mtx);
+    if (probe_cache_enabled)
+    {
+        probe_services.insert(key);
+    }
+    return true;
+}
+
+
+std::string ServiceProbe::ServiceVersion(DBus::Proxy::Client::Ptr proxy,
+                                         const DBus::Object::Path &path,
+                                         const std::string &interface)
+{
+    const std::string key = proxy->GetDestination() + " " + path + " " + interface;
+    {
+        std::lock_guard<std::mutex> guard(probe_mtx);
+        auto it = probe_versions.find(key);
+        if (probe_cache_enabled && probe_versions.end() != it)
+        {
+            return it->second;
+        }
+    }
+
+    auto qry = DBus::Proxy::Utils::Query::Create(proxy);
+    const std::string version = qry->ServiceVersion(path, interface);
+
+    std::lock_guard<std::mutex> guard(probe_mtx);
+    if (probe_cache_enabled)
+    {
+        probe_versions[key] = version;
+    }
+    return version;
+}
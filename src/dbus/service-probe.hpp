@@ -0,0 +1,68 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   service-probe.hpp
+ *
+ * @brief  Checks of D-Bus service availability and service versions,
+ *         with an optional process wide cache of the results
+ */
+
+#pragma once
+
+#include <string>
+#include <gdbuspp/connection.hpp>
+#include <gdbuspp/object/path.hpp>
+#include <gdbuspp/proxy.hpp>
+
+
+/**
+ *  The proxy classes checks if the service is available and which
+ *  version it runs before accessing it.  For short lived programs
+ *  creating many proxy objects, such as the openvpn3 command line
+ *  tool in batch mode, these checks can be cached for the lifetime
+ *  of the process.
+ *
+ *  The cache is disabled by default, as long running services must
+ *  see restarted services.  Only successful results are cached.
+ */
+class ServiceProbe
+{
+  public:
+    /**
+     *  Enable or disable caching of the probe results.  Disabling the
+     *  cache also clears it.
+     *
+     * @param enable  bool, true enables the cache
+     */
+    static void EnableCache(const bool enable);
+
+    /**
+     *  Check if a D-Bus service is available, starting it via D-Bus
+     *  activation if needed
+     *
+     * @param conn     DBus::Connection::Ptr to use
+     * @param service  std::string with the D-Bus service name
+     * @return bool    true if the service is available
+     */
+    static bool CheckServiceAvail(DBus::Connection::Ptr conn,
+                                  const std::string &service);
+
+    /**
+     *  Retrieve the version property of a D-Bus service
+     *
+     * @param proxy      DBus::Proxy::Client::Ptr to the service
+     * @param path       DBus::Object::Path of the object with the
+     *                   version property
+     * @param interface  std::string with the interface of the object
+     * @return std::string with the service version
+     */
+    static std::string ServiceVersion(DBus::Proxy::Client::Ptr proxy,
+                                      const DBus::Object::Path &path,
+                                      const std::string &interface);
+};
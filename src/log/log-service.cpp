@@ -135,12 +135,21 @@ DBus::Object::Path AttachedService::AddProxyTarget(const std::string &recv_tgt,
 
 void AttachedService::OverrideObjectPath(const DBus::Object::Path &new_path)
 {
+    std::lock_guard<std::mutex> guard(meta_cache_mtx);
     override_obj_path = new_path;
+    meta_cache.clear();
 }
 
 
-void AttachedService::process_log_event(const Events::Log &logevent)
+RenderedLogMetaData::Ptr AttachedService::get_metadata(const Events::Log &logevent)
 {
+    std::lock_guard<std::mutex> guard(meta_cache_mtx);
+    auto it = meta_cache.find(logevent.sender->object_path);
+    if (meta_cache.end() != it)
+    {
+        return it->second;
+    }
+
     auto meta = LogMetaData::Create();
     meta->AddMeta("sender", logevent.sender->busname);
     if (!override_obj_path.empty())
@@ -154,9 +163,21 @@ void AttachedService::process_log_event(const Events::Log &logevent)
     }
     meta->AddMeta("interface", logevent.sender->object_interface);
 
+    if (meta_cache.size() >= META_CACHE_MAX)
+    {
+        meta_cache.clear();
+    }
+    auto rendered = RenderedLogMetaData::Create(meta);
+    meta_cache[logevent.sender->object_path] = rendered;
+    return rendered;
+}
+
+
+void AttachedService::process_log_event(const Events::Log &logevent)
+{
     Events::Log local_event(logevent);
     local_event.AddLogTag(logtag);
-    log->Log(local_event, meta);
+    log->Log(local_event, get_metadata(logevent));
 
     for (const auto &[proxy_tgt, sig_proxy] : proxies)
     {
@@ -57,6 +57,7 @@ struct Configuration
     std::string log_file = "";
     std::string log_method = "";
     int32_t syslog_facility = LOG_DAEMON;
+    bool syslog_rfc5424 = false;
     bool log_dbus_details = false;
     bool log_prefix_logtag = true;
     bool log_timestamp = true;
@@ -94,6 +95,20 @@ class AttachedService
     std::map<DBus::Object::Path, std::shared_ptr<ProxyLogEvents>> proxies = {};
     DBus::Object::Path override_obj_path{};
 
+    /**
+     *  Pre-rendered meta data for the log events, per object path of the
+     *  sender.  The meta data only depends on the sender details, which
+     *  rarely change for an attached service.  This is reset when the
+     *  object path is overridden.
+     */
+    std::map<DBus::Object::Path, RenderedLogMetaData::Ptr> meta_cache = {};
+    std::mutex meta_cache_mtx{};
+
+    /**
+     *  Upper limit of meta_cache entries; the cache is reset when reached
+     */
+    static constexpr size_t META_CACHE_MAX = 64;
+
     AttachedService(DBus::Connection::Ptr conn,
                     DBus::Object::Manager::Ptr obj_mgr,
                     LogService::Logger::Ptr log,
@@ -102,6 +117,7 @@ class AttachedService
                     const std::string &busname,
                     const std::string &interface);
 
+    RenderedLogMetaData::Ptr get_metadata(const Events::Log &logevent);
     void process_log_event(const Events::Log &logevent);
     void process_statuschg_event(const std::string &sender,
                                  const DBus::Object::Path &path,
@@ -129,6 +129,35 @@ LogMetaData::Records LogMetaData::GetMetaDataRecords(const bool upcase_label,
 }
 
 
+std::string LogMetaData::GetStructuredDataParams() const
+{
+    std::string ret;
+    for (const auto &mdc : metadata)
+    {
+        // RFC 5424, section 6.3.3: PARAM-NAME is 1-32 printable US-ASCII
+        // characters except '=', ' ', ']' and '"'.  In PARAM-VALUE the
+        // characters '"', '\\' and ']' must be escaped.
+        ret.append(1, ' ');
+        for (const char c : mdc->label.substr(0, 32))
+        {
+            bool valid = (c > 32 && c < 127 && '=' != c && ']' != c && '"' != c);
+            ret.append(1, (valid ? c : '_'));
+        }
+        ret.append("=\"");
+        for (const char c : mdc->GetValue(false))
+        {
+            if ('"' == c || '\\' == c || ']' == c)
+            {
+                ret.append(1, '\\');
+            }
+            ret.append(1, c);
+        }
+        ret.append(1, '"');
+    }
+    return ret;
+}
+
+
 size_t LogMetaData::size() const
 {
     return metadata.size();
@@ -154,3 +183,39 @@ LogMetaData::LogMetaData(const LogMetaData &src)
         metadata.push_back(e);
     }
 }
+
+
+
+//
+//  RenderedLogMetaData  -  implementation
+//
+
+RenderedLogMetaData::Ptr RenderedLogMetaData::Create(const LogMetaData::Ptr md)
+{
+    std::vector<std::string> fields;
+    std::string text;
+    std::string sd_params;
+    if (md)
+    {
+        for (auto &rec : md->GetMetaDataRecords(true, false))
+        {
+            fields.push_back("O3_" + rec);
+        }
+        std::ostringstream txt;
+        txt << md;
+        text = txt.str();
+        sd_params = md->GetStructuredDataParams();
+    }
+    return RenderedLogMetaData::Ptr(new RenderedLogMetaData(std::move(fields),
+                                                            std::move(text),
+                                                            std::move(sd_params)));
+}
+
+
+RenderedLogMetaData::RenderedLogMetaData(std::vector<std::string> &&fields,
+                                         std::string &&txt,
+                                         std::string &&sdp)
+    : journald_fields(std::move(fields)), text(std::move(txt)),
+      sd_params(std::move(sdp))
+{
+}
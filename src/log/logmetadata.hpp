@@ -9,7 +9,8 @@
 /**
  * @file   logmetadata.hpp
  *
- * @brief  Declaration of LogMetaData and LogMetaDataValue classes
+ * @brief  Declaration of LogMetaData, LogMetaDataValue and
+ *         RenderedLogMetaData classes
  */
 
 #pragma once
@@ -182,6 +183,17 @@ class LogMetaData
                                const bool logtag_encaps = true) const;
 
 
+    /**
+     *  Retrieve all collected meta data values formatted as RFC 5424
+     *  structured data parameters, as ' label="value"' for each value.
+     *  LogTag values are not encapsulated.  Characters not allowed in
+     *  a parameter name are replaced by '_' and the value is escaped.
+     *
+     * @return std::string with all the parameters, each with a leading space
+     */
+    std::string GetStructuredDataParams() const;
+
+
     /**
      *  Retrieve how many meta data values has been collected
      */
@@ -239,3 +251,83 @@ class LogMetaData
      */
     LogMetaData(const LogMetaData &src);
 };
+
+
+
+/**
+ *  An immutable copy of a LogMetaData container, where all the formats
+ *  used by the LogWriter implementations are rendered when it is created.
+ *
+ *  This is used for meta data which does not change between log events,
+ *  like the details of a service attached to the log service.  The
+ *  LogWriter implementations can then use the pre-rendered strings
+ *  directly for each log event instead of formatting them again.
+ */
+class RenderedLogMetaData
+{
+  public:
+    using Ptr = std::shared_ptr<const RenderedLogMetaData>;
+
+    /**
+     *  Render the meta data values of a LogMetaData container
+     *
+     * @param md  LogMetaData::Ptr with the values to render
+     * @return RenderedLogMetaData::Ptr to the new immutable object
+     */
+    [[nodiscard]] static RenderedLogMetaData::Ptr Create(const LogMetaData::Ptr md);
+
+    ~RenderedLogMetaData() noexcept = default;
+
+    /**
+     *  Retrieve the meta data as systemd-journald fields, formatted as
+     *  "O3_LABEL=value" with the label in upper case and LogTag values
+     *  without the '{tag:...}' encapsulation.  All values are included,
+     *  also those to be skipped in the text form.
+     *
+     * @return const std::vector<std::string> reference of the fields
+     */
+    const std::vector<std::string> &GetJournaldFields() const noexcept
+    {
+        return journald_fields;
+    }
+
+    /**
+     *  Retrieve the meta data formatted as a single text line, identical
+     *  to what the LogMetaData::operator<<() provides
+     *
+     * @return const std::string reference of the text line
+     */
+    const std::string &GetText() const noexcept
+    {
+        return text;
+    }
+
+    /**
+     *  Retrieve the meta data formatted as RFC 5424 structured data
+     *  parameters, see LogMetaData::GetStructuredDataParams()
+     *
+     * @return const std::string reference of the parameters
+     */
+    const std::string &GetStructuredDataParams() const noexcept
+    {
+        return sd_params;
+    }
+
+    /**
+     *  Check if this object carries any meta data values
+     */
+    bool empty() const noexcept
+    {
+        return journald_fields.empty();
+    }
+
+
+  private:
+    const std::vector<std::string> journald_fields;
+    const std::string text;
+    const std::string sd_params;
+
+    RenderedLogMetaData(std::vector<std::string> &&fields,
+                        std::string &&txt,
+                        std::string &&sdp);
+};
@@ -36,32 +36,27 @@ LogTag::LogTag(std::string sender, std::string interface, const bool default_enc
     // Create a hash of the tag, used as an index
     std::hash<std::string> hashfunc;
     hash = hashfunc(tag);
+
+    // The string forms of the tag are used for every log event
+    tag_bare = std::to_string(hash);
+    tag_encaps = "{tag:" + tag_bare + "}";
 }
 
 
 LogTag::LogTag(const LogTag &cp)
+    : tag(cp.tag), hash(cp.hash), encaps(cp.encaps),
+      tag_bare(cp.tag_bare), tag_encaps(cp.tag_encaps)
 {
-    tag = cp.tag;
-    hash = cp.hash;
-    encaps = cp.encaps;
 }
 
 
-const std::string LogTag::str() const
+const std::string &LogTag::str() const noexcept
 {
     return LogTag::str(encaps);
 }
 
 
-const std::string LogTag::str(const bool encaps_override) const
+const std::string &LogTag::str(const bool encaps_override) const noexcept
 {
-    if (encaps_override)
-    {
-        return std::string("{tag:") + std::string(std::to_string(hash))
-               + std::string("}");
-    }
-    else
-    {
-        return std::string(std::to_string(hash));
-    }
+    return (encaps_override ? tag_encaps : tag_bare);
 }
@@ -17,12 +17,17 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 
 
 /**
  *  This provides a more generic interface to generate and process
  *  the log tags and hashes used to separate log events from various
  *  attached log senders.
+ *
+ *  Both the encapsulated and the bare string forms of the tag are
+ *  rendered when the object is created, as they are used for each
+ *  log event written.
  */
 struct LogTag
 {
@@ -58,7 +63,7 @@ struct LogTag
      * @return  Returns a std::string containing the tag this sender and
      *          interface will use
      */
-    const std::string str(const bool encaps_override) const;
+    const std::string &str(const bool encaps_override) const noexcept;
 
 
     /**
@@ -68,7 +73,37 @@ struct LogTag
      * @return  Returns a std::string containing the tag this sender and
      *          interface will use
      */
-    const std::string str() const;
+    const std::string &str() const noexcept;
+
+
+    /**
+     *  Same as @str(const bool), but returns a std::string_view to the
+     *  pre-rendered tag string.  This is intended for the LogWriter
+     *  implementations appending the tag to their output buffers.
+     *
+     *  The view is valid as long as this LogTag object exists.
+     *
+     * @param encaps_override  Bool flag to override the default encapsulating
+     *                         of the tag hash.
+     *
+     * @return  Returns a std::string_view of the tag string
+     */
+    std::string_view strview(const bool encaps_override) const noexcept
+    {
+        return (encaps_override ? tag_encaps : tag_bare);
+    }
+
+
+    /**
+     *  Same as @strview(const bool), using the default_encaps setting
+     *  given to the constructor.
+     *
+     * @return  Returns a std::string_view of the tag string
+     */
+    std::string_view strview() const noexcept
+    {
+        return strview(encaps);
+    }
 
 
     /**
@@ -90,5 +125,8 @@ struct LogTag
     bool encaps = true; /**<  Encapsulate the hash value in "{tag:...}" */
 
   private:
+    std::string tag_bare{};   /**<  Pre-rendered hash value string */
+    std::string tag_encaps{}; /**<  Pre-rendered "{tag:...}" string */
+
     LogTag(std::string sender, std::string interface, const bool default_encaps = true);
 };
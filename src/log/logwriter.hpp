@@ -220,12 +220,73 @@ class LogWriter
     }
 
 
+    /**
+     *  Adds pre-rendered meta log info to the next log line written.
+     *  The object is shared with the caller and not copied; it is
+     *  released again after the next log line has been written.
+     *
+     *  Meta data added via AddMeta() or AddMetaCopy() is logged after
+     *  the pre-rendered meta data.
+     *
+     * @param mdr  RenderedLogMetaData::Ptr with the meta data
+     */
+    void AddMetaRendered(const RenderedLogMetaData::Ptr &mdr)
+    {
+        rendered_meta = mdr;
+    }
+
+
   protected:
     bool timestamp = true;
     bool log_meta = true;
     LogMetaData::Ptr metadata = nullptr;
+    RenderedLogMetaData::Ptr rendered_meta = nullptr;
     bool prepend_prefix = true;
 
+
+    /**
+     *  Check if there is any meta data to log with the next log line
+     */
+    bool meta_pending() const noexcept
+    {
+        return (rendered_meta && !rendered_meta->empty())
+               || (metadata && !metadata->empty());
+    }
+
+
+    /**
+     *  Append the meta data for the next log line as a single text line
+     *
+     * @param buf  std::string buffer to append the meta data to
+     */
+    void append_meta_text(std::string &buf) const
+    {
+        bool rendered = (rendered_meta && !rendered_meta->empty());
+        if (rendered)
+        {
+            buf.append(rendered_meta->GetText());
+        }
+        if (metadata && !metadata->empty())
+        {
+            std::ostringstream md;
+            md << (rendered ? ", " : "") << metadata;
+            buf.append(md.str());
+        }
+    }
+
+
+    /**
+     *  Release the meta data after a log line has been written
+     */
+    void clear_meta() noexcept
+    {
+        if (metadata)
+        {
+            metadata->clear();
+        }
+        rendered_meta.reset();
+    }
+
     /**
      *  Writes log data and an optional LogTag to the log destination
      *
@@ -15,5 +15,6 @@
 #pragma once
 
 #include "journald.hpp"
+#include "rfc5424.hpp"
 #include "streamwriter.hpp"
 #include "syslog.hpp"
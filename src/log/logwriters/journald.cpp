@@ -20,6 +20,7 @@
 #include <sys/uio.h>
 #include <ctype.h>
 #include <string>
+#include <vector>
 
 #define SD_JOURNAL_SUPPRESS_LOCATION
 #include <systemd/sd-journal.h>
@@ -73,24 +74,37 @@ void JournaldWriter::WriteLogLine(LogTag::Ptr logtag,
 
 void JournaldWriter::Write(const Events::Log &event)
 {
-    // We need extra elements for O3_LOGTAG, O3_SESSION_TOKEN,
-    // O3_LOG_GROUP, O3_LOG_CATEGORY, MESSAGE and
-    // the NULL termination
-    size_t meta_size = (metadata ? metadata->size() : 0) + 8;
-    struct iovec *l = (struct iovec *)calloc(sizeof(struct iovec) + 2,
-                                             meta_size);
+    // The iovec elements point directly at the strings prepared here
+    // and at the pre-rendered meta data; sd_journal_sendv() does not
+    // modify them.  This avoids copying each field before sending.
+    std::vector<struct iovec> l;
+    l.reserve((rendered_meta ? rendered_meta->GetJournaldFields().size() : 0)
+              + (metadata ? metadata->size() : 0) + 7);
+    auto add = [&l](const std::string &field)
+    {
+        l.push_back({const_cast<char *>(field.data()), field.length()});
+    };
 
     // Add the fixed O3_LOG_SENDER data, to more easily identify
     // log events from this log service across all Linux distros in the journal
-    size_t i = 0;
-    l[i++] = {(char *)strdup(log_sender.c_str()), log_sender.length()};
+    add(log_sender);
 
+    if (rendered_meta)
+    {
+        for (const auto &field : rendered_meta->GetJournaldFields())
+        {
+            add(field);
+        }
+    }
+
+    LogMetaData::Records mdrecs;
     if (metadata)
     {
-        for (const auto &mdr : metadata->GetMetaDataRecords(true, false))
+        mdrecs = metadata->GetMetaDataRecords(true, false);
+        for (auto &mdr : mdrecs)
         {
-            std::string md = std::string("O3_") + mdr;
-            l[i++] = {(char *)strdup(md.c_str()), md.length()};
+            mdr.insert(0, "O3_");
+            add(mdr);
         }
     }
 
@@ -98,51 +112,40 @@ void JournaldWriter::Write(const Events::Log &event)
     std::string logtag_str("O3_LOGTAG=");
     if (logtag)
     {
-        logtag_str += logtag->str(false);
-        l[i++] = {(char *)strdup(logtag_str.c_str()), logtag_str.length()};
+        logtag_str.append(logtag->strview(false));
+        add(logtag_str);
     }
 
     std::string st("O3_SESSION_TOKEN=");
     if (!event.session_token.empty())
     {
         st += event.session_token;
-        l[i++] = {(char *)strdup(st.c_str()), st.length()};
+        add(st);
     }
 
     std::string lg("O3_LOG_GROUP=" + event.GetLogGroupStr());
-    l[i++] = {(char *)strdup(lg.c_str()), lg.length()};
+    add(lg);
 
     std::string lc("O3_LOG_CATEGORY=" + event.GetLogCategoryStr());
-    l[i++] = {(char *)strdup(lc.c_str()), lc.length()};
+    add(lc);
 
-    std::string m("MESSAGE=");
+    std::string m;
+    m.reserve(8 + (logtag ? logtag->strview(true).size() + 1 : 0)
+              + event.message.size());
+    m.append("MESSAGE=");
     if (prepend_prefix && logtag)
     {
-        m += logtag->str(true) + " ";
+        m.append(logtag->strview(true)).append(1, ' ');
     }
+    m.append(event.message);
+    add(m);
 
-    m += event.message;
-    l[i++] = {(char *)strdup(m.c_str()), m.length()};
-    l[i] = {NULL};
-
-    int r = sd_journal_sendv(l, i);
+    int r = sd_journal_sendv(l.data(), l.size());
     if (0 != r)
     {
         std::cout << "ERROR: " << strerror(errno) << std::endl;
     }
 
-    // struct iovec is a C interface; need to clean up manually
-    for (size_t j = 0; j < i; j++)
-    {
-        free(l[j].iov_base);
-        l[j].iov_base = 0;
-        l[j].iov_len = 0;
-    }
-    free(l);
-
-    if (metadata)
-    {
-        metadata->clear();
-    }
+    clear_meta();
 }
 #endif // HAVE_SYSTEMD
@@ -0,0 +1,328 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   rfc5424.cpp
+ *
+ * @brief  Implementation of RFC5424SyslogWriter
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../logwriter.hpp"
+#include "rfc5424.hpp"
+
+
+/**
+ *  Make a string usable as a HOSTNAME or APP-NAME field of the RFC 5424
+ *  header.  Only printable US-ASCII characters are allowed; others are
+ *  replaced by '_'.  An empty field is sent as the NILVALUE, '-'.
+ *
+ * @param value   std::string with the field value
+ * @param maxlen  size_t with the maximum length of the field
+ * @return std::string with the field to use
+ */
+static std::string header_field(const std::string &value, const size_t maxlen)
+{
+    std::string ret = value.substr(0, maxlen);
+    std::replace_if(
+        ret.begin(),
+        ret.end(),
+        [](const char c)
+        {
+            return c < 33 || c > 126;
+        },
+        '_');
+    return (ret.empty() ? "-" : ret);
+}
+
+
+//
+//  RFC5424SyslogWriter - implementation
+//
+RFC5424SyslogWriter::RFC5424SyslogWriter(const std::string &prgname,
+                                         const int log_facility,
+                                         const std::string &sockpath)
+    : LogWriter(),
+      facility(log_facility & LOG_FACMASK),
+      socket_path(sockpath)
+{
+    if (!connect_socket())
+    {
+        throw SyslogException("Could not connect to " + socket_path + ": "
+                              + std::string(strerror(errno)));
+    }
+
+    // The HOSTNAME, APP-NAME, PROCID and MSGID fields are the same
+    // for all messages
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    header = " " + header_field(hostname, 255)
+             + " " + header_field(prgname.substr(prgname.rfind('/') + 1), 48)
+             + " " + std::to_string(getpid())
+             + " - ";
+
+    writer_thread = std::thread(&RFC5424SyslogWriter::writer_loop, this);
+}
+
+
+RFC5424SyslogWriter::~RFC5424SyslogWriter()
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        running = false;
+    }
+    queue_cv.notify_one();
+    if (writer_thread.joinable())
+    {
+        writer_thread.join();
+    }
+    if (sockfd >= 0)
+    {
+        close(sockfd);
+    }
+}
+
+
+const std::string RFC5424SyslogWriter::GetLogWriterInfo() const
+{
+    return std::string("syslog (RFC 5424 via ") + socket_path + ")";
+}
+
+
+bool RFC5424SyslogWriter::TimestampEnabled()
+{
+    return true;
+}
+
+
+void RFC5424SyslogWriter::WriteLogLine(LogTag::Ptr logtag,
+                                       const std::string &data,
+                                       const std::string &colour_init,
+                                       const std::string &colour_reset)
+{
+    // Colours are ignored, as with SyslogWriter
+    queue_message(format_message(LOG_INFO, logtag, "", data, true));
+    clear_meta();
+}
+
+
+void RFC5424SyslogWriter::WriteLogLine(LogTag::Ptr logtag,
+                                       const LogGroup grp,
+                                       const LogCategory ctg,
+                                       const std::string &data,
+                                       const std::string &colour_init,
+                                       const std::string &colour_reset)
+{
+    queue_message(format_message(SyslogWriter::logcatg2syslog(ctg),
+                                 logtag,
+                                 LogPrefix(grp, ctg),
+                                 data,
+                                 true));
+    clear_meta();
+}
+
+
+bool RFC5424SyslogWriter::connect_socket()
+{
+    if (sockfd >= 0)
+    {
+        close(sockfd);
+        sockfd = -1;
+    }
+
+    struct sockaddr_un addr = {};
+    if (socket_path.size() >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+    sockfd = fd;
+    return true;
+}
+
+
+std::string RFC5424SyslogWriter::format_message(const int severity,
+                                                const LogTag::Ptr &logtag,
+                                                const std::string &prefix,
+                                                const std::string &data,
+                                                const bool with_meta) const
+{
+    // <PRI>VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID SD MSG
+    std::string msg;
+    msg.reserve(128 + header.size() + prefix.size() + data.size());
+    msg.append(1, '<')
+        .append(std::to_string(facility | (severity & LOG_PRIMASK)))
+        .append(">1 ");
+
+    struct timespec ts = {};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    struct tm tm = {};
+    gmtime_r(&ts.tv_sec, &tm);
+    char tstamp[40] = {};
+    size_t len = strftime(tstamp, sizeof(tstamp), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(tstamp + len, sizeof(tstamp) - len, ".%06ldZ", ts.tv_nsec / 1000);
+    msg.append(tstamp).append(header);
+
+    if (with_meta && log_meta && meta_pending())
+    {
+        msg.append(1, '[').append(SD_ID);
+        if (rendered_meta)
+        {
+            msg.append(rendered_meta->GetStructuredDataParams());
+        }
+        if (metadata)
+        {
+            msg.append(metadata->GetStructuredDataParams());
+        }
+        msg.append(1, ']');
+    }
+    else
+    {
+        msg.append(1, '-');
+    }
+    msg.append(1, ' ');
+
+    if (logtag)
+    {
+        msg.append(logtag->strview(true)).append(1, ' ');
+    }
+    msg.append(prefix).append(data);
+    return msg;
+}
+
+
+void RFC5424SyslogWriter::queue_message(std::string &&msg)
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        if (queue.size() >= MAX_QUEUE)
+        {
+            ++dropped;
+            return;
+        }
+        queue.push_back(std::move(msg));
+    }
+    queue_cv.notify_one();
+}
+
+
+void RFC5424SyslogWriter::writer_loop()
+{
+    std::vector<std::string> batch;
+    std::unique_lock<std::mutex> lock(queue_mtx);
+    while (running || !queue.empty())
+    {
+        queue_cv.wait(lock,
+                      [this]()
+                      {
+                          return !running || !queue.empty();
+                      });
+        batch.swap(queue);
+        size_t lost = dropped;
+        dropped = 0;
+        lock.unlock();
+
+        if (lost > 0)
+        {
+            batch.push_back(format_message(LOG_WARNING,
+                                           nullptr,
+                                           "",
+                                           std::to_string(lost)
+                                               + " log events were lost",
+                                           false));
+        }
+        send_messages(batch);
+        batch.clear();
+
+        lock.lock();
+    }
+}
+
+
+void RFC5424SyslogWriter::send_messages(const std::vector<std::string> &msgs)
+{
+    std::vector<struct iovec> iov(msgs.size());
+    std::vector<struct mmsghdr> hdrs(msgs.size());
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        iov[i].iov_base = const_cast<char *>(msgs[i].data());
+        iov[i].iov_len = msgs[i].size();
+        hdrs[i] = {};
+        hdrs[i].msg_hdr.msg_iov = &iov[i];
+        hdrs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    bool reconnected = false;
+    while (sent < msgs.size())
+    {
+        unsigned int vlen = static_cast<unsigned int>(
+            std::min(msgs.size() - sent, MAX_BATCH));
+        int r = sendmmsg(sockfd, &hdrs[sent], vlen, MSG_NOSIGNAL);
+        if (r > 0)
+        {
+            sent += static_cast<size_t>(r);
+            continue;
+        }
+        if (r < 0 && EINTR == errno)
+        {
+            continue;
+        }
+        if (r < 0 && !reconnected
+            && (ECONNREFUSED == errno || ENOTCONN == errno
+                || ECONNRESET == errno || EBADF == errno))
+        {
+            // The syslog daemon has most likely been restarted
+            reconnected = true;
+            if (connect_socket())
+            {
+                continue;
+            }
+        }
+        if (r < 0 && EMSGSIZE == errno)
+        {
+            // Only this message is too large for the socket; skip it
+            // and continue with the rest of the batch
+            std::lock_guard<std::mutex> guard(queue_mtx);
+            ++dropped;
+            ++sent;
+            continue;
+        }
+
+        // Just as syslog(3), give up on the messages which could not
+        // be delivered instead of blocking the log service.  They are
+        // reported with the next batch.
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        dropped += msgs.size() - sent;
+        break;
+    }
+}
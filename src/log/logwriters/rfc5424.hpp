@@ -0,0 +1,161 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   rfc5424.hpp
+ *
+ * @brief  Declaration of the RFC5424SyslogWriter implementation of LogWriter
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log/logwriter.hpp"
+#include "log/log-helpers.hpp"
+#include "syslog.hpp"
+
+
+/**
+ *  LogWriter sending RFC 5424 formatted messages directly to the local
+ *  syslog socket, without using syslog(3).
+ *
+ *  The messages are formatted by the caller of Write() and put on a
+ *  queue.  A separate writer thread sends all the queued messages with
+ *  a single sendmmsg(2) call over a connected AF_UNIX datagram socket.
+ *  The meta data is sent as structured data in the same message as the
+ *  log line, using the SD_ID structured data element.
+ */
+class RFC5424SyslogWriter : public LogWriter
+{
+  public:
+    /**
+     *  Structured data ID of the element carrying the meta data
+     */
+    static constexpr char SD_ID[] = "openvpn3";
+
+    /**
+     *  Maximum number of messages waiting to be sent.  When the queue
+     *  is full, new messages are dropped and a warning is sent once
+     *  the writer thread catches up.  Messages which could not be
+     *  delivered to the syslog socket are reported the same way.
+     */
+    static constexpr size_t MAX_QUEUE = 4096;
+
+    /**
+     *  Maximum number of messages sent in a single sendmmsg(2) call
+     */
+    static constexpr size_t MAX_BATCH = 256;
+
+
+    /**
+     *  Initialize the RFC5424SyslogWriter
+     *
+     * @param prgname       std::string containing the program identifier,
+     *                      used as the APP-NAME of the messages
+     * @param log_facility  Syslog facility to use for log messages.
+     *                      (Default: LOG_DAEMON)
+     * @param socket_path   std::string with the path to the syslog socket
+     *                      (Default: /dev/log)
+     *
+     * @throws SyslogException if the syslog socket could not be connected
+     */
+    RFC5424SyslogWriter(const std::string &prgname = "",
+                        const int log_facility = LOG_DAEMON,
+                        const std::string &socket_path = "/dev/log");
+    virtual ~RFC5424SyslogWriter();
+
+    const std::string GetLogWriterInfo() const override;
+
+    /**
+     *  Each RFC 5424 message carries a timestamp, regardless of the
+     *  timestamp flag.
+     *
+     * @return Will always return true.
+     */
+    bool TimestampEnabled() override;
+
+
+  protected:
+    void WriteLogLine(LogTag::Ptr logtag,
+                      const std::string &data,
+                      const std::string &colour_init = "",
+                      const std::string &colour_reset = "") override;
+
+
+    void WriteLogLine(LogTag::Ptr logtag,
+                      const LogGroup grp,
+                      const LogCategory ctg,
+                      const std::string &data,
+                      const std::string &colour_init,
+                      const std::string &colour_reset) override;
+
+
+  private:
+    const int facility;
+    const std::string socket_path;
+    std::string header{};
+    int sockfd = -1;
+
+    std::mutex queue_mtx{};
+    std::condition_variable queue_cv{};
+    std::vector<std::string> queue{};
+    size_t dropped = 0;
+    bool running = true;
+    std::thread writer_thread{};
+
+
+    /**
+     *  (Re)connect the socket to the syslog socket path
+     *
+     * @return true if the socket was connected, otherwise false with
+     *         errno set
+     */
+    bool connect_socket();
+
+    /**
+     *  Format a complete RFC 5424 message
+     *
+     * @param severity   int with the syslog(3) log level
+     * @param logtag     LogTag::Ptr to prefix the message with, may be nullptr
+     * @param prefix     std::string put between the LogTag and the data
+     * @param data       std::string with the log message
+     * @param with_meta  bool, if the pending meta data should be included
+     * @return std::string with the message
+     */
+    std::string format_message(const int severity,
+                               const LogTag::Ptr &logtag,
+                               const std::string &prefix,
+                               const std::string &data,
+                               const bool with_meta) const;
+
+    /**
+     *  Put a formatted message on the queue of the writer thread
+     *
+     * @param msg  std::string with the formatted message
+     */
+    void queue_message(std::string &&msg);
+
+    /**
+     *  Main loop of the writer thread, sending the queued messages
+     *  until the writer is destroyed
+     */
+    void writer_loop();
+
+    /**
+     *  Send a list of messages to the syslog socket with as few
+     *  sendmmsg(2) calls as possible
+     *
+     * @param msgs  std::vector<std::string> with the messages to send
+     */
+    void send_messages(const std::vector<std::string> &msgs);
+};
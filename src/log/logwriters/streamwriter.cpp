@@ -45,16 +45,18 @@ void StreamLogWriter::WriteLogLine(LogTag::Ptr logtag,
                                    const std::string &colour_init,
                                    const std::string &colour_reset)
 {
-    if (log_meta && metadata && !metadata->empty())
+    if (log_meta && meta_pending())
     {
         dest << (timestamp ? GetTimestamp() : "") << " "
              << colour_init;
 
-        if (!metadata->empty() && logtag)
+        std::string meta;
+        if (logtag)
         {
-            dest << logtag->str(true) << " ";
+            meta.append(logtag->strview(true)).append(1, ' ');
         }
-        dest << metadata << colour_reset
+        append_meta_text(meta);
+        dest << meta << colour_reset
              << std::endl;
     }
 
@@ -62,14 +64,11 @@ void StreamLogWriter::WriteLogLine(LogTag::Ptr logtag,
          << colour_init;
     if (prepend_prefix && logtag)
     {
-        dest << logtag->str(true) << " ";
+        dest << logtag->strview(true) << ' ';
     }
     dest << data << colour_reset << std::endl;
 
-    if (metadata)
-    {
-        metadata->clear();
-    }
+    clear_meta();
 }
 
 
@@ -60,25 +60,23 @@ void SyslogWriter::WriteLogLine(LogTag::Ptr logtag,
     // care of that.  We also do not do anything about
     // colours, as that can mess up the log files.
 
-    std::ostringstream logtag_str;
+    std::string line;
     if (logtag)
     {
-        logtag_str << logtag->str(true) << " ";
+        line.append(logtag->strview(true)).append(1, ' ');
     }
+    const size_t tag_len = line.size();
 
-    if (log_meta && metadata && !metadata->empty())
+    if (log_meta && meta_pending())
     {
-        std::ostringstream meta_str;
-        meta_str << metadata;
-
-        syslog(LOG_INFO, "%s%s", logtag_str.str().c_str(), meta_str.str().c_str());
+        append_meta_text(line);
+        syslog(LOG_INFO, "%s", line.c_str());
+        line.resize(tag_len);
     }
 
-    syslog(LOG_INFO, "%s%s", logtag_str.str().c_str(), data.c_str());
-    if (metadata)
-    {
-        metadata->clear();
-    }
+    line.append(data);
+    syslog(LOG_INFO, "%s", line.c_str());
+    clear_meta();
 }
 
 
@@ -93,31 +91,21 @@ void SyslogWriter::WriteLogLine(LogTag::Ptr logtag,
     // we have access to LogGroup and LogCategory, so we
     // include that information.
 
-    std::ostringstream logtag_str;
+    std::string line;
     if (logtag)
     {
-        logtag_str << logtag->str(true) << " ";
+        line.append(logtag->strview(true)).append(1, ' ');
     }
+    const size_t tag_len = line.size();
 
-    if (log_meta && metadata && !metadata->empty())
+    if (log_meta && meta_pending())
     {
-        std::ostringstream meta_str;
-        meta_str << metadata;
-
-        syslog(logcatg2syslog(ctg),
-               "%s%s",
-               logtag_str.str().c_str(),
-               meta_str.str().c_str());
+        append_meta_text(line);
+        syslog(logcatg2syslog(ctg), "%s", line.c_str());
+        line.resize(tag_len);
     }
 
-    syslog(logcatg2syslog(ctg),
-           "%s%s%s",
-           logtag_str.str().c_str(),
-           LogPrefix(grp, ctg).c_str(),
-           data.c_str());
-
-    if (metadata)
-    {
-        metadata->clear();
-    }
+    line.append(LogPrefix(grp, ctg)).append(data);
+    syslog(logcatg2syslog(ctg), "%s", line.c_str());
+    clear_meta();
 }
@@ -120,24 +120,6 @@ class SyslogWriter : public LogWriter
     }
 
 
-  protected:
-    void WriteLogLine(LogTag::Ptr logtag,
-                      const std::string &data,
-                      const std::string &colour_init = "",
-                      const std::string &colour_reset = "") override;
-
-
-    void WriteLogLine(LogTag::Ptr logtag,
-                      const LogGroup grp,
-                      const LogCategory ctg,
-                      const std::string &data,
-                      const std::string &colour_init,
-                      const std::string &colour_reset) override;
-
-
-  private:
-    char *progname = nullptr;
-
     /**
      *  Simple conversion between LogCategory and a corresponding
      *  log level used by syslog(3).
@@ -173,4 +155,23 @@ class SyslogWriter : public LogWriter
             return LOG_INFO;
         }
     }
+
+
+  protected:
+    void WriteLogLine(LogTag::Ptr logtag,
+                      const std::string &data,
+                      const std::string &colour_init = "",
+                      const std::string &colour_reset = "") override;
+
+
+    void WriteLogLine(LogTag::Ptr logtag,
+                      const LogGroup grp,
+                      const LogCategory ctg,
+                      const std::string &data,
+                      const std::string &colour_init,
+                      const std::string &colour_reset) override;
+
+
+  private:
+    char *progname = nullptr;
 };
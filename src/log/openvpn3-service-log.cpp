@@ -99,6 +99,7 @@ static int logger_service(ParsedArgs::Ptr args)
                                        excp.what());
             }
         }
+        servicecfg.syslog_rfc5424 = args->Present("syslog-rfc5424");
     }
 #ifdef HAVE_SYSTEMD
     else if (args->Present("journald"))
@@ -152,8 +153,24 @@ static int logger_service(ParsedArgs::Ptr args)
         if ("syslog" == servicecfg.log_method)
         {
             do_console_info = true;
-            logwr.reset(new SyslogWriter(args->GetArgv0(),
-                                         servicecfg.syslog_facility));
+            if (servicecfg.syslog_rfc5424)
+            {
+                try
+                {
+                    logwr.reset(new RFC5424SyslogWriter(args->GetArgv0(),
+                                                        servicecfg.syslog_facility));
+                }
+                catch (const SyslogException &excp)
+                {
+                    throw CommandException("openvpn3-service-log",
+                                           excp.what());
+                }
+            }
+            else
+            {
+                logwr.reset(new SyslogWriter(args->GetArgv0(),
+                                             servicecfg.syslog_facility));
+            }
         }
         else if (servicecfg.log_colour)
         {
@@ -267,6 +284,10 @@ int main(int argc, char **argv)
                         "FACILITY",
                         true,
                         "Use a specific syslog facility (Default: LOG_DAEMON)");
+    argparser.AddOption("syslog-rfc5424",
+                        0,
+                        "Send RFC 5424 formatted log events directly to "
+                        "/dev/log (requires --syslog)");
     argparser.AddOption("log-file",
                         0,
                         "FILE",
@@ -22,6 +22,7 @@
 #include <gdbuspp/proxy/utils.hpp>
 
 #include "dbus/constants.hpp"
+#include "dbus/service-probe.hpp"
 
 using namespace DBus;
 
@@ -183,15 +184,15 @@ class LogServiceProxy
           logtarget(Proxy::TargetPreset::Create(Constants::GenPath("log"),
                                                 Constants::GenInterface("log")))
     {
-        if (!service_qry->CheckServiceAvail(logservice->GetDestination()))
+        if (!ServiceProbe::CheckServiceAvail(connection, logservice->GetDestination()))
         {
             throw DBus::Exception("LogServiceProxy", "Log service inaccessible");
         }
         try
         {
-            auto proxy_qry = Proxy::Utils::Query::Create(logservice);
-            (void)proxy_qry->ServiceVersion(logtarget->object_path,
-                                            logtarget->interface);
+            (void)ServiceProbe::ServiceVersion(logservice,
+                                               logtarget->object_path,
+                                               logtarget->interface);
             cache_initial_settings();
         }
         catch (const DBus::Exception &)
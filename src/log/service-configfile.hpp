@@ -54,6 +54,9 @@ class LogServiceConfigFile : public virtual Configuration::File
             OptionMapEntry{"syslog-facility", "syslog_facility",
                            "Syslog facility",
                            OptionValueType::String},
+            OptionMapEntry{"syslog-rfc5424", "syslog_rfc5424",
+                           "Send RFC 5424 messages directly to /dev/log",
+                           OptionValueType::Present},
             OptionMapEntry{"log-file", "log_file",
                            "log_method_group",
                            "Log file",
@@ -44,6 +44,18 @@ class Logger
     void Log(const Events::Log &logev,
              LogMetaData::Ptr metadata = nullptr,
              const bool duplicate_check = false);
+
+    /**
+     *  Log an event with pre-rendered meta data.  The meta data object
+     *  is passed on to the LogWriter without being copied.
+     *
+     * @param logev            Events::Log to log
+     * @param metadata         RenderedLogMetaData::Ptr to log with the event
+     * @param duplicate_check  Skip the event if identical to the last one
+     */
+    void Log(const Events::Log &logev,
+             const RenderedLogMetaData::Ptr &metadata,
+             const bool duplicate_check = false);
     void Debug(const std::string &msg,
                LogMetaData::Ptr md = nullptr,
                const bool duplicate_check = false);
@@ -66,6 +78,8 @@ class Logger
     LogWriter::Ptr GetLogWriter() const noexcept;
 
   private:
+    bool allowed(const Events::Log &logev, const bool duplicate_check) const;
+
     LogWriter::Ptr logwr = nullptr;
     const LogGroup loggroup = LogGroup::UNDEFINED;
     Log::EventFilter::Ptr filter = nullptr;
@@ -86,21 +100,28 @@ inline Logger::Logger(LogWriter::Ptr logwr_,
 }
 
 
-inline void Logger::Log(const Events::Log &logev,
-                        LogMetaData::Ptr metadata,
-                        const bool duplicate_check)
+inline bool Logger::allowed(const Events::Log &logev,
+                            const bool duplicate_check) const
 {
     if (duplicate_check && logev == last_log)
     {
         // If duplicate check is enabled, we skip this log event if
         // it's identical to the last previously logged event
-        return;
+        return false;
     }
 
-    if (filter && !filter->Allow(logev))
+    // Only perform the logging if the log event is within the log level
+    // scope of this logger service
+    return !filter || filter->Allow(logev);
+}
+
+
+inline void Logger::Log(const Events::Log &logev,
+                        LogMetaData::Ptr metadata,
+                        const bool duplicate_check)
+{
+    if (!allowed(logev, duplicate_check))
     {
-        // Only perform the logging if the log event is within the log level
-        // scope of this logger service
         return;
     }
 
@@ -114,6 +135,25 @@ inline void Logger::Log(const Events::Log &logev,
 }
 
 
+inline void Logger::Log(const Events::Log &logev,
+                        const RenderedLogMetaData::Ptr &metadata,
+                        const bool duplicate_check)
+{
+    if (!allowed(logev, duplicate_check))
+    {
+        return;
+    }
+
+    if (metadata)
+    {
+        logwr->AddMetaRendered(metadata);
+    }
+
+    logwr->Write(logev);
+    last_log = logev;
+}
+
+
 inline void Logger::Debug(const std::string &msg,
                           LogMetaData::Ptr md,
                           const bool duplicate_check)
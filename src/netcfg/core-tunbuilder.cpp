@@ -20,6 +20,15 @@
 
 #include "build-config.h"
 
+#include <map>
+#include <set>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <linux/if_tun.h>
+
 // Enable D-Bus logging of Core library
 //
 // The OPENVPN_EXTERN macro must be defined as well as
@@ -35,12 +44,20 @@
 #include <openvpn/tun/linux/client/tuncli.hpp>
 
 #include "common/utils.hpp"
+#include "netcfg-configdiff.hpp"
 #include "netcfg-device.hpp"
 #include "netcfg-signals.hpp"
 
 
 #define TUN_CLASS_SETUP TunLinuxSetup::Setup<TUN_LINUX>
 
+// UDP segmentation offload was added in Linux 6.2
+#ifndef TUN_F_USO4
+#define TUN_F_USO4 0x20
+#define TUN_F_USO6 0x40
+#endif
+#define TUN_OFFLOAD_FLAGS (TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 | TUN_F_USO4 | TUN_F_USO6)
+
 namespace openvpn {
 
 class CoreTunbuilderImpl : public CoreTunbuilder
@@ -73,6 +90,205 @@ class CoreTunbuilderImpl : public CoreTunbuilder
     }
 
 
+    /**
+     * Opens the queues of a new tun device.  If more than one queue is
+     * requested, the device is created with IFF_MULTI_QUEUE.
+     *
+     * @param queues    Number of queues to open
+     * @param vnet_hdr  If true, the device is created with IFF_VNET_HDR
+     *
+     * @return std::vector<int> with one fd per queue
+     */
+    std::vector<int> open_tun_queues(const unsigned int queues, const bool vnet_hdr)
+    {
+        std::vector<int> fds;
+        std::string iface_name;
+        for (unsigned int i = 0; i < queues; ++i)
+        {
+            int fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+            if (fd < 0)
+            {
+                close_fds(fds);
+                throw NetCfgException(std::string("Failed opening tun device: ")
+                                      + strerror(errno));
+            }
+            fds.push_back(fd);
+
+            // The first queue creates the device, the following
+            // queues are attached to the same device
+            struct ifreq ifr = {};
+            ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+            ifr.ifr_flags |= (queues > 1 ? IFF_MULTI_QUEUE : 0);
+            ifr.ifr_flags |= (vnet_hdr ? IFF_VNET_HDR : 0);
+            strncpy(ifr.ifr_name, iface_name.c_str(), IFNAMSIZ - 1);
+            if (ioctl(fd, TUNSETIFF, (void *)&ifr) < 0)
+            {
+                close_fds(fds);
+                throw NetCfgException(std::string("Failed setting up tun queue: ")
+                                      + strerror(errno));
+            }
+            iface_name = ifr.ifr_name;
+        }
+        return fds;
+    }
+
+
+    static void close_fds(const std::vector<int> &fds)
+    {
+        for (const auto fd : fds)
+        {
+            close(fd);
+        }
+    }
+
+
+    /**
+     * Enables segmentation and checksum offloading on a tun device
+     * opened with IFF_VNET_HDR.  UDP segmentation offload is only
+     * supported by newer kernels; if not available, only TCP
+     * segmentation and checksum offloading is enabled.
+     *
+     * @param fd  File descriptor of the tun device
+     *
+     * @return The TUN_F_* flags which were enabled, 0 if offloading
+     *         could not be enabled at all
+     */
+    static unsigned int enable_offload(int fd)
+    {
+        for (const unsigned int flags : {TUN_OFFLOAD_FLAGS,
+                                         TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6})
+        {
+            if (0 == ioctl(fd, TUNSETOFFLOAD, flags))
+            {
+                return flags;
+            }
+        }
+        return 0;
+    }
+
+
+    /**
+     * Opens a new tun device directly, without using the OpenVPN 3 Core
+     * library.  This is used for multi-queue and offload capable devices,
+     * which the Core library does not know how to open.  Only the address
+     * and route configuration is done via the Core library.
+     *
+     * @param tbc     TunBuilderCapture that specifies the configuration
+     * @param config  Tun Linux specific configuration.  The iface_name
+     *                will be set to the name of the new device
+     * @param queues  Number of queues to open
+     * @param offload If true, enable the IFF_VNET_HDR mode with offloading
+     * @param offload_flags  Returns the enabled TUN_F_* offload flags.  If
+     *                0, the device does not use the virtio-net header
+     *
+     * @return std::vector<int> with one fd per queue
+     */
+    std::vector<int> establish_tun_direct(const TunBuilderCapture &tbc,
+                                          TUN_CLASS_SETUP::Config &config,
+                                          const unsigned int queues,
+                                          const bool offload,
+                                          unsigned int &offload_flags)
+    {
+        offload_flags = 0;
+        std::vector<int> fds = open_tun_queues(queues, offload);
+        if (offload)
+        {
+            // The offload flags are per device, so it is enough
+            // to set them via the first queue
+            offload_flags = enable_offload(fds[0]);
+            if (0 == offload_flags)
+            {
+                // The virtio-net header is of no use without
+                // offloading; fall back to a plain tun device
+                OPENVPN_LOG("Tun device offloading not available: "
+                            + std::string(strerror(errno)));
+                close_fds(fds);
+                fds = open_tun_queues(queues, false);
+            }
+        }
+
+        struct ifreq ifr = {};
+        if (ioctl(fds[0], TUNGETIFF, (void *)&ifr) < 0)
+        {
+            close_fds(fds);
+            throw NetCfgException(std::string("Failed retrieving tun device name: ")
+                                  + strerror(errno));
+        }
+        const std::string iface_name(ifr.ifr_name);
+        config.iface_name = iface_name;
+
+        if (config.txqueuelen > 0)
+        {
+            int ctl_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            struct ifreq qlen = {};
+            strncpy(qlen.ifr_name, iface_name.c_str(), IFNAMSIZ - 1);
+            qlen.ifr_qlen = config.txqueuelen;
+            if (ctl_fd < 0 || ioctl(ctl_fd, SIOCSIFTXQLEN, (void *)&qlen) < 0)
+            {
+                OPENVPN_LOG("Failed setting txqueuelen on " + iface_name
+                            + ": " + strerror(errno));
+            }
+            if (ctl_fd >= 0)
+            {
+                close(ctl_fd);
+            }
+        }
+
+        std::vector<IP::Route> rtvec;
+        ActionList::Ptr add_cmds = new ActionList();
+        remove_cmds.reset(new ActionListReversed());
+        TUN_LINUX::TunMethods::tun_config(iface_name,
+                                          tbc,
+                                          &rtvec,
+                                          *add_cmds,
+                                          *remove_cmds,
+                                          TunConfigFlags::NONE);
+        add_cmds->execute_log();
+
+        return fds;
+    }
+
+
+    /**
+     * Adds the 'def1' style default routes to the configured networks
+     * if the default gateway is redirected
+     *
+     * @param networks      std::vector<Network> of the configured networks
+     * @param reroute_ipv4  Redirect the IPv4 default gateway
+     * @param reroute_ipv6  Redirect the IPv6 default gateway
+     * @param method        RedirectMethod in use
+     *
+     * @return std::vector<Network> with all the routes of the device
+     */
+    static std::vector<Network> expand_routes(const std::vector<Network> &networks,
+                                              const bool reroute_ipv4,
+                                              const bool reroute_ipv6,
+                                              const RedirectMethod method)
+    {
+        std::vector<Network> routes(networks);
+        switch (method)
+        {
+        case RedirectMethod::HOST_ROUTE:
+        case RedirectMethod::BINDTODEV:
+            if (reroute_ipv4)
+            {
+                routes.emplace_back("0.0.0.0", 1, false);
+                routes.emplace_back("128.0.0.0", 1, false);
+            }
+            if (reroute_ipv6)
+            {
+                routes.emplace_back("::", 1, true);
+                routes.emplace_back("8000::", 1, true);
+            }
+            break;
+
+        case RedirectMethod::NONE:
+            break;
+        }
+        return routes;
+    }
+
+
     /**
      * This create a TunBuilderCapture (OpenVPN3 internal representation)
      * from our internal representation in NetCfgDevice.
@@ -101,7 +317,10 @@ class CoreTunbuilderImpl : public CoreTunbuilder
                                             netCfgDevice.remote.ipv6);
 
         // Add routes
-        for (const auto &net : netCfgDevice.networks)
+        for (const auto &net : expand_routes(netCfgDevice.networks,
+                                             netCfgDevice.reroute_ipv4,
+                                             netCfgDevice.reroute_ipv6,
+                                             netCfgDevice.options.redirect_method))
         {
             if (net.exclude)
             {
@@ -114,30 +333,6 @@ class CoreTunbuilderImpl : public CoreTunbuilder
             }
         }
 
-        if (netCfgDevice.reroute_ipv4 || netCfgDevice.reroute_ipv6)
-        {
-            switch (netCfgDevice.options.redirect_method)
-            {
-            case RedirectMethod::HOST_ROUTE:
-            case RedirectMethod::BINDTODEV:
-                // Add 'def1' style default routes
-                if (netCfgDevice.reroute_ipv4)
-                {
-                    tbc->tun_builder_add_route("0.0.0.0", 1, -1, false);
-                    tbc->tun_builder_add_route("128.0.0.0", 1, -1, false);
-                }
-                if (netCfgDevice.reroute_ipv6)
-                {
-                    tbc->tun_builder_add_route("::", 1, -1, true);
-                    tbc->tun_builder_add_route("8000::", 1, -1, true);
-                }
-                break;
-
-            case RedirectMethod::NONE:
-                break;
-            }
-        }
-
         tbc->validate();
 
         // We ignore tbc.dns_servers and other DNS related items since
@@ -171,7 +366,29 @@ class CoreTunbuilderImpl : public CoreTunbuilder
         // The config object below is a return value rather than
         // an argument
         //
-        int ret = establish_tun(*tbc, config, nullptr, std::cout);
+        bool direct = (netCfgDevice.tun_queues > 1
+                       || (netCfgDevice.tun_offload && netCfgDevice.options.tun_offload));
+#ifdef ENABLE_OVPNDCO
+        direct = direct && !netCfgDevice.dco_device;
+#endif
+
+        int ret = -1;
+        netCfgDevice.tun_offload_flags = 0;
+        if (direct)
+        {
+            auto fds = establish_tun_direct(*tbc,
+                                            config,
+                                            netCfgDevice.tun_queues,
+                                            (netCfgDevice.tun_offload
+                                             && netCfgDevice.options.tun_offload),
+                                            netCfgDevice.tun_offload_flags);
+            ret = fds[0];
+            netCfgDevice.tun_queue_fds.assign(fds.begin() + 1, fds.end());
+        }
+        else
+        {
+            ret = establish_tun(*tbc, config, nullptr, std::cout);
+        }
 
 #ifdef ENABLE_OVPNDCO
         if (!netCfgDevice.dco_device)
@@ -246,11 +463,120 @@ class CoreTunbuilderImpl : public CoreTunbuilder
     }
 
 
+    bool update_routes(NetCfgDevice &netCfgDevice,
+                       const std::vector<Network> &prev_networks,
+                       const bool prev_reroute_ipv4,
+                       const bool prev_reroute_ipv6) override
+    {
+        const RedirectMethod method = netCfgDevice.options.redirect_method;
+        auto diff = NetCfg::DiffLists(expand_routes(prev_networks,
+                                                    prev_reroute_ipv4,
+                                                    prev_reroute_ipv6,
+                                                    method),
+                                      expand_routes(netCfgDevice.networks,
+                                                    netCfgDevice.reroute_ipv4,
+                                                    netCfgDevice.reroute_ipv6,
+                                                    method));
+        if (diff.empty())
+        {
+            return true;
+        }
+
+        // Excluded routes are set up by the Core library together
+        // with the rest of the device configuration
+        for (const auto *list : {&diff.removed, &diff.added})
+        {
+            for (const auto &net : *list)
+            {
+                if (net.exclude)
+                {
+                    return false;
+                }
+            }
+        }
+
+        CoreLog::Connect(netCfgDevice.signals);
+
+        std::string gw4;
+        std::string gw6;
+        for (const auto &ip : netCfgDevice.vpnips)
+        {
+            (ip.ipv6 ? gw6 : gw4) = ip.gateway;
+        }
+
+        // Routes removed here are still part of the removal commands
+        // of the Core library, which will fail removing them again
+        // when the device is torn down.  That is harmless.
+        if (!remove_cmds)
+        {
+            remove_cmds.reset(new ActionListReversed());
+        }
+        ActionList add_cmds;
+        ActionList del_cmds;
+        for (const auto &net : diff.added)
+        {
+            Action::Ptr add;
+            Action::Ptr del;
+            TUN_LINUX::add_del_route(net.address,
+                                     net.prefix,
+                                     (net.ipv6 ? gw6 : gw4),
+                                     netCfgDevice.device_name,
+                                     (net.ipv6 ? TUN_LINUX::R_IPv6 : 0) | TUN_LINUX::R_ADD_ALL,
+                                     nullptr,
+                                     add,
+                                     del);
+            add_cmds.add(add);
+            remove_cmds->add(del);
+        }
+        for (const auto &net : diff.removed)
+        {
+            Action::Ptr add;
+            Action::Ptr del;
+            TUN_LINUX::add_del_route(net.address,
+                                     net.prefix,
+                                     (net.ipv6 ? gw6 : gw4),
+                                     netCfgDevice.device_name,
+                                     (net.ipv6 ? TUN_LINUX::R_IPv6 : 0) | TUN_LINUX::R_ADD_ALL,
+                                     nullptr,
+                                     add,
+                                     del);
+            del_cmds.add(del);
+        }
+
+        // Add the new routes first, to not leave a gap where
+        // traffic would not be routed via the VPN
+        add_cmds.execute_log();
+        del_cmds.execute_log();
+
+        for (const auto &net : diff.removed)
+        {
+            NetCfgChangeEvent chg_ev(NetCfgChangeType::ROUTE_REMOVED,
+                                     netCfgDevice.get_device_name(),
+                                     {{"ip_version", (net.ipv6 ? "6" : "4")},
+                                      {"subnet", net.address},
+                                      {"prefix", std::to_string(net.prefix)}});
+            netCfgDevice.signals->NetworkChange(chg_ev);
+        }
+        for (const auto &net : diff.added)
+        {
+            NetCfgChangeEvent chg_ev(NetCfgChangeType::ROUTE_ADDED,
+                                     netCfgDevice.get_device_name(),
+                                     {{"ip_version", (net.ipv6 ? "6" : "4")},
+                                      {"subnet", net.address},
+                                      {"prefix", std::to_string(net.prefix)},
+                                      {"gateway", (net.ipv6 ? gw6 : gw4)}});
+            netCfgDevice.signals->NetworkChange(chg_ev);
+        }
+        return true;
+    }
+
+
     void teardown(const NetCfgDevice &ncdev, bool disconnect) override
     {
         if (remove_cmds)
         {
             remove_cmds->execute_log();
+            remove_cmds.reset();
         }
 
         if (tun)
@@ -310,18 +636,87 @@ void protect_socket_somark(int fd, const std::string &remote, int somark)
 
 // Although this is not the cleanest approach the include of the action.hpp header
 // breaks if it is done from core-tunbuilder.hpp, so we keep the management of this list here
-std::map<pid_t, ActionList> protected_sockets;
 
-void cleanup_protected_sockets(pid_t pid, NetCfgSignals::Ptr signals)
+/**
+ *  Bypass host routes are shared between all processes protecting a socket
+ *  to the same remote via the same gateway.  The route is installed by the
+ *  first user and removed when the last user is gone.  This avoids removing
+ *  and re-adding identical host routes each time one of many sessions to
+ *  the same server reconnects.
+ *
+ *  All of this is only accessed from the main loop thread.
+ */
+struct BypassRouteKey
+{
+    std::string remote;
+    bool ipv6;
+    std::string gateway;
+    std::string device;
+
+    bool operator<(const BypassRouteKey &other) const
+    {
+        return std::tie(remote, ipv6, gateway, device)
+               < std::tie(other.remote, other.ipv6, other.gateway, other.device);
+    }
+
+    bool operator==(const BypassRouteKey &other) const
+    {
+        return std::tie(remote, ipv6, gateway, device)
+               == std::tie(other.remote, other.ipv6, other.gateway, other.device);
+    }
+};
+
+struct BypassRoute
+{
+    ActionList remove_cmds;
+    std::set<pid_t> users;
+};
+
+std::map<BypassRouteKey, BypassRoute> bypass_routes;
+
+// Which bypass route each process is using.  For now we assume a process
+// only has one socket it needs to protect, a new protection replaces the
+// previous one.
+std::map<pid_t, BypassRouteKey> protected_sockets;
+
+
+static void release_bypass_route(pid_t pid, NetCfgSignals::Ptr signals)
 {
-    // Execute remove commands for protected sockets
     auto psocket = protected_sockets.find(pid);
-    if (psocket != protected_sockets.end())
+    if (psocket == protected_sockets.end())
+    {
+        return;
+    }
+
+    auto rt = bypass_routes.find(psocket->second);
+    if (rt != bypass_routes.end())
+    {
+        rt->second.users.erase(pid);
+        if (rt->second.users.empty())
+        {
+            if (signals)
+            {
+                signals->Debug("Removing bypass route to "
+                               + psocket->second.remote + " via "
+                               + psocket->second.gateway
+                               + ", last user was pid "
+                               + std::to_string(pid));
+            }
+            rt->second.remove_cmds.execute_log();
+            bypass_routes.erase(rt);
+        }
+    }
+    protected_sockets.erase(psocket);
+}
+
+
+void cleanup_protected_sockets(pid_t pid, NetCfgSignals::Ptr signals)
+{
+    if (protected_sockets.find(pid) != protected_sockets.end())
     {
         signals->Debug("Cleaning up protected sockets from pid "
                        + std::to_string(pid));
-        psocket->second.execute_log();
-        protected_sockets.erase(psocket);
+        release_bypass_route(pid, signals);
     }
 }
 
@@ -329,23 +724,130 @@ void cleanup_protected_sockets(pid_t pid, NetCfgSignals::Ptr signals)
 
 void protect_socket_hostroute(const std::string &tun_intf, const std::string &remote, bool ipv6, pid_t pid)
 {
-    std::vector<IP::Route> rtvec;
-    ActionList add_cmds;
+    BypassRouteKey key{remote, ipv6, "", ""};
+    int ret = -1;
+    if (ipv6)
+    {
+        IPv6::Addr gw;
+        ret = TunNetlink::SITNL::net_route_best_gw(IP::Route6(IPv6::Addr::from_string(remote), 128),
+                                                   gw,
+                                                   key.device,
+                                                   tun_intf);
+        key.gateway = gw.to_string();
+    }
+    else
+    {
+        IPv4::Addr gw;
+        ret = TunNetlink::SITNL::net_route_best_gw(IP::Route4(IPv4::Addr::from_string(remote), 32),
+                                                   gw,
+                                                   key.device,
+                                                   tun_intf);
+        key.gateway = gw.to_string();
+    }
+    if (0 != ret)
+    {
+        // No gateway to bypass the VPN via; no host route is needed
+        OPENVPN_LOG("No gateway found for '" + remote + "', no host route added");
+        release_bypass_route(pid, nullptr);
+        return;
+    }
 
-    // For now we assume that the will only have one socket it needs to protect and remove
-    // the old protection when we get a new one. This can later be extended to supported multiple
-    // sockets per pid if we need to
-    protected_sockets.emplace(std::piecewise_construct, std::make_tuple(pid), std::make_tuple());
+    auto psocket = protected_sockets.find(pid);
+    if (psocket != protected_sockets.end() && psocket->second == key)
+    {
+        // This process already uses this route
+        return;
+    }
 
-    OPENVPN_LOG("Protecting socket to '" + remote + " by adding host route");
-    TUN_LINUX::TunMethods::add_bypass_route(tun_intf, remote, ipv6, &rtvec, add_cmds, protected_sockets[pid]);
+    auto rt = bypass_routes.find(key);
+    if (rt != bypass_routes.end())
+    {
+        OPENVPN_LOG("Protecting socket to '" + remote + "' using existing host route via "
+                    + key.gateway + " (" + std::to_string(rt->second.users.size())
+                    + " other users)");
+    }
+    else
+    {
+        // There can only be one host route to the remote.  If it is
+        // currently routed via a different gateway or device, the old
+        // route is removed before the new one is added, as adding it
+        // would fail.  The users of the old route are moved over to the
+        // new one.
+        std::set<pid_t> users;
+        for (auto old = bypass_routes.begin(); old != bypass_routes.end(); ++old)
+        {
+            if (old->first.remote == key.remote && old->first.ipv6 == key.ipv6)
+            {
+                OPENVPN_LOG("Replacing host route to '" + remote + "' via "
+                            + old->first.gateway + " with a route via " + key.gateway);
+                old->second.remove_cmds.execute_log();
+                users = std::move(old->second.users);
+                bypass_routes.erase(old);
+                break;
+            }
+        }
 
-    add_cmds.execute_log();
+        OPENVPN_LOG("Protecting socket to '" + remote + " by adding host route");
+        rt = bypass_routes.emplace(std::piecewise_construct,
+                                   std::forward_as_tuple(key),
+                                   std::forward_as_tuple())
+                 .first;
+
+        // The gateway and device were already looked up above, so the
+        // route is added directly instead of via add_bypass_route()
+        Action::Ptr add;
+        Action::Ptr del;
+        TUN_LINUX::add_del_route(remote,
+                                 (ipv6 ? 128 : 32),
+                                 key.gateway,
+                                 key.device,
+                                 (ipv6 ? TUN_LINUX::R_IPv6 : 0) | TUN_LINUX::R_ADD_SYS,
+                                 nullptr,
+                                 add,
+                                 del);
+        ActionList add_cmds;
+        add_cmds.add(add);
+        rt->second.remove_cmds.add(del);
+        add_cmds.execute_log();
+
+        for (const auto &user : users)
+        {
+            rt->second.users.insert(user);
+            protected_sockets[user] = key;
+        }
+    }
+
+    // The previous route is released after the new one is in place,
+    // to not leave a gap where the traffic would go via the VPN.  The
+    // process may already have been moved to the new route above.
+    psocket = protected_sockets.find(pid);
+    if (psocket != protected_sockets.end() && !(psocket->second == key))
+    {
+        release_bypass_route(pid, nullptr);
+    }
+    rt->second.users.insert(pid);
+    protected_sockets[pid] = key;
 }
 
 
 
-void protect_socket_binddev(int fd, const std::string &remote, bool ipv6)
+std::vector<BypassRouteInfo> get_bypass_routes()
+{
+    std::vector<BypassRouteInfo> ret;
+    for (const auto &[key, rt] : bypass_routes)
+    {
+        ret.push_back({key.remote,
+                       key.ipv6,
+                       key.gateway,
+                       key.device,
+                       static_cast<uint32_t>(rt.users.size())});
+    }
+    return ret;
+}
+
+
+
+std::string find_best_device(const std::string &remote, bool ipv6)
 {
     std::string bestdev;
 
@@ -369,6 +871,16 @@ void protect_socket_binddev(int fd, const std::string &remote, bool ipv6)
                                   + remote + " failed");
         }
     }
+    return bestdev;
+}
+
+
+
+void protect_socket_binddev(int fd, const std::string &remote, bool ipv6, NetCfgRouteCache::Ptr route_cache)
+{
+    std::string bestdev = (route_cache
+                               ? route_cache->GetBestDevice(remote, ipv6)
+                               : find_best_device(remote, ipv6));
 
     OPENVPN_LOG("Protecting socket " + std::to_string(fd)
                 + " to '" + remote + "'(" + (ipv6 ? "inet6" : "inet")
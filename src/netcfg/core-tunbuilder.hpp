@@ -15,13 +15,17 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <openvpn/common/rc.hpp>
 
+#include "netcfg-routecache.hpp"
 #include "netcfg-signals.hpp"
 
 class NetCfgDevice;
+class Network;
 
 
 namespace openvpn {
@@ -30,6 +34,24 @@ class CoreTunbuilder : public RC<thread_safe_refcount>
   public:
     virtual int establish(NetCfgDevice &netCfgDevice) = 0;
     virtual void teardown(const NetCfgDevice &netCfgDevice, bool disconnect) = 0;
+
+    /**
+     * Update the routes of an established device to the routes currently
+     * configured in netCfgDevice.  Only the routes which differ from the
+     * previous configuration are added or removed.
+     *
+     * @param netCfgDevice       The established device
+     * @param prev_networks      The networks the device was established with
+     * @param prev_reroute_ipv4  The previous IPv4 default gateway redirect flag
+     * @param prev_reroute_ipv6  The previous IPv6 default gateway redirect flag
+     *
+     * @return false if the changes cannot be applied to the established
+     *         device, which then needs to be established again
+     */
+    virtual bool update_routes(NetCfgDevice &netCfgDevice,
+                               const std::vector<Network> &prev_networks,
+                               const bool prev_reroute_ipv4,
+                               const bool prev_reroute_ipv6) = 0;
 };
 
 
@@ -37,13 +59,27 @@ class CoreTunbuilder : public RC<thread_safe_refcount>
 class CoreTunbuilderImpl;
 
 
+/**
+ * Function that looks up the device of the best route to remote
+ * @param remote remote host to lookup
+ * @param ipv6 is remote ipv6
+ * @return std::string with the device name
+ */
+std::string find_best_device(const std::string &remote, bool ipv6);
+
+
 /**
  * Function that binds the the fd to the device of the best route to remote
  * @param fd Socket to bind
  * @param remote remote host to lookup
  * @param ipv6 is remote ipv6
+ * @param route_cache NetCfgRouteCache to look up the device in.  If nullptr,
+ *                    find_best_device() is used directly
  */
-void protect_socket_binddev(int fd, const std::string &remote, bool ipv6);
+void protect_socket_binddev(int fd,
+                            const std::string &remote,
+                            bool ipv6,
+                            NetCfgRouteCache::Ptr route_cache = nullptr);
 
 
 /**
@@ -56,14 +92,15 @@ void protect_socket_somark(int fd, const std::string &remote, int somark);
 
 
 /**
- * Function that adds a host route
- * @param tun_intf Name of the tun interface, will be ignore for calculating the host route
- * @param fd Socket for the SO_MARK to set
- * @param remote remote host to connect to (for logging only)
- * @param remove_cmds Return the commands to undo the protect command
+ * Function that adds a host route.  Host routes are shared by all processes
+ * protecting a socket to the same remote via the same gateway; the route is
+ * only added if it does not exist already.  A process can only use one host
+ * route, a previously used route is released.
  *
- * The remove_cmds is a parameter instead of a return value since the move only
- * semantics of ActionList prevent returning it without wrapping it in a smartpointer
+ * @param tun_intf Name of the tun interface, will be ignore for calculating the host route
+ * @param remote remote host to connect to
+ * @param ipv6 is remote ipv6
+ * @param pid the pid of the process using this host route
  */
 void protect_socket_hostroute(const std::string &tun_intf,
                               const std::string &remote,
@@ -71,12 +108,32 @@ void protect_socket_hostroute(const std::string &tun_intf,
                               pid_t pid);
 
 /**
- * Remove all protected sockets that belong to a certain pid
+ * Remove all protected sockets that belong to a certain pid.  A shared
+ * host route is only removed when no other process is using it.
  * @param pid the pid for which the socket protection to remove for
  */
 void cleanup_protected_sockets(pid_t pid, NetCfgSignals::Ptr signals);
 
 
+/**
+ * Details of a host route added by protect_socket_hostroute()
+ */
+struct BypassRouteInfo
+{
+    std::string remote;
+    bool ipv6;
+    std::string gateway;
+    std::string device;
+    uint32_t users;
+};
+
+/**
+ * Retrieve all the host routes currently in use
+ * @return std::vector<BypassRouteInfo>
+ */
+std::vector<BypassRouteInfo> get_bypass_routes();
+
+
 // Workaround to avoid circular dependencies
 CoreTunbuilder *getCoreBuilderInstance();
 
@@ -0,0 +1,72 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-configdiff.hpp
+ *
+ * @brief  Helper finding the differences between two lists of network
+ *         configuration items, used when a device is reconfigured
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+
+namespace NetCfg {
+
+/**
+ *  The result of DiffLists()
+ */
+template <typename T>
+struct ListDiff
+{
+    /** Items only found in the previous list */
+    std::vector<T> removed{};
+
+    /** Items only found in the new list */
+    std::vector<T> added{};
+
+    bool empty() const noexcept
+    {
+        return removed.empty() && added.empty();
+    }
+};
+
+
+/**
+ *  Find the items which have been removed and added between two lists.
+ *  The order of the items is not considered.  Duplicated items are
+ *  counted, so one item present twice in prev and once in next is
+ *  reported as removed once.
+ *
+ *  T must provide operator<
+ *
+ * @param prev   std::vector<T> with the previous items
+ * @param next   std::vector<T> with the new items
+ * @return ListDiff<T>
+ */
+template <typename T>
+ListDiff<T> DiffLists(std::vector<T> prev, std::vector<T> next)
+{
+    std::sort(prev.begin(), prev.end());
+    std::sort(next.begin(), next.end());
+
+    ListDiff<T> ret;
+    std::set_difference(prev.begin(), prev.end(),
+                        next.begin(), next.end(),
+                        std::back_inserter(ret.removed));
+    std::set_difference(next.begin(), next.end(),
+                        prev.begin(), prev.end(),
+                        std::back_inserter(ret.added));
+    return ret;
+}
+
+} // namespace NetCfg
@@ -48,7 +48,17 @@ class NetCfgConfigFile : public virtual Configuration::File
             OptionMapEntry{"redirect-method", "redirect_method",
                            "Server route redirection mode", OptionValueType::String},
             OptionMapEntry{"set-somark", "set_somark",
-                           "Netfilter SO_MARK", OptionValueType::String}
+                           "Netfilter SO_MARK", OptionValueType::String},
+            OptionMapEntry{"qdisc", "qdisc",
+                           "Default device qdisc", OptionValueType::String},
+            OptionMapEntry{"txqueuelen", "txqueuelen",
+                           "Default device transmit queue length", OptionValueType::Int},
+            OptionMapEntry{"tun-offload", "tun_offload",
+                           "Offload capable tun devices", OptionValueType::Present},
+            OptionMapEntry{"dco-threads", "dco_threads",
+                           "Threads handling DCO devices", OptionValueType::Int},
+            OptionMapEntry{"reconnect-grace", "reconnect_grace",
+                           "Seconds a device is kept for a reconnect", OptionValueType::Int}
             // clang-format on
         };
     }
@@ -0,0 +1,232 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-dco-engine.cpp
+ *
+ * @brief  Implementation of the shared DCO event loop pool
+ */
+
+#include "build-config.h"
+
+#ifdef ENABLE_OVPNDCO
+#include <algorithm>
+#include <future>
+
+#include "netcfg-dco-engine.hpp"
+
+
+NetCfgDCOEngine::Worker::Worker(const unsigned int idx)
+    : index(idx), io_context(std::make_shared<openvpn_io::io_context>())
+{
+    asio_work.reset(new openvpn::AsioWork(*io_context));
+
+    // The thread keeps its own reference to the event loop, which
+    // must outlive this object if the last reference to the Worker
+    // is released by a task running in this thread
+    thread = std::thread([ioctx = io_context]()
+                         {
+                             ioctx->run();
+                         });
+}
+
+
+NetCfgDCOEngine::Worker::~Worker() noexcept
+{
+    asio_work.reset();
+    io_context->stop();
+    if (thread.joinable())
+    {
+        if (std::this_thread::get_id() == thread.get_id())
+        {
+            // The last reference was released by a task in this
+            // worker.  The event loop is released by the thread
+            // itself when run() has returned.
+            thread.detach();
+        }
+        else
+        {
+            thread.join();
+        }
+    }
+}
+
+
+
+NetCfgDCOEngine::Queue::Queue(std::shared_ptr<Worker> worker_,
+                              NetCfgSignals::Ptr signals_,
+                              const std::string &dev_name_)
+    : worker(worker_), signals(signals_), dev_name(dev_name_)
+{
+    stats.worker = worker->index;
+    ++worker->devices;
+}
+
+
+NetCfgDCOEngine::Queue::~Queue() noexcept
+{
+    --worker->devices;
+}
+
+
+openvpn_io::io_context &NetCfgDCOEngine::Queue::GetIOContext()
+{
+    return *worker->io_context;
+}
+
+
+void NetCfgDCOEngine::Queue::Post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(stats_mtx);
+        ++stats.pending;
+        stats.pending_max = std::max(stats.pending_max, stats.pending);
+    }
+
+    openvpn_io::post(*worker->io_context,
+                     [self = shared_from_this(), task = std::move(task), queued = clock::now()]()
+                     {
+                         using std::chrono::duration_cast;
+                         using std::chrono::microseconds;
+
+                         auto started = clock::now();
+                         bool failed = false;
+                         try
+                         {
+                             task();
+                         }
+                         catch (const std::exception &excp)
+                         {
+                             // Must not stop the event loop shared
+                             // with other devices
+                             failed = true;
+                             self->log_failure(excp.what());
+                         }
+                         catch (...)
+                         {
+                             failed = true;
+                             self->log_failure("Unknown error");
+                         }
+                         auto finished = clock::now();
+
+                         uint64_t wait = duration_cast<microseconds>(started - queued).count();
+                         uint64_t exec = duration_cast<microseconds>(finished - started).count();
+
+                         std::lock_guard<std::mutex> guard(self->stats_mtx);
+                         auto &s = self->stats;
+                         --s.pending;
+                         ++s.executed;
+                         s.failed += (failed ? 1 : 0);
+                         self->wait_total_usec += wait;
+                         self->exec_total_usec += exec;
+                         s.wait_max_usec = std::max(s.wait_max_usec, wait);
+                         s.exec_max_usec = std::max(s.exec_max_usec, exec);
+                     });
+}
+
+
+void NetCfgDCOEngine::Queue::Drain()
+{
+    if (std::this_thread::get_id() == worker->thread.get_id())
+    {
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> result = done.get_future();
+    openvpn_io::post(*worker->io_context,
+                     [&done]()
+                     {
+                         done.set_value();
+                     });
+    result.wait();
+}
+
+
+void NetCfgDCOEngine::Queue::log_failure(const std::string &error) noexcept
+{
+    if (!signals)
+    {
+        return;
+    }
+    try
+    {
+        signals->LogError("NetCfgDCO [" + dev_name + "] Task failed: " + error);
+    }
+    catch (...)
+    {
+        // Logging must not stop the event loop either
+    }
+}
+
+
+NetCfgDCOEngine::Queue::Statistics NetCfgDCOEngine::Queue::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(stats_mtx);
+    Statistics ret = stats;
+    if (stats.executed > 0)
+    {
+        ret.wait_avg_usec = wait_total_usec / stats.executed;
+        ret.exec_avg_usec = exec_total_usec / stats.executed;
+    }
+    return ret;
+}
+
+
+
+NetCfgDCOEngine::Ptr NetCfgDCOEngine::Create(const unsigned int threads)
+{
+    return NetCfgDCOEngine::Ptr(new NetCfgDCOEngine(threads));
+}
+
+
+NetCfgDCOEngine::NetCfgDCOEngine(const unsigned int threads)
+    : thread_count(threads > 0
+                       ? std::min(threads, MAX_THREADS)
+                       : std::clamp(std::thread::hardware_concurrency(),
+                                    1u,
+                                    DEFAULT_MAX_THREADS))
+{
+}
+
+
+NetCfgDCOEngine::Queue::Ptr NetCfgDCOEngine::Attach(NetCfgSignals::Ptr signals,
+                                                    const std::string &dev_name)
+{
+    std::lock_guard<std::mutex> guard(workers_mtx);
+    if (workers.empty())
+    {
+        for (unsigned int i = 0; i < thread_count; ++i)
+        {
+            workers.push_back(std::make_shared<Worker>(i));
+        }
+    }
+
+    auto least_used = std::min_element(workers.begin(),
+                                       workers.end(),
+                                       [](const auto &a, const auto &b)
+                                       {
+                                           return a->devices < b->devices;
+                                       });
+    return Queue::Ptr(new Queue(*least_used, signals, dev_name));
+}
+
+
+NetCfgDCOEngine::Statistics NetCfgDCOEngine::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(workers_mtx);
+    Statistics ret;
+    ret.threads = workers.size();
+    for (const auto &w : workers)
+    {
+        ret.devices += w->devices;
+    }
+    return ret;
+}
+
+#endif // ENABLE_OVPNDCO
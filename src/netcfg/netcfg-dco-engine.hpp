@@ -0,0 +1,209 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-dco-engine.hpp
+ *
+ * @brief  Shared pool of ASIO event loops used by all the DCO devices
+ */
+
+#pragma once
+
+#include "build-config.h"
+
+#ifdef ENABLE_OVPNDCO
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef USE_ASIO
+#define USE_ASIO
+#endif
+#include <asio.hpp>
+
+// This needs to be included before any of the OpenVPN 3 Core
+// header files.  This is needed to enable the D-Bus logging
+// infrastructure for the Core library
+#include "log/core-dbus-logger.hpp"
+
+#define OPENVPN_EXTERN extern
+#include <openvpn/io/io.hpp>
+#include <openvpn/asio/asiowork.hpp>
+
+#include "netcfg-signals.hpp"
+
+
+/**
+ *  Runs a small, fixed number of ASIO event loops, each in its own
+ *  thread.  Each DCO device is attached to one of these event loops,
+ *  which is used for all the GeNL and pipe I/O of that device.  This
+ *  way the number of threads depends on the number of CPU cores and
+ *  not the number of DCO devices.
+ *
+ *  The worker threads are started when the first device is attached.
+ */
+class NetCfgDCOEngine
+{
+  public:
+    using Ptr = std::shared_ptr<NetCfgDCOEngine>;
+
+    /**
+     *  Upper limit of worker threads.  By default, one worker thread
+     *  per CPU core is used, up to DEFAULT_MAX_THREADS
+     */
+    static constexpr unsigned int MAX_THREADS = 16;
+    static constexpr unsigned int DEFAULT_MAX_THREADS = 4;
+
+  private:
+    struct Worker;
+
+  public:
+    /**
+     *  The per device task queue, attached to one of the worker
+     *  threads.  Tasks posted via the same Queue are run in the order
+     *  they were posted.  The device is detached from the worker when
+     *  the Queue object is destroyed.
+     */
+    class Queue : public std::enable_shared_from_this<Queue>
+    {
+      public:
+        using Ptr = std::shared_ptr<Queue>;
+
+        struct Statistics
+        {
+            uint64_t worker = 0;
+            uint64_t pending = 0;
+            uint64_t pending_max = 0;
+            uint64_t executed = 0;
+            uint64_t failed = 0;
+            uint64_t wait_avg_usec = 0;
+            uint64_t wait_max_usec = 0;
+            uint64_t exec_avg_usec = 0;
+            uint64_t exec_max_usec = 0;
+        };
+
+        ~Queue() noexcept;
+
+        /**
+         *  Retrieve the event loop of the worker this device is
+         *  attached to.  Used for the I/O objects of the device.
+         *
+         * @return openvpn_io::io_context&
+         */
+        openvpn_io::io_context &GetIOContext();
+
+        /**
+         *  Run a task in the worker thread of this device.  Exceptions
+         *  thrown by the task are logged and counted in the statistics,
+         *  but not passed on, as the event loop is shared with other
+         *  devices.
+         *
+         * @param task  std::function<void()> to run
+         */
+        void Post(std::function<void()> task);
+
+        /**
+         *  Wait until all the tasks posted so far have been run.  Does
+         *  nothing if called from the worker thread itself.
+         */
+        void Drain();
+
+        /**
+         *  Retrieve the queue and latency counters of this device
+         *
+         * @return Queue::Statistics
+         */
+        Statistics GetStatistics() const;
+
+
+      private:
+        friend class NetCfgDCOEngine;
+        using clock = std::chrono::steady_clock;
+
+        std::shared_ptr<Worker> worker;
+        NetCfgSignals::Ptr signals = nullptr;
+        const std::string dev_name;
+        mutable std::mutex stats_mtx{};
+        Statistics stats{};
+        uint64_t wait_total_usec = 0;
+        uint64_t exec_total_usec = 0;
+
+        Queue(std::shared_ptr<Worker> worker,
+              NetCfgSignals::Ptr signals,
+              const std::string &dev_name);
+        void log_failure(const std::string &error) noexcept;
+    };
+
+    struct Statistics
+    {
+        uint64_t threads = 0;
+        uint64_t devices = 0;
+    };
+
+
+    /**
+     *  Prepare a new DCO engine.  No threads are started until the
+     *  first device is attached.
+     *
+     * @param threads  unsigned int with the number of worker threads.
+     *                 If 0, one thread per CPU core is used, up to
+     *                 DEFAULT_MAX_THREADS.
+     * @return NetCfgDCOEngine::Ptr
+     */
+    [[nodiscard]] static NetCfgDCOEngine::Ptr Create(const unsigned int threads = 0);
+    ~NetCfgDCOEngine() noexcept = default;
+
+    /**
+     *  Attach a new device to the worker with the fewest devices
+     *
+     * @param signals   NetCfgSignals::Ptr used to log failing tasks,
+     *                  if not set these are only counted
+     * @param dev_name  std::string with the device name used in the
+     *                  log messages
+     * @return Queue::Ptr to be used for all the I/O of the device
+     */
+    Queue::Ptr Attach(NetCfgSignals::Ptr signals = nullptr,
+                      const std::string &dev_name = {});
+
+    /**
+     *  Retrieve the number of worker threads and attached devices
+     *
+     * @return NetCfgDCOEngine::Statistics
+     */
+    Statistics GetStatistics() const;
+
+
+  private:
+    struct Worker
+    {
+        const unsigned int index;
+        std::shared_ptr<openvpn_io::io_context> io_context;
+        std::unique_ptr<openvpn::AsioWork> asio_work;
+        std::thread thread;
+        std::atomic<uint64_t> devices{0};
+
+        Worker(const unsigned int idx);
+        ~Worker() noexcept;
+    };
+
+    const unsigned int thread_count;
+    mutable std::mutex workers_mtx{};
+    std::vector<std::shared_ptr<Worker>> workers{};
+
+    NetCfgDCOEngine(const unsigned int threads);
+};
+
+#endif // ENABLE_OVPNDCO
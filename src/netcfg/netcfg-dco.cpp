@@ -12,6 +12,8 @@
 #include "build-config.h"
 
 #ifdef ENABLE_OVPNDCO
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <thread>
 #include <sys/types.h>
@@ -38,10 +40,34 @@
 #include <openvpn/asio/asiowork.hpp>
 
 
+/**
+ *  Fills a KoRekey::KeyConfig from a DcoKeyConfig.  The key material
+ *  is not copied, the pointers in kc refer to the data in dco_kc.
+ */
+static void copy_key_config(const DcoKeyConfig &dco_kc, KoRekey::KeyConfig &kc)
+{
+    auto copyKeyDirection = [](const DcoKeyConfig_KeyDirection &src, KoRekey::KeyDirection &dst)
+    {
+        dst.cipher_key = reinterpret_cast<const unsigned char *>(src.cipher_key().data());
+        std::memcpy(dst.nonce_tail, src.nonce_tail().data(), sizeof(dst.nonce_tail));
+        dst.cipher_key_size = src.cipher_key_size();
+    };
+
+    std::memset(&kc, 0, sizeof(kc));
+    kc.key_id = dco_kc.key_id();
+    kc.remote_peer_id = dco_kc.remote_peer_id();
+    kc.cipher_alg = dco_kc.cipher_alg();
+
+    copyKeyDirection(dco_kc.encrypt(), kc.encrypt);
+    copyKeyDirection(dco_kc.decrypt(), kc.decrypt);
+}
+
+
 NetCfgDCO::NetCfgDCO(DBus::Connection::Ptr dbuscon,
                      const DBus::Object::Path &objpath,
                      const std::string &dev_name,
                      pid_t backend_pid,
+                     NetCfgDCOEngine::Ptr engine,
                      LogWriter *logwr)
     : DBus::Object::Base(objpath + "/dco", Constants::GenInterface("netcfg")),
       fds{},
@@ -100,6 +126,48 @@ NetCfgDCO::NetCfgDCO(DBus::Connection::Ptr dbuscon,
     set_peer->AddInput("keepalive_interval", glib2::DataType::DBus<uint32_t>());
     set_peer->AddInput("keepalive_timeout", glib2::DataType::DBus<uint32_t>());
 
+    auto update_keys = AddMethod("UpdateKeys",
+                                 [this](DBus::Object::Method::Arguments::Ptr args)
+                                 {
+                                     this->method_update_keys(args->GetMethodParameters());
+                                     args->SetMethodReturn(nullptr);
+                                 });
+    update_keys->AddInput("key_update", "ay");
+
+    auto prop_update_keys_stats = [this](const DBus::Object::Property::BySpec &prop) -> GVariant *
+    {
+        std::lock_guard<std::mutex> guard(this->update_keys_mtx);
+        const auto &s = this->update_keys_stats;
+        GVariantBuilder *b = glib2::Builder::Create("a{st}");
+        g_variant_builder_add(b, "{st}", "updates", s.updates);
+        g_variant_builder_add(b, "{st}", "failures", s.failures);
+        g_variant_builder_add(b, "{st}", "latency_last_usec", s.latency_last_usec);
+        g_variant_builder_add(b, "{st}", "latency_avg_usec", (s.updates > 0 ? s.latency_total_usec / s.updates : 0));
+        g_variant_builder_add(b, "{st}", "latency_max_usec", s.latency_max_usec);
+        return glib2::Builder::Finish(b);
+    };
+    AddPropertyBySpec("update_keys_statistics", "a{st}", prop_update_keys_stats);
+
+    auto prop_queue_stats = [this](const DBus::Object::Property::BySpec &prop) -> GVariant *
+    {
+        GVariantBuilder *b = glib2::Builder::Create("a{st}");
+        if (this->queue)
+        {
+            auto s = this->queue->GetStatistics();
+            g_variant_builder_add(b, "{st}", "worker", s.worker);
+            g_variant_builder_add(b, "{st}", "pending", s.pending);
+            g_variant_builder_add(b, "{st}", "pending_max", s.pending_max);
+            g_variant_builder_add(b, "{st}", "executed", s.executed);
+            g_variant_builder_add(b, "{st}", "failed", s.failed);
+            g_variant_builder_add(b, "{st}", "wait_avg_usec", s.wait_avg_usec);
+            g_variant_builder_add(b, "{st}", "wait_max_usec", s.wait_max_usec);
+            g_variant_builder_add(b, "{st}", "exec_avg_usec", s.exec_avg_usec);
+            g_variant_builder_add(b, "{st}", "exec_max_usec", s.exec_max_usec);
+        }
+        return glib2::Builder::Finish(b);
+    };
+    AddPropertyBySpec("queue_statistics", "a{st}", prop_queue_stats);
+
     backend_bus_name = Constants::GenServiceName("backends.be")
                        + std::to_string(backend_pid);
 
@@ -111,13 +179,12 @@ NetCfgDCO::NetCfgDCO(DBus::Connection::Ptr dbuscon,
         throw NetCfgException("Error creating ovpn-dco device: " + os.str());
     }
 
-    pipe.reset(new openvpn_io::posix::stream_descriptor(io_context, fds[1]));
-
-    asio_work.reset(new AsioWork(io_context));
+    queue = engine->Attach(signals, dev_name);
+    pipe.reset(new openvpn_io::posix::stream_descriptor(queue->GetIOContext(), fds[1]));
 
     try
     {
-        genl.reset(new GeNLImpl(io_context,
+        genl.reset(new GeNLImpl(queue->GetIOContext(),
                                 if_nametoindex(dev_name.c_str()),
                                 this));
     }
@@ -128,11 +195,6 @@ NetCfgDCO::NetCfgDCO(DBus::Connection::Ptr dbuscon,
         teardown();
         throw NetCfgException(err);
     }
-
-    th.reset(new std::thread([this]()
-                             {
-                                 this->io_context.run();
-                             }));
 }
 
 
@@ -160,32 +222,29 @@ const bool NetCfgDCO::Authorize(const DBus::Authz::Request::Ptr request)
 
 void NetCfgDCO::teardown()
 {
-    ::close(fds[0]); // fds[1] will be closed by pipe dctor
-
-    if (genl)
+    if (queue)
     {
-        genl->stop();
+        // GeNL and the pipe are used by the worker thread, which is
+        // shared with other devices.  Stop them from that thread and
+        // ensure no task for this device is still pending.
+        queue->Post([this]()
+                    {
+                        if (this->genl)
+                        {
+                            this->genl->stop();
+                        }
+                        if (this->pipe)
+                        {
+                            this->pipe->close();
+                        }
+                    });
+        queue->Drain();
     }
 
-    if (pipe)
-    {
-        pipe->close();
-    }
-
-    if (asio_work)
-    {
-        asio_work.reset();
-    }
-
-    io_context.stop();
+    ::close(fds[0]); // fds[1] will be closed by pipe dctor
 
     std::ostringstream os;
     TunNetlink::iface_del(os, dev_name);
-
-    if (th && th->joinable())
-    {
-        th->join();
-    }
 }
 
 
@@ -237,16 +296,15 @@ void NetCfgDCO::method_new_peer(GVariant *params, int transport_fd)
     IPv4::Addr vpn4 = IPv4::Addr::from_string(vpn4_str);
     IPv6::Addr vpn6 = IPv6::Addr::from_string(vpn6_str);
 
-    openvpn_io::post(io_context,
-                     [peer_id, transport_fd, sa, salen, vpn4, vpn6, this]()
-                     {
-                         this->genl->new_peer(peer_id,
-                                              transport_fd,
-                                              (struct sockaddr *)&sa,
-                                              salen,
-                                              vpn4,
-                                              vpn6);
-                     });
+    queue->Post([peer_id, transport_fd, sa, salen, vpn4, vpn6, this]()
+                {
+                    this->genl->new_peer(peer_id,
+                                         transport_fd,
+                                         (struct sockaddr *)&sa,
+                                         salen,
+                                         vpn4,
+                                         vpn6);
+                });
 }
 
 void NetCfgDCO::method_new_key(GVariant *params)
@@ -259,29 +317,12 @@ void NetCfgDCO::method_new_key(GVariant *params)
     DcoKeyConfig dco_kc;
     dco_kc.ParseFromString(base64->decode(key_config));
 
-    auto copyKeyDirection = [](const DcoKeyConfig_KeyDirection &src, KoRekey::KeyDirection &dst)
-    {
-        dst.cipher_key = reinterpret_cast<const unsigned char *>(src.cipher_key().data());
-        std::memcpy(dst.nonce_tail, src.nonce_tail().data(), sizeof(dst.nonce_tail));
-        dst.cipher_key_size = src.cipher_key_size();
-    };
-
-    openvpn_io::post(io_context,
-                     [=]()
-                     {
-                         KoRekey::KeyConfig kc;
-                         std::memset(&kc, 0, sizeof(kc));
-                         kc.key_id = dco_kc.key_id();
-                         kc.remote_peer_id = dco_kc.remote_peer_id();
-                         kc.cipher_alg = dco_kc.cipher_alg();
-
-                         copyKeyDirection(dco_kc.encrypt(),
-                                          kc.encrypt);
-                         copyKeyDirection(dco_kc.decrypt(),
-                                          kc.decrypt);
-
-                         this->genl->new_key(key_slot, &kc);
-                     });
+    queue->Post([=]()
+                {
+                    KoRekey::KeyConfig kc;
+                    copy_key_config(dco_kc, kc);
+                    this->genl->new_key(key_slot, &kc);
+                });
 }
 
 
@@ -291,11 +332,10 @@ void NetCfgDCO::method_swap_keys(GVariant *params)
 
     unsigned int peer_id = glib2::Value::Extract<unsigned int>(params, 0);
 
-    openvpn_io::post(io_context,
-                     [=]()
-                     {
-                         this->genl->swap_keys(peer_id);
-                     });
+    queue->Post([=]()
+                {
+                    this->genl->swap_keys(peer_id);
+                });
 }
 
 
@@ -307,12 +347,80 @@ void NetCfgDCO::method_set_peer(GVariant *params)
     uint32_t keepalive_interval = glib2::Value::Extract<uint32_t>(params, 1);
     uint32_t keepalive_timeout = glib2::Value::Extract<uint32_t>(params, 2);
 
-    openvpn_io::post(io_context,
-                     [peer_id, keepalive_interval, keepalive_timeout, this]()
-                     {
-                         this->genl->set_peer(peer_id,
-                                              keepalive_interval,
-                                              keepalive_timeout);
-                     });
+    queue->Post([peer_id, keepalive_interval, keepalive_timeout, this]()
+                {
+                    this->genl->set_peer(peer_id,
+                                         keepalive_interval,
+                                         keepalive_timeout);
+                });
+}
+
+
+void NetCfgDCO::method_update_keys(GVariant *params)
+{
+    glib2::Utils::checkParams(__func__, params, "(ay)", 1);
+
+    auto received = std::chrono::steady_clock::now();
+
+    GVariant *payload = g_variant_get_child_value(params, 0);
+    gsize len = 0;
+    const void *data = g_variant_get_fixed_array(payload, &len, sizeof(uint8_t));
+
+    DcoKeyUpdate upd;
+    bool parsed = upd.ParseFromArray(data, static_cast<int>(len));
+    g_variant_unref(payload);
+    if (!parsed)
+    {
+        throw NetCfgException("Invalid key update");
+    }
+    if (upd.has_key_config() != upd.has_key_slot()
+        || upd.has_keepalive_interval() != upd.has_keepalive_timeout())
+    {
+        throw NetCfgException("Incomplete key update");
+    }
+
+    // All the changes are done by a single task in the GeNL thread, so
+    // no other DCO operation can be run between them.
+    queue->Post([upd, received, this]()
+                {
+                    bool failed = false;
+                    try
+                    {
+                        if (upd.has_key_config())
+                        {
+                            KoRekey::KeyConfig kc;
+                            copy_key_config(upd.key_config(), kc);
+                            this->genl->new_key(upd.key_slot(), &kc);
+                        }
+                        if (upd.swap_keys())
+                        {
+                            this->genl->swap_keys(upd.peer_id());
+                        }
+                        if (upd.has_keepalive_interval())
+                        {
+                            this->genl->set_peer(upd.peer_id(),
+                                                 upd.keepalive_interval(),
+                                                 upd.keepalive_timeout());
+                        }
+                    }
+                    catch (const std::exception &excp)
+                    {
+                        failed = true;
+                        this->signals->LogError("NetCfgDCO [" + this->dev_name
+                                                + "] Key update failed: "
+                                                + std::string(excp.what()));
+                    }
+
+                    using namespace std::chrono;
+                    uint64_t latency = duration_cast<microseconds>(steady_clock::now() - received).count();
+
+                    std::lock_guard<std::mutex> guard(this->update_keys_mtx);
+                    auto &s = this->update_keys_stats;
+                    ++s.updates;
+                    s.failures += (failed ? 1 : 0);
+                    s.latency_last_usec = latency;
+                    s.latency_total_usec += latency;
+                    s.latency_max_usec = std::max(s.latency_max_usec, latency);
+                });
 }
 #endif // ENABLE_OVPNDCO
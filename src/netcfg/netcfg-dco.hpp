@@ -15,6 +15,8 @@
 
 #ifdef ENABLE_OVPNDCO
 
+#include <cstdint>
+#include <mutex>
 #include <gdbuspp/connection.hpp>
 #include <gdbuspp/object/base.hpp>
 
@@ -35,6 +37,7 @@
 #include <openvpn/tun/linux/client/tuncli.hpp>
 
 
+#include "netcfg-dco-engine.hpp"
 #include "netcfg-signals.hpp"
 
 
@@ -48,6 +51,7 @@ class NetCfgDCO : public DBus::Object::Base
               const DBus::Object::Path &objpath,
               const std::string &dev_name,
               pid_t backend_pid,
+              NetCfgDCOEngine::Ptr engine,
               LogWriter *logwr);
 
     ~NetCfgDCO();
@@ -63,7 +67,7 @@ class NetCfgDCO : public DBus::Object::Base
 
 
     /**
-     * Called by GeNL in worker thread when there is incoming data or event from kernel
+     * Called by GeNL in the engine worker thread when there is incoming data or event from kernel
      *
      * @param buf
      */
@@ -71,8 +75,8 @@ class NetCfgDCO : public DBus::Object::Base
 
 
     /**
-     * Deletes ovpn-dco net dev, stops ASIO event loop and GeNL and
-     * waits for worker thread to exit.
+     * Stops GeNL and the pipe in the engine worker thread, waits for
+     * all pending tasks of this device and deletes ovpn-dco net dev.
      */
     void teardown();
 
@@ -82,6 +86,24 @@ class NetCfgDCO : public DBus::Object::Base
     void method_new_key(GVariant *params);
     void method_swap_keys(GVariant *params);
     void method_set_peer(GVariant *params);
+    void method_update_keys(GVariant *params);
+
+    /**
+     *  Latency counters for the UpdateKeys method, measured from the
+     *  method call being received until the update has been applied
+     *  by the GeNL thread.  Updated by the GeNL thread, protected by
+     *  update_keys_mtx.
+     */
+    struct UpdateKeysStatistics
+    {
+        uint64_t updates = 0;
+        uint64_t failures = 0;
+        uint64_t latency_last_usec = 0;
+        uint64_t latency_max_usec = 0;
+        uint64_t latency_total_usec = 0;
+    };
+    UpdateKeysStatistics update_keys_stats{};
+    std::mutex update_keys_mtx{};
 
     struct PacketFrom
     {
@@ -96,10 +118,8 @@ class NetCfgDCO : public DBus::Object::Base
     int fds[2]; // fds[0] is passed to client, here we use fds[1]
     std::unique_ptr<openvpn_io::posix::stream_descriptor> pipe;
     GeNLImpl::Ptr genl;
-    openvpn_io::io_context io_context;
-    // thread where ASIO event loop runs, used by GeNL and pipe
-    std::unique_ptr<std::thread> th;
-    std::unique_ptr<openvpn::AsioWork> asio_work;
+    // task queue in the shared engine thread, used by GeNL and pipe
+    NetCfgDCOEngine::Queue::Ptr queue;
     std::string dev_name;
 };
 
@@ -18,7 +18,14 @@
 
 #include "build-config.h"
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+
+#include "netcfg-configdiff.hpp"
 #include "netcfg-device.hpp"
+#include "netcfg-qdisc.hpp"
 
 #ifdef ENABLE_OVPNDCO
 #include "netcfg-dco.hpp"
@@ -38,7 +45,8 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
                            NetCfgSubscriptions::Ptr subscriptions,
                            const unsigned int log_level,
                            LogWriter *logwr_,
-                           const NetCfgOptions &options)
+                           const NetCfgOptions &options,
+                           std::shared_ptr<NetCfgDCOEngine> dco_engine_)
     : DBus::Object::Base(objpath, Constants::GenInterface("netcfg")),
       dbuscon(dbuscon_),
       object_manager(obj_mgr),
@@ -47,7 +55,8 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
       creator_pid(creator_pid_),
       resolver(resolver),
       logwr(logwr_),
-      options(std::move(options))
+      options(std::move(options)),
+      dco_engine(dco_engine_)
 {
     signals = NetCfgSignals::Create(dbuscon_,
                                     LogGroup::NETCFG,
@@ -69,6 +78,29 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
     AddProperty("mtu", mtu, true);
     AddProperty("layer", device_type, true);
     AddProperty("txqueuelen", txqueuelen, true);
+
+    AddPropertyBySpec(
+        "tun_queues",
+        glib2::DataType::DBus<uint32_t>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(tun_queues);
+        },
+        [&](const DBus::Object::Property::BySpec &prop, GVariant *value) -> DBus::Object::Property::Update::Ptr
+        {
+            uint32_t q = glib2::Value::Get<uint32_t>(value);
+            if (q < 1 || q > MAX_TUN_QUEUES)
+            {
+                throw DBus::Object::Property::Exception(
+                    this,
+                    "tun_queues",
+                    "Must be between 1 and " + std::to_string(MAX_TUN_QUEUES));
+            }
+            tun_queues = q;
+            auto upd = prop.PrepareUpdate();
+            upd->AddValue(tun_queues);
+            return upd;
+        });
     AddProperty("reroute_ipv4", reroute_ipv4, true);
     AddProperty("reroute_ipv6", reroute_ipv6, true);
 
@@ -135,10 +167,73 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         });
 
 
+    AddProperty("tun_offload", tun_offload, true);
+    AddPropertyBySpec(
+        "tun_offload_flags",
+        glib2::DataType::DBus<uint32_t>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(tun_offload_flags);
+        });
+
+    // Time spent in each phase of the last Establish call
+    AddPropertyBySpec(
+        "establish_timeline",
+        "a(sstt)",
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return timeline->GetGVariant();
+        });
+
+    AddPropertyBySpec(
+        "qdisc",
+        glib2::DataType::DBus<std::string>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(qdisc);
+        },
+        [&](const DBus::Object::Property::BySpec &prop, GVariant *value) -> DBus::Object::Property::Update::Ptr
+        {
+            try
+            {
+                qdisc = NetCfg::Qdisc::Parse(glib2::Value::Get<std::string>(value)).str();
+            }
+            catch (const NetCfg::QdiscException &excp)
+            {
+                throw DBus::Object::Property::Exception(this, "qdisc", excp.what());
+            }
+            auto upd = prop.PrepareUpdate();
+            upd->AddValue(qdisc);
+            return upd;
+        });
+    AddPropertyBySpec(
+        "effective_qdisc",
+        glib2::DataType::DBus<std::string>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(effective_qdisc);
+        });
+    AddPropertyBySpec(
+        "establish_mode",
+        glib2::DataType::DBus<std::string>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(establish_mode);
+        });
+    AddPropertyBySpec(
+        "effective_txqueuelen",
+        glib2::DataType::DBus<uint32_t>(),
+        [&](const DBus::Object::Property::BySpec &prop) -> GVariant *
+        {
+            return glib2::Value::Create(effective_txqueuelen);
+        });
+
+
     auto args_add_ipaddr = AddMethod(
         "AddIPAddress",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_add_ip_address(args->GetMethodParameters());
             args->SetMethodReturn(nullptr);
         });
@@ -151,6 +246,7 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "SetRemoteAddress",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_set_remote_addr(args->GetMethodParameters());
             args->SetMethodReturn(nullptr);
         });
@@ -162,6 +258,7 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "AddNetworks",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_add_networks(args->GetMethodParameters());
             args->SetMethodReturn(nullptr);
         });
@@ -172,6 +269,7 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "AddDNS",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_add_dns(args->GetMethodParameters());
             args->SetMethodReturn(nullptr);
         });
@@ -181,6 +279,7 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "AddDNSSearch",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_add_dns_search(args->GetMethodParameters());
             args->SetMethodReturn(nullptr);
         });
@@ -191,6 +290,7 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "EnableDCO",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_enable_dco(args);
         });
     args_enable_dco->AddInput("dev_name", "s");
@@ -201,13 +301,34 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
         "Establish",
         [this](DBus::Object::Method::Arguments::Ptr args)
         {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
             this->method_establish(args);
         });
     args_establish->PassFileDescriptor(DBus::Object::Method::PassFDmode::SEND);
 
+    auto args_get_queue_fd = AddMethod(
+        "GetQueueFD",
+        [this](DBus::Object::Method::Arguments::Ptr args)
+        {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
+            this->method_get_queue_fd(args);
+        });
+    args_get_queue_fd->AddInput("queue", glib2::DataType::DBus<uint32_t>());
+    args_get_queue_fd->PassFileDescriptor(DBus::Object::Method::PassFDmode::SEND);
+
+    auto args_prep_reconnect = AddMethod(
+        "PrepareReconnect",
+        [this](DBus::Object::Method::Arguments::Ptr args)
+        {
+            std::lock_guard<std::mutex> guard(this->device_mtx);
+            this->method_prepare_reconnect(args);
+        });
+    args_prep_reconnect->AddOutput("reusable", glib2::DataType::DBus<bool>());
+
     AddMethod("Disable",
               [this](DBus::Object::Method::Arguments::Ptr args)
               {
+                  std::lock_guard<std::mutex> guard(this->device_mtx);
                   this->method_disable();
                   args->SetMethodReturn(nullptr);
               });
@@ -224,6 +345,13 @@ NetCfgDevice::NetCfgDevice(DBus::Connection::Ptr dbuscon_,
 
 NetCfgDevice::~NetCfgDevice() noexcept
 {
+    std::lock_guard<std::mutex> guard(device_mtx);
+    abort_reconnect();
+    if (reuse_fd >= 0)
+    {
+        close(reuse_fd);
+    }
+    close_tun_queues();
     if (tunimpl)
     {
         tunimpl->teardown(*this, true);
@@ -333,6 +461,19 @@ void NetCfgDevice::method_add_dns(GVariant *params)
         return;
     }
 
+    if (reconnecting)
+    {
+        // Compared with the active settings by Establish
+        for (const auto &srv : glib2::Value::ExtractVector<std::string>(params))
+        {
+            if (pending_dns_servers.end() == std::find(pending_dns_servers.begin(), pending_dns_servers.end(), srv))
+            {
+                pending_dns_servers.push_back(srv);
+            }
+        }
+        return;
+    }
+
     // Adds DNS name servers
     std::string added = dnsconfig->AddNameServers(params);
     signals->DebugDevice(device_name, "Added DNS name servers: " + added);
@@ -349,6 +490,18 @@ void NetCfgDevice::method_add_dns_search(GVariant *params)
         return;
     }
 
+    if (reconnecting)
+    {
+        for (const auto &dom : glib2::Value::ExtractVector<std::string>(params))
+        {
+            if (pending_dns_search.end() == std::find(pending_dns_search.begin(), pending_dns_search.end(), dom))
+            {
+                pending_dns_search.push_back(dom);
+            }
+        }
+        return;
+    }
+
     // Adds DNS search domains
     dnsconfig->AddSearchDomains(params);
     modified = true;
@@ -370,6 +523,7 @@ void NetCfgDevice::method_enable_dco(DBus::Object::Method::Arguments::Ptr args)
             GetPath(),
             dev_name,
             creator_pid,
+            dco_engine,
             logwr);
     }
     catch (const NetCfgException &excp)
@@ -383,6 +537,24 @@ void NetCfgDevice::method_enable_dco(DBus::Object::Method::Arguments::Ptr args)
 
 void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
 {
+    timeline->Clear();
+    if (reconnecting)
+    {
+        int fd = -1;
+        {
+            ConnectTimeline::Scope phase(timeline, "netcfg.reconnect");
+            fd = establish_reconnect();
+        }
+        if (fd >= 0)
+        {
+            args->SendFD(fd);
+            args->SetMethodReturn(nullptr);
+            return;
+        }
+        // The device could not be reused; it has been torn down
+        // and is established again from scratch
+    }
+
     // The virtual device has not yet been created on the host (for
     // non-DCO case), but all settings which has been queued up
     // will be activated when this method is called.
@@ -391,6 +563,7 @@ void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
         if (resolver && dnsconfig
             && DNS::ApplySettingsMode::MODE_PRE == resolver->GetApplyMode())
         {
+            ConnectTimeline::Scope phase(timeline, "netcfg.dns");
             dnsconfig->Enable();
             resolver->ApplySettings(signals);
         }
@@ -408,9 +581,18 @@ void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
     }
 
     int fd = -1;
+    close_tun_queues();
     try
     {
-        fd = tunimpl->establish(*this);
+        {
+            ConnectTimeline::Scope phase(timeline, "netcfg.tun_setup");
+            fd = tunimpl->establish(*this);
+        }
+        {
+            ConnectTimeline::Scope phase(timeline, "netcfg.queueing");
+            apply_queueing();
+        }
+        establish_mode = "full";
     }
     catch (const NetCfgException &excp)
     {
@@ -424,6 +606,7 @@ void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
         {
             if (DNS::ApplySettingsMode::MODE_POST == resolver->GetApplyMode())
             {
+                ConnectTimeline::Scope phase(timeline, "netcfg.dns");
                 dnsconfig->SetDeviceName(device_name);
                 dnsconfig->Enable();
                 resolver->ApplySettings(signals);
@@ -442,6 +625,8 @@ void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
         signals->LogCritical("DNS Resolver settings: "
                              + std::string(excp.what()));
     }
+    save_applied_config(fd);
+
 #ifdef ENABLE_OVPNDCO
     // in DCO case don't return anything
     if (!dco_device)
@@ -455,8 +640,300 @@ void NetCfgDevice::method_establish(DBus::Object::Method::Arguments::Ptr args)
 }
 
 
+void NetCfgDevice::method_get_queue_fd(DBus::Object::Method::Arguments::Ptr args)
+{
+    GVariant *params = args->GetMethodParameters();
+    glib2::Utils::checkParams(__func__, params, "(u)", 1);
+    uint32_t queue = glib2::Value::Extract<uint32_t>(params, 0);
+
+    // Queue 0 is the file descriptor returned by Establish
+    if (queue < 1 || queue > tun_queue_fds.size())
+    {
+        throw NetCfgException("Invalid tun queue index: "
+                              + std::to_string(queue));
+    }
+    args->SendFD(tun_queue_fds[queue - 1]);
+    args->SetMethodReturn(nullptr);
+}
+
+
+void NetCfgDevice::close_tun_queues() noexcept
+{
+    for (const auto fd : tun_queue_fds)
+    {
+        close(fd);
+    }
+    tun_queue_fds.clear();
+}
+
+
+void NetCfgDevice::apply_queueing()
+{
+    // The device settings from the VPN client takes
+    // precedence over the netcfg service defaults
+    const std::string spec = (!qdisc.empty() ? qdisc : options.qdisc);
+    const unsigned int qlen = (txqueuelen > 0 ? txqueuelen : options.txqueuelen);
+
+    try
+    {
+        if (qlen > 0)
+        {
+            NetCfg::SetTxQueueLen(device_name, qlen);
+        }
+        auto root_qdisc = NetCfg::Qdisc::Parse(spec);
+        if (!root_qdisc.empty())
+        {
+            root_qdisc.Apply(device_name);
+            signals->DebugDevice(device_name, "Root qdisc set to " + root_qdisc.str());
+        }
+    }
+    catch (const NetCfg::QdiscException &excp)
+    {
+        signals->LogError("Queueing setup failed: " + std::string(excp.what()));
+    }
+
+    try
+    {
+        effective_qdisc = NetCfg::Qdisc::GetRootKind(device_name);
+        effective_txqueuelen = NetCfg::GetTxQueueLen(device_name);
+    }
+    catch (const NetCfg::QdiscException &excp)
+    {
+        signals->LogWarn("Could not retrieve queueing settings: "
+                         + std::string(excp.what()));
+    }
+}
+
+
+void NetCfgDevice::method_prepare_reconnect(DBus::Object::Method::Arguments::Ptr args)
+{
+    // The grace timer only keeps a weak reference, so it does not
+    // keep the device alive and it does nothing if the device is
+    // already gone when it fires
+    auto self = object_manager->GetObject<NetCfgDevice>(GetPath());
+    bool reusable = (self && tunimpl && reuse_fd >= 0 && options.reconnect_grace > 0);
+    if (!reusable)
+    {
+        method_disable();
+        args->SetMethodReturn(glib2::Value::CreateTupleWrapped(false));
+        return;
+    }
+
+    // The VPN client adds the complete configuration again before
+    // calling Establish.  Until then, everything stays as it is.
+    abort_reconnect();
+    vpnips.clear();
+    networks.clear();
+    reroute_ipv4 = false;
+    reroute_ipv6 = false;
+    pending_dns_servers.clear();
+    pending_dns_search.clear();
+    reconnecting = true;
+    reconnect_timer = g_timeout_add_seconds_full(G_PRIORITY_DEFAULT,
+                                                 options.reconnect_grace,
+                                                 cb_reconnect_timeout,
+                                                 new std::weak_ptr<NetCfgDevice>(self),
+                                                 [](gpointer data)
+                                                 {
+                                                     delete static_cast<std::weak_ptr<NetCfgDevice> *>(data);
+                                                 });
+
+    signals->DebugDevice(device_name, "Device kept for reconnect");
+    args->SetMethodReturn(glib2::Value::CreateTupleWrapped(true));
+}
+
+
+int NetCfgDevice::establish_reconnect()
+{
+    if (reconnect_timer > 0)
+    {
+        g_source_remove(reconnect_timer);
+        reconnect_timer = 0;
+    }
+    reconnecting = false;
+
+    // DNS settings are only applied again if they have changed
+    if (resolver && dnsconfig
+        && (pending_dns_servers != applied.dns_servers
+            || pending_dns_search != applied.dns_search))
+    {
+        try
+        {
+            ConnectTimeline::Scope phase(timeline, "netcfg.dns");
+            dnsconfig->ClearNameServers();
+            for (const auto &srv : pending_dns_servers)
+            {
+                dnsconfig->AddNameServer(srv);
+            }
+            dnsconfig->ClearSearchDomains();
+            for (const auto &dom : pending_dns_search)
+            {
+                dnsconfig->AddSearchDomain(dom);
+            }
+            resolver->ApplySettings(signals);
+            applied.dns_servers = pending_dns_servers;
+            applied.dns_search = pending_dns_search;
+        }
+        catch (const NetCfgException &excp)
+        {
+            signals->LogCritical("DNS Resolver settings: "
+                                 + std::string(excp.what()));
+        }
+    }
+
+    // The remote address is used by the Core library when setting up
+    // the routes, like excluding the remote from the redirected
+    // default route
+    bool device_changed = (remote.address != applied.remote.address
+                           || remote.ipv6 != applied.remote.ipv6
+                           || mtu != applied.mtu
+                           || device_type != applied.device_type
+                           || tun_queues != applied.tun_queues
+                           || tun_offload != applied.tun_offload
+                           || qdisc != applied.qdisc
+                           || txqueuelen != applied.txqueuelen
+                           || !NetCfg::DiffLists(applied.vpnips, vpnips).empty());
+    if (!device_changed)
+    {
+        try
+        {
+            bool routes_changed = !NetCfg::DiffLists(applied.networks, networks).empty()
+                                  || reroute_ipv4 != applied.reroute_ipv4
+                                  || reroute_ipv6 != applied.reroute_ipv6;
+            bool updated = false;
+            {
+                ConnectTimeline::Scope phase(timeline, "netcfg.routes");
+                updated = tunimpl->update_routes(*this,
+                                                 applied.networks,
+                                                 applied.reroute_ipv4,
+                                                 applied.reroute_ipv6);
+            }
+            if (updated)
+            {
+                applied.networks = networks;
+                applied.reroute_ipv4 = reroute_ipv4;
+                applied.reroute_ipv6 = reroute_ipv6;
+                establish_mode = (routes_changed ? "updated" : "reused");
+                signals->LogVerb1("Device '" + device_name + "' reused after reconnect"
+                                  + (routes_changed ? ", routes updated" : ""));
+                return dup(reuse_fd);
+            }
+        }
+        catch (const std::exception &excp)
+        {
+            signals->LogError("Failed updating routes: " + std::string(excp.what()));
+        }
+    }
+
+    // Tear down the device with the configuration it was established
+    // with, so the removal notifications are correct
+    signals->LogVerb1("Device '" + device_name + "' configuration changed, "
+                      + "establishing it again");
+    std::swap(vpnips, applied.vpnips);
+    std::swap(networks, applied.networks);
+    close(reuse_fd);
+    reuse_fd = -1;
+    close_tun_queues();
+    tunimpl->teardown(*this, true);
+    tunimpl.reset();
+    std::swap(vpnips, applied.vpnips);
+    std::swap(networks, applied.networks);
+
+    // The DNS settings have already been updated above
+    return -1;
+}
+
+
+void NetCfgDevice::save_applied_config(const int fd)
+{
+    if (reuse_fd >= 0)
+    {
+        close(reuse_fd);
+        reuse_fd = -1;
+    }
+#ifdef ENABLE_OVPNDCO
+    if (dco_device)
+    {
+        return;
+    }
+#endif
+    if (fd < 0)
+    {
+        return;
+    }
+
+    reuse_fd = dup(fd);
+    applied.remote = remote;
+    applied.vpnips = vpnips;
+    applied.networks = networks;
+    applied.reroute_ipv4 = reroute_ipv4;
+    applied.reroute_ipv6 = reroute_ipv6;
+    applied.mtu = mtu;
+    applied.device_type = device_type;
+    applied.tun_queues = tun_queues;
+    applied.tun_offload = tun_offload;
+    applied.qdisc = qdisc;
+    applied.txqueuelen = txqueuelen;
+    applied.dns_servers = (dnsconfig ? dnsconfig->GetNameServers() : std::vector<std::string>{});
+    applied.dns_search = (dnsconfig ? dnsconfig->GetSearchDomains() : std::vector<std::string>{});
+}
+
+
+void NetCfgDevice::abort_reconnect() noexcept
+{
+    if (reconnect_timer > 0)
+    {
+        g_source_remove(reconnect_timer);
+        reconnect_timer = 0;
+    }
+    if (reconnecting)
+    {
+        // Restore the configuration which is still active
+        vpnips = applied.vpnips;
+        networks = applied.networks;
+        reroute_ipv4 = applied.reroute_ipv4;
+        reroute_ipv6 = applied.reroute_ipv6;
+        reconnecting = false;
+    }
+}
+
+
+gboolean NetCfgDevice::cb_reconnect_timeout(gpointer data)
+{
+    auto self = static_cast<std::weak_ptr<NetCfgDevice> *>(data)->lock();
+    if (!self)
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    // This runs in the main loop thread, while the D-Bus methods of
+    // the device are handled in other threads
+    std::lock_guard<std::mutex> guard(self->device_mtx);
+    if (self->reconnect_timer != g_source_get_id(g_main_current_source()))
+    {
+        // The device was established or disabled while this was
+        // waiting for the lock
+        return G_SOURCE_REMOVE;
+    }
+
+    // The source is removed by returning G_SOURCE_REMOVE
+    self->reconnect_timer = 0;
+    self->signals->LogVerb1("Device '" + self->device_name + "' was not "
+                            + "established again after reconnect, disabling it");
+    self->method_disable();
+    return G_SOURCE_REMOVE;
+}
+
+
 void NetCfgDevice::method_disable()
 {
+    abort_reconnect();
+    if (reuse_fd >= 0)
+    {
+        close(reuse_fd);
+        reuse_fd = -1;
+    }
+
     if (resolver && dnsconfig)
     {
         std::stringstream details;
@@ -476,6 +953,7 @@ void NetCfgDevice::method_disable()
 
         modified = false;
     }
+    close_tun_queues();
     if (tunimpl)
     {
         tunimpl->teardown(*this, true);
@@ -491,17 +969,21 @@ void NetCfgDevice::method_destroy(DBus::Object::Method::Arguments::Ptr args)
     uid_t caller_uid = credsq->GetUID(caller);
     // CheckOwnerAccess(caller);
 
-    if (resolver && dnsconfig)
     {
-        std::stringstream details;
-        details << dnsconfig;
+        // Not held while the object is removed, as that destroys it
+        std::lock_guard<std::mutex> guard(device_mtx);
+        if (resolver && dnsconfig)
+        {
+            std::stringstream details;
+            details << dnsconfig;
 
-        signals->DebugDevice(device_name,
-                             "Removing DNS/resolver settings: "
-                                 + details.str());
-        dnsconfig->PrepareRemoval();
-        resolver->ApplySettings(signals);
-        modified = false;
+            signals->DebugDevice(device_name,
+                                 "Removing DNS/resolver settings: "
+                                     + details.str());
+            dnsconfig->PrepareRemoval();
+            resolver->ApplySettings(signals);
+            modified = false;
+        }
     }
 
     std::string sender_name = lookup_username(caller_uid);
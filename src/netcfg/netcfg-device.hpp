@@ -21,6 +21,9 @@
 #include "build-config.h"
 
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <gio/gunixfdlist.h>
 #include <gio/gunixconnection.h>
 #include <gdbuspp/connection.hpp>
@@ -33,6 +36,7 @@
 #include <openvpn/common/rc.hpp>
 
 #include "common/lookup.hpp"
+#include "common/timeline.hpp"
 #include "core-tunbuilder.hpp"
 #include "dbus/object-ownership.hpp"
 #include "netcfg/dns/resolver-settings.hpp"
@@ -46,6 +50,8 @@
 #include "netcfg-dco.hpp"
 #endif
 
+class NetCfgDCOEngine;
+
 using namespace openvpn;
 using namespace NetCfg;
 
@@ -101,6 +107,13 @@ class Network : public IPAddr
     {
         return address + "/" + std::to_string(prefix);
     }
+
+    bool operator<(const Network &other) const
+    {
+        return std::tie(address, prefix, ipv6, exclude)
+               < std::tie(other.address, other.prefix, other.ipv6, other.exclude);
+    }
+
     unsigned int prefix;
     bool exclude;
 };
@@ -124,6 +137,12 @@ class VPNAddress : public Network
     {
     }
 
+    bool operator<(const VPNAddress &other) const
+    {
+        return std::tie(address, prefix, ipv6, gateway)
+               < std::tie(other.address, other.prefix, other.ipv6, other.gateway);
+    }
+
     std::string gateway;
 };
 
@@ -136,6 +155,12 @@ class NetCfgDevice : public DBus::Object::Base
   public:
     using Ptr = std::shared_ptr<NetCfgDevice>;
 
+    /**
+     *  Maximum number of queues which can be requested via the
+     *  tun_queues property
+     */
+    static constexpr uint32_t MAX_TUN_QUEUES = 16;
+
     NetCfgDevice(DBus::Connection::Ptr dbuscon,
                  DBus::Object::Manager::Ptr obj_mgr,
                  const uid_t creator_,
@@ -146,7 +171,8 @@ class NetCfgDevice : public DBus::Object::Base
                  NetCfgSubscriptions::Ptr subscriptions,
                  const unsigned int log_level,
                  LogWriter *logwr,
-                 const NetCfgOptions &options);
+                 const NetCfgOptions &options,
+                 std::shared_ptr<NetCfgDCOEngine> dco_engine);
     ~NetCfgDevice() noexcept;
 
     const bool Authorize(const DBus::Authz::Request::Ptr request) override;
@@ -172,6 +198,14 @@ class NetCfgDevice : public DBus::Object::Base
     std::string device_name{};
     uint16_t mtu{1500};
     uint16_t txqueuelen{0};
+    uint32_t tun_queues{1};
+    bool tun_offload{false};
+    uint32_t tun_offload_flags{0};
+    ConnectTimeline::Ptr timeline = ConnectTimeline::Create("netcfg");
+    std::string qdisc{};
+    std::string effective_qdisc{};
+    uint32_t effective_txqueuelen{0};
+    std::vector<int> tun_queue_fds{};
     GDBusPP::Object::Extension::ACL::Ptr object_acl = nullptr;
     pid_t creator_pid{-1};
     DNS::SettingsManager::Ptr resolver;
@@ -186,6 +220,44 @@ class NetCfgDevice : public DBus::Object::Base
     IPAddr remote{};
     bool reroute_ipv4{false};
     bool reroute_ipv6{false};
+    std::shared_ptr<NetCfgDCOEngine> dco_engine = nullptr;
+
+    /**
+     *  The configuration the device was last established with.  Used
+     *  to find out what needs to change when the device is established
+     *  again after PrepareReconnect
+     */
+    struct AppliedConfig
+    {
+        IPAddr remote{};
+        std::vector<VPNAddress> vpnips{};
+        std::vector<Network> networks{};
+        bool reroute_ipv4 = false;
+        bool reroute_ipv6 = false;
+        uint16_t mtu = 0;
+        unsigned int device_type = NetCfgDeviceType::UNSET;
+        uint32_t tun_queues = 1;
+        bool tun_offload = false;
+        std::string qdisc{};
+        uint16_t txqueuelen = 0;
+        std::vector<std::string> dns_servers{};
+        std::vector<std::string> dns_search{};
+    };
+    AppliedConfig applied{};
+
+    /**
+     *  Serializes the D-Bus method calls, which are handled in worker
+     *  threads, and the reconnect grace timer running in the main loop
+     */
+    std::mutex device_mtx{};
+
+    /** Copy of the tun fd, to hand out again if the device is reused */
+    int reuse_fd = -1;
+    bool reconnecting = false;
+    guint reconnect_timer = 0;
+    std::vector<std::string> pending_dns_servers{};
+    std::vector<std::string> pending_dns_search{};
+    std::string establish_mode{};
 #ifdef ENABLE_OVPNDCO
     NetCfgDCO::Ptr dco_device = nullptr;
 #endif
@@ -197,6 +269,14 @@ class NetCfgDevice : public DBus::Object::Base
     void method_add_dns_search(GVariant *params);
     void method_enable_dco(DBus::Object::Method::Arguments::Ptr args);
     void method_establish(DBus::Object::Method::Arguments::Ptr args);
+    void method_prepare_reconnect(DBus::Object::Method::Arguments::Ptr args);
+    int establish_reconnect();
+    void save_applied_config(const int fd);
+    void abort_reconnect() noexcept;
+    static gboolean cb_reconnect_timeout(gpointer data);
+    void method_get_queue_fd(DBus::Object::Method::Arguments::Ptr args);
+    void close_tun_queues() noexcept;
+    void apply_queueing();
     void method_disable();
     void method_destroy(DBus::Object::Method::Arguments::Ptr);
 };
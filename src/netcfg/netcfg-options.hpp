@@ -17,6 +17,7 @@
 
 #include "common/cmdargparser.hpp"
 #include "netcfg/netcfg-configfile.hpp"
+#include "netcfg/netcfg-qdisc.hpp"
 
 
 enum class RedirectMethod : std::uint8_t
@@ -39,6 +40,24 @@ struct NetCfgOptions
     /** the SO_MARK to use if > 0 */
     int so_mark = -1;
 
+    /** Default root qdisc for new devices, see NetCfg::Qdisc */
+    std::string qdisc = "";
+
+    /** Default transmit queue length for new devices, if > 0 */
+    unsigned int txqueuelen = 0;
+
+    /** May backend clients request offload capable tun devices? */
+    bool tun_offload = false;
+
+    /** Number of threads handling the DCO devices, 0 for automatic */
+    unsigned int dco_threads = 0;
+
+    /**
+     *  Seconds a device is kept after a client prepared a reconnect,
+     *  0 disables reusing devices across reconnects
+     */
+    unsigned int reconnect_grace = 30;
+
     /** Will signals be broadcast to all users? */
     bool signal_broadcast = false;
 
@@ -101,6 +120,37 @@ struct NetCfgOptions
             so_mark = std::atoi(args->GetValue("set-somark", 0).c_str());
         }
 
+        if (args->Present("qdisc"))
+        {
+            qdisc = args->GetLastValue("qdisc");
+            try
+            {
+                // Only validate it here; it is parsed again per device
+                (void)NetCfg::Qdisc::Parse(qdisc);
+            }
+            catch (const NetCfg::QdiscException &excp)
+            {
+                throw CommandArgBaseException("Invalid argument to --qdisc: "
+                                              + std::string(excp.what()));
+            }
+        }
+
+        if (args->Present("txqueuelen"))
+        {
+            txqueuelen = std::atoi(args->GetLastValue("txqueuelen").c_str());
+        }
+
+        tun_offload = args->Present("tun-offload");
+
+        if (args->Present("dco-threads"))
+        {
+            dco_threads = std::atoi(args->GetLastValue("dco-threads").c_str());
+        }
+
+        if (args->Present("reconnect-grace"))
+        {
+            reconnect_grace = std::atoi(args->GetLastValue("reconnect-grace").c_str());
+        }
         signal_broadcast = args->Present("signal-broadcast");
     }
 
@@ -157,6 +207,23 @@ struct NetCfgOptions
         {
             s << ", so-mark: " << std::to_string(o.so_mark);
         }
+        if (!o.qdisc.empty())
+        {
+            s << ", qdisc: " << o.qdisc;
+        }
+        if (o.txqueuelen > 0)
+        {
+            s << ", txqueuelen: " << std::to_string(o.txqueuelen);
+        }
+        if (o.tun_offload)
+        {
+            s << ", tun-offload";
+        }
+        if (o.dco_threads > 0)
+        {
+            s << ", dco-threads: " << std::to_string(o.dco_threads);
+        }
+        s << ", reconnect-grace: " << std::to_string(o.reconnect_grace);
         return s.str();
     }
 };
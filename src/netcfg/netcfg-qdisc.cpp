@@ -0,0 +1,358 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-qdisc.cpp
+ *
+ * @brief  Implementation of the qdisc and transmit queue configuration
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+
+#include "netcfg-qdisc.hpp"
+
+
+namespace NetCfg {
+
+// Parameters of the supported qdisc kinds, mapped to
+// their netlink TCA_OPTIONS attribute type
+static const std::map<std::string, std::map<std::string, uint16_t>> qdisc_params = {
+    // clang-format off
+    {"fq_codel", {{"limit", TCA_FQ_CODEL_LIMIT},
+                  {"flows", TCA_FQ_CODEL_FLOWS},
+                  {"target", TCA_FQ_CODEL_TARGET},
+                  {"interval", TCA_FQ_CODEL_INTERVAL},
+                  {"quantum", TCA_FQ_CODEL_QUANTUM},
+                  {"ecn", TCA_FQ_CODEL_ECN},
+                  {"ce_threshold", TCA_FQ_CODEL_CE_THRESHOLD}}},
+    {"codel", {{"limit", TCA_CODEL_LIMIT},
+               {"target", TCA_CODEL_TARGET},
+               {"interval", TCA_CODEL_INTERVAL},
+               {"ecn", TCA_CODEL_ECN}}},
+    {"fq", {{"limit", TCA_FQ_PLIMIT},
+            {"flow_limit", TCA_FQ_FLOW_PLIMIT},
+            {"quantum", TCA_FQ_QUANTUM},
+            {"initial_quantum", TCA_FQ_INITIAL_QUANTUM},
+            {"maxrate", TCA_FQ_FLOW_MAX_RATE},
+            {"pacing", TCA_FQ_RATE_ENABLE}}},
+    {"pfifo_fast", {}},
+    {"noqueue", {}}
+    // clang-format on
+};
+
+
+Qdisc Qdisc::Parse(const std::string &spec)
+{
+    Qdisc ret;
+    if (spec.empty())
+    {
+        return ret;
+    }
+
+    const size_t sep = spec.find(':');
+    ret.kind = spec.substr(0, sep);
+    auto known = qdisc_params.find(ret.kind);
+    if (qdisc_params.end() == known)
+    {
+        throw QdiscException("Unsupported qdisc: " + ret.kind);
+    }
+    if (std::string::npos == sep)
+    {
+        return ret;
+    }
+
+    std::stringstream params(spec.substr(sep + 1));
+    std::string param;
+    while (std::getline(params, param, ','))
+    {
+        const size_t eq = param.find('=');
+        const std::string name = param.substr(0, eq);
+        if (known->second.end() == known->second.find(name))
+        {
+            throw QdiscException("Unsupported parameter for " + ret.kind
+                                 + ": " + name);
+        }
+
+        const std::string value = (std::string::npos != eq
+                                       ? param.substr(eq + 1)
+                                       : "");
+        try
+        {
+            size_t used = 0;
+            unsigned long v = std::stoul(value, &used);
+            if (used != value.size() || v > UINT32_MAX || '-' == value[0])
+            {
+                throw std::out_of_range(value);
+            }
+            ret.params[name] = static_cast<uint32_t>(v);
+        }
+        catch (const std::logic_error &)
+        {
+            throw QdiscException("Invalid value for " + ret.kind
+                                 + " parameter " + name + ": '"
+                                 + value + "'");
+        }
+    }
+    return ret;
+}
+
+
+std::string Qdisc::str() const
+{
+    std::string ret = kind;
+    char sep = ':';
+    for (const auto &[name, value] : params)
+    {
+        ret += sep + name + "=" + std::to_string(value);
+        sep = ',';
+    }
+    return ret;
+}
+
+
+/**
+ *  Minimal netlink message builder for the RTM_*QDISC requests
+ */
+class QdiscRequest
+{
+  public:
+    QdiscRequest(uint16_t type, uint16_t flags, int ifindex)
+        : buf(NLMSG_SPACE(sizeof(struct tcmsg)), 0)
+    {
+        auto nlh = reinterpret_cast<struct nlmsghdr *>(buf.data());
+        nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct tcmsg));
+        nlh->nlmsg_type = type;
+        nlh->nlmsg_flags = NLM_F_REQUEST | flags;
+        nlh->nlmsg_seq = 1;
+
+        auto tcm = static_cast<struct tcmsg *>(NLMSG_DATA(nlh));
+        tcm->tcm_family = AF_UNSPEC;
+        tcm->tcm_ifindex = ifindex;
+        tcm->tcm_parent = TC_H_ROOT;
+    }
+
+    size_t AddAttr(uint16_t type, const void *data, size_t len)
+    {
+        const size_t offset = NLMSG_ALIGN(buf.size());
+        buf.resize(offset + RTA_SPACE(len), 0);
+        auto rta = reinterpret_cast<struct rtattr *>(buf.data() + offset);
+        rta->rta_type = type;
+        rta->rta_len = RTA_LENGTH(len);
+        if (len > 0)
+        {
+            memcpy(RTA_DATA(rta), data, len);
+        }
+        reinterpret_cast<struct nlmsghdr *>(buf.data())->nlmsg_len = buf.size();
+        return offset;
+    }
+
+    void EndNested(size_t offset)
+    {
+        auto rta = reinterpret_cast<struct rtattr *>(buf.data() + offset);
+        rta->rta_len = buf.size() - offset;
+    }
+
+    /**
+     *  Send the request and process the responses.  The callback is
+     *  called for each response message which is not an ACK or error.
+     */
+    template <typename Callback>
+    void Send(Callback callback)
+    {
+        int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd < 0)
+        {
+            throw QdiscException(std::string("Could not open netlink socket: ")
+                                 + strerror(errno));
+        }
+
+        try
+        {
+            if (send(fd, buf.data(), buf.size(), 0) < 0)
+            {
+                throw QdiscException(std::string("Netlink request failed: ")
+                                     + strerror(errno));
+            }
+
+            alignas(struct nlmsghdr) char resp[16384];
+            bool done = false;
+            while (!done)
+            {
+                ssize_t len = recv(fd, resp, sizeof(resp), 0);
+                if (len < 0)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    throw QdiscException(std::string("Netlink response failed: ")
+                                         + strerror(errno));
+                }
+
+                for (auto nlh = reinterpret_cast<struct nlmsghdr *>(resp);
+                     NLMSG_OK(nlh, static_cast<unsigned int>(len));
+                     nlh = NLMSG_NEXT(nlh, len))
+                {
+                    if (NLMSG_DONE == nlh->nlmsg_type)
+                    {
+                        done = true;
+                    }
+                    else if (NLMSG_ERROR == nlh->nlmsg_type)
+                    {
+                        auto err = static_cast<struct nlmsgerr *>(NLMSG_DATA(nlh));
+                        if (0 != err->error)
+                        {
+                            throw QdiscException(strerror(-err->error));
+                        }
+                        done = true;
+                    }
+                    else
+                    {
+                        callback(nlh);
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+  private:
+    std::vector<char> buf;
+};
+
+
+static int get_ifindex(const std::string &ifname)
+{
+    int idx = if_nametoindex(ifname.c_str());
+    if (0 == idx)
+    {
+        throw QdiscException("Unknown network device: " + ifname);
+    }
+    return idx;
+}
+
+
+void Qdisc::Apply(const std::string &ifname) const
+{
+    if (empty())
+    {
+        return;
+    }
+
+    QdiscRequest req(RTM_NEWQDISC,
+                     NLM_F_CREATE | NLM_F_REPLACE | NLM_F_ACK,
+                     get_ifindex(ifname));
+    req.AddAttr(TCA_KIND, kind.c_str(), kind.size() + 1);
+    if (!params.empty())
+    {
+        const auto &known = qdisc_params.at(kind);
+        size_t opts = req.AddAttr(TCA_OPTIONS | NLA_F_NESTED, nullptr, 0);
+        for (const auto &[name, value] : params)
+        {
+            req.AddAttr(known.at(name), &value, sizeof(value));
+        }
+        req.EndNested(opts);
+    }
+
+    try
+    {
+        req.Send([](const struct nlmsghdr *) {});
+    }
+    catch (const QdiscException &excp)
+    {
+        throw QdiscException("Could not set qdisc '" + str() + "' on "
+                             + ifname + ": " + excp.what());
+    }
+}
+
+
+std::string Qdisc::GetRootKind(const std::string &ifname)
+{
+    const int ifindex = get_ifindex(ifname);
+    QdiscRequest req(RTM_GETQDISC, NLM_F_DUMP, 0);
+
+    std::string ret;
+    req.Send([&ret, ifindex](const struct nlmsghdr *nlh)
+             {
+                 if (RTM_NEWQDISC != nlh->nlmsg_type)
+                 {
+                     return;
+                 }
+                 auto tcm = static_cast<const struct tcmsg *>(NLMSG_DATA(nlh));
+                 if (tcm->tcm_ifindex != ifindex || TC_H_ROOT != tcm->tcm_parent)
+                 {
+                     return;
+                 }
+
+                 int len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*tcm));
+                 for (auto rta = reinterpret_cast<const struct rtattr *>(
+                          reinterpret_cast<const char *>(tcm) + NLMSG_ALIGN(sizeof(*tcm)));
+                      RTA_OK(rta, len);
+                      rta = RTA_NEXT(rta, len))
+                 {
+                     if (TCA_KIND == rta->rta_type)
+                     {
+                         ret = static_cast<const char *>(RTA_DATA(rta));
+                     }
+                 }
+             });
+    return ret;
+}
+
+
+static void txqueuelen_ioctl(const std::string &ifname, unsigned long req, struct ifreq &ifr)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw QdiscException(std::string("Could not open socket: ")
+                             + strerror(errno));
+    }
+    strncpy(ifr.ifr_name, ifname.c_str(), IFNAMSIZ - 1);
+    int r = ioctl(fd, req, &ifr);
+    int err = errno;
+    close(fd);
+    if (r < 0)
+    {
+        throw QdiscException("Could not access the transmit queue length of "
+                             + ifname + ": " + strerror(err));
+    }
+}
+
+
+void SetTxQueueLen(const std::string &ifname, const unsigned int qlen)
+{
+    struct ifreq ifr = {};
+    ifr.ifr_qlen = qlen;
+    txqueuelen_ioctl(ifname, SIOCSIFTXQLEN, ifr);
+}
+
+
+unsigned int GetTxQueueLen(const std::string &ifname)
+{
+    struct ifreq ifr = {};
+    txqueuelen_ioctl(ifname, SIOCGIFTXQLEN, ifr);
+    return ifr.ifr_qlen;
+}
+
+} // namespace NetCfg
@@ -0,0 +1,126 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-qdisc.hpp
+ *
+ * @brief  Configuration of the queueing discipline (qdisc) and transmit
+ *         queue length of the virtual network devices
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+
+namespace NetCfg {
+
+class QdiscException : public std::runtime_error
+{
+  public:
+    QdiscException(const std::string &msg)
+        : std::runtime_error(msg)
+    {
+    }
+};
+
+
+/**
+ *  Queueing discipline to use as the root qdisc of a device, with
+ *  optional parameters.
+ *
+ *  The textual representation is "KIND[:PARAM=VALUE[,PARAM=VALUE...]]",
+ *  for example "fq_codel:target=5000,interval=100000".  All parameter
+ *  values are unsigned integers.  The supported kinds and parameters are:
+ *
+ *    - fq_codel: limit, flows, target (usec), interval (usec),
+ *                quantum, ecn, ce_threshold (usec)
+ *    - codel:    limit, target (usec), interval (usec), ecn
+ *    - fq:       limit, flow_limit, quantum, initial_quantum,
+ *                maxrate (bytes/sec), pacing
+ *    - pfifo_fast, noqueue: no parameters
+ */
+struct Qdisc
+{
+    std::string kind{};
+    std::map<std::string, uint32_t> params{};
+
+    /**
+     *  Parse and validate a qdisc specification
+     *
+     * @param spec  std::string with the textual representation.  An
+     *              empty string results in an empty Qdisc object,
+     *              meaning the system default is used.
+     * @return Qdisc
+     *
+     * @throws NetCfg::QdiscException on invalid specifications
+     */
+    static Qdisc Parse(const std::string &spec);
+
+    /**
+     *  Check if this object is empty; no qdisc is configured
+     */
+    bool empty() const noexcept
+    {
+        return kind.empty();
+    }
+
+    /**
+     *  Textual representation of this qdisc, as parsed by Parse()
+     */
+    std::string str() const;
+
+    /**
+     *  Install this qdisc as the root qdisc of a network device,
+     *  replacing the current one.  Requires CAP_NET_ADMIN.
+     *
+     * @param ifname  std::string with the network device name
+     *
+     * @throws NetCfg::QdiscException on errors
+     */
+    void Apply(const std::string &ifname) const;
+
+    /**
+     *  Retrieve the kind of the root qdisc of a network device
+     *
+     * @param ifname  std::string with the network device name
+     * @return std::string with the qdisc kind, empty if the device does
+     *         not have a root qdisc
+     *
+     * @throws NetCfg::QdiscException on errors
+     */
+    static std::string GetRootKind(const std::string &ifname);
+};
+
+
+/**
+ *  Change the transmit queue length of a network device.  Requires
+ *  CAP_NET_ADMIN.
+ *
+ * @param ifname  std::string with the network device name
+ * @param qlen    unsigned int with the new queue length
+ *
+ * @throws NetCfg::QdiscException on errors
+ */
+void SetTxQueueLen(const std::string &ifname, const unsigned int qlen);
+
+
+/**
+ *  Retrieve the transmit queue length of a network device
+ *
+ * @param ifname  std::string with the network device name
+ * @return unsigned int with the queue length
+ *
+ * @throws NetCfg::QdiscException on errors
+ */
+unsigned int GetTxQueueLen(const std::string &ifname);
+
+} // namespace NetCfg
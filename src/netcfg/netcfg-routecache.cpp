@@ -0,0 +1,350 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-routecache.cpp
+ *
+ * @brief  Implementation of NetCfgRouteCache
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <glib-unix.h>
+
+#include "netcfg-routecache.hpp"
+
+
+NetCfgRouteCache::Ptr NetCfgRouteCache::Create(LookupFunc lookup, bool subscribe)
+{
+    return NetCfgRouteCache::Ptr(new NetCfgRouteCache(std::move(lookup), subscribe));
+}
+
+
+NetCfgRouteCache::NetCfgRouteCache(LookupFunc lookup, bool subscribe)
+    : lookup_func(std::move(lookup))
+{
+    if (subscribe)
+    {
+        subscribe_route_changes();
+    }
+}
+
+
+NetCfgRouteCache::~NetCfgRouteCache() noexcept
+{
+    unsubscribe_route_changes();
+}
+
+
+std::string NetCfgRouteCache::GetBestDevice(const std::string &remote, bool ipv6)
+{
+    auto key = std::make_pair(ipv6, remote);
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        ++stats.hits;
+        return it->second.device;
+    }
+
+    ++stats.misses;
+    std::string device = lookup_func(remote, ipv6);
+
+    Entry entry{(ipv6 ? AF_INET6 : AF_INET), {}, device};
+    if (caching
+        && 1 == inet_pton(entry.family, remote.c_str(), entry.addr.data()))
+    {
+        cache[key] = entry;
+    }
+    return device;
+}
+
+
+void NetCfgRouteCache::InvalidatePrefix(int family, const void *addr, unsigned int prefix_len)
+{
+    const auto prefix = static_cast<const uint8_t *>(addr);
+    prefix_len = std::min(prefix_len, (AF_INET6 == family ? 128u : 32u));
+    const unsigned int full_bytes = prefix_len / 8;
+    const uint8_t mask = static_cast<uint8_t>(0xff << (8 - (prefix_len % 8)));
+
+    for (auto it = cache.begin(); it != cache.end();)
+    {
+        const Address &a = it->second.addr;
+        bool covered = (it->second.family == family)
+                       && (0 == memcmp(a.data(), prefix, full_bytes))
+                       && (0 == (prefix_len % 8)
+                           || (a[full_bytes] & mask) == (prefix[full_bytes] & mask));
+        if (covered)
+        {
+            it = cache.erase(it);
+            ++stats.invalidated;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+void NetCfgRouteCache::InvalidateDevice(const std::string &device)
+{
+    for (auto it = cache.begin(); it != cache.end();)
+    {
+        if (it->second.device == device)
+        {
+            it = cache.erase(it);
+            ++stats.invalidated;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+void NetCfgRouteCache::ProcessNetlinkMessage(const struct nlmsghdr *nlh)
+{
+    switch (nlh->nlmsg_type)
+    {
+    case RTM_NEWROUTE:
+    case RTM_DELROUTE:
+        {
+            auto rtm = static_cast<const struct rtmsg *>(NLMSG_DATA(nlh));
+            if (AF_INET != rtm->rtm_family && AF_INET6 != rtm->rtm_family)
+            {
+                return;
+            }
+
+            // A route without RTA_DST is a default route, which
+            // covers all addresses.  Tables above 255 are only
+            // given in RTA_TABLE.
+            Address dst{};
+            uint32_t table = rtm->rtm_table;
+            int rtlen = RTM_PAYLOAD(nlh);
+            for (auto rta = RTM_RTA(rtm); RTA_OK(rta, rtlen); rta = RTA_NEXT(rta, rtlen))
+            {
+                if (RTA_DST == rta->rta_type)
+                {
+                    memcpy(dst.data(),
+                           RTA_DATA(rta),
+                           std::min<size_t>(RTA_PAYLOAD(rta), dst.size()));
+                }
+                else if (RTA_TABLE == rta->rta_type
+                         && static_cast<size_t>(RTA_PAYLOAD(rta)) >= sizeof(uint32_t))
+                {
+                    memcpy(&table, RTA_DATA(rta), sizeof(uint32_t));
+                }
+            }
+
+            // The lookup only uses the main routing table
+            if (RT_TABLE_MAIN != table)
+            {
+                return;
+            }
+            InvalidatePrefix(rtm->rtm_family, dst.data(), rtm->rtm_dst_len);
+        }
+        break;
+
+    case RTM_NEWLINK:
+    case RTM_DELLINK:
+        {
+            auto ifi = static_cast<const struct ifinfomsg *>(NLMSG_DATA(nlh));
+            std::string ifname;
+            int len = IFLA_PAYLOAD(nlh);
+            for (auto rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+            {
+                if (IFLA_IFNAME == rta->rta_type)
+                {
+                    ifname = std::string(static_cast<const char *>(RTA_DATA(rta)),
+                                         strnlen(static_cast<const char *>(RTA_DATA(rta)),
+                                                 RTA_PAYLOAD(rta)));
+                }
+            }
+
+            const unsigned int up = IFF_UP | IFF_RUNNING;
+            if (RTM_NEWLINK == nlh->nlmsg_type && up == (ifi->ifi_flags & up))
+            {
+                // Routes via this link may be better than the cached ones
+                Flush();
+            }
+            else if (!ifname.empty())
+            {
+                InvalidateDevice(ifname);
+            }
+            else
+            {
+                Flush();
+            }
+        }
+        break;
+
+    case RTM_NEWADDR:
+    case RTM_DELADDR:
+        {
+            auto ifa = static_cast<const struct ifaddrmsg *>(NLMSG_DATA(nlh));
+            if (AF_INET != ifa->ifa_family && AF_INET6 != ifa->ifa_family)
+            {
+                return;
+            }
+
+            Address prefix{};
+            bool have_prefix = false;
+            int len = IFA_PAYLOAD(nlh);
+            for (auto rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+            {
+                if (IFA_ADDRESS == rta->rta_type)
+                {
+                    memcpy(prefix.data(),
+                           RTA_DATA(rta),
+                           std::min<size_t>(RTA_PAYLOAD(rta), prefix.size()));
+                    have_prefix = true;
+                }
+            }
+            if (have_prefix)
+            {
+                InvalidatePrefix(ifa->ifa_family, prefix.data(), ifa->ifa_prefixlen);
+            }
+
+            // Routes via gateways reachable through the removed
+            // address are removed without any notification
+            if (RTM_DELADDR == nlh->nlmsg_type)
+            {
+                char ifname[IF_NAMESIZE] = {};
+                if (nullptr != if_indextoname(ifa->ifa_index, ifname))
+                {
+                    InvalidateDevice(ifname);
+                }
+                else
+                {
+                    Flush();
+                }
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void NetCfgRouteCache::Flush()
+{
+    stats.invalidated += cache.size();
+    cache.clear();
+}
+
+
+NetCfgRouteCache::Statistics NetCfgRouteCache::GetStatistics() const
+{
+    Statistics ret = stats;
+    ret.entries = cache.size();
+    return ret;
+}
+
+
+void NetCfgRouteCache::subscribe_route_changes()
+{
+    // Without the netlink subscription, there is no way to know
+    // when a cached entry becomes stale
+    caching = false;
+
+    nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (nl_fd < 0)
+    {
+        return;
+    }
+
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE | RTMGRP_LINK
+                     | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (0 != bind(nl_fd, (struct sockaddr *)&addr, sizeof(addr)))
+    {
+        close(nl_fd);
+        nl_fd = -1;
+        return;
+    }
+    nl_watch_id = g_unix_fd_add(nl_fd, G_IO_IN, cb_netlink, this);
+    caching = true;
+}
+
+
+void NetCfgRouteCache::unsubscribe_route_changes() noexcept
+{
+    if (nl_watch_id > 0)
+    {
+        g_source_remove(nl_watch_id);
+        nl_watch_id = 0;
+    }
+    if (nl_fd >= 0)
+    {
+        close(nl_fd);
+        nl_fd = -1;
+    }
+}
+
+
+gboolean NetCfgRouteCache::cb_netlink(gint fd, GIOCondition cond, gpointer data)
+{
+    auto self = static_cast<NetCfgRouteCache *>(data);
+    if (!self->process_netlink())
+    {
+        // The subscription is broken; stop caching
+        self->nl_watch_id = 0;
+        self->unsubscribe_route_changes();
+        self->caching = false;
+        self->Flush();
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+
+bool NetCfgRouteCache::process_netlink()
+{
+    alignas(struct nlmsghdr) char buf[16384];
+    while (true)
+    {
+        ssize_t len = recv(nl_fd, buf, sizeof(buf), 0);
+        if (len < 0)
+        {
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                return true;
+            }
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            if (ENOBUFS == errno)
+            {
+                // Route change notifications were lost; no way to
+                // know which entries are affected
+                Flush();
+                continue;
+            }
+            return false;
+        }
+
+        for (auto nlh = reinterpret_cast<struct nlmsghdr *>(buf);
+             NLMSG_OK(nlh, static_cast<unsigned int>(len));
+             nlh = NLMSG_NEXT(nlh, len))
+        {
+            ProcessNetlinkMessage(nlh);
+        }
+    }
+}
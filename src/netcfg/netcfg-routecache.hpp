@@ -0,0 +1,159 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-routecache.hpp
+ *
+ * @brief  Cache of the best network device to reach a remote host,
+ *         invalidated by routing table changes reported via netlink
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <glib.h>
+
+struct nlmsghdr;
+
+/**
+ *  Looking up the best route to a remote host requires a full dump of
+ *  the routing table via netlink.  This cache keeps the result of such
+ *  lookups per remote host.
+ *
+ *  The cache subscribes to the route, link and address netlink groups.
+ *  When a route in the main routing table is added or removed, only the
+ *  cached entries for remote hosts covered by that route are removed.
+ *  Routes in other tables are not used by the lookup and are ignored.
+ *
+ *  The kernel does not report all the routes it removes when a link
+ *  goes down or an address is removed.  In these cases, all entries
+ *  using that device are removed.  When a link comes up, a better route
+ *  may become usable for any remote host, so the cache is flushed.  A
+ *  new address only invalidates the entries covered by its prefix.
+ *
+ *  If the netlink subscription cannot be set up or netlink messages
+ *  have been lost, the complete cache is flushed and lookups are not
+ *  cached.
+ *
+ *  This is used from the main loop thread only.
+ */
+class NetCfgRouteCache
+{
+  public:
+    using Ptr = std::shared_ptr<NetCfgRouteCache>;
+
+    /**
+     *  Function doing the real lookup of the best device to reach
+     *  a remote host.  This is called on cache misses.
+     *
+     *  @param remote   std::string with the IP address of the remote host
+     *  @param ipv6     bool, true if remote is an IPv6 address
+     *  @return std::string with the network device name
+     */
+    using LookupFunc = std::function<std::string(const std::string &remote, bool ipv6)>;
+
+    struct Statistics
+    {
+        uint64_t entries = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t invalidated = 0;
+    };
+
+    /**
+     *  Create a new route cache
+     *
+     * @param lookup     LookupFunc used on cache misses
+     * @param subscribe  bool, if true (default) subscribe to route changes
+     *                   via netlink.  If false, the caller is responsible
+     *                   for invalidating entries via InvalidatePrefix()
+     * @return NetCfgRouteCache::Ptr
+     */
+    [[nodiscard]] static NetCfgRouteCache::Ptr Create(LookupFunc lookup,
+                                                      bool subscribe = true);
+    ~NetCfgRouteCache() noexcept;
+
+    /**
+     *  Retrieve the network device to use to reach a remote host
+     *
+     * @param remote   std::string with the IP address of the remote host
+     * @param ipv6     bool, true if remote is an IPv6 address
+     * @return std::string with the network device name
+     *
+     * @throws Exceptions from the LookupFunc are passed on to the caller
+     */
+    std::string GetBestDevice(const std::string &remote, bool ipv6);
+
+    /**
+     *  Remove all cached entries covered by a route prefix
+     *
+     * @param family      int with the address family (AF_INET or AF_INET6)
+     * @param addr        Pointer to the network address in network byte
+     *                    order; 4 bytes for AF_INET, 16 for AF_INET6
+     * @param prefix_len  unsigned int with the prefix length of the route
+     */
+    void InvalidatePrefix(int family, const void *addr, unsigned int prefix_len);
+
+    /**
+     *  Remove all cached entries using a network device
+     *
+     * @param device  std::string with the network device name
+     */
+    void InvalidateDevice(const std::string &device);
+
+    /**
+     *  Invalidate the cached entries affected by a single route, link
+     *  or address netlink notification.  This is called for each
+     *  message received by the netlink subscription.
+     *
+     * @param nlh  Pointer to the netlink message
+     */
+    void ProcessNetlinkMessage(const struct nlmsghdr *nlh);
+
+    /**
+     *  Remove all cached entries
+     */
+    void Flush();
+
+    /**
+     *  Retrieve the cache counters
+     *
+     * @return NetCfgRouteCache::Statistics
+     */
+    Statistics GetStatistics() const;
+
+
+  private:
+    using Address = std::array<uint8_t, 16>;
+
+    struct Entry
+    {
+        int family;
+        Address addr;
+        std::string device;
+    };
+
+    LookupFunc lookup_func;
+    bool caching = true;
+    int nl_fd = -1;
+    guint nl_watch_id = 0;
+    std::map<std::pair<bool, std::string>, Entry> cache{};
+    Statistics stats{};
+
+    NetCfgRouteCache(LookupFunc lookup, bool subscribe);
+
+    void subscribe_route_changes();
+    void unsubscribe_route_changes() noexcept;
+    static gboolean cb_netlink(gint fd, GIOCondition cond, gpointer data);
+    bool process_netlink();
+};
@@ -103,6 +103,57 @@ NetCfgServiceHandler::NetCfgServiceHandler(DBus::Connection::Ptr conn_,
                       glib2::DataType::DBus<std::string>(),
                       prop_cfg_file);
 
+    auto prop_bypass_routes = [](const DBus::Object::Property::BySpec &prop) -> GVariant *
+    {
+        GVariantBuilder *b = glib2::Builder::Create("a(ssssu)");
+        for (const auto &rt : openvpn::get_bypass_routes())
+        {
+            g_variant_builder_add(b,
+                                  "(ssssu)",
+                                  rt.remote.c_str(),
+                                  (rt.ipv6 ? "inet6" : "inet"),
+                                  rt.gateway.c_str(),
+                                  rt.device.c_str(),
+                                  rt.users);
+        }
+        return glib2::Builder::Finish(b);
+    };
+    AddPropertyBySpec("bypass_routes", "a(ssssu)", prop_bypass_routes);
+
+    if (RedirectMethod::BINDTODEV == this->options.redirect_method)
+    {
+        route_cache = NetCfgRouteCache::Create(openvpn::find_best_device);
+    }
+    auto prop_route_cache = [this](const DBus::Object::Property::BySpec &prop) -> GVariant *
+    {
+        GVariantBuilder *b = glib2::Builder::Create("a{st}");
+        if (this->route_cache)
+        {
+            auto s = this->route_cache->GetStatistics();
+            g_variant_builder_add(b, "{st}", "entries", s.entries);
+            g_variant_builder_add(b, "{st}", "hits", s.hits);
+            g_variant_builder_add(b, "{st}", "misses", s.misses);
+            g_variant_builder_add(b, "{st}", "invalidated", s.invalidated);
+        }
+        return glib2::Builder::Finish(b);
+    };
+    AddPropertyBySpec("route_cache_statistics", "a{st}", prop_route_cache);
+
+#ifdef ENABLE_OVPNDCO
+    dco_engine = NetCfgDCOEngine::Create(this->options.dco_threads);
+#endif
+    auto prop_dco_engine = [this](const DBus::Object::Property::BySpec &prop) -> GVariant *
+    {
+        GVariantBuilder *b = glib2::Builder::Create("a{st}");
+#ifdef ENABLE_OVPNDCO
+        auto s = this->dco_engine->GetStatistics();
+        g_variant_builder_add(b, "{st}", "threads", s.threads);
+        g_variant_builder_add(b, "{st}", "devices", s.devices);
+#endif
+        return glib2::Builder::Finish(b);
+    };
+    AddPropertyBySpec("dco_engine_statistics", "a{st}", prop_dco_engine);
+
     AddProperty("version", version, false);
 
 
@@ -233,7 +284,8 @@ void NetCfgServiceHandler::method_create_virtual_interface(DBus::Object::Method:
         subscriptions,
         signals->GetLogLevel(),
         signals->GetLogWriter(),
-        options);
+        options,
+        dco_engine);
 
     signals->LogInfo(std::string("Virtual device '") + device_name + "'"
                      + " registered on " + dev_path
@@ -315,11 +367,10 @@ void NetCfgServiceHandler::method_protect_socket(DBus::Object::Method::Arguments
         {
             throw NetCfgException("bind to dev method requested but protect_socket call received no fd");
         }
-        openvpn::protect_socket_binddev(fd, remote, ipv6);
+        openvpn::protect_socket_binddev(fd, remote, ipv6, route_cache);
     }
     if (options.redirect_method == RedirectMethod::HOST_ROUTE)
     {
-        openvpn::cleanup_protected_sockets(creator_pid, signals);
         openvpn::protect_socket_hostroute(tunif, remote, ipv6, creator_pid);
     }
     if (fd >= 0)
@@ -27,11 +27,15 @@
 
 #include "log/logwriter.hpp"
 #include "dns/settings-manager.hpp"
+#include "netcfg-routecache.hpp"
 #include "netcfg-signals.hpp"
 #include "netcfg-subscriptions.hpp"
 #include "netcfg-options.hpp"
 
 
+class NetCfgDCOEngine;
+
+
 using namespace NetCfg;
 
 class NetCfgDevice;
@@ -89,6 +93,8 @@ class NetCfgServiceHandler : public DBus::Object::Base
     std::string version{package_version};
     NetCfgOptions options;
     NetCfgSubscriptions::Ptr subscriptions = nullptr;
+    NetCfgRouteCache::Ptr route_cache = nullptr;
+    std::shared_ptr<NetCfgDCOEngine> dco_engine = nullptr;
 
     /**
      *  D-Bus method - CreateVirtualInterface(s device_name)
@@ -353,6 +353,29 @@ int main(int argc, char **argv)
                         "MARK",
                         true,
                         "Set the specified so mark on all VPN sockets.");
+    argparser.AddOption("qdisc",
+                        "SPEC",
+                        true,
+                        "Default queueing discipline for new devices, "
+                        "as KIND[:PARAM=VALUE,...]");
+    argparser.AddOption("txqueuelen",
+                        "LEN",
+                        true,
+                        "Default transmit queue length for new devices");
+    argparser.AddOption("tun-offload",
+                        0,
+                        "Allow VPN clients to request tun devices with "
+                        "segmentation and checksum offloading");
+    argparser.AddOption("dco-threads",
+                        "NUM",
+                        true,
+                        "Number of threads handling the DCO devices "
+                        "(Default: one per CPU core, up to 4)");
+    argparser.AddOption("reconnect-grace",
+                        "SECONDS",
+                        true,
+                        "Seconds a device is kept while a VPN client "
+                        "reconnects, 0 disables reusing devices (Default: 30)");
     argparser.AddOption("state-dir",
                         0,
                         "DIRECTORY",
@@ -237,6 +237,20 @@ void Device::Disable()
 }
 
 
+bool Device::PrepareReconnect()
+{
+    GVariant *res = proxy->Call(prxtgt, "PrepareReconnect");
+    if (!res)
+    {
+        return false;
+    }
+    glib2::Utils::checkParams(__func__, res, "(b)", 1);
+    bool ret = glib2::Value::Extract<bool>(res, 0);
+    g_variant_unref(res);
+    return ret;
+}
+
+
 void Device::Destroy()
 {
     GVariant *res = proxy->Call(prxtgt, "Destroy");
@@ -271,6 +285,24 @@ void Device::SetMtu(const uint16_t mtu)
 }
 
 
+void Device::SetQdisc(const std::string &qdisc)
+{
+    proxy->SetProperty(prxtgt, "qdisc", qdisc);
+}
+
+
+void Device::SetTxQueueLen(const uint16_t qlen)
+{
+    proxy->SetProperty(prxtgt, "txqueuelen", qlen);
+}
+
+
+GVariant *Device::GetEstablishTimeline() const
+{
+    return proxy->GetPropertyGVariant(prxtgt, "establish_timeline");
+}
+
+
 uid_t Device::GetOwner()
 {
     return proxy->GetProperty<uid_t>(prxtgt, "owner");
@@ -410,10 +442,8 @@ void DCO::NewPeer(unsigned int peer_id,
 }
 
 
-void DCO::NewKey(unsigned int key_slot, const KoRekey::KeyConfig *kc_arg)
+static void fill_key_config(const KoRekey::KeyConfig *kc_arg, DcoKeyConfig &kc)
 {
-    DcoKeyConfig kc;
-
     kc.set_key_id(kc_arg->key_id);
     kc.set_remote_peer_id(kc_arg->remote_peer_id);
     kc.set_cipher_alg(kc_arg->cipher_alg);
@@ -427,6 +457,13 @@ void DCO::NewKey(unsigned int key_slot, const KoRekey::KeyConfig *kc_arg)
 
     copyKeyDirection(kc_arg->encrypt, kc.mutable_encrypt());
     copyKeyDirection(kc_arg->decrypt, kc.mutable_decrypt());
+}
+
+
+void DCO::NewKey(unsigned int key_slot, const KoRekey::KeyConfig *kc_arg)
+{
+    DcoKeyConfig kc;
+    fill_key_config(kc_arg, kc);
 
     auto str = base64->encode(kc.SerializeAsString());
 
@@ -461,5 +498,74 @@ void DCO::SetPeer(unsigned int peer_id, int keepalive_interval, int keepalive_ti
         g_variant_unref(res);
     }
 }
+
+
+bool DCO::KeyUpdate::Merge(const KeyUpdate &upd)
+{
+    // Order of the changes: 1 = key, 2 = swap, 3 = keepalive
+    const int last = (set_keepalive ? 3 : (swap_keys ? 2 : (!key_config.empty() ? 1 : 0)));
+    const int first = (!upd.key_config.empty() ? 1 : (upd.swap_keys ? 2 : (upd.set_keepalive ? 3 : 4)));
+    if (peer_id != upd.peer_id || first <= last)
+    {
+        return false;
+    }
+
+    if (!upd.key_config.empty())
+    {
+        key_config = upd.key_config;
+        key_slot = upd.key_slot;
+    }
+    swap_keys |= upd.swap_keys;
+    if (upd.set_keepalive)
+    {
+        set_keepalive = true;
+        keepalive_interval = upd.keepalive_interval;
+        keepalive_timeout = upd.keepalive_timeout;
+    }
+    return true;
+}
+
+
+std::string DCO::EncodeKeyConfig(const KoRekey::KeyConfig *kc)
+{
+    DcoKeyConfig msg;
+    fill_key_config(kc, msg);
+    return msg.SerializeAsString();
+}
+
+
+void DCO::UpdateKeys(const KeyUpdate &upd)
+{
+    DcoKeyUpdate msg;
+    msg.set_peer_id(upd.peer_id);
+    if (!upd.key_config.empty())
+    {
+        msg.set_key_slot(upd.key_slot);
+        if (!msg.mutable_key_config()->ParseFromString(upd.key_config))
+        {
+            throw NetCfgProxyException(__func__, "Invalid key configuration");
+        }
+    }
+    msg.set_swap_keys(upd.swap_keys);
+    if (upd.set_keepalive)
+    {
+        msg.set_keepalive_interval(upd.keepalive_interval);
+        msg.set_keepalive_timeout(upd.keepalive_timeout);
+    }
+
+    // The key material is passed as-is, without base64 encoding it
+    const std::string payload = msg.SerializeAsString();
+    GVariant *res = proxy->Call(dcotgt,
+                                "UpdateKeys",
+                                g_variant_new("(@ay)",
+                                              g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+                                                                        payload.data(),
+                                                                        payload.size(),
+                                                                        sizeof(uint8_t))));
+    if (res)
+    {
+        g_variant_unref(res);
+    }
+}
 #endif // ENABLE_OVPNDCO
 } // namespace NetCfgProxy
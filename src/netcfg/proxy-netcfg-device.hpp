@@ -102,6 +102,66 @@ class DCO
      */
     void SetPeer(unsigned int peer_id, int keepalive_interval, int keepalive_timeout);
 
+
+    /**
+     *  Changes to the keys and settings of a peer, to be applied
+     *  in a single step by UpdateKeys().  The changes are applied in
+     *  the order of the members: the new key is installed, the keys
+     *  are swapped and the keepalive settings are updated.
+     */
+    struct KeyUpdate
+    {
+        /** ID of the peer to swap keys for and to set keepalive for */
+        unsigned int peer_id = 0;
+
+        /**
+         *  New key to install, as a serialized DcoKeyConfig from
+         *  EncodeKeyConfig().  Empty if no key is installed.
+         */
+        std::string key_config{};
+        unsigned int key_slot = 0;
+
+        /** Swap the primary and secondary keys after installing the key */
+        bool swap_keys = false;
+
+        /** Update the keepalive settings of the peer */
+        bool set_keepalive = false;
+        int keepalive_interval = 0;
+        int keepalive_timeout = 0;
+
+        /**
+         *  Add the changes of another KeyUpdate to this one, if the
+         *  result is applied in the same order as sending them one by
+         *  one.  That is the case when both are for the same peer and
+         *  all the changes in upd come after the changes in this one.
+         *
+         * @param upd  KeyUpdate with the changes to add
+         * @return true if the changes were added, otherwise false and
+         *         this KeyUpdate is unchanged
+         */
+        bool Merge(const KeyUpdate &upd);
+    };
+
+    /**
+     *  Copy a key for a KeyUpdate.  The KeyConfig from the Core library
+     *  only points at the key material, which is not kept once the
+     *  tun builder hook has returned.
+     *
+     * @param kc  KeyConfig with the key
+     * @return std::string with the serialized DcoKeyConfig
+     */
+    static std::string EncodeKeyConfig(const openvpn::KoRekey::KeyConfig *kc);
+
+    /**
+     *  Install a new key, swap the keys and/or update the keepalive
+     *  settings of a peer.  All the changes set in the KeyUpdate are
+     *  sent in a single D-Bus call and the netcfg service applies them
+     *  in one go in the GeNL thread.
+     *
+     * @param upd  KeyUpdate with the changes to apply
+     */
+    void UpdateKeys(const KeyUpdate &upd);
+
   private:
     DBus::Proxy::Client::Ptr proxy = nullptr;
     DBus::Proxy::TargetPreset::Ptr dcotgt = nullptr;
@@ -260,6 +320,22 @@ class Device
     void Disable();
 
 
+    /**
+     *  Keeps the established virtual device, its routes and DNS settings
+     *  while the VPN client reconnects.  The configuration is then added
+     *  again as usual.  The following Establish() call compares it with
+     *  the active configuration and reuses the device if nothing changed,
+     *  or applies only the route and DNS changes when possible.
+     *
+     *  If Establish() is not called within the grace period configured
+     *  in the netcfg service, the device is disabled.
+     *
+     *  @return true if the device is kept.  If false, the device has been
+     *          disabled, like by Disable()
+     */
+    bool PrepareReconnect();
+
+
     /**
      *   Destroys and completely removes this virtual network interface.
      */
@@ -283,6 +359,32 @@ class Device
     void SetLayer(unsigned int layer);
 
 
+    /**
+     * Set the root queueing discipline to use on the device
+     *
+     * @param qdisc  std::string with the qdisc, as KIND[:PARAM=VALUE,...]
+     */
+    void SetQdisc(const std::string &qdisc);
+
+
+    /**
+     * Set the transmit queue length of the device
+     *
+     * @param qlen  uint16_t with the queue length.  If 0, the netcfg
+     *              service default is used
+     */
+    void SetTxQueueLen(const uint16_t qlen);
+
+
+    /**
+     * Retrieve the time spent in each phase of the last Establish() call
+     *
+     * @return GVariant object with the 'a(sstt)' data type, to be parsed
+     *         by ConnectTimeline.  The caller must unref this object.
+     */
+    GVariant *GetEstablishTimeline() const;
+
+
     /**
      * Set to have a default route installed and reroute the gw to avoid routing loops
      *
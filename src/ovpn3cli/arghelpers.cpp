@@ -14,16 +14,82 @@
  *
  */
 
+#include <fstream>
+#include <iostream>
 #include <string>
 #include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
 #include <gdbuspp/connection.hpp>
 
 #include "dbus/constants.hpp"
 #include "configmgr/proxy-configmgr.hpp"
 #include "common/cmdargparser.hpp"
+#include "common/utils.hpp"
 #include "sessionmgr/proxy-sessionmgr.hpp"
 #include "arghelpers.hpp"
 
+DBus::Connection::Ptr get_system_connection()
+{
+    static DBus::Connection::Ptr conn = nullptr;
+    if (!conn)
+    {
+        conn = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    }
+    return conn;
+}
+
+
+namespace {
+bool batch_mode = false;
+std::ifstream batch_tty;
+int batch_tty_fd = -1;
+} // namespace
+
+
+void set_batch_mode(const bool enable)
+{
+    batch_mode = enable;
+}
+
+
+std::istream &get_user_input(const std::string &cmd)
+{
+    if (!batch_mode)
+    {
+        return std::cin;
+    }
+
+    // In batch mode, stdin provides the commands; reading user input
+    // from it would consume the following commands
+    if (!batch_tty.is_open())
+    {
+        batch_tty_fd = open("/dev/tty", O_RDWR | O_CLOEXEC);
+        if (batch_tty_fd >= 0)
+        {
+            batch_tty.open("/dev/tty");
+        }
+    }
+    if (!batch_tty.is_open())
+    {
+        throw CommandException(cmd,
+                               "User input is required, but no terminal "
+                               "is available in batch mode");
+    }
+    return batch_tty;
+}
+
+
+void set_user_input_echo(const bool echo)
+{
+    int fd = (batch_mode ? batch_tty_fd : STDIN_FILENO);
+    if (fd >= 0)
+    {
+        set_console_echo(echo, fd);
+    }
+}
+
+
 /**
  * Retrieves a list of available configuration paths
  *
@@ -31,7 +97,7 @@
  */
 std::string arghelper_config_paths()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     OpenVPN3ConfigurationProxy confmgr(dbuscon,
                                        Constants::GenPath("configuration"));
 
@@ -84,7 +150,7 @@ std::string arghelper_config_names_dbus(DBus::Connection::Ptr dbuscon)
 
 std::string arghelper_config_names()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     return arghelper_config_names_dbus(dbuscon);
 }
 
@@ -96,7 +162,7 @@ std::string arghelper_config_names()
  */
 std::string arghelper_session_paths()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
     std::stringstream res;
@@ -114,7 +180,7 @@ std::string arghelper_session_paths()
 
 std::string arghelper_managed_interfaces()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
     std::stringstream res;
@@ -165,7 +231,7 @@ std::string arghelper_config_names_sessions_dbus(DBus::Connection::Ptr dbuscon)
 
 std::string arghelper_config_names_sessions()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     return arghelper_config_names_sessions_dbus(dbuscon);
 }
 
@@ -249,7 +315,7 @@ DBus::Object::Path retrieve_config_path(const std::string &cmd,
 {
     auto conn = (dbusconn
                      ? dbusconn
-                     : DBus::Connection::Create(DBus::BusType::SYSTEM));
+                     : get_system_connection());
     OpenVPN3ConfigurationProxy cfgmgr(conn,
                                       Constants::GenPath("configuration"));
 
@@ -19,6 +19,7 @@
 #include <gdbuspp/connection.hpp>
 #include <gdbuspp/object/path.hpp>
 
+#include <istream>
 #include <string>
 
 
@@ -110,6 +111,47 @@ std::string arghelper_boolean();
  */
 std::string arghelper_log_levels();
 
+/**
+ *  Retrieve the D-Bus system bus connection used by the commands.  The
+ *  connection is created on the first call and reused by all the
+ *  commands run by the same process, such as in the --batch mode.
+ *
+ * @return DBus::Connection::Ptr
+ */
+DBus::Connection::Ptr get_system_connection();
+
+
+/**
+ *  Enable the batch mode, where stdin provides the commands to run.
+ *  User input, such as confirmations and credentials, is then read
+ *  from the controlling terminal instead of stdin.
+ *
+ * @param enable  bool, true enables the batch mode
+ */
+void set_batch_mode(const bool enable);
+
+/**
+ *  Retrieve the input stream to read user input from.  This is std::cin,
+ *  unless the batch mode is enabled.
+ *
+ * @param cmd  std::string with the command requesting user input,
+ *             used in error messages
+ * @return std::istream&
+ *
+ * @throws CommandException if the batch mode is enabled and there is no
+ *         controlling terminal to read the user input from
+ */
+std::istream &get_user_input(const std::string &cmd);
+
+/**
+ *  Enables or disables the echo of the user input, used when reading
+ *  passwords.  This applies to the terminal used by get_user_input().
+ *
+ * @param echo  bool, true enables the echo
+ */
+void set_user_input_echo(const bool echo);
+
+
 DBus::Object::Path retrieve_config_path(const std::string &cmd,
                                         const std::string &config_name,
                                         DBus::Connection::Ptr dbusconn = nullptr);
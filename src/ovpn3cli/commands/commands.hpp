@@ -16,10 +16,23 @@
 #pragma once
 
 #include <functional>
+#include <string>
 
 #include "common/cmdargparser.hpp"
 
-using PrepareCommand = std::function<SingleCommand::Ptr()>;
+using PrepareCommand = Commands::PrepareCommand;
+
+/**
+ *  Describes a command for the registered_commands list of a program.
+ *  The command name and alias must match the SingleCommand object
+ *  returned by the prepare function, which is only called when needed.
+ */
+struct RegisteredCommand
+{
+    std::string command;
+    PrepareCommand prepare;
+    std::string alias{};
+};
 
 // Command provided in version.cpp
 SingleCommand::Ptr prepare_command_version();
@@ -57,6 +70,7 @@ SingleCommand::Ptr prepare_command_session_manage();
 SingleCommand::Ptr prepare_command_session_auth();
 SingleCommand::Ptr prepare_command_session_acl();
 SingleCommand::Ptr prepare_command_session_stats();
+SingleCommand::Ptr prepare_command_session_trace();
 SingleCommand::Ptr prepare_command_sessions_list();
 
 // Commands provided in netcfg-service.cpp
@@ -70,7 +70,7 @@ static int cmd_config_acl(ParsedArgs::Ptr args)
     OpenVPN3ConfigurationProxy::Ptr conf = nullptr;
     try
     {
-        dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        dbuscon = get_system_connection();
         std::string path = (args->Present("config")
                                 ? retrieve_config_path("config-acl",
                                                        args->GetValue("config", 0),
@@ -202,7 +202,7 @@ static int cmd_config_acl(ParsedArgs::Ptr args)
                       << "(enter yes in upper case) ";
 
             std::string response;
-            std::cin >> response;
+            get_user_input("config-acl") >> response;
             if ("YES" == response)
             {
                 conf->Seal();
@@ -50,7 +50,7 @@ static int cmd_config_dump(ParsedArgs::Ptr args)
     OpenVPN3ConfigurationProxy::Ptr conf = nullptr;
     try
     {
-        dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        dbuscon = get_system_connection();
         std::string path = (args->Present("config")
                                 ? retrieve_config_path("config-dump",
                                                        args->GetValue("config", 0),
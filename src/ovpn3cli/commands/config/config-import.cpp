@@ -177,7 +177,7 @@ static int cmd_config_import(ParsedArgs::Ptr args)
         };
         std::string name = (args->Present("name") ? args->GetValue("name", 0)
                                                   : args->GetValue("config", 0));
-        auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        auto dbuscon = get_system_connection();
         std::string path = import_config(dbuscon,
                                          args->GetValue("config", 0),
                                          name,
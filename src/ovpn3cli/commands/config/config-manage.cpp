@@ -293,7 +293,7 @@ static int cmd_config_manage(ParsedArgs::Ptr args)
                                                 "(--path, --config)");
     }
 
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
 
     std::string path = (args->Present("config")
                             ? retrieve_config_path("config-manage",
@@ -49,7 +49,7 @@ static int cmd_config_remove(ParsedArgs::Ptr args)
     OpenVPN3ConfigurationProxy::Ptr conf = nullptr;
     try
     {
-        dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        dbuscon = get_system_connection();
         std::string path = (args->Present("config")
                                 ? retrieve_config_path("config-remove",
                                                        args->GetValue("config", 0),
@@ -65,7 +65,7 @@ static int cmd_config_remove(ParsedArgs::Ptr args)
             std::cout << "Are you sure you want to do this? "
                       << "(enter yes in upper case) ";
 
-            std::cin >> response;
+            get_user_input("config-remove") >> response;
         }
 
 
@@ -39,7 +39,7 @@
  */
 static int cmd_configs_list(ParsedArgs::Ptr args)
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     OpenVPN3ConfigurationProxy confmgr(dbuscon,
                                        Constants::GenPath("configuration"));
 
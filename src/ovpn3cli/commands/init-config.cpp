@@ -206,6 +206,7 @@ void configure_logger(const setup_config &setupcfg, DBus::Connection::Ptr dbusco
                              {"journald",
                               "syslog",
                               "syslog-facility",
+                              "syslog-rfc5424",
                               "log-file",
                               "timestamp",
                               "no-logtag-prefix",
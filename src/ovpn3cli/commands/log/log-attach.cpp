@@ -12,7 +12,10 @@
  * @brief  Helper class to prepare setting up the EventLogger object
  */
 
+#include <gdbuspp/glib2/utils.hpp>
+
 #include "common/cmdargparser-exceptions.hpp"
+#include "dbus/constants.hpp"
 #include "log-attach.hpp"
 
 
@@ -43,6 +46,17 @@ LogAttach::LogAttach(DBus::MainLoop::Ptr main_loop,
                                  SessionManager::Event smgrev(event->params);
                                  sessionmgr_event(smgrev);
                              });
+
+    // Used to detect if the backend VPN client process disappears
+    busowner_tgt = DBus::Signals::Target::Create("org.freedesktop.DBus",
+                                                 "/org/freedesktop/DBus",
+                                                 "org.freedesktop.DBus");
+    signal_subscr->Subscribe(busowner_tgt,
+                             "NameOwnerChanged",
+                             [&](DBus::Signals::Event::Ptr &event)
+                             {
+                                 name_owner_changed(event);
+                             });
 }
 
 
@@ -53,7 +67,6 @@ LogAttach::~LogAttach() noexcept
         try
         {
             session_proxy->LogForward(false);
-            usleep(500000);
         }
         catch (const DBus::Exception &)
         {
@@ -74,7 +87,7 @@ void LogAttach::AttachByPath(const DBus::Object::Path &path)
 void LogAttach::AttachByConfig(const std::string &config)
 {
     config_name = config;
-    lookup_config_name(config_name, 1);
+    lookup_config_name(config_name);
     setup_session_logger(session_path);
 }
 
@@ -105,16 +118,11 @@ void LogAttach::sessionmgr_event(const SessionManager::Event &event)
             // ignore new sessions
             return;
         }
-        if (!config_name.empty())
-        {
-            lookup_config_name(config_name);
-        }
-        else if (!tun_interf.empty())
+        if (match_new_session(event.path))
         {
-            lookup_interface(tun_interf);
+            session_path = event.path;
+            setup_session_logger(session_path);
         }
-
-        setup_session_logger(session_path);
         break;
 
     case SessionManager::EventType::SESS_DESTROYED:
@@ -123,8 +131,7 @@ void LogAttach::sessionmgr_event(const SessionManager::Event &event)
             // This event is not related to us, ignore it
             return;
         }
-        std::cout << "Session closed" << std::endl;
-        mainloop->Stop();
+        close_session();
         break;
 
     case SessionManager::EventType::UNSET:
@@ -135,45 +142,93 @@ void LogAttach::sessionmgr_event(const SessionManager::Event &event)
 }
 
 
-void LogAttach::lookup_config_name(const std::string &cfgname,
-                                   const uint16_t check_count)
+void LogAttach::name_owner_changed(DBus::Signals::Event::Ptr event)
 {
-    // We need to try a few times, as the SESS_CREATED event comes
-    // quite early and the session object itself might not be registered
-    // quite yet.  This needs to be a tight loop to catch the earliest
-    // log messages, as certificate only based authentication may do
-    // the full connection establishing in a little bit less than 200ms.
-    for (unsigned int i = check_count; i > 0; i--)
+    if (backend_busname.empty())
+    {
+        return;
+    }
+
+    try
     {
-        DBus::Object::Path::List paths = manager->LookupConfigName(cfgname);
-        if (1 < paths.size())
+        glib2::Utils::checkParams(__func__, event->params, "(sss)", 3);
+        auto name = glib2::Value::Extract<std::string>(event->params, 0);
+        auto new_owner = glib2::Value::Extract<std::string>(event->params, 2);
+        if (name == backend_busname && new_owner.empty())
         {
-            throw CommandException("log",
-                                   "More than one session with the given "
-                                   "configuration profile name was found.");
+            close_session();
         }
-        else if (1 == paths.size())
+    }
+    catch (const DBus::Exception &)
+    {
+        // Ignore malformed signals
+    }
+}
+
+
+bool LogAttach::match_new_session(const DBus::Object::Path &path)
+{
+    // The SESS_CREATED event is sent after the session has been
+    // fully registered, so the session object can be queried directly.
+    // Sessions not accessible to the current user will fail the
+    // property lookup and is not a match.
+    try
+    {
+        auto prx = manager->Retrieve(path);
+        if (!config_name.empty())
         {
-            // If only a single path is found, that's the one we're
-            // looking for.
-            session_path = paths.at(0);
-            return;
+            return prx->GetConfigName() == config_name;
         }
-        else
+        else if (!tun_interf.empty())
         {
-            // If no paths has been found, we wait until next call
-            if (!wait_notification)
-            {
-                std::cout << "Waiting for session to start ..."
-                          << std::flush;
-                wait_notification = true;
-            }
+            return prx->GetDeviceName() == tun_interf;
         }
-        usleep(50000); // 50ms
+    }
+    catch (const DBus::Exception &)
+    {
+    }
+    return false;
+}
+
+
+void LogAttach::lookup_config_name(const std::string &cfgname)
+{
+    DBus::Object::Path::List paths = manager->LookupConfigName(cfgname);
+    if (1 < paths.size())
+    {
+        throw CommandException("log",
+                               "More than one session with the given "
+                               "configuration profile name was found.");
+    }
+    else if (1 == paths.size())
+    {
+        // If only a single path is found, that's the one we're
+        // looking for.
+        session_path = paths.at(0);
+    }
+    else if (!wait_notification)
+    {
+        // If no paths has been found, the SESS_CREATED event will
+        // trigger the log attach when the session is started
+        std::cout << "Waiting for session to start ..." << std::flush;
+        wait_notification = true;
     }
 }
 
 
+void LogAttach::close_session()
+{
+    if (session_closed)
+    {
+        return;
+    }
+    session_closed = true;
+    session_proxy.reset();
+    std::cout << "Session closed" << std::endl;
+    mainloop->Stop();
+}
+
+
 void LogAttach::lookup_interface(const std::string &interf)
 {
     // This method does not have any retry logic as @lookup_config_name()
@@ -249,11 +304,25 @@ void LogAttach::setup_session_logger(const DBus::Object::Path &path)
         }
     }
 
-    // Setup the EventLogger object for the provided session path
+    // Watch the backend VPN client process, to catch if it disappears
+    // without the session manager sending the SESS_DESTROYED event
+    try
+    {
+        backend_busname = Constants::GenServiceName("backends.be")
+                          + std::to_string(session_proxy->GetBackendPid());
+    }
+    catch (const DBus::Exception &)
+    {
+        backend_busname.clear();
+    }
+
+    // Setup the EventLogger object for the provided session path.  The
+    // EventLogger subscribes to the signals before the log forwarding is
+    // enabled, to not lose the first log events.
     try
     {
-        session_proxy->LogForward(true);
         eventlogger = EventLogger::Create(mainloop, dbuscon, path);
+        session_proxy->LogForward(true);
     }
     catch (const SessionManager::Proxy::Exception &excp)
     {
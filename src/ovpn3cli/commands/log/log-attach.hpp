@@ -32,7 +32,11 @@ namespace ovpn3cli::log {
  *  configuration profile name.  Once the session is found, the SessionLogger
  *  class takes over the log event handling itself.  The LogAttach object
  *  will also stop the logging once the session manager signals the session
- *  has been destroyed.
+ *  has been destroyed or the backend VPN client process disappears from
+ *  the bus.
+ *
+ *  All of this is driven by D-Bus signals processed in the main loop;
+ *  there is no polling involved.
  *
  */
 class LogAttach
@@ -57,14 +61,17 @@ class LogAttach
     DBus::MainLoop::Ptr mainloop = nullptr;
     DBus::Connection::Ptr dbuscon = nullptr;
     DBus::Signals::SubscriptionManager::Ptr signal_subscr = nullptr;
+    DBus::Signals::Target::Ptr busowner_tgt = nullptr;
     SessionManager::Proxy::Manager::Ptr manager = nullptr;
     SessionManager::Proxy::Session::Ptr session_proxy = nullptr;
     EventLogger::Ptr eventlogger = nullptr;
     DBus::Object::Path session_path{};
     std::string config_name{};
     std::string tun_interf{};
+    std::string backend_busname{};
     uint32_t log_level = 0;
     bool wait_notification = false;
+    bool session_closed = false;
 
 
     LogAttach(DBus::MainLoop::Ptr main_loop,
@@ -72,11 +79,35 @@ class LogAttach
 
     void sessionmgr_event(const SessionManager::Event &event);
 
-    void lookup_config_name(const std::string &cfgname,
-                            const uint16_t check_count = 250);
+    /**
+     *  Callback for the org.freedesktop.DBus.NameOwnerChanged signal.
+     *  This is used to detect if the backend VPN client process of the
+     *  attached session disappears.
+     *
+     * @param event  DBus::Signals::Event::Ptr with the signal details
+     */
+    void name_owner_changed(DBus::Signals::Event::Ptr event);
+
+    /**
+     *  Checks if a newly created session matches the configuration
+     *  profile name or interface name this log attach is waiting for
+     *
+     * @param path   DBus::Object::Path of the new session
+     * @return true if the session matches, otherwise false
+     */
+    bool match_new_session(const DBus::Object::Path &path);
+
+    void lookup_config_name(const std::string &cfgname);
 
     void lookup_interface(const std::string &interf);
 
+    /**
+     *  Stops the main loop once the attached session has been closed.
+     *  This can be triggered by several signals, but will only stop
+     *  the main loop once.
+     */
+    void close_session();
+
 
     /**
      *  Create a new EventLogger object for processing log and status event
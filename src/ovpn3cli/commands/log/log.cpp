@@ -45,7 +45,7 @@ static int cmd_log(ParsedArgs::Ptr args)
 
     // Prepare the main loop which will listen for Log events and process them
     auto mainloop = DBus::MainLoop::Create();
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto logattach = LogAttach::Create(mainloop, dbuscon);
 
     if (args->Present("log-level"))
@@ -75,7 +75,7 @@ static int cmd_log(ParsedArgs::Ptr args)
 
 std::string arghelper_log_config_names()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     return arghelper_config_names_dbus(dbuscon)
            + arghelper_config_names_sessions_dbus(dbuscon);
 }
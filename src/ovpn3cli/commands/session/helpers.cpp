@@ -16,6 +16,7 @@
 #include <csignal>
 
 #include "common/open-uri.hpp"
+#include "../../arghelpers.hpp"
 #include "helpers.hpp"
 
 
@@ -93,66 +94,69 @@ bool query_user_input(SessionManager::Proxy::Session::Ptr session,
 {
     try
     {
-        for (auto &type_group : session->QueueCheckTypeGroup())
+        bool credentials = false;
+        for (auto &r : session->FetchAll())
         {
-            ClientAttentionType type;
-            ClientAttentionGroup group;
-            std::tie(type, group) = type_group;
+            if (ClientAttentionType::CREDENTIALS != r.type)
+            {
+                continue;
+            }
+            if (sigact && !credentials)
+            {
+                sigaction(SIGINT, sigact, NULL);
+            }
+            credentials = true;
 
-            if (ClientAttentionType::CREDENTIALS == type)
+            bool done = false;
+            if (ExitReason::NONE != exit_reason)
             {
-                if (sigact)
-                {
-                    sigaction(SIGINT, sigact, NULL);
-                }
-                std::vector<struct RequiresSlot> reqslots;
-                session->QueueFetchAll(reqslots, type, group);
-                for (auto &r : reqslots)
+                break;
+            }
+            while (!done && ExitReason::NONE == exit_reason)
+            {
+                try
                 {
-                    bool done = false;
-                    if (ExitReason::NONE != exit_reason)
+                    std::istream &input = get_user_input("session");
+                    std::cout << r.user_description << ": ";
+                    if (r.hidden_input)
                     {
-                        break;
+                        set_user_input_echo(false);
                     }
-                    while (!done && ExitReason::NONE == exit_reason)
+                    std::getline(input, r.value);
+                    if (r.hidden_input)
                     {
-                        try
-                        {
-                            std::cout << r.user_description << ": ";
-                            if (r.hidden_input)
-                            {
-                                set_console_echo(false);
-                            }
-                            std::getline(std::cin, r.value);
-                            if (r.hidden_input)
-                            {
-                                std::cout << std::endl;
-                                set_console_echo(true);
-                            }
-                            if (exit_reason == ExitReason::NONE)
-                            {
-                                session->ProvideResponse(r);
-                            }
-                            done = true;
-                        }
-                        catch (const DBus::Exception &excp)
+                        std::cout << std::endl;
+                        set_user_input_echo(true);
+                    }
+                    if (exit_reason == ExitReason::NONE)
+                    {
+                        session->ProvideResponse(r);
+                    }
+                    done = true;
+                }
+                catch (const CommandException &excp)
+                {
+                    // No terminal to read the user input from
+                    std::cerr << "** ERROR **   " << excp.what() << std::endl;
+                    done = true;
+                    exit_reason = ExitReason::ERROR;
+                }
+                catch (const DBus::Exception &excp)
+                {
+                    std::string err(excp.GetRawError());
+                    if (err.find("No value provided for") != std::string::npos)
+                    {
+                        if (ExitReason::CTRL_C != exit_reason)
                         {
-                            std::string err(excp.GetRawError());
-                            if (err.find("No value provided for") != std::string::npos)
-                            {
-                                if (ExitReason::CTRL_C != exit_reason)
-                                {
-                                    std::cerr << "** ERROR **   "
-                                              << "Empty input not allowed" << std::endl;
-                                }
-                                done = true;
-                            }
-                            else
-                            {
-                                done = true;
-                                exit_reason = ExitReason::ERROR;
-                            }
+                            std::cerr << "** ERROR **   "
+                                      << "Empty input not allowed" << std::endl;
                         }
+                        done = true;
+                    }
+                    else
+                    {
+                        done = true;
+                        exit_reason = ExitReason::ERROR;
                     }
                 }
             }
@@ -190,6 +194,9 @@ void start_session(SessionManager::Proxy::Session::Ptr session,
                    int timeout,
                    bool background)
 {
+    // More sessions may be started by the same process in batch mode
+    exit_reason = ExitReason::NONE;
+
     // Prepare the SIGINT signal handling
     auto sact = new struct sigaction;
     sact->sa_handler = sigint_handler;
@@ -61,7 +61,7 @@ static int cmd_session_acl(ParsedArgs::Ptr args)
 
     try
     {
-        auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        auto dbuscon = get_system_connection();
         auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
         std::string sesspath = "";
@@ -35,7 +35,7 @@ using namespace ovpn3cli::session;
  */
 static std::string arghelper_auth_req()
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto smprx = SessionManager::Proxy::Manager::Create(dbuscon);
     std::ostringstream res;
 
@@ -62,7 +62,7 @@ static std::string arghelper_auth_req()
  */
 static int cmd_session_auth_complete(const pid_t authid)
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto smprx = SessionManager::Proxy::Manager::Create(dbuscon);
     SessionManager::Proxy::Session::Ptr session = nullptr;
     for (const auto &s : smprx->FetchAvailableSessions())
@@ -131,7 +131,7 @@ static int cmd_session_auth(ParsedArgs::Ptr args)
     //
     // List all running sessions requiring user authentication interaction
     //
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto smprx = SessionManager::Proxy::Manager::Create(dbuscon);
 
     // Retrieve a list of all sessions requiring user interaction
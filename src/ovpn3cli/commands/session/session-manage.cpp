@@ -109,7 +109,7 @@ static int cmd_session_manage(ParsedArgs::Ptr args)
             timeout = std::atoi(args->GetValue("timeout", 0).c_str());
         }
 
-        auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        auto dbuscon = get_system_connection();
         auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
         if (mode_cleanup == mode)
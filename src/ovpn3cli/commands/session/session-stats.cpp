@@ -66,7 +66,7 @@ static int cmd_session_stats(ParsedArgs::Ptr args)
 
     try
     {
-        auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        auto dbuscon = get_system_connection();
         auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
         DBus::Object::Path sesspath{};
@@ -0,0 +1,217 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   session-trace.cpp
+ *
+ * @brief  Show how long each phase of starting a VPN session took
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <gdbuspp/connection.hpp>
+
+#include "common/cmdargparser.hpp"
+#include "common/timeline.hpp"
+#include "sessionmgr/proxy-sessionmgr.hpp"
+#include "../../arghelpers.hpp"
+#include "helpers.hpp"
+
+using namespace ovpn3cli::session;
+
+
+/**
+ *  Formats the connect time line as a plain text table.  The start time
+ *  of each phase is relative to the first phase.
+ *
+ * @param phases  ConnectTimeline::PhaseList to format
+ * @return std::string with the formatted table
+ */
+static std::string timeline_plain(const ConnectTimeline::PhaseList &phases)
+{
+    std::ostringstream res;
+    res << std::left
+        << std::setw(12) << "Source"
+        << std::setw(24) << "Phase"
+        << std::right
+        << std::setw(12) << "Start (ms)"
+        << std::setw(16) << "Duration (ms)"
+        << std::endl
+        << std::setw(64) << std::setfill('-') << "-" << std::setfill(' ')
+        << std::endl;
+
+    if (phases.empty())
+    {
+        return res.str();
+    }
+
+    const uint64_t first = phases.front().start_usec;
+    res << std::fixed << std::setprecision(3);
+    for (const auto &p : phases)
+    {
+        res << std::left
+            << std::setw(12) << p.source
+            << std::setw(24) << p.name
+            << std::right
+            << std::setw(12) << (p.start_usec - first) / 1000.0;
+        if (p.end_usec > 0)
+        {
+            res << std::setw(16) << (p.end_usec - p.start_usec) / 1000.0;
+        }
+        else
+        {
+            res << std::setw(16) << "-";
+        }
+        res << std::endl;
+    }
+    return res.str();
+}
+
+
+/**
+ *  openvpn3 session-trace command
+ *
+ *  Shows the time spent in each phase of starting a specific VPN session,
+ *  either as a plain text table or in the Chrome trace event format
+ *
+ * @param args  ParsedArgs object containing all related options and arguments
+ * @return Returns the exit code which will be returned to the calling shell
+ */
+static int cmd_session_trace(ParsedArgs::Ptr args)
+{
+    if (!args->Present("path") && !args->Present("config")
+        && !(args->Present("interface")))
+    {
+        throw CommandException("session-trace",
+                               "Missing required session path, config "
+                               "or interface name");
+    }
+
+    auto dbuscon = get_system_connection();
+    auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
+
+    DBus::Object::Path sesspath{};
+    if (args->Present("config"))
+    {
+        auto paths = sessmgr->LookupConfigName(args->GetValue("config", 0));
+        if (0 == paths.size())
+        {
+            throw CommandException("session-trace",
+                                   "No sessions started with the "
+                                   "configuration profile name was found");
+        }
+        else if (1 < paths.size())
+        {
+            throw CommandException("session-trace",
+                                   "More than one session with the given "
+                                   "configuration profile name was found.");
+        }
+        sesspath = paths.at(0);
+    }
+    else if (args->Present("interface"))
+    {
+        try
+        {
+            sesspath = sessmgr->LookupInterface(args->GetValue("interface", 0));
+        }
+        catch (const DBus::Exception &excp)
+        {
+            throw CommandException("session-trace", excp.GetRawError());
+        }
+    }
+    else
+    {
+        sesspath = args->GetValue("path", 0);
+    }
+
+    std::string result;
+    try
+    {
+        auto session = sessmgr->Retrieve(sesspath);
+        auto phases = session->GetConnectTimeline();
+
+        // The session path identifies the trace; the session token
+        // used internally is never exposed outside the services
+        result = (args->Present("json")
+                      ? ConnectTimeline::ChromeTrace(phases, sesspath)
+                      : timeline_plain(phases));
+    }
+    catch (const DBus::Exception &excp)
+    {
+        throw CommandException("session-trace", excp.GetRawError());
+    }
+
+    if (args->Present("output"))
+    {
+        const std::string fname = args->GetValue("output", 0);
+        std::ofstream out(fname);
+        if (!out.is_open())
+        {
+            throw CommandException("session-trace",
+                                   "Could not open '" + fname + "' for writing");
+        }
+        out << result;
+        std::cout << "Session trace saved to " << fname << std::endl;
+    }
+    else
+    {
+        std::cout << result;
+    }
+    return 0;
+}
+
+
+/**
+ *  Creates the SingleCommand object for the 'session-trace' command
+ *
+ * @return  Returns a SingleCommand::Ptr object declaring the command
+ */
+SingleCommand::Ptr prepare_command_session_trace()
+{
+    //
+    //  session-trace command
+    //
+    SingleCommand::Ptr cmd;
+    cmd.reset(new SingleCommand("session-trace",
+                                "Show the time spent starting a session",
+                                cmd_session_trace));
+    auto path_opt = cmd->AddOption("path",
+                                   'o',
+                                   "SESSION-PATH",
+                                   true,
+                                   "Path to the session in the "
+                                   "session manager",
+                                   arghelper_session_paths);
+    path_opt->SetAlias("session-path");
+    cmd->AddOption("config",
+                   'c',
+                   "CONFIG-NAME",
+                   true,
+                   "Alternative to --path, where configuration profile name "
+                   "is used instead",
+                   arghelper_config_names_sessions);
+    cmd->AddOption("interface",
+                   'I',
+                   "INTERFACE",
+                   true,
+                   "Alternative to --path, where tun interface name is used "
+                   "instead",
+                   arghelper_managed_interfaces);
+    cmd->AddOption("json",
+                   'j',
+                   "Dump the time line in the Chrome trace event format");
+    cmd->AddOption("output",
+                   'O',
+                   "FILE",
+                   true,
+                   "Write the result to a file instead of the terminal");
+
+    return cmd;
+}
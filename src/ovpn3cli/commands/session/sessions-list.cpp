@@ -20,6 +20,7 @@
 #include "events/status.hpp"
 #include "configmgr/proxy-configmgr.hpp"
 #include "sessionmgr/proxy-sessionmgr.hpp"
+#include "../../arghelpers.hpp"
 
 
 /**
@@ -35,7 +36,7 @@
  */
 static int cmd_sessions_list(ParsedArgs::Ptr args)
 {
-    auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto dbuscon = get_system_connection();
     auto sessmgr = SessionManager::Proxy::Manager::Create(dbuscon);
 
     bool first = true;
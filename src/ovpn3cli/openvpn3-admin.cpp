@@ -25,17 +25,17 @@
 //
 //  openvpn3-admin command line utility
 //
-inline std::vector<PrepareCommand> registered_commands = {
-    prepare_command_version_services,
-    prepare_command_variables,
+inline std::vector<RegisteredCommand> registered_commands = {
+    {"version", prepare_command_version_services},
+    {"variables", prepare_command_variables},
 
 #ifdef HAVE_SYSTEMD
-    prepare_command_journal,
+    {"journal", prepare_command_journal},
 #endif
-    prepare_command_log_service,
-    prepare_command_netcfg_service,
-    prepare_command_sessionmgr_service,
-    prepare_command_initcfg,
+    {"log-service", prepare_command_log_service},
+    {"netcfg-service", prepare_command_netcfg_service},
+    {"sessionmgr-service", prepare_command_sessionmgr_service},
+    {"init-config", prepare_command_initcfg},
 };
 
 #include "ovpn3cli.hpp" // main() is implemented here
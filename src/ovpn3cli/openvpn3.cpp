@@ -16,24 +16,25 @@
 //
 //  openvpn3 command line utility
 //
-inline const std::vector<PrepareCommand> registered_commands = {
-    prepare_command_version,
+inline const std::vector<RegisteredCommand> registered_commands = {
+    {"version", prepare_command_version},
 
-    prepare_command_config_import,
-    prepare_command_config_manage,
-    prepare_command_config_acl,
-    prepare_command_config_dump,
-    prepare_command_config_remove,
-    prepare_command_configs_list,
+    {"config-import", prepare_command_config_import},
+    {"config-manage", prepare_command_config_manage},
+    {"config-acl", prepare_command_config_acl},
+    {"config-dump", prepare_command_config_dump, "config-show"},
+    {"config-remove", prepare_command_config_remove},
+    {"configs-list", prepare_command_configs_list},
 
-    prepare_command_session_start,
-    prepare_command_session_manage,
-    prepare_command_session_auth,
-    prepare_command_session_acl,
-    prepare_command_session_stats,
-    prepare_command_sessions_list,
+    {"session-start", prepare_command_session_start},
+    {"session-manage", prepare_command_session_manage},
+    {"session-auth", prepare_command_session_auth},
+    {"session-acl", prepare_command_session_acl},
+    {"session-stats", prepare_command_session_stats},
+    {"session-trace", prepare_command_session_trace},
+    {"sessions-list", prepare_command_sessions_list},
 
-    prepare_command_log,
+    {"log", prepare_command_log},
 };
 
 #include "ovpn3cli.hpp" // main() is implemented here
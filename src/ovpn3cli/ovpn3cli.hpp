@@ -18,22 +18,26 @@
  *         OVPN3CLI_COMMANDS_LIST to be defined in advance.
  */
 
+#include <iostream>
+#include <string>
+#include <vector>
 #include <gdbuspp/exceptions.hpp>
 #include "common/cmdargparser.hpp"
+#include "dbus/service-probe.hpp"
+#include "arghelpers.hpp"
 
 
-int main(int argc, char **argv)
+/**
+ *  Parse the command line arguments and execute the command given,
+ *  reporting errors to the user
+ *
+ * @param cmds  Commands object with the registered commands
+ * @param argc  int with the number of arguments in argv
+ * @param argv  char ** with the arguments, argv[0] is the program name
+ * @return int with the exit code of the command
+ */
+static int run_command(Commands &cmds, int argc, char **argv)
 {
-    Commands cmds(OVPN3CLI_PROGNAME,
-                  OVPN3CLI_PROGDESCR);
-
-    // Register commands
-    for (const auto &cmd : registered_commands)
-    {
-        cmds.RegisterCommand(cmd());
-    }
-
-    // Parse the command line arguments and execute the commands given
     try
     {
         return cmds.ProcessCommandLine(argc, argv);
@@ -61,3 +65,89 @@ int main(int argc, char **argv)
         return 9;
     }
 }
+
+
+#ifdef OVPN3CLI_OPENVPN3
+/**
+ *  Runs the commands read from stdin, one command with its arguments
+ *  per line.  Empty lines and lines starting with '#' are ignored.
+ *
+ *  All the commands share the same D-Bus connection and the service
+ *  probe results, which avoids the start-up cost of running the program
+ *  once per command.
+ *
+ * @param cmds  Commands object with the registered commands
+ * @param arg0  char * with the program name
+ * @return int with the exit code of the last failing command, 0 if all
+ *         the commands succeeded
+ */
+static int run_batch(Commands &cmds, char *arg0)
+{
+    int ret = 0;
+    std::string line;
+    unsigned int lineno = 0;
+    while (std::getline(std::cin, line))
+    {
+        ++lineno;
+        std::vector<std::string> args;
+        try
+        {
+            args = SplitCommandLine(line);
+        }
+        catch (const CommandArgBaseException &e)
+        {
+            std::cerr << simple_basename(arg0) << ": line " << lineno
+                      << ": ** ERROR ** " << e.what() << std::endl;
+            ret = 1;
+            continue;
+        }
+        if (args.empty() || '#' == args[0][0])
+        {
+            continue;
+        }
+
+        std::vector<char *> cmdargv = {arg0};
+        for (auto &a : args)
+        {
+            cmdargv.push_back(a.data());
+        }
+        cmdargv.push_back(nullptr);
+
+        int ec = run_command(cmds, static_cast<int>(cmdargv.size()) - 1, cmdargv.data());
+        if (0 != ec)
+        {
+            ret = ec;
+        }
+        std::cout.flush();
+    }
+    return ret;
+}
+#endif
+
+
+int main(int argc, char **argv)
+{
+    Commands cmds(OVPN3CLI_PROGNAME,
+                  OVPN3CLI_PROGDESCR);
+
+    // Register commands; these are only prepared when used
+    for (const auto &cmd : registered_commands)
+    {
+        cmds.RegisterCommand(cmd.command, cmd.prepare, cmd.alias);
+    }
+
+#ifdef OVPN3CLI_OPENVPN3
+    // The service availability and versions only needs to be checked
+    // once per process
+    ServiceProbe::EnableCache(true);
+
+    if (2 == argc && std::string("--batch") == argv[1])
+    {
+        set_batch_mode(true);
+        return run_batch(cmds, argv[0]);
+    }
+#endif
+
+    // Parse the command line arguments and execute the commands given
+    return run_command(cmds, argc, argv);
+}
@@ -552,6 +552,10 @@ class SessionManager(object):
     ##
     #  Create a new VPN session
     #
+    #  The session object is available once the backend VPN client process
+    #  has registered itself, which happens after the session manager has
+    #  returned the session path.  This waits up to 10 seconds for it.
+    #
     #  @param cfgobj      openvpn3.Configuration object to use for this new
     #                     session
     #
@@ -560,7 +564,14 @@ class SessionManager(object):
     def NewTunnel(self, cfgobj):
         self.__ping()
         path = self.__manager_intf.NewTunnel(cfgobj.GetPath())
-        return Session(self.__dbuscon, path)
+
+        attempts = 100
+        while attempts > 0:
+            if path in self.__manager_intf.FetchAvailableSessions():
+                return Session(self.__dbuscon, path)
+            time.sleep(0.1)
+            attempts -= 1
+        raise RuntimeError("The VPN client did not register the new session")
 
 
     ##
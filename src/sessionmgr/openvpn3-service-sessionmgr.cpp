@@ -9,6 +9,7 @@
 #include <gdbuspp/connection.hpp>
 #include <gdbuspp/service.hpp>
 #include <glib-unix.h>
+#include <sys/stat.h>
 
 #include "common/cmdargparser.hpp"
 #include "log/ansicolours.hpp"
@@ -79,6 +80,21 @@ static int session_manager(ParsedArgs::Ptr args)
     }
     sessmgr_srv->SetLogLevel(log_level);
 
+    if (args->Present("worker-threads"))
+    {
+        sessmgr_srv->SetWorkerThreads(std::atoi(args->GetValue("worker-threads", 0).c_str()));
+    }
+
+    if (args->Present("query-socket"))
+    {
+        sessmgr_srv->SetQuerySocket(args->GetValue("query-socket", 0));
+    }
+
+    if (args->Present("state-dir"))
+    {
+        sessmgr_srv->SetStateDirectory(args->GetValue("state-dir", 0));
+        umask(077);
+    }
 
     sessmgr_srv->Run();
 
@@ -95,6 +111,15 @@ int main(int argc, char **argv)
     argparser.AddOption("colour", 0, "Make the log lines colourful");
     argparser.AddOption("idle-exit", "MINUTES", true, "How long to wait before exiting if being idle. "
                                                       "0 disables it (Default: 3 minutes)");
+    argparser.AddOption("state-dir", 0, "DIRECTORY", true,
+                        "Directory where to keep the session journal, used to "
+                        "re-adopt running VPN sessions after a restart");
+    argparser.AddOption("worker-threads", "NUM", true,
+                        "Run at most NUM expensive D-Bus methods at the "
+                        "same time (Default: 0, no limit)");
+    argparser.AddOption("query-socket", "PATH", true,
+                        "Provide read-only session status details via a "
+                        "local UNIX socket");
     try
     {
         // This program does not require root privileges,
@@ -32,7 +32,9 @@ using XmlDocPtr = std::shared_ptr<openvpn::Xml::Document>;
 
 
 #include "dbus/requiresqueue-proxy.hpp"
+#include "dbus/service-probe.hpp"
 #include "client/statistics.hpp"
+#include "common/timeline.hpp"
 #include "common/utils.hpp"
 #include "events/status.hpp"
 #include "log/log-helpers.hpp"
@@ -348,6 +350,22 @@ class Session : public DBusRequiresQueueProxy
     }
 
 
+    /**
+     *  Retrieves the time spent in each phase of starting the VPN session,
+     *  as recorded by the session manager, the backend VPN client and the
+     *  netcfg service.
+     *
+     * @return ConnectTimeline::PhaseList ordered by the start time
+     */
+    ConnectTimeline::PhaseList GetConnectTimeline()
+    {
+        GVariant *tl = proxy->GetPropertyGVariant(target, "connect_timeline");
+        auto ret = ConnectTimeline::Parse(tl);
+        g_variant_unref(tl);
+        return ret;
+    }
+
+
     /**
      *  Manipulate the public-access flag.  When public-access is set to
      *  true, everyone have access to this session regardless of how the
@@ -562,7 +580,8 @@ class Session : public DBusRequiresQueueProxy
         : DBusRequiresQueueProxy("UserInputQueueGetTypeGroup",
                                  "UserInputQueueFetch",
                                  "UserInputQueueCheck",
-                                 "UserInputProvide"),
+                                 "UserInputProvide",
+                                 "UserInputQueueFetchAll"),
           proxy(prx)
     {
         target = DBus::Proxy::TargetPreset::Create(objpath,
@@ -625,15 +644,27 @@ class Manager
                                       "NewTunnel",
                                       glib2::Value::CreateTupleWrapped(cfgpath));
             auto session_path = glib2::Value::Extract<DBus::Object::Path>(r, 0);
-            // TODO: Listen for SessionManagerEvent::SESS_CREATED signal before
-            // returning
-            sleep(1);
-            return Session::Create(proxy, session_path);
+            g_variant_unref(r);
+
+            // The session object is created once the backend VPN client
+            // has registered itself, which happens after NewTunnel has
+            // returned.  Wait up to 10 seconds for it to appear.
+            auto prxchk = DBus::Proxy::Utils::Query::Create(proxy);
+            for (uint8_t i = 100; i > 0; i--)
+            {
+                if (prxchk->CheckObjectExists(session_path,
+                                              target->interface))
+                {
+                    return Session::Create(proxy, session_path);
+                }
+                usleep(100000);
+            }
         }
         catch (const DBus::Proxy::Exception &)
         {
             throw SessionManager::Proxy::Exception("Failed to start new tunnel");
         }
+        throw SessionManager::Proxy::Exception("The VPN client did not register the new session");
     }
 
 
@@ -760,8 +791,7 @@ class Manager
           target(DBus::Proxy::TargetPreset::Create(Constants::GenPath("sessions"),
                                                    Constants::GenInterface("sessions")))
     {
-        auto prxqry = DBus::Proxy::Utils::DBusServiceQuery::Create(conn);
-        prxqry->CheckServiceAvail(Constants::GenServiceName("sessions"));
+        ServiceProbe::CheckServiceAvail(conn, Constants::GenServiceName("sessions"));
 
         // Delay the return up to 750ms, to ensure we have a valid
         // Session Manager service object available
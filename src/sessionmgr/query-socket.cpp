@@ -0,0 +1,617 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   query-socket.cpp
+ *
+ * @brief  Implementation of the Session Manager local query socket
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <glib-unix.h>
+
+#include "sessionmgr-exceptions.hpp"
+#include "sessionmgr-session.hpp"
+#include "query-socket.hpp"
+
+
+namespace SessionManager {
+
+QuerySocket::Ptr QuerySocket::Create(const std::string &path,
+                                     DBus::Object::Manager::Ptr objmgr,
+                                     SessionManager::Log::Ptr log)
+{
+    return QuerySocket::Ptr(new QuerySocket(path, objmgr, log));
+}
+
+
+QuerySocket::QuerySocket(const std::string &path,
+                         DBus::Object::Manager::Ptr objmgr,
+                         SessionManager::Log::Ptr log_)
+    : socket_path(path), object_mgr(objmgr), log(log_)
+{
+    struct sockaddr_un addr = {};
+    if (socket_path.size() >= sizeof(addr.sun_path))
+    {
+        throw SessionManager::Exception("Query socket path is too long: "
+                                        + socket_path);
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+    {
+        throw SessionManager::Exception("Could not create query socket: "
+                                        + std::string(strerror(errno)));
+    }
+
+    // Remove a stale socket left behind by a previous instance
+    unlink(socket_path.c_str());
+
+    if (0 != bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr))
+        || 0 != chmod(socket_path.c_str(), 0666)
+        || 0 != listen(listen_fd, 16))
+    {
+        std::string err(strerror(errno));
+        close(listen_fd);
+        throw SessionManager::Exception("Could not prepare query socket "
+                                        + socket_path + ": " + err);
+    }
+
+    listen_watch_id = g_unix_fd_add(listen_fd, G_IO_IN, cb_accept, this);
+    refresh_pool = WorkerPool::Create(REFRESH_THREADS);
+    log->LogVerb1("Query socket listening on " + socket_path);
+}
+
+
+QuerySocket::~QuerySocket() noexcept
+{
+    if (timer_id > 0)
+    {
+        g_source_remove(timer_id);
+    }
+    if (refresh_timer_id > 0)
+    {
+        g_source_remove(refresh_timer_id);
+    }
+    if (pending_timer_id > 0)
+    {
+        g_source_remove(pending_timer_id);
+    }
+
+    // Waits for the running refreshes, which are bound by the
+    // D-Bus call timeout
+    refresh_pool.reset();
+    while (!clients.empty())
+    {
+        close_client(clients.begin()->second);
+    }
+    if (listen_watch_id > 0)
+    {
+        g_source_remove(listen_watch_id);
+    }
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+
+gboolean QuerySocket::cb_accept(gint fd, GIOCondition cond, gpointer data)
+{
+    auto self = static_cast<QuerySocket *>(data);
+    self->accept_client();
+    return G_SOURCE_CONTINUE;
+}
+
+
+gboolean QuerySocket::cb_read(gint fd, GIOCondition cond, gpointer data)
+{
+    auto self = static_cast<QuerySocket *>(data);
+    auto it = self->clients.find(fd);
+    if (self->clients.end() == it)
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    auto client = it->second;
+    if (!self->read_client(client))
+    {
+        // The watch is removed by returning G_SOURCE_REMOVE
+        client->watch_id = 0;
+        self->close_client(client);
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+
+gboolean QuerySocket::cb_timer(gpointer data)
+{
+    auto self = static_cast<QuerySocket *>(data);
+    self->push_updates();
+    return G_SOURCE_CONTINUE;
+}
+
+
+gboolean QuerySocket::cb_refresh(gpointer data)
+{
+    auto self = static_cast<QuerySocket *>(data);
+    self->schedule_refresh();
+    return G_SOURCE_CONTINUE;
+}
+
+
+gboolean QuerySocket::cb_pending(gpointer data)
+{
+    auto self = static_cast<QuerySocket *>(data);
+    if (!self->process_pending())
+    {
+        // The source is removed by returning G_SOURCE_REMOVE
+        self->pending_timer_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+
+void QuerySocket::accept_client()
+{
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct ucred cred = {};
+    socklen_t credlen = sizeof(cred);
+    if (0 != getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credlen)
+        || clients.size() >= MAX_CLIENTS)
+    {
+        close(fd);
+        return;
+    }
+
+    auto client = std::make_shared<Client>();
+    client->fd = fd;
+    client->uid = cred.uid;
+    client->pid = cred.pid;
+    client->watch_id = g_unix_fd_add(fd, G_IO_IN, cb_read, this);
+    clients[fd] = client;
+
+    if (0 == refresh_timer_id)
+    {
+        schedule_refresh();
+        refresh_timer_id = g_timeout_add_seconds(REFRESH_INTERVAL, cb_refresh, this);
+    }
+
+    log->LogVerb2("Query socket client connected, uid="
+                  + std::to_string(client->uid)
+                  + " pid=" + std::to_string(client->pid));
+}
+
+
+bool QuerySocket::read_client(ClientPtr client)
+{
+    char buf[1024];
+    ssize_t len = read(client->fd, buf, sizeof(buf));
+    if (len < 0 && (EAGAIN == errno || EINTR == errno))
+    {
+        return true;
+    }
+    if (len <= 0)
+    {
+        // Disconnected or failed
+        return false;
+    }
+
+    client->readbuf.append(buf, len);
+    size_t eol = std::string::npos;
+    while (std::string::npos != (eol = client->readbuf.find('\n')))
+    {
+        std::string line = client->readbuf.substr(0, eol);
+        client->readbuf.erase(0, eol + 1);
+        process_request(client, line);
+        if (client->fd < 0)
+        {
+            return false;
+        }
+    }
+
+    // A request line must not grow without bounds
+    return client->readbuf.size() <= MAX_REQUEST_LEN;
+}
+
+
+void QuerySocket::close_client(ClientPtr client) noexcept
+{
+    if (client->watch_id > 0)
+    {
+        g_source_remove(client->watch_id);
+        client->watch_id = 0;
+    }
+    if (client->fd >= 0)
+    {
+        clients.erase(client->fd);
+        close(client->fd);
+        client->fd = -1;
+    }
+
+    bool subscribers = false;
+    for (const auto &[fd, c] : clients)
+    {
+        subscribers |= c->subscribed;
+    }
+    if (!subscribers && timer_id > 0)
+    {
+        g_source_remove(timer_id);
+        timer_id = 0;
+    }
+    if (clients.empty() && refresh_timer_id > 0)
+    {
+        g_source_remove(refresh_timer_id);
+        refresh_timer_id = 0;
+    }
+}
+
+
+void QuerySocket::process_request(ClientPtr client, const std::string &line)
+{
+    // Requests are answered in order, so a request must also wait if
+    // an earlier request from the same client is still waiting
+    if (!client->pending.empty() || must_wait_refresh(client, true))
+    {
+        if (client->pending.size() >= MAX_PENDING)
+        {
+            close_client(client);
+            return;
+        }
+        if (client->pending.empty())
+        {
+            client->pending_since = std::chrono::steady_clock::now();
+        }
+        client->pending.push_back(line);
+        if (0 == pending_timer_id)
+        {
+            pending_timer_id = g_timeout_add(PENDING_CHECK_MS, cb_pending, this);
+        }
+        return;
+    }
+    handle_request(client, line);
+}
+
+
+bool QuerySocket::must_wait_refresh(const ClientPtr client, const bool queue_missing)
+{
+    std::vector<std::string> missing;
+    for (const auto &[path, obj] : object_mgr->GetAllObjects())
+    {
+        auto session = std::dynamic_pointer_cast<Session>(obj);
+        if (session
+            && session->CheckQueryAccess(client->uid)
+            && !session->HasQueryDetails())
+        {
+            missing.push_back(path);
+        }
+    }
+    if (missing.empty())
+    {
+        return false;
+    }
+
+    if (queue_missing)
+    {
+        // Sessions created since the last refresh are queued right away
+        schedule_refresh();
+    }
+
+    // Only wait if a refresh is actually running for one of the sessions
+    std::lock_guard<std::mutex> guard(refresh_mtx);
+    for (const auto &path : missing)
+    {
+        if (refresh_inflight.count(path) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+bool QuerySocket::process_pending()
+{
+    // A refresh takes two D-Bus calls, each limited by the call timeout
+    const auto max_wait = std::chrono::milliseconds(2 * REFRESH_TIMEOUT_MS);
+
+    std::vector<ClientPtr> waiting;
+    for (const auto &[fd, c] : clients)
+    {
+        if (!c->pending.empty())
+        {
+            waiting.push_back(c);
+        }
+    }
+
+    bool remaining = false;
+    for (auto &client : waiting)
+    {
+        if (client->fd < 0)
+        {
+            continue;
+        }
+        if (std::chrono::steady_clock::now() - client->pending_since < max_wait
+            && must_wait_refresh(client, false))
+        {
+            remaining = true;
+            continue;
+        }
+
+        auto requests = std::move(client->pending);
+        client->pending.clear();
+        for (const auto &line : requests)
+        {
+            handle_request(client, line);
+            if (client->fd < 0)
+            {
+                break;
+            }
+        }
+    }
+    return remaining;
+}
+
+
+void QuerySocket::handle_request(ClientPtr client, const std::string &line)
+{
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    Json::Value req;
+    std::string errors;
+    if (!reader->parse(line.data(), line.data() + line.size(), &req, &errors)
+        || !req.isObject())
+    {
+        Json::Value err;
+        err["error"] = "Invalid request";
+        send_json(client, err);
+        return;
+    }
+
+    const std::string request = req.get("request", "").asString();
+    Json::Value resp;
+    if ("sessions" == request)
+    {
+        resp["sessions"] = Json::Value(Json::arrayValue);
+        for (const auto &snap : collect_sessions(client))
+        {
+            resp["sessions"].append(snap.details);
+        }
+    }
+    else if ("session" == request)
+    {
+        const std::string path = req.get("session_path", "").asString();
+        for (const auto &snap : collect_sessions(client))
+        {
+            if (snap.session->GetPath() == path)
+            {
+                resp["session"] = snap.details;
+            }
+        }
+        if (!resp.isMember("session"))
+        {
+            resp["error"] = "Session not found";
+        }
+    }
+    else if ("subscribe" == request)
+    {
+        client->subscribed = true;
+        for (const auto &snap : collect_sessions(client))
+        {
+            Json::Value upd;
+            upd["event"] = "update";
+            upd["session"] = snap.details;
+            if (!send_json(client, upd))
+            {
+                return;
+            }
+            client->last_sent[snap.session->GetPath()] = snap.serialized;
+        }
+        if (0 == timer_id)
+        {
+            timer_id = g_timeout_add_seconds(SUBSCRIBE_INTERVAL, cb_timer, this);
+        }
+        return;
+    }
+    else
+    {
+        resp["error"] = "Unknown request";
+    }
+    send_json(client, resp);
+}
+
+
+bool QuerySocket::send_json(ClientPtr client, const Json::Value &data) noexcept
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    const std::string line = Json::writeString(builder, data) + "\n";
+
+    // The client socket is non-blocking.  If the response cannot be
+    // written completely right away, the client is not keeping up and
+    // is disconnected.
+    ssize_t ret = send(client->fd, line.c_str(), line.size(),
+                       MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (ret < 0 || static_cast<size_t>(ret) != line.size())
+    {
+        log->LogVerb2("Query socket client disconnected, uid="
+                      + std::to_string(client->uid)
+                      + " pid=" + std::to_string(client->pid));
+        close_client(client);
+        return false;
+    }
+    return true;
+}
+
+
+std::vector<QuerySocket::SessionSnapshot> QuerySocket::collect_sessions(const ClientPtr client)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+
+    std::vector<SessionSnapshot> ret;
+    for (const auto &[path, obj] : object_mgr->GetAllObjects())
+    {
+        auto session = std::dynamic_pointer_cast<Session>(obj);
+        if (!session || (client && !session->CheckQueryAccess(client->uid)))
+        {
+            continue;
+        }
+
+        try
+        {
+            SessionSnapshot snap;
+            snap.session = session;
+            snap.details = session->QuerySnapshot();
+            snap.serialized = Json::writeString(builder, snap.details);
+            ret.push_back(std::move(snap));
+        }
+        catch (const std::exception &excp)
+        {
+            log->LogVerb2("Query socket: could not retrieve details for "
+                          + path + ": " + std::string(excp.what()));
+        }
+    }
+    return ret;
+}
+
+
+void QuerySocket::push_updates()
+{
+    auto sessions = collect_sessions(nullptr);
+
+    // Take a copy of the client list, as a client may be closed
+    // while sending updates
+    std::vector<ClientPtr> subscribers;
+    for (const auto &[fd, c] : clients)
+    {
+        if (c->subscribed)
+        {
+            subscribers.push_back(c);
+        }
+    }
+
+    for (auto &client : subscribers)
+    {
+        std::map<std::string, std::string> current;
+        for (const auto &snap : sessions)
+        {
+            if (!snap.session->CheckQueryAccess(client->uid))
+            {
+                continue;
+            }
+            const std::string path = snap.session->GetPath();
+            current[path] = snap.serialized;
+
+            auto prev = client->last_sent.find(path);
+            if (client->last_sent.end() == prev || prev->second != snap.serialized)
+            {
+                Json::Value upd;
+                upd["event"] = "update";
+                upd["session"] = snap.details;
+                if (!send_json(client, upd))
+                {
+                    break;
+                }
+            }
+        }
+        if (client->fd < 0)
+        {
+            continue;
+        }
+
+        for (const auto &[path, serialized] : client->last_sent)
+        {
+            if (0 == current.count(path))
+            {
+                Json::Value rem;
+                rem["event"] = "removed";
+                rem["session_path"] = path;
+                if (!send_json(client, rem))
+                {
+                    break;
+                }
+            }
+        }
+        client->last_sent = std::move(current);
+    }
+}
+
+
+
+void QuerySocket::schedule_refresh()
+{
+    for (const auto &[path, obj] : object_mgr->GetAllObjects())
+    {
+        auto session = std::dynamic_pointer_cast<Session>(obj);
+        if (!session)
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(refresh_mtx);
+            if (!refresh_inflight.insert(path).second)
+            {
+                // The previous refresh of this session has not completed
+                continue;
+            }
+        }
+
+        // Only a weak reference is queued, so a session removed before
+        // the refresh starts is skipped.  The reference taken by the
+        // task keeps the session alive until its refresh is done.
+        std::weak_ptr<Session> weak = session;
+        const std::string sesspath = path;
+        try
+        {
+            (void)refresh_pool->Submit(
+                [this, weak, sesspath]()
+                {
+                    if (auto sess = weak.lock())
+                    {
+                        try
+                        {
+                            sess->RefreshQueryDetails(REFRESH_TIMEOUT_MS);
+                        }
+                        catch (const std::exception &excp)
+                        {
+                            log->LogVerb2("Query socket: could not refresh details for "
+                                          + sesspath + ": " + std::string(excp.what()));
+                        }
+                    }
+                    std::lock_guard<std::mutex> guard(refresh_mtx);
+                    refresh_inflight.erase(sesspath);
+                });
+        }
+        catch (const WorkerPoolException &)
+        {
+            // Retried on the next refresh interval
+            std::lock_guard<std::mutex> guard(refresh_mtx);
+            refresh_inflight.erase(sesspath);
+        }
+    }
+}
+
+} // namespace SessionManager
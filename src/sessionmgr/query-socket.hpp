@@ -0,0 +1,226 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   query-socket.hpp
+ *
+ * @brief  Read-only local UNIX socket providing session status details
+ *         without going through the D-Bus system bus
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <glib.h>
+#include <json/json.h>
+#include <gdbuspp/object/manager.hpp>
+
+#include "common/worker-pool.hpp"
+#include "sessionmgr-signals.hpp"
+
+
+namespace SessionManager {
+
+class Session;
+
+/**
+ *  The query socket is a UNIX stream socket where each request and
+ *  response is a single line containing a JSON object.  The caller is
+ *  identified via SO_PEERCRED and only sessions the caller may read
+ *  via the D-Bus properties are reported.
+ *
+ *  Requests:
+ *
+ *     {"request":"sessions"}
+ *         Responds with {"sessions":[{...},...]}
+ *
+ *     {"request":"session","session_path":"/net/openvpn/v3/sessions/..."}
+ *         Responds with {"session":{...}}
+ *
+ *     {"request":"subscribe"}
+ *         Responds with an {"event":"update","session":{...}} line for
+ *         each session.  Afterwards, new update lines are sent each time
+ *         the details of a session change, and
+ *         {"event":"removed","session_path":"..."} when a session is gone.
+ *
+ *  Errors are reported as {"error":"..."}.  The session details are
+ *  provided by SessionManager::Session::QuerySnapshot().
+ *
+ *  The clients are served in the main loop thread, without any D-Bus
+ *  calls.  The details provided by the backend VPN client processes
+ *  are refreshed by a small pool of worker threads while clients are
+ *  connected.  Each session has at most one refresh running and each
+ *  D-Bus call has a short timeout, so a backend not responding does
+ *  not delay the details of the other sessions.  Requests arriving
+ *  before the details of a session have been retrieved for the first
+ *  time are answered when that refresh has completed.  Clients not
+ *  reading their responses fast enough are disconnected.
+ */
+class QuerySocket
+{
+  public:
+    using Ptr = std::shared_ptr<QuerySocket>;
+
+    /**
+     *  How often sessions are checked for changes for the
+     *  subscribed clients, in seconds
+     */
+    static constexpr unsigned int SUBSCRIBE_INTERVAL = 1;
+
+    /**
+     *  How often the details from the backend VPN client processes
+     *  are refreshed while clients are connected, in seconds
+     */
+    static constexpr unsigned int REFRESH_INTERVAL = 1;
+
+    /**
+     *  Number of threads refreshing the backend details in parallel
+     *  and the timeout of each D-Bus call to a backend, in milliseconds
+     */
+    static constexpr unsigned int REFRESH_THREADS = 4;
+    static constexpr int REFRESH_TIMEOUT_MS = 1000;
+
+    /**
+     *  How often requests waiting for the first refresh of a session
+     *  are checked, in milliseconds
+     */
+    static constexpr unsigned int PENDING_CHECK_MS = 50;
+
+    /**
+     *  Maximum number of connected clients and the maximum length
+     *  of a single request line
+     */
+    static constexpr size_t MAX_CLIENTS = 64;
+    static constexpr size_t MAX_REQUEST_LEN = 4096;
+
+    /**
+     *  Maximum number of requests from a single client waiting for
+     *  the first refresh of the session details
+     */
+    static constexpr size_t MAX_PENDING = 16;
+
+    /**
+     *  Create the query socket and start accepting clients
+     *
+     * @param path     std::string with the file system path of the socket
+     * @param objmgr   DBus::Object::Manager::Ptr where the session objects
+     *                 are looked up
+     * @param log      SessionManager::Log::Ptr for logging
+     * @return QuerySocket::Ptr
+     *
+     * @throws SessionManager::Exception if the socket cannot be created
+     */
+    [[nodiscard]] static QuerySocket::Ptr Create(const std::string &path,
+                                                 DBus::Object::Manager::Ptr objmgr,
+                                                 SessionManager::Log::Ptr log);
+    ~QuerySocket() noexcept;
+
+
+  private:
+    struct Client
+    {
+        int fd = -1;
+        uid_t uid = -1;
+        pid_t pid = -1;
+        guint watch_id = 0;
+        bool subscribed = false;
+        std::string readbuf{};
+        std::map<std::string, std::string> last_sent{};
+
+        /// Requests waiting for the first refresh of the sessions
+        std::vector<std::string> pending{};
+        std::chrono::steady_clock::time_point pending_since{};
+    };
+    using ClientPtr = std::shared_ptr<Client>;
+
+    const std::string socket_path;
+    DBus::Object::Manager::Ptr object_mgr = nullptr;
+    SessionManager::Log::Ptr log = nullptr;
+    int listen_fd = -1;
+    guint listen_watch_id = 0;
+    guint timer_id = 0;
+    guint refresh_timer_id = 0;
+    guint pending_timer_id = 0;
+    std::map<int, ClientPtr> clients{};
+
+    WorkerPool::Ptr refresh_pool = nullptr;
+    std::mutex refresh_mtx{};
+    std::set<std::string> refresh_inflight{};
+
+    QuerySocket(const std::string &path,
+                DBus::Object::Manager::Ptr objmgr,
+                SessionManager::Log::Ptr log);
+
+    static gboolean cb_accept(gint fd, GIOCondition cond, gpointer data);
+    static gboolean cb_read(gint fd, GIOCondition cond, gpointer data);
+    static gboolean cb_timer(gpointer data);
+    static gboolean cb_refresh(gpointer data);
+    static gboolean cb_pending(gpointer data);
+
+    void accept_client();
+    bool read_client(ClientPtr client);
+    void close_client(ClientPtr client) noexcept;
+    void process_request(ClientPtr client, const std::string &line);
+    void handle_request(ClientPtr client, const std::string &line);
+    bool send_json(ClientPtr client, const Json::Value &data) noexcept;
+
+    struct SessionSnapshot
+    {
+        std::shared_ptr<Session> session;
+        Json::Value details;
+        std::string serialized;
+    };
+
+    /**
+     *  Retrieve the QuerySnapshot() of the sessions.  For the subscribed
+     *  clients, this is called once for all sessions and each client
+     *  filters the result, to avoid retrieving the same details more
+     *  than once.
+     *
+     * @param client   Only include sessions this client can access.  If
+     *                 nullptr, all sessions are included.
+     * @return std::vector<SessionSnapshot>
+     */
+    std::vector<SessionSnapshot> collect_sessions(const ClientPtr client);
+
+    void push_updates();
+
+    /**
+     *  Queue a Session::RefreshQueryDetails() call in the refresh pool
+     *  for all sessions which do not already have a refresh running
+     */
+    void schedule_refresh();
+
+    /**
+     *  Checks if a request from a client must wait for the first
+     *  refresh of a session it can access
+     *
+     * @param client         ClientPtr of the client sending the request
+     * @param queue_missing  If true, sessions without any details are
+     *                       queued for a refresh right away
+     * @return true if the request must wait
+     */
+    bool must_wait_refresh(const ClientPtr client, const bool queue_missing);
+
+    /**
+     *  Process the requests which have been waiting for the first
+     *  refresh, once it has completed or the wait has timed out
+     *
+     * @return true if there are still requests waiting
+     */
+    bool process_pending();
+};
+
+} // namespace SessionManager
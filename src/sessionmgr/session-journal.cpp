@@ -0,0 +1,295 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   session-journal.cpp
+ *
+ * @brief  Implementation of the Session Manager session journal
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sessionmgr-exceptions.hpp"
+#include "session-journal.hpp"
+
+
+namespace SessionManager {
+
+Json::Value JournalRecord::Export() const
+{
+    Json::Value ret;
+    ret["session_path"] = session_path;
+    ret["config_path"] = config_path;
+    ret["config_name"] = config_name;
+    ret["backend_busname"] = backend_busname;
+    ret["backend_pid"] = (Json::Value::Int)backend_pid;
+    ret["owner"] = (Json::Value::UInt)owner;
+    ret["created"] = (Json::Value::UInt64)created;
+    ret["public_access"] = public_access;
+    ret["restrict_log_access"] = restrict_log_access;
+    ret["acl"] = Json::Value(Json::arrayValue);
+    for (const auto &uid : acl)
+    {
+        ret["acl"].append((Json::Value::UInt)uid);
+    }
+    return ret;
+}
+
+
+JournalRecord JournalRecord::Import(const Json::Value &data)
+{
+    for (const auto &field : {"session_path", "backend_busname", "backend_pid", "owner"})
+    {
+        if (!data.isMember(field))
+        {
+            throw SessionManager::Exception("Session journal record is missing '"
+                                            + std::string(field) + "'");
+        }
+    }
+
+    try
+    {
+        JournalRecord rec;
+        rec.session_path = data["session_path"].asString();
+        rec.config_path = data.get("config_path", "").asString();
+        rec.config_name = data.get("config_name", "").asString();
+        rec.backend_busname = data["backend_busname"].asString();
+        rec.backend_pid = data["backend_pid"].asInt();
+        rec.owner = data["owner"].asUInt();
+        rec.created = data.get("created", 0).asUInt64();
+        rec.public_access = data.get("public_access", false).asBool();
+        rec.restrict_log_access = data.get("restrict_log_access", true).asBool();
+        for (const auto &uid : data["acl"])
+        {
+            rec.acl.push_back(uid.asUInt());
+        }
+        return rec;
+    }
+    catch (const Json::Exception &excp)
+    {
+        throw SessionManager::Exception("Invalid session journal record: "
+                                        + std::string(excp.what()));
+    }
+}
+
+
+
+SessionJournal::Ptr SessionJournal::Create(const std::string &filename)
+{
+    return SessionJournal::Ptr(new SessionJournal(filename));
+}
+
+
+SessionJournal::SessionJournal(const std::string &fname)
+    : filename(fname)
+{
+}
+
+
+SessionJournal::~SessionJournal() noexcept
+{
+    close_journal();
+}
+
+
+JournalRecords SessionJournal::Replay()
+{
+    std::lock_guard<std::mutex> guard(journal_mtx);
+    close_journal();
+
+    JournalRecords records{};
+    skipped_lines = 0;
+
+    std::ifstream journal(filename);
+    if (journal.is_open())
+    {
+        Json::CharReaderBuilder builder;
+        builder["collectComments"] = false;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+        for (std::string line; std::getline(journal, line);)
+        {
+            if (line.empty())
+            {
+                continue;
+            }
+
+            Json::Value entry;
+            std::string errors;
+            if (!reader->parse(line.data(), line.data() + line.size(), &entry, &errors)
+                || !entry.isObject())
+            {
+                // Most likely a partially written line caused by
+                // the Session Manager being terminated abruptly
+                ++skipped_lines;
+                continue;
+            }
+
+            try
+            {
+                const std::string op = entry.get("op", "").asString();
+                if ("created" == op || "updated" == op)
+                {
+                    auto rec = JournalRecord::Import(entry["session"]);
+                    records[rec.session_path] = rec;
+                }
+                else if ("removed" == op)
+                {
+                    records.erase(entry.get("session_path", "").asString());
+                }
+                else
+                {
+                    ++skipped_lines;
+                }
+            }
+            catch (const std::exception &)
+            {
+                ++skipped_lines;
+            }
+        }
+        journal.close();
+    }
+
+    compact(records);
+    open_journal();
+    return records;
+}
+
+
+size_t SessionJournal::GetSkippedLines() const noexcept
+{
+    return skipped_lines;
+}
+
+
+void SessionJournal::Created(const JournalRecord &rec)
+{
+    Json::Value entry;
+    entry["op"] = "created";
+    entry["session"] = rec.Export();
+    append(entry);
+}
+
+
+void SessionJournal::Updated(const JournalRecord &rec)
+{
+    Json::Value entry;
+    entry["op"] = "updated";
+    entry["session"] = rec.Export();
+    append(entry);
+}
+
+
+void SessionJournal::Removed(const std::string &session_path)
+{
+    Json::Value entry;
+    entry["op"] = "removed";
+    entry["session_path"] = session_path;
+    append(entry);
+}
+
+
+void SessionJournal::open_journal()
+{
+    journal_fd = ::open(filename.c_str(),
+                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                        S_IRUSR | S_IWUSR);
+    if (journal_fd < 0)
+    {
+        throw SessionManager::Exception("Could not open session journal '"
+                                        + filename + "': "
+                                        + std::string(strerror(errno)));
+    }
+}
+
+
+void SessionJournal::close_journal() noexcept
+{
+    if (journal_fd >= 0)
+    {
+        ::close(journal_fd);
+        journal_fd = -1;
+    }
+}
+
+
+void SessionJournal::append(const Json::Value &entry)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    const std::string line = Json::writeString(builder, entry) + "\n";
+
+    std::lock_guard<std::mutex> guard(journal_mtx);
+    if (journal_fd < 0)
+    {
+        open_journal();
+    }
+
+    // The complete line is written in a single write(2) call, so the
+    // kernel appends it atomically to the end of the file
+    ssize_t ret = ::write(journal_fd, line.c_str(), line.size());
+    if (ret < 0 || static_cast<size_t>(ret) != line.size())
+    {
+        throw SessionManager::Exception("Failed writing to session journal '"
+                                        + filename + "': "
+                                        + std::string(ret < 0 ? strerror(errno)
+                                                              : "short write"));
+    }
+    ::fdatasync(journal_fd);
+}
+
+
+void SessionJournal::compact(const JournalRecords &records)
+{
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+
+    std::ostringstream compacted;
+    for (const auto &[path, rec] : records)
+    {
+        Json::Value entry;
+        entry["op"] = "created";
+        entry["session"] = rec.Export();
+        compacted << Json::writeString(builder, entry) << "\n";
+    }
+    const std::string data = compacted.str();
+
+    // Write the compacted journal to a temporary file which then
+    // replaces the current journal.  rename(2) is atomic, so a crash
+    // at any point leaves either the old or the new journal in place.
+    const std::string tmpfile = filename + ".tmp";
+    int fd = ::open(tmpfile.c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        throw SessionManager::Exception("Could not create '" + tmpfile + "': "
+                                        + std::string(strerror(errno)));
+    }
+
+    ssize_t ret = ::write(fd, data.c_str(), data.size());
+    bool success = (ret >= 0 && static_cast<size_t>(ret) == data.size());
+    success = success && (0 == ::fsync(fd));
+    ::close(fd);
+
+    if (!success || 0 != std::rename(tmpfile.c_str(), filename.c_str()))
+    {
+        std::string err(strerror(errno));
+        std::remove(tmpfile.c_str());
+        throw SessionManager::Exception("Could not compact session journal '"
+                                        + filename + "': " + err);
+    }
+}
+
+} // namespace SessionManager
@@ -0,0 +1,159 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   session-journal.hpp
+ *
+ * @brief  Append-only journal of the session life cycle events in the
+ *         Session Manager.  This is used to re-adopt already running
+ *         backend VPN client processes if the openvpn3-service-sessionmgr
+ *         process is restarted.
+ */
+
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <json/json.h>
+
+
+namespace SessionManager {
+
+/**
+ *  Contains all the details needed to re-create a
+ *  SessionManager::Session object tied to an already running
+ *  backend VPN client process.
+ */
+struct JournalRecord
+{
+    std::string session_path{};
+    std::string config_path{};
+    std::string config_name{};
+    std::string backend_busname{};
+    pid_t backend_pid = -1;
+    uid_t owner = 0;
+    std::time_t created = 0;
+    std::vector<uid_t> acl{};
+    bool public_access = false;
+    bool restrict_log_access = true;
+
+    /**
+     *  Serializes this record into a JSON object
+     *
+     * @return Json::Value containing all the record fields
+     */
+    Json::Value Export() const;
+
+    /**
+     *  Parses a JSON object as exported by JournalRecord::Export()
+     *
+     * @param data          Json::Value to parse
+     * @return JournalRecord
+     * @throws SessionManager::Exception on missing or invalid fields
+     */
+    static JournalRecord Import(const Json::Value &data);
+};
+
+/**
+ *  All live sessions found in the journal, indexed by the session path
+ */
+using JournalRecords = std::map<std::string, JournalRecord>;
+
+
+/**
+ *  The session journal is a plain text file where each line is a single
+ *  JSON object describing one life cycle event of a VPN session:
+ *
+ *     {"op":"created","session":{...}}
+ *     {"op":"updated","session":{...}}
+ *     {"op":"removed","session_path":"/net/openvpn/v3/sessions/..."}
+ *
+ *  Each event is written with a single write(2) call to a file opened with
+ *  O_APPEND and is flushed to disk with fdatasync(2) before returning.  If
+ *  the process crashes while writing, only the last line can be incomplete;
+ *  such a line is ignored when the journal is replayed.
+ *
+ *  The journal is compacted on each Replay(), where only the sessions still
+ *  being alive are written to a new file which atomically replaces the old
+ *  journal file.
+ */
+class SessionJournal
+{
+  public:
+    using Ptr = std::shared_ptr<SessionJournal>;
+
+    /**
+     *  Prepare a new session journal
+     *
+     * @param filename   std::string with the file name of the journal file
+     * @return SessionJournal::Ptr
+     */
+    [[nodiscard]] static SessionJournal::Ptr Create(const std::string &filename);
+    ~SessionJournal() noexcept;
+
+    /**
+     *  Reads the complete journal and returns the sessions which has
+     *  been created but not removed.  The journal file is compacted to
+     *  only contain these records before it is re-opened for appending
+     *  new events.
+     *
+     * @return JournalRecords of all sessions considered to be alive
+     */
+    JournalRecords Replay();
+
+    /**
+     *  Retrieve the number of journal lines which could not be parsed
+     *  during the last Replay() call
+     *
+     * @return size_t
+     */
+    size_t GetSkippedLines() const noexcept;
+
+    /**
+     *  Records a new session being registered in the Session Manager
+     *
+     * @param rec   JournalRecord with the session details
+     */
+    void Created(const JournalRecord &rec);
+
+    /**
+     *  Records an updated state of an already registered session, such as
+     *  ownership or ACL changes.
+     *
+     * @param rec   JournalRecord with all the current session details
+     */
+    void Updated(const JournalRecord &rec);
+
+    /**
+     *  Records that a session has been closed and removed
+     *
+     * @param session_path  std::string with the D-Bus path of the session
+     */
+    void Removed(const std::string &session_path);
+
+
+  private:
+    const std::string filename;
+    int journal_fd = -1;
+    size_t skipped_lines = 0;
+    std::mutex journal_mtx{};
+
+    SessionJournal(const std::string &fname);
+
+    void open_journal();
+    void close_journal() noexcept;
+    void append(const Json::Value &entry);
+    void compact(const JournalRecords &records);
+};
+
+} // namespace SessionManager
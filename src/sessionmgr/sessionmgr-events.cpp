@@ -41,7 +41,7 @@ Event::Event(GVariant *params)
     type = glib2::Value::Extract<SessionManager::EventType>(params, 1);
     owner = glib2::Value::Extract<uid_t>(params, 2);
 
-    if (type > EventType::SESS_DESTROYED
+    if (type > EventType::SESS_START_FAILED
         || type < EventType::SESS_CREATED)
     {
         throw SessionManager::Exception("Invalid SessionManager::EventType value");
@@ -80,6 +80,9 @@ const std::string Event::TypeStr(const EventType type,
 
     case EventType::SESS_DESTROYED:
         return (tech_form ? "SESS_DESTROYED" : "Session destroyed");
+
+    case EventType::SESS_START_FAILED:
+        return (tech_form ? "SESS_START_FAILED" : "Session start failed");
     }
     return "[UNKNOWN]";
 }
@@ -29,7 +29,8 @@ enum class EventType : std::uint16_t
 {
     UNSET = 0,
     SESS_CREATED,
-    SESS_DESTROYED
+    SESS_DESTROYED,
+    SESS_START_FAILED
 };
 
 
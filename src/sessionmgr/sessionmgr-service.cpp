@@ -24,6 +24,7 @@
 
 #include "dbus/constants.hpp"
 #include "dbus/path.hpp"
+#include "sessionmgr-exceptions.hpp"
 #include "sessionmgr-service.hpp"
 #include "sessionmgr-session.hpp"
 #include "sessionmgr-signals.hpp"
@@ -35,10 +36,13 @@ namespace SessionManager {
 
 SrvHandler::SrvHandler(DBus::Connection::Ptr con,
                        DBus::Object::Manager::Ptr objmgr,
-                       LogWriter::Ptr lwr)
+                       LogWriter::Ptr lwr,
+                       SessionJournal::Ptr jrnl,
+                       WorkerPool::Ptr wrkpool)
     : DBus::Object::Base(Constants::GenPath("sessions"),
                          Constants::GenInterface("sessions")),
-      dbuscon(con), object_mgr(objmgr), logwr(lwr)
+      dbuscon(con), object_mgr(objmgr), logwr(lwr), journal(jrnl),
+      worker_pool(wrkpool)
 {
     DisableIdleDetector(true);
 
@@ -59,31 +63,17 @@ SrvHandler::SrvHandler(DBus::Connection::Ptr con,
                                           object_mgr,
                                           logwr,
                                           sig_sessmgr,
-                                          sig_sessmgr_event);
+                                          sig_sessmgr_event,
+                                          journal);
 
 
     auto new_tun = AddMethod("NewTunnel",
                              [this](DBus::Object::Method::Arguments::Ptr args)
                              {
-                                 this->method_new_tunnel(args);
-
-                                 // FIXME: This is a hackish workaround to
-                                 // avoid issues with the Python code not
-                                 // able to yet handle an object path
-                                 // which is not available yet.  This simple
-                                 // sleep allows the backend client to register
-                                 // itself.
-                                 //
-                                 // This was not needed with the previous
-                                 // implementation because this call returned
-                                 // after the Session object was created - and
-                                 // the handling of method calls was not handled
-                                 // asynchronously - which basically hid this
-                                 // this issue.
-                                 //
-                                 // This can be removed once the Python code
-                                 // is updated
-                                 usleep(700000);
+                                 helper_run_limited([this, args]()
+                                                    {
+                                                        this->method_new_tunnel(args);
+                                                    });
                              });
     new_tun->AddInput("config_path", glib2::DataType::DBus<DBus::Object::Path>());
     new_tun->AddOutput("session_path", glib2::DataType::DBus<DBus::Object::Path>());
@@ -120,7 +110,15 @@ SrvHandler::SrvHandler(DBus::Connection::Ptr con,
 
     AddProperty("version", version, false);
 
+    AddPropertyBySpec("worker_statistics",
+                      "a{st}",
+                      [this](const DBus::Object::Property::BySpec &prop)
+                      {
+                          return WorkerPool::StatisticsGVariant(worker_pool);
+                      });
+
     sig_sessmgr->LogInfo("OpenVPN 3 Session Manager started");
+    restore_sessions();
 }
 
 
@@ -130,6 +128,12 @@ void SrvHandler::SetLogLevel(const uint8_t loglvl)
 }
 
 
+void SrvHandler::EnableQuerySocket(const std::string &path)
+{
+    query_socket = QuerySocket::Create(path, object_mgr, sig_sessmgr);
+}
+
+
 const bool SrvHandler::Authorize(const Authz::Request::Ptr request)
 {
     // There is no ACL management in the service handler object
@@ -148,6 +152,26 @@ void SrvHandler::method_new_tunnel(Object::Method::Arguments::Ptr args)
 }
 
 
+void SrvHandler::helper_run_limited(std::function<void()> fn)
+{
+    if (!worker_pool)
+    {
+        fn();
+        return;
+    }
+
+    try
+    {
+        worker_pool->RunLimited(std::move(fn));
+    }
+    catch (const WorkerPoolException &excp)
+    {
+        sig_sessmgr->LogWarn("Method call rejected: " + std::string(excp.what()));
+        throw SessionManager::Exception("Service is busy, try again later");
+    }
+}
+
+
 void SrvHandler::method_fetch_avail_sessions(Object::Method::Arguments::Ptr args)
 {
     std::vector<DBus::Object::Path> session_paths{};
@@ -260,6 +284,42 @@ SessionCollection SrvHandler::helper_retrieve_sessions(const std::string &caller
 
 
 
+void SrvHandler::restore_sessions()
+{
+    if (!journal)
+    {
+        return;
+    }
+
+    try
+    {
+        auto records = journal->Replay();
+        if (journal->GetSkippedLines() > 0)
+        {
+            sig_sessmgr->LogWarn("Session journal: ignored "
+                                 + std::to_string(journal->GetSkippedLines())
+                                 + " invalid record(s)");
+        }
+        if (records.empty())
+        {
+            return;
+        }
+
+        size_t adopted = tunnel_queue->AdoptSessions(records);
+        sig_sessmgr->LogInfo("Re-adopted " + std::to_string(adopted)
+                             + " of " + std::to_string(records.size())
+                             + " running VPN session(s)");
+    }
+    catch (const DBus::Exception &excp)
+    {
+        sig_sessmgr->LogCritical("Session journal disabled: "
+                                 + std::string(excp.GetRawError()));
+        journal.reset();
+    }
+}
+
+
+
 //
 //
 //  SessionManager::Service
@@ -290,8 +350,16 @@ void Service::BusNameAcquired(const std::string &busname)
 {
     auto srvh = CreateServiceHandler<SrvHandler>(GetConnection(),
                                                  GetObjectManager(),
-                                                 logwr);
+                                                 logwr,
+                                                 journal,
+                                                 (worker_threads > 0
+                                                      ? WorkerPool::Create(worker_threads)
+                                                      : nullptr));
     srvh->SetLogLevel(log_level);
+    if (!query_socket_path.empty())
+    {
+        srvh->EnableQuerySocket(query_socket_path);
+    }
 }
 
 
@@ -307,4 +375,26 @@ void Service::SetLogLevel(const uint8_t loglvl)
     log_level = loglvl;
 }
 
+
+void Service::SetStateDirectory(const std::string &state_dir)
+{
+    if (journal)
+    {
+        throw SessionManager::Exception("State directory already set");
+    }
+    journal = SessionJournal::Create(state_dir + "/sessions.journal");
+}
+
+
+void Service::SetWorkerThreads(unsigned int threads)
+{
+    worker_threads = threads;
+}
+
+
+void Service::SetQuerySocket(const std::string &path)
+{
+    query_socket_path = path;
+}
+
 } // namespace SessionManager
@@ -21,11 +21,14 @@
 #include <gdbuspp/service.hpp>
 
 #include "common/utils.hpp"
+#include "common/worker-pool.hpp"
 #include "dbus/constants.hpp"
 #include "log/logwriter.hpp"
 #include "log/proxy-log.hpp"
+#include "query-socket.hpp"
 #include "sessionmgr-session.hpp"
 #include "sessionmgr-signals.hpp"
+#include "session-journal.hpp"
 #include "tunnel-queue.hpp"
 
 using namespace DBus;
@@ -49,7 +52,9 @@ class SrvHandler : public Object::Base
   public:
     SrvHandler(DBus::Connection::Ptr con,
                Object::Manager::Ptr objmgr,
-               LogWriter::Ptr lwr);
+               LogWriter::Ptr lwr,
+               SessionJournal::Ptr jrnl = nullptr,
+               WorkerPool::Ptr wrkpool = nullptr);
     ~SrvHandler() = default;
 
     /**
@@ -59,6 +64,14 @@ class SrvHandler : public Object::Base
      */
     void SetLogLevel(const uint8_t loglvl);
 
+    /**
+     *  Enables the read-only local query socket, see
+     *  SessionManager::QuerySocket for details.
+     *
+     * @param path  std::string with the file system path of the socket
+     */
+    void EnableQuerySocket(const std::string &path);
+
   protected:
     /**
      *  Authorization callback for D-Bus object access.
@@ -82,7 +95,19 @@ class SrvHandler : public Object::Base
     DBus::Signals::Emit::Ptr broadcast_emitter = nullptr;
     ::Signals::SessionManagerEvent::Ptr sig_sessmgr_event = nullptr;
     std::shared_ptr<NewTunnelQueue> tunnel_queue = nullptr;
+    SessionJournal::Ptr journal = nullptr;
+    WorkerPool::Ptr worker_pool = nullptr;
+    QuerySocket::Ptr query_socket = nullptr;
+
 
+    /**
+     *  Runs a method call handler via WorkerPool::RunLimited(), which
+     *  limits how many handlers run at the same time, if the worker pool
+     *  is enabled.  Otherwise the handler is run directly.
+     *
+     * @param fn   std::function<void()> with the method call handler
+     */
+    void helper_run_limited(std::function<void()> fn);
 
     /**
      *  D-Bus method: net.openvpn.v3.sessions.NewTunnel
@@ -201,6 +226,13 @@ class SrvHandler : public Object::Base
      */
     SessionCollection helper_retrieve_sessions(const std::string &caller,
                                                fn_search_filter &&filter_fn) const;
+
+    /**
+     *  Replays the session journal and re-adopts all backend VPN client
+     *  processes which are still running.  Errors are logged and will
+     *  disable the session journal.
+     */
+    void restore_sessions();
 };
 
 
@@ -226,10 +258,40 @@ class Service : public DBus::Service
 
     void SetLogLevel(const uint8_t loglvl);
 
+    /**
+     *  Sets the directory where the Session Manager keeps its session
+     *  journal.  This must be called before the service is started, as
+     *  the journal is replayed when the service handler is created.
+     *
+     * @param state_dir  std::string containing the file system directory
+     */
+    void SetStateDirectory(const std::string &state_dir);
+
+    /**
+     *  Enables the worker pool limiting how many NewTunnel method calls
+     *  run at the same time.  This must be called before the service
+     *  is started.
+     *
+     * @param threads  unsigned int with the number of worker threads.
+     *                 If 0, the worker pool is not enabled.
+     */
+    void SetWorkerThreads(unsigned int threads);
+
+    /**
+     *  Enables the read-only local query socket for session status
+     *  details.  This must be called before the service is started.
+     *
+     * @param path  std::string with the file system path of the socket
+     */
+    void SetQuerySocket(const std::string &path);
+
   private:
     LogWriter::Ptr logwr = nullptr;
     LogServiceProxy::Ptr logsrvprx = nullptr;
+    SessionJournal::Ptr journal = nullptr;
     uint8_t log_level = 3;
+    unsigned int worker_threads = 0;
+    std::string query_socket_path{};
 };
 
 
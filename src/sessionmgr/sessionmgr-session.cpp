@@ -80,7 +80,7 @@ Session::Session(DBus::Connection::Ptr dbuscon,
                  LogWriter::Ptr logwr)
     : DBus::Object::Base(std::move(sespath), Constants::GenInterface("sessions")),
       dbus_conn(dbuscon), object_mgr(objmgr), creds_qry(creds_qry_),
-      sig_sessmgr(sig_sessionmgr),
+      sig_sessmgr(sig_sessionmgr), backend_busname(be_busname),
       backend_pid(be_pid), config_path(std::move(cfg_path))
 {
     // Set up the D-Bus proxy towards the back-end VPN client process
@@ -224,6 +224,17 @@ Session::Session(DBus::Connection::Ptr dbuscon,
     arg_usrinpq_fetch->AddOutput("description", glib2::DataType::DBus<std::string>());
     arg_usrinpq_fetch->AddOutput("hidden_input", glib2::DataType::DBus<bool>());
 
+    auto arg_usrinpq_fetchall = AddMethod(
+        "UserInputQueueFetchAll",
+        [=](Object::Method::Arguments::Ptr args)
+        {
+            validate_vpn_backend();
+            GVariant *r = be_prx->Call(be_target,
+                                       "UserInputQueueFetchAll");
+            args->SetMethodReturn(r);
+        });
+    arg_usrinpq_fetchall->AddOutput("slots", "a(uuussb)");
+
     auto arg_usrinpq_check = AddMethod(
         "UserInputQueueCheck",
         [=](Object::Method::Arguments::Ptr args)
@@ -258,7 +269,24 @@ Session::Session(DBus::Connection::Ptr dbuscon,
     AddProperty("config_path", config_path, false);
     AddProperty("config_name", config_name, false);
     AddProperty("backend_pid", backend_pid, false, glib2::DataType::DBus<uint32_t>());
-    AddProperty("restrict_log_access", restrict_log_access, true);
+
+    AddPropertyBySpec(
+        "restrict_log_access",
+        glib2::DataType::DBus<bool>(),
+        [=](const DBus::Object::Property::BySpec &prop)
+            -> GVariant *
+        {
+            return glib2::Value::Create(restrict_log_access);
+        },
+        [=](const DBus::Object::Property::BySpec &prop, GVariant *value)
+            -> DBus::Object::Property::Update::Ptr
+        {
+            restrict_log_access = glib2::Value::Get<bool>(value);
+            helper_journal_update();
+            auto upd = prop.PrepareUpdate();
+            upd->AddValue(restrict_log_access);
+            return upd;
+        });
 
     // Prepare object properties extracting information from other sources
     AddPropertyBySpec(
@@ -363,6 +391,38 @@ Session::Session(DBus::Connection::Ptr dbuscon,
             return be_prx->GetPropertyGVariant(be_target, "session_name");
         });
 
+    // connect_timeline: phases of the session start-up, from the
+    // session manager, backend VPN client and netcfg service
+    AddPropertyBySpec(
+        "connect_timeline",
+        "a(sstt)",
+        [=](const DBus::Object::Property::BySpec &prop)
+            -> GVariant *
+        {
+            ConnectTimeline::PhaseList phases;
+            if (timeline)
+            {
+                phases = timeline->GetPhases();
+            }
+            try
+            {
+                validate_vpn_backend("connect_timeline");
+                GVariant *be = be_prx->GetPropertyGVariant(be_target, "connect_timeline");
+                for (auto &p : ConnectTimeline::Parse(be))
+                {
+                    phases.push_back(std::move(p));
+                }
+                g_variant_unref(be);
+            }
+            catch (const DBus::Exception &)
+            {
+                // An older backend VPN client without this property
+                // or the backend is not available; provide only the
+                // phases recorded by the session manager
+            }
+            return ConnectTimeline::Serialize(std::move(phases));
+        });
+
 
     //
     // Prepare object properties which has information in other object and
@@ -403,6 +463,7 @@ Session::Session(DBus::Connection::Ptr dbuscon,
             -> DBus::Object::Property::Update::Ptr
         {
             object_acl->SetPublicAccess(glib2::Value::Get<bool>(value));
+            helper_journal_update();
             auto upd = prop.PrepareUpdate();
             upd->AddValue(object_acl->GetPublicAccess());
             std::string valstr = (object_acl->GetPublicAccess()
@@ -618,6 +679,12 @@ void Session::SetConfigName(const std::string &cfgname)
 }
 
 
+void Session::SetConnectTimeline(ConnectTimeline::Ptr tl)
+{
+    timeline = tl;
+}
+
+
 const std::string Session::GetConfigName() const noexcept
 {
     return config_name;
@@ -637,6 +704,150 @@ const bool Session::CheckACL(const std::string &caller) const noexcept
 }
 
 
+const bool Session::CheckQueryAccess(const uid_t uid) const noexcept
+{
+    // Same rules as for D-Bus property reads, see Authorize()
+    return object_acl->CheckACL(uid,
+                                {0,
+                                 object_acl->GetOwner(),
+                                 lookup_uid(OPENVPN_USERNAME)},
+                                true);
+}
+
+
+Json::Value Session::QuerySnapshot() const
+{
+    Json::Value ret;
+    ret["session_path"] = GetPath();
+    ret["config_name"] = config_name;
+    ret["owner"] = (Json::Value::UInt)object_acl->GetOwner();
+    ret["backend_pid"] = (Json::Value::Int)backend_pid;
+
+    Events::Status status(sig_statuschg->LastStatusChange());
+    ret["status"]["major"] = static_cast<uint32_t>(status.major);
+    ret["status"]["minor"] = static_cast<uint32_t>(status.minor);
+    ret["status"]["message"] = status.message;
+
+    Events::Log lastlog = sig_session->GetLastLogEvent();
+    if (!lastlog.empty())
+    {
+        ret["last_log"]["group"] = static_cast<uint32_t>(lastlog.group);
+        ret["last_log"]["category"] = static_cast<uint32_t>(lastlog.category);
+        ret["last_log"]["message"] = lastlog.message;
+    }
+
+    std::lock_guard<std::mutex> guard(query_details_mtx);
+    for (const auto &key : query_details.getMemberNames())
+    {
+        ret[key] = query_details[key];
+    }
+    return ret;
+}
+
+
+/**
+ *  Retrieve a property from the backend VPN client process, waiting no
+ *  longer than the given timeout.  The DBus::Proxy::Client calls use the
+ *  default D-Bus timeout, which is far too long for the query socket.
+ *
+ * @param conn        GDBusConnection to use
+ * @param busname     std::string with the bus name of the backend
+ * @param tgt         DBus::Proxy::TargetPreset with the backend object
+ * @param property    std::string with the property name
+ * @param timeout_ms  int with the call timeout, in milliseconds
+ * @return GVariant* with the property value, must be freed by the caller
+ *
+ * @throws DBus::Exception on errors or timeout
+ */
+static GVariant *get_backend_property(GDBusConnection *conn,
+                                      const std::string &busname,
+                                      DBus::Proxy::TargetPreset::Ptr tgt,
+                                      const std::string &property,
+                                      const int timeout_ms)
+{
+    GError *err = nullptr;
+    GVariant *res = g_dbus_connection_call_sync(conn,
+                                                busname.c_str(),
+                                                tgt->object_path.c_str(),
+                                                "org.freedesktop.DBus.Properties",
+                                                "Get",
+                                                g_variant_new("(ss)",
+                                                              tgt->interface.c_str(),
+                                                              property.c_str()),
+                                                G_VARIANT_TYPE("(v)"),
+                                                G_DBUS_CALL_FLAGS_NONE,
+                                                timeout_ms,
+                                                nullptr,
+                                                &err);
+    if (!res)
+    {
+        std::string msg = (err ? err->message : "Unknown error");
+        g_clear_error(&err);
+        throw DBus::Exception("RefreshQueryDetails",
+                              "Could not read " + property + ": " + msg);
+    }
+
+    GVariant *value = nullptr;
+    g_variant_get(res, "(v)", &value);
+    g_variant_unref(res);
+    return value;
+}
+
+
+void Session::RefreshQueryDetails(const int timeout_ms)
+{
+    if (!be_prx || !be_target)
+    {
+        return;
+    }
+
+    Json::Value details;
+    try
+    {
+        GVariant *devname = get_backend_property(dbus_conn->ConnPtr(),
+                                                 backend_busname,
+                                                 be_target,
+                                                 "device_name",
+                                                 timeout_ms);
+        details["device_name"] = std::string(g_variant_get_string(devname, nullptr));
+        g_variant_unref(devname);
+
+        GVariant *stats = get_backend_property(dbus_conn->ConnPtr(),
+                                               backend_busname,
+                                               be_target,
+                                               "statistics",
+                                               timeout_ms);
+        GVariantIter *it = nullptr;
+        const gchar *key = nullptr;
+        gint64 val = 0;
+        g_variant_get(stats, "a{sx}", &it);
+        details["statistics"] = Json::Value(Json::objectValue);
+        while (g_variant_iter_next(it, "{&sx}", &key, &val))
+        {
+            details["statistics"][key] = (Json::Value::Int64)val;
+        }
+        g_variant_iter_free(it);
+        g_variant_unref(stats);
+    }
+    catch (const DBus::Exception &)
+    {
+        // The backend VPN client process is not responding; the
+        // previously retrieved details are kept
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(query_details_mtx);
+    query_details = std::move(details);
+}
+
+
+bool Session::HasQueryDetails() const noexcept
+{
+    std::lock_guard<std::mutex> guard(query_details_mtx);
+    return query_details.isMember("device_name");
+}
+
+
 const uid_t Session::GetOwner() const noexcept
 {
     return object_acl->GetOwner();
@@ -648,12 +859,69 @@ void Session::MoveToOwner(const uid_t from_uid, const uid_t to_uid)
     object_acl->TransferOwnership(to_uid);
     object_acl->GrantAccess(from_uid);
     restrict_log_access = false; // The previous owner can receive log events
+    helper_journal_update();
     sig_session->LogInfo("Ownership changed from " + lookup_username(from_uid)
                          + " to " + lookup_username(to_uid)
                          + " on " + GetPath());
 }
 
 
+void Session::RestoreState(const JournalRecord &rec)
+{
+    created = rec.created;
+    restrict_log_access = rec.restrict_log_access;
+    object_acl->SetPublicAccess(rec.public_access);
+    for (const auto &uid : rec.acl)
+    {
+        try
+        {
+            object_acl->GrantAccess(uid);
+        }
+        catch (const GDBusPP::Object::Extension::ACLException &)
+        {
+            // Already granted; ignore it
+        }
+    }
+    SetConfigName(rec.config_name);
+}
+
+
+JournalRecord Session::GetJournalRecord() const
+{
+    JournalRecord rec;
+    rec.session_path = GetPath();
+    rec.config_path = config_path;
+    rec.config_name = config_name;
+    rec.backend_busname = backend_busname;
+    rec.backend_pid = backend_pid;
+    rec.owner = object_acl->GetOwner();
+    rec.created = created;
+    rec.acl = object_acl->GetAccessList();
+    rec.public_access = object_acl->GetPublicAccess();
+    rec.restrict_log_access = restrict_log_access;
+    return rec;
+}
+
+
+void Session::EnableJournal(SessionJournal::Ptr jrnl)
+{
+    journal = jrnl;
+    if (!journal)
+    {
+        return;
+    }
+
+    try
+    {
+        journal->Created(GetJournalRecord());
+    }
+    catch (const DBus::Exception &excp)
+    {
+        sig_session->LogError("Session journal: " + std::string(excp.GetRawError()));
+    }
+}
+
+
 void Session::method_ready(DBus::Object::Method::Arguments::Ptr args)
 {
     validate_vpn_backend();
@@ -781,6 +1049,7 @@ void Session::method_access_grant(DBus::Object::Method::Arguments::Ptr args)
     {
         throw DBus::Object::Method::Exception(excp.GetRawError());
     }
+    helper_journal_update();
     sig_session->LogInfo("Granted access to " + lookup_username(user)
                          + " on " + GetPath());
 }
@@ -798,6 +1067,7 @@ void Session::method_access_revoke(DBus::Object::Method::Arguments::Ptr args)
     {
         throw DBus::Object::Method::Exception(excp.GetRawError());
     }
+    helper_journal_update();
     sig_session->LogInfo("Revoked access from " + lookup_username(user)
                          + " on " + GetPath());
 }
@@ -837,6 +1107,18 @@ void Session::close_session(const bool forced)
 
     helper_stop_log_forwards();
     sig_session->LogVerb1("Session closing - " + GetPath());
+    if (journal)
+    {
+        try
+        {
+            journal->Removed(GetPath());
+        }
+        catch (const DBus::Exception &excp)
+        {
+            sig_session->LogError("Session journal: " + std::string(excp.GetRawError()));
+        }
+        journal.reset();
+    }
     try
     {
         object_mgr->RemoveObject(GetPath());
@@ -876,6 +1158,24 @@ void Session::helper_stop_log_forwards()
 }
 
 
+void Session::helper_journal_update() noexcept
+{
+    if (!journal)
+    {
+        return;
+    }
+
+    try
+    {
+        journal->Updated(GetJournalRecord());
+    }
+    catch (const std::exception &excp)
+    {
+        sig_session->LogError("Session journal: " + std::string(excp.what()));
+    }
+}
+
+
 void Session::validate_vpn_backend(const std::string &property) const
 {
     if (!be_prx || !be_target)
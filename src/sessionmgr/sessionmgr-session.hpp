@@ -17,6 +17,7 @@
 #pragma once
 
 #include <mutex>
+#include <json/json.h>
 #include <gdbuspp/connection.hpp>
 #include <gdbuspp/object/base.hpp>
 #include <gdbuspp/object/manager.hpp>
@@ -27,9 +28,11 @@
 #include "log/proxy-log.hpp"
 #include "log/logwriter.hpp"
 #include "common/requiresqueue.hpp"
+#include "common/timeline.hpp"
 #include "dbus/signals/attention-required.hpp"
 #include "dbus/signals/statuschange.hpp"
 #include "sessionmgr-signals.hpp"
+#include "session-journal.hpp"
 
 
 namespace SessionManager {
@@ -79,6 +82,82 @@ class Session : public DBus::Object::Base
     const uid_t GetOwner() const noexcept;
     void MoveToOwner(const uid_t from_uid, const uid_t to_uid);
 
+    /**
+     *  Restores the session state which is not available from the
+     *  backend VPN client process, based on a session journal record.
+     *  This is used when re-adopting an already running backend VPN client
+     *  after the Session Manager has been restarted.
+     *
+     * @param rec  JournalRecord with the saved session state
+     */
+    void RestoreState(const JournalRecord &rec);
+
+    /**
+     *  Retrieve the current session state as a session journal record
+     *
+     * @return JournalRecord
+     */
+    JournalRecord GetJournalRecord() const;
+
+    /**
+     *  Enables tracking of this session in the session journal.  This will
+     *  record the current session state in the journal and all later
+     *  changes to the ownership and access control will be recorded as well.
+     *
+     * @param jrnl  SessionJournal::Ptr to the journal to use
+     */
+    void EnableJournal(SessionJournal::Ptr jrnl);
+
+    /**
+     *  Sets the time line of the session start-up as recorded by the
+     *  NewTunnelQueue.  This is combined with the time line of the
+     *  backend VPN client process in the connect_timeline property.
+     *
+     * @param tl  ConnectTimeline::Ptr with the session manager phases
+     */
+    void SetConnectTimeline(ConnectTimeline::Ptr tl);
+
+    /**
+     *  Checks if a user can read the session details via the local
+     *  query socket.  This uses the same access rules as D-Bus property
+     *  reads of this object.
+     *
+     * @param uid    uid_t of the user, from the SO_PEERCRED details
+     * @return true if access is granted
+     */
+    const bool CheckQueryAccess(const uid_t uid) const noexcept;
+
+    /**
+     *  Retrieve the current session status, statistics, device name and
+     *  the last log event, as provided via the local query socket.
+     *  The statistics and device name are the values retrieved by the
+     *  last RefreshQueryDetails() call; they are left out until the
+     *  backend VPN client process has responded.
+     *
+     *  This does not make any D-Bus calls.
+     *
+     * @return Json::Value
+     */
+    Json::Value QuerySnapshot() const;
+
+    /**
+     *  Retrieve the device name and statistics from the backend VPN
+     *  client process, used by QuerySnapshot().  This makes blocking
+     *  D-Bus calls and must not be called from the main loop thread.
+     *
+     * @param timeout_ms  int with the maximum time to wait for each
+     *                    D-Bus call, in milliseconds
+     */
+    void RefreshQueryDetails(const int timeout_ms);
+
+    /**
+     *  Checks if RefreshQueryDetails() has retrieved the details from
+     *  the backend VPN client process at least once
+     *
+     * @return true if the details are available
+     */
+    bool HasQueryDetails() const noexcept;
+
   protected:
     const bool Authorize(DBus::Authz::Request::Ptr) override;
     const std::string AuthorizationRejected(const Authz::Request::Ptr) const noexcept override;
@@ -90,6 +169,7 @@ class Session : public DBus::Object::Base
     DBus::Object::Manager::Ptr object_mgr = nullptr;
     DBus::Credentials::Query::Ptr creds_qry = nullptr;
     ::Signals::SessionManagerEvent::Ptr sig_sessmgr = nullptr;
+    std::string backend_busname{};
     pid_t backend_pid = -1;
     DBus::Object::Path config_path = {};
     std::string config_name{};
@@ -109,6 +189,12 @@ class Session : public DBus::Object::Base
     DCOstatus dco_status = DCOstatus::UNCHANGED;
     bool dco = false;
     bool connection_started = false;
+    SessionJournal::Ptr journal = nullptr;
+    ConnectTimeline::Ptr timeline = nullptr;
+
+    /// Backend details from RefreshQueryDetails(), used by QuerySnapshot()
+    Json::Value query_details{Json::objectValue};
+    mutable std::mutex query_details_mtx{};
 
     /**
      *  D-Bus method: net.openvpn.v3.sessions.Ready
@@ -244,6 +330,12 @@ class Session : public DBus::Object::Base
 
     void helper_stop_log_forwards();
 
+    /**
+     *  Records the current session state in the session journal, if
+     *  the journal is enabled for this session.  Errors are only logged.
+     */
+    void helper_journal_update() noexcept;
+
     void validate_vpn_backend(const std::string &property = "") const;
 };
 
@@ -12,6 +12,7 @@
 
 #include "common/lookup.hpp"
 #include "configmgr/proxy-configmgr.hpp"
+#include "sessionmgr-exceptions.hpp"
 #include "sessionmgr-session.hpp"
 #include "tunnel-queue.hpp"
 
@@ -36,14 +37,16 @@ NewTunnelQueue::Ptr NewTunnelQueue::Create(DBus::Connection::Ptr dbuscon,
                                            DBus::Object::Manager::Ptr objmgr,
                                            LogWriter::Ptr logwr,
                                            SessionManager::Log::Ptr sig_log,
-                                           ::Signals::SessionManagerEvent::Ptr sesmgrev)
+                                           ::Signals::SessionManagerEvent::Ptr sesmgrev,
+                                           SessionJournal::Ptr journal)
 {
     return NewTunnelQueue::Ptr(new NewTunnelQueue(dbuscon,
                                                   creds_qry,
                                                   objmgr,
                                                   logwr,
                                                   sig_log,
-                                                  sesmgrev));
+                                                  sesmgrev,
+                                                  journal));
 }
 
 
@@ -52,11 +55,15 @@ NewTunnelQueue::NewTunnelQueue(DBus::Connection::Ptr dbuscon_,
                                DBus::Object::Manager::Ptr objmgr,
                                LogWriter::Ptr logwr_,
                                SessionManager::Log::Ptr sig_log,
-                               ::Signals::SessionManagerEvent::Ptr sesmgrev)
+                               ::Signals::SessionManagerEvent::Ptr sesmgrev,
+                               SessionJournal::Ptr journal_)
     : dbuscon(dbuscon_), creds_qry(creds_qry_), object_mgr(objmgr), logwr(logwr_),
-      log(sig_log), sesmgr_event(sesmgrev)
+      log(sig_log), sesmgr_event(sesmgrev), journal(journal_)
 {
     be_prxqry = DBus::Proxy::Utils::DBusServiceQuery::Create(dbuscon);
+    be_start_target = DBus::Proxy::TargetPreset::Create(Constants::GenPath("backends"),
+                                                        Constants::GenInterface("backends"));
+    spawner = WorkerPool::Create(SPAWNER_THREADS, SPAWNER_QUEUE);
 
     signal_subscr = DBus::Signals::SubscriptionManager::Create(dbuscon);
     subscr_target = DBus::Signals::Target::Create("",
@@ -74,42 +81,193 @@ NewTunnelQueue::NewTunnelQueue(DBus::Connection::Ptr dbuscon_,
 const DBus::Object::Path NewTunnelQueue::AddTunnel(const std::string &config_path,
                                                    const uid_t owner)
 {
-    try
+    // Create a session token and prepare a tunnel record keeping
+    // the details.  The TunnelRecord will generate the session path this
+    // backend VPN client process can be reached via.
+    const std::string session_token(generate_path_uuid("", 't'));
+    auto trq = TunnelRecord::Create(config_path, owner);
+    trq->timeline->Begin("new_tunnel");
+    trq->timeline->Begin("spawner_queue");
     {
-        // Create a session token and prepare a tunnel record keeping
-        // the details.  The TunnelRecord will generate the session path this
-        // backend VPN client process can be reached via.
-        const std::string session_token(generate_path_uuid("", 't'));
-        auto trq = TunnelRecord::Create(config_path, owner);
+        std::lock_guard<std::mutex> guard(queue_mtx);
         queue[session_token] = trq;
+    }
 
-        // Request the backend VPN client process to be started.
-        if (!be_prxqry->CheckServiceAvail(Constants::GenInterface("backends")))
+    // Request the backend VPN client process to be started.  This is
+    // done in the background, as the StartClient call does not return
+    // before the client process has been started.  Failures are reported
+    // via the SessionManagerEvent signal.
+    try
+    {
+        (void)spawner->Submit([this, session_token, trq]()
+                              {
+                                  start_backend(session_token, trq);
+                              });
+    }
+    catch (const WorkerPoolException &excp)
+    {
+        log->LogError("Could not start the VPN client: "
+                      + std::string(excp.what()));
         {
-            throw DBus::Exception(__func__,
-                                  "Could not connect to net.openvpn.v3.backends");
+            std::lock_guard<std::mutex> guard(queue_mtx);
+            queue.erase(session_token);
         }
-        auto be_start = DBus::Proxy::Client::Create(dbuscon,
-                                                    Constants::GenServiceName("backends"));
-        auto be_qry = DBus::Proxy::Utils::Query::Create(be_start);
-        (void)be_qry->CheckObjectExists(Constants::GenPath("backends"),
-                                        Constants::GenInterface("backends"));
-
-        GVariant *r = be_start->Call(Constants::GenPath("backends"),
-                                     Constants::GenInterface("backends"),
-                                     "StartClient",
-                                     glib2::Value::CreateTupleWrapped(session_token));
-        g_variant_unref(r);
+        throw DBus::Exception(__func__,
+                              "Could not start the VPN client");
+    }
+
+    // The session path for this session is returned
+    trq->timeline->End("new_tunnel");
+    return trq->session_path;
+}
+
+
+size_t NewTunnelQueue::AdoptSessions(const JournalRecords &records)
+{
+    size_t adopted = 0;
+    for (const auto &[path, rec] : records)
+    {
+        try
+        {
+            // Ensure the backend bus name is still owned by the same
+            // process; this throws if the bus name is gone
+            pid_t pid = creds_qry->GetPID(rec.backend_busname);
+            if (pid != rec.backend_pid)
+            {
+                throw SessionManager::Exception("Backend PID mismatch (expected "
+                                                + std::to_string(rec.backend_pid)
+                                                + ", found "
+                                                + std::to_string(pid) + ")");
+            }
+
+            // Ensure the backend VPN client is still tied to this session
+            auto be_client = DBus::Proxy::Client::Create(dbuscon, rec.backend_busname);
+            auto be_target = DBus::Proxy::TargetPreset::Create(Constants::GenPath("backends/session"),
+                                                               Constants::GenInterface("backends"));
+            auto be_sesspath = be_client->GetProperty<DBus::Object::Path>(be_target,
+                                                                          "session_path");
+            if (be_sesspath != rec.session_path)
+            {
+                throw SessionManager::Exception("Backend session path mismatch ("
+                                                + be_sesspath + ")");
+            }
+
+            auto session = object_mgr->CreateObject<Session>(dbuscon,
+                                                             object_mgr,
+                                                             creds_qry,
+                                                             sesmgr_event,
+                                                             rec.session_path,
+                                                             rec.owner,
+                                                             rec.backend_busname,
+                                                             rec.backend_pid,
+                                                             rec.config_path,
+                                                             log->GetLogLevel(),
+                                                             logwr);
+            session->RestoreState(rec);
+            session->EnableJournal(journal);
+            ++adopted;
+
+            log->LogVerb1("Re-adopted running session - session-path=" + rec.session_path
+                          + " client-bus-name=" + rec.backend_busname
+                          + " client-pid=" + std::to_string(rec.backend_pid)
+                          + " config-name=" + rec.config_name);
+        }
+        catch (const DBus::Exception &excp)
+        {
+            log->LogWarn("Could not re-adopt session " + rec.session_path
+                         + " (client-bus-name=" + rec.backend_busname + "): "
+                         + std::string(excp.GetRawError()));
+            if (journal)
+            {
+                // A failing journal must not stop the remaining
+                // sessions from being adopted
+                try
+                {
+                    journal->Removed(rec.session_path);
+                }
+                catch (const std::exception &jexcp)
+                {
+                    log->LogError("Could not remove session " + rec.session_path
+                                  + " from the session journal: "
+                                  + std::string(jexcp.what()));
+                }
+            }
+        }
+    }
+    return adopted;
+}
+
+
+DBus::Proxy::Client::Ptr NewTunnelQueue::get_backendstart_proxy()
+{
+    std::lock_guard<std::mutex> guard(be_start_mtx);
+    if (be_start)
+    {
+        return be_start;
+    }
+
+    if (!be_prxqry->CheckServiceAvail(Constants::GenInterface("backends")))
+    {
+        throw DBus::Exception(__func__,
+                              "Could not connect to net.openvpn.v3.backends");
+    }
+    auto prx = DBus::Proxy::Client::Create(dbuscon,
+                                           Constants::GenServiceName("backends"));
+    auto be_qry = DBus::Proxy::Utils::Query::Create(prx);
+    (void)be_qry->CheckObjectExists(Constants::GenPath("backends"),
+                                    Constants::GenInterface("backends"));
+    be_start = prx;
+    return be_start;
+}
+
+
+void NewTunnelQueue::start_backend(const std::string &session_token,
+                                   TunnelRecord::Ptr trq) noexcept
+{
+    trq->timeline->End("spawner_queue");
+    try
+    {
+        auto prx = get_backendstart_proxy();
 
-        // The session path for this session is returned
-        return trq->session_path;
+        // The client_startup phase lasts until the RegistrationRequest
+        // signal from the new VPN client process arrives
+        trq->timeline->Begin("client_startup");
+        trq->timeline->Begin("backend_start");
+        GVariant *r = prx->Call(be_start_target,
+                                "StartClient",
+                                glib2::Value::CreateTupleWrapped(session_token));
+        g_variant_unref(r);
+        trq->timeline->End("backend_start");
+        return;
     }
     catch (const DBus::Exception &excp)
     {
         log->Debug("EXCEPTION [" + std::string(__func__) + "]: "
                    + std::string(excp.what()));
-        throw DBus::Exception(__func__,
-                              "Could not start the VPN client");
+
+        // The backendstart service might have been restarted; ensure
+        // a new proxy is prepared on the next attempt
+        std::lock_guard<std::mutex> guard(be_start_mtx);
+        be_start.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queue_mtx);
+        queue.erase(session_token);
+    }
+
+    try
+    {
+        log->LogError("Could not start the VPN client for "
+                      + trq->session_path + " (config " + trq->config_path + ")");
+        sesmgr_event->Send(trq->session_path,
+                           EventType::SESS_START_FAILED,
+                           trq->owner);
+    }
+    catch (const DBus::Exception &excp)
+    {
+        log->LogCritical("Could not send session start failure event: "
+                         + std::string(excp.GetRawError()));
     }
 }
 
@@ -127,7 +285,11 @@ void NewTunnelQueue::process_registration(DBus::Signals::Event::Ptr event)
         // Look up the session token from the signal in the list of
         // new tunnels.  This gives access to the tunnel details needed
         // to start the VPN tunnel
-        auto rec = queue.extract(sesstok);
+        QueuedTunnels::node_type rec;
+        {
+            std::lock_guard<std::mutex> guard(queue_mtx);
+            rec = queue.extract(sesstok);
+        }
         if (rec.empty())
         {
             log->LogCritical("Unknown session token recieved: " + sesstok);
@@ -135,6 +297,8 @@ void NewTunnelQueue::process_registration(DBus::Signals::Event::Ptr event)
         }
         // Get access to the TunnelRecord object
         auto tunnel = rec.mapped();
+        tunnel->timeline->End("client_startup");
+        tunnel->timeline->Begin("registration");
 
         // Create the session object which will be used to manage the
         // VPN session.  This is the bridge point betweeen the
@@ -193,10 +357,13 @@ void NewTunnelQueue::process_registration(DBus::Signals::Event::Ptr event)
             // The VPN client process responds with the configuration name
             // it has been requested to use
             auto config_name = glib2::Value::Extract<std::string>(reg, 0);
+            tunnel->timeline->End("registration");
 
             // Update the session object with the config name; this is
             // static for this session object after this point
             session->SetConfigName(config_name);
+            session->SetConnectTimeline(tunnel->timeline);
+            session->EnableJournal(journal);
             sesmgr_event->Send(tunnel->session_path,
                                EventType::SESS_CREATED,
                                tunnel->owner);
@@ -217,9 +384,9 @@ void NewTunnelQueue::process_registration(DBus::Signals::Event::Ptr event)
             object_mgr->RemoveObject(session->GetPath());
         }
 
-        // Clean up and remove the tracking in the tunnel queue
+        // The tunnel record was already removed from the tunnel queue
+        // when it was extracted
         tunnel.reset();
-        queue.erase(sesstok);
     }
     catch (const DBus::Exception &excp)
     {
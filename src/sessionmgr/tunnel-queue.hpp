@@ -19,14 +19,20 @@
 #pragma once
 #include <ctime>
 #include <map>
+#include <mutex>
 #include <gdbuspp/connection.hpp>
 #include <gdbuspp/credentials/query.hpp>
 #include <gdbuspp/object/manager.hpp>
 #include <gdbuspp/object/path.hpp>
+#include <gdbuspp/proxy.hpp>
+#include <gdbuspp/proxy/utils.hpp>
 
+#include "common/timeline.hpp"
+#include "common/worker-pool.hpp"
 #include "dbus/constants.hpp"
 #include "dbus/path.hpp"
 #include "sessionmgr-signals.hpp"
+#include "session-journal.hpp"
 
 
 namespace SessionManager {
@@ -51,6 +57,12 @@ struct TunnelRecord
     const DBus::Object::Path config_path;
     const uid_t owner;
 
+    /**
+     *  Time line of the session start-up, passed on to the
+     *  SessionManager::Session object once the backend has registered
+     */
+    const ConnectTimeline::Ptr timeline = ConnectTimeline::Create("sessionmgr");
+
   private:
     TunnelRecord(const DBus::Object::Path &cfgpath, const uid_t owner_uid);
 };
@@ -67,9 +79,12 @@ using QueuedTunnels = std::map<std::string, std::shared_ptr<TunnelRecord>>;
  *  the net.openvpn.v3.sessions.NewTunnel D-Bus method.
  *
  *  When a new tunnel is added to the queue, it wil call the
- *  net.openvpn.v3.backends.StartClient method (openvpn3-service-backendstart).
- *  This service will start an openvpn3-service-client process (the VPN client)
- *  which will send a "RegistrationRequest" signal to this SessionManager
+ *  net.openvpn.v3.backends.StartClient method (openvpn3-service-backendstart)
+ *  in a background thread.  This service will start an
+ *  openvpn3-service-client process (the VPN client) which will send a
+ *  "RegistrationRequest" signal to this SessionManager.  If the
+ *  StartClient call fails, a SessionManagerEvent signal with the
+ *  SESS_START_FAILED event type is sent.
  *
  *  This object will listen for the "RegistrationRequest" signals and will
  *  create the Session object and complete the registration.  This establishes
@@ -81,12 +96,20 @@ class NewTunnelQueue
   public:
     using Ptr = std::shared_ptr<NewTunnelQueue>;
 
+    /**
+     *  Number of parallel StartClient calls to the backendstart service
+     *  and the maximum number of tunnels waiting to be started
+     */
+    static constexpr unsigned int SPAWNER_THREADS = 4;
+    static constexpr size_t SPAWNER_QUEUE = 256;
+
     [[nodiscard]] static NewTunnelQueue::Ptr Create(DBus::Connection::Ptr dbuscon,
                                                     DBus::Credentials::Query::Ptr creds_qry,
                                                     DBus::Object::Manager::Ptr objmgr,
                                                     LogWriter::Ptr logwr,
                                                     SessionManager::Log::Ptr sig_log,
-                                                    ::Signals::SessionManagerEvent::Ptr sesmgrev);
+                                                    ::Signals::SessionManagerEvent::Ptr sesmgrev,
+                                                    SessionJournal::Ptr journal = nullptr);
 
     /**
      *  Enqueues a new tunnel request to the queue
@@ -97,6 +120,7 @@ class NewTunnelQueue
      *
      *  NOTE: The returned D-Bus path will not be available (visible) before
      *        the client process has registered itself with this service.
+     *        This method does not wait for the client process to be started.
      *
      * @param config_path         std::string with the D-Bus configuration path
      * @param owner               uid_t of the owner of the session
@@ -105,6 +129,22 @@ class NewTunnelQueue
     const DBus::Object::Path AddTunnel(const std::string &config_path,
                                        const uid_t owner);
 
+    /**
+     *  Re-creates the SessionManager::Session objects for backend VPN
+     *  client processes which are still running, based on the records
+     *  found in the session journal.  This is used when the Session
+     *  Manager has been restarted while VPN sessions were running.
+     *
+     *  Each record is validated by checking that the backend bus name is
+     *  still owned by the same process ID and that the backend client
+     *  reports the same session path.  Records which cannot be validated
+     *  are removed from the journal.
+     *
+     * @param records   JournalRecords with the sessions to re-adopt
+     * @return size_t   Number of sessions successfully re-adopted
+     */
+    size_t AdoptSessions(const JournalRecords &records);
+
   private:
     DBus::Connection::Ptr dbuscon = nullptr;
     DBus::Credentials::Query::Ptr creds_qry = nullptr;
@@ -112,11 +152,26 @@ class NewTunnelQueue
     LogWriter::Ptr logwr = nullptr;
     SessionManager::Log::Ptr log = nullptr;
     ::Signals::SessionManagerEvent::Ptr sesmgr_event = nullptr;
+    SessionJournal::Ptr journal = nullptr;
     DBus::Proxy::Utils::DBusServiceQuery::Ptr be_prxqry = nullptr;
+    DBus::Proxy::Client::Ptr be_start = nullptr;
+    DBus::Proxy::TargetPreset::Ptr be_start_target = nullptr;
+    std::mutex be_start_mtx{};
     DBus::Signals::SubscriptionManager::Ptr signal_subscr = nullptr;
     DBus::Signals::Target::Ptr subscr_target = nullptr;
     QueuedTunnels queue{};
 
+    /**
+     *  Protects the tunnel queue; NewTunnel and the StartClient calls may
+     *  be processed in worker threads while the RegistrationRequest signals
+     *  are processed in the main loop thread
+     */
+    std::mutex queue_mtx{};
+
+    // Must be the last member, so the worker threads are stopped
+    // before anything they use is destroyed
+    WorkerPool::Ptr spawner = nullptr;
+
     /**
      *  Callback function triggered when the backend VPN client
      *  (openvpn3-service-client) sends the RegistrationRequest signal.
@@ -133,13 +188,38 @@ class NewTunnelQueue
      */
     void process_registration(DBus::Signals::Event::Ptr event);
 
+    /**
+     *  Retrieve the proxy to the net.openvpn.v3.backends service
+     *  (openvpn3-service-backendstart).  The proxy is created on the first
+     *  call and reused by later calls.
+     *
+     * @return DBus::Proxy::Client::Ptr
+     * @throws DBus::Exception if the service is not available
+     */
+    DBus::Proxy::Client::Ptr get_backendstart_proxy();
+
+    /**
+     *  Calls the net.openvpn.v3.backends.StartClient method to start
+     *  the backend VPN client process for a queued tunnel.  This runs in
+     *  the spawner worker pool.
+     *
+     *  On failure, the tunnel is removed from the queue and a
+     *  SessionManagerEvent::SESS_START_FAILED signal is sent.
+     *
+     * @param session_token   std::string with the session token of the tunnel
+     * @param trq             TunnelRecord::Ptr with the tunnel details
+     */
+    void start_backend(const std::string &session_token,
+                       TunnelRecord::Ptr trq) noexcept;
+
 
     NewTunnelQueue(DBus::Connection::Ptr dbuscon,
                    DBus::Credentials::Query::Ptr creds_qry,
                    DBus::Object::Manager::Ptr objmgr,
                    LogWriter::Ptr logwr,
                    SessionManager::Log::Ptr sig_log,
-                   ::Signals::SessionManagerEvent::Ptr sesmgrev);
+                   ::Signals::SessionManagerEvent::Ptr sesmgrev,
+                   SessionJournal::Ptr journal);
 };
 
 } // namespace SessionManager
@@ -0,0 +1,213 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+#pragma once
+
+/**
+ * @file   benchmark-utils.hpp
+ *
+ * @brief  Helpers shared by the micro-benchmark programs, collecting
+ *         the results and reporting them either as a table or as JSON
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+
+namespace Benchmark {
+
+/**
+ *  std::streambuf implementation discarding everything written to it
+ */
+class NullBuffer : public std::streambuf
+{
+  protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        return n;
+    }
+};
+
+
+/**
+ *  Runs benchmarks and collects the results.  The results are written
+ *  as a table when each benchmark completes, or as a single JSON
+ *  document by Finish() if JSON output is enabled.
+ *
+ *  If an allocation counter is provided, the number of allocations
+ *  per event is reported as well.
+ */
+class Runner
+{
+  public:
+    using AllocCounter = std::function<uint64_t()>;
+
+    Runner(const std::string &suite_name,
+           const bool json_output,
+           AllocCounter alloc_counter = nullptr)
+        : json(json_output), allocs(std::move(alloc_counter))
+    {
+        report["suite"] = suite_name;
+        report["results"] = Json::Value(Json::arrayValue);
+    }
+
+
+    /**
+     *  Runs a benchmark and records the number of events per second
+     *
+     * @param name    std::string with the benchmark name
+     * @param events  uint64_t with the number of events to process
+     * @param func    Function processing a single event
+     */
+    void Run(const std::string &name,
+             const uint64_t events,
+             std::function<void()> func)
+    {
+        uint64_t allocs_start = (allocs ? allocs() : 0);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < events; ++i)
+        {
+            func();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t allocs_used = (allocs ? allocs() - allocs_start : 0);
+        Record(name, events, elapsed.count(), allocs_used);
+    }
+
+
+    /**
+     *  Runs a benchmark timing each event separately, and records the
+     *  median and 99th percentile latency in addition to the number
+     *  of events per second
+     *
+     * @param name    std::string with the benchmark name
+     * @param events  uint64_t with the number of events to process
+     * @param func    Function processing a single event
+     */
+    void RunLatency(const std::string &name,
+                    const uint64_t events,
+                    std::function<void()> func)
+    {
+        std::vector<double> latency;
+        latency.reserve(events);
+        uint64_t allocs_start = (allocs ? allocs() : 0);
+        double total = 0;
+        for (uint64_t i = 0; i < events; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            latency.push_back(elapsed.count() * 1e6);
+            total += elapsed.count();
+        }
+        uint64_t allocs_used = (allocs ? allocs() - allocs_start : 0);
+        std::sort(latency.begin(), latency.end());
+
+        Json::Value r = create_result(name, events, total, allocs_used);
+        r["p50_usec"] = latency[events / 2];
+        r["p99_usec"] = latency[events * 99 / 100];
+        add_result(r);
+    }
+
+
+    /**
+     *  Records the result of a benchmark which was timed by the caller
+     *
+     * @param name         std::string with the benchmark name
+     * @param events       uint64_t with the number of events processed
+     * @param seconds      double with the time used, in seconds
+     * @param allocations  uint64_t with the number of allocations done,
+     *                     only reported if an allocation counter is used
+     */
+    void Record(const std::string &name,
+                const uint64_t events,
+                const double seconds,
+                const uint64_t allocations = 0)
+    {
+        add_result(create_result(name, events, seconds, allocations));
+    }
+
+
+    /**
+     *  Writes the JSON report, if enabled
+     */
+    void Finish()
+    {
+        if (json)
+        {
+            std::cout << report << std::endl;
+        }
+    }
+
+  private:
+    const bool json;
+    AllocCounter allocs = nullptr;
+    Json::Value report;
+
+
+    Json::Value create_result(const std::string &name,
+                              const uint64_t events,
+                              const double seconds,
+                              const uint64_t allocations) const
+    {
+        Json::Value r;
+        r["name"] = name;
+        r["events"] = static_cast<Json::UInt64>(events);
+        r["seconds"] = seconds;
+        r["events_per_sec"] = events / seconds;
+        r["ns_per_event"] = seconds * 1e9 / events;
+        if (allocs)
+        {
+            r["allocs_per_event"] = static_cast<double>(allocations) / events;
+        }
+        return r;
+    }
+
+
+    void add_result(const Json::Value &r)
+    {
+        report["results"].append(r);
+
+        if (json)
+        {
+            return;
+        }
+        std::cout << std::left << std::setw(40) << r["name"].asString()
+                  << std::right << std::setw(12)
+                  << static_cast<uint64_t>(r["events_per_sec"].asDouble())
+                  << " events/s  "
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << r["ns_per_event"].asDouble() << " ns/event";
+        if (allocs)
+        {
+            std::cout << std::setw(8) << r["allocs_per_event"].asDouble()
+                      << " allocs/event";
+        }
+        if (r.isMember("p50_usec"))
+        {
+            std::cout << "  p50: " << std::setw(9) << r["p50_usec"].asDouble() << " us"
+                      << "  p99: " << std::setw(9) << r["p99_usec"].asDouble() << " us";
+        }
+        std::cout << std::endl;
+    }
+};
+
+} // namespace Benchmark
@@ -0,0 +1,175 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   cli-startup.cpp
+ *
+ * @brief  Benchmark of the start-up time of the openvpn3 command line
+ *         tool.  The 'version' command does not use D-Bus, so this
+ *         measures the cost of starting the program and preparing the
+ *         command.  The same command is also run repeatedly in the
+ *         --batch mode, which shows the cost per command without the
+ *         process start-up.
+ *
+ *         If --max-ms is given, the program fails if a single invocation
+ *         takes longer than this on average.
+ *
+ *         Usage: cli-startup [--json] [--max-ms MS] OPENVPN3-BIN [RUNS]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "benchmark-utils.hpp"
+
+
+/**
+ *  Runs the openvpn3 program and waits for it to complete.  The output
+ *  is discarded.
+ *
+ * @param binary  std::string with the path to the program
+ * @param arg     std::string with the single argument to give
+ * @param input   std::string to write to stdin of the program; if
+ *                empty, stdin is not redirected
+ * @return bool   true if the program exited successfully
+ */
+static bool run_program(const std::string &binary,
+                        const std::string &arg,
+                        const std::string &input = {})
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    int pipefd[2] = {-1, -1};
+    if (!input.empty())
+    {
+        if (pipe(pipefd) < 0)
+        {
+            posix_spawn_file_actions_destroy(&actions);
+            return false;
+        }
+        posix_spawn_file_actions_adddup2(&actions, pipefd[0], STDIN_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipefd[1]);
+    }
+
+    std::string argv0 = binary;
+    std::string argv1 = arg;
+    char *argv[] = {argv0.data(), argv1.data(), nullptr};
+    pid_t pid = -1;
+    int r = posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (!input.empty())
+    {
+        close(pipefd[0]);
+        const char *p = input.data();
+        size_t left = input.size();
+        while (0 == r && left > 0)
+        {
+            ssize_t w = write(pipefd[1], p, left);
+            if (w <= 0)
+            {
+                break;
+            }
+            p += w;
+            left -= w;
+        }
+        close(pipefd[1]);
+    }
+    if (0 != r)
+    {
+        std::cerr << "Could not start " << binary << ": " << strerror(r) << std::endl;
+        return false;
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && 0 == WEXITSTATUS(status);
+}
+
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    double max_ms = 0.0;
+    std::string binary;
+    uint64_t runs = 100;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ("--json" == arg)
+        {
+            json = true;
+        }
+        else if ("--max-ms" == arg && i + 1 < argc)
+        {
+            max_ms = std::strtod(argv[++i], nullptr);
+        }
+        else if (binary.empty())
+        {
+            binary = arg;
+        }
+        else if (0 == (runs = std::strtoull(argv[i], nullptr, 10)))
+        {
+            binary.clear();
+            break;
+        }
+    }
+    if (binary.empty())
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--json] [--max-ms MS] OPENVPN3-BIN [RUNS]" << std::endl;
+        return 1;
+    }
+
+    Benchmark::Runner bench("cli-startup", json);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < runs; ++i)
+    {
+        if (!run_program(binary, "version"))
+        {
+            std::cerr << "openvpn3 version failed" << std::endl;
+            return 1;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double invocation_ms = elapsed.count() * 1000 / runs;
+    bench.Record("openvpn3.version.invocation", runs, elapsed.count());
+
+    std::string batch;
+    for (uint64_t i = 0; i < runs; ++i)
+    {
+        batch += "version\n";
+    }
+    start = std::chrono::steady_clock::now();
+    if (!run_program(binary, "--batch", batch))
+    {
+        std::cerr << "openvpn3 --batch failed" << std::endl;
+        return 1;
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    bench.Record("openvpn3.version.batch", runs, elapsed.count());
+    bench.Finish();
+
+    if (max_ms > 0 && invocation_ms > max_ms)
+    {
+        std::cerr << "openvpn3 start-up time regression: " << invocation_ms
+                  << " ms per invocation, limit is " << max_ms << " ms" << std::endl;
+        return 1;
+    }
+    return 0;
+}
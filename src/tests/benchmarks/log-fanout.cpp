@@ -0,0 +1,266 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   log-fanout.cpp
+ *
+ * @brief  Benchmark of the log service forwarding Log signals from an
+ *         attached service to a varying number of log proxies.
+ *
+ *         An AttachedService object is set up like the log service does
+ *         in the Attach() method, receiving the Log signals sent over a
+ *         second D-Bus connection.  The rate is measured from sending
+ *         the first Log signal until all the events have been written
+ *         by the log writer of the service, which includes the D-Bus
+ *         signal round trip.  The difference between the proxy counts
+ *         is the cost of the fan-out.
+ *
+ *         This requires a D-Bus session bus; the benchmark is skipped
+ *         if it is not available.
+ *
+ *         Usage: log-fanout [--json] [EVENTS]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <gdbuspp/connection.hpp>
+#include <gdbuspp/mainloop.hpp>
+#include <gdbuspp/object/manager.hpp>
+#include <gdbuspp/signals/group.hpp>
+#include <gdbuspp/signals/subscriptionmgr.hpp>
+
+#include "dbus/signals/log.hpp"
+#include "log/log-service.hpp"
+#include "log/logwriters/streamwriter.hpp"
+#include "benchmark-utils.hpp"
+
+
+/**
+ *  Counts the log lines written to it, discarding the data
+ */
+class LineCounter : public std::streambuf
+{
+  public:
+    /**
+     *  Wait until a certain number of lines has been written
+     *
+     * @param lines    uint64_t with the number of lines to wait for
+     * @return bool    false if the lines did not arrive within 10 seconds
+     */
+    bool WaitFor(const uint64_t lines)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock,
+                           std::chrono::seconds(10),
+                           [&]()
+                           {
+                               return count >= lines;
+                           });
+    }
+
+    /**
+     *  Retrieve the number of lines written so far
+     *
+     * @return uint64_t
+     */
+    uint64_t Lines()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        return count;
+    }
+
+  protected:
+    int overflow(int c) override
+    {
+        if ('\n' == c)
+        {
+            add_line();
+        }
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        for (std::streamsize i = 0; i < n; ++i)
+        {
+            if ('\n' == s[i])
+            {
+                add_line();
+            }
+        }
+        return n;
+    }
+
+  private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    uint64_t count = 0;
+
+    void add_line()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            ++count;
+        }
+        cv.notify_all();
+    }
+};
+
+
+/**
+ *  Sends Log signals to the log service connection, like a VPN
+ *  backend process does
+ */
+class SourceSignals : public DBus::Signals::Group
+{
+  public:
+    using Ptr = std::shared_ptr<SourceSignals>;
+
+    SourceSignals(DBus::Connection::Ptr conn,
+                  const DBus::Object::Path &path,
+                  const std::string &interf)
+        : DBus::Signals::Group(conn, path, interf)
+    {
+        log = CreateSignal<Signals::Log>();
+    }
+
+    void SendLog(const Events::Log &logev) const
+    {
+        log->Send(logev);
+    }
+
+  private:
+    Signals::Log::Ptr log = nullptr;
+};
+
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    uint64_t events = 20000;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ("--json" == arg)
+        {
+            json = true;
+        }
+        else if (0 == (events = std::strtoull(argv[i], nullptr, 10)))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json] [EVENTS]" << std::endl;
+            return 1;
+        }
+    }
+
+    DBus::Connection::Ptr svc_conn = nullptr;
+    DBus::Connection::Ptr src_conn = nullptr;
+    try
+    {
+        svc_conn = DBus::Connection::Create(DBus::BusType::SESSION);
+        src_conn = DBus::Connection::Create(DBus::BusType::SESSION);
+    }
+    catch (const DBus::Exception &excp)
+    {
+        std::cerr << "D-Bus session bus not available; skipping: "
+                  << excp.GetRawError() << std::endl;
+        return 77;
+    }
+
+    auto mainloop = DBus::MainLoop::Create();
+    std::thread mainloop_thread(
+        [mainloop]()
+        {
+            mainloop->Run();
+        });
+
+    const std::string interface = "net.openvpn.v3.backends";
+    const DBus::Object::Path session_path = "/net/openvpn/v3/backends/session";
+    const std::string src_busname = src_conn->GetUniqueBusName();
+
+    LineCounter counter;
+    std::ostream logstream(&counter);
+    auto writer = std::make_shared<StreamLogWriter>(logstream);
+    writer->EnableTimestamp(false);
+    writer->EnableLogMeta(false);
+    auto logger = LogService::Logger::Create(writer,
+                                             LogGroup::LOGGER,
+                                             Log::EventFilter::Create(6));
+
+    auto object_mgr = DBus::Object::Manager::Create(svc_conn);
+    auto submgr = DBus::Signals::SubscriptionManager::Create(svc_conn);
+    auto attached = LogService::AttachedService::Create(svc_conn,
+                                                        object_mgr,
+                                                        logger,
+                                                        submgr,
+                                                        LogTag::Create(src_busname, interface),
+                                                        src_busname,
+                                                        interface);
+
+    auto source = DBus::Signals::Group::Create<SourceSignals>(src_conn,
+                                                              session_path,
+                                                              interface);
+    source->AddTarget(svc_conn->GetUniqueBusName());
+
+    Benchmark::Runner bench("log-fanout", json);
+    Events::Log ev(LogGroup::CLIENT,
+                   LogCategory::INFO,
+                   "Connected via UDPv4 to 192.0.2.1:1194");
+
+    // Keep a limited number of signals in flight, to avoid the bus
+    // daemon disconnecting the receiver for queuing too much data
+    const uint64_t window = 500;
+    size_t proxy_count = 0;
+    int ret = 0;
+    for (size_t proxies : {0, 1, 4, 16, 64})
+    {
+        for (; proxy_count < proxies; ++proxy_count)
+        {
+            // The proxied Log signals are sent back to the source
+            // connection, which ignores them
+            attached->AddProxyTarget(src_busname, session_path);
+        }
+
+        // Setting up the proxies logs a line each; only count the
+        // log lines written after that
+        uint64_t written = counter.Lines();
+        auto start = std::chrono::steady_clock::now();
+        bool complete = true;
+        for (uint64_t sent = 0; sent < events && complete; sent += window)
+        {
+            const uint64_t batch = std::min(window, events - sent);
+            for (uint64_t i = 0; i < batch; ++i)
+            {
+                source->SendLog(ev);
+            }
+            written += batch;
+            complete = counter.WaitFor(written);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (!complete)
+        {
+            std::cerr << "Timed out waiting for log events with "
+                      << proxies << " proxies" << std::endl;
+            ret = 2;
+            break;
+        }
+        bench.Record("attached_service.fanout." + std::to_string(proxies) + "_proxies",
+                     events,
+                     elapsed.count());
+    }
+    bench.Finish();
+
+    mainloop->Stop();
+    mainloop_thread.join();
+    return ret;
+}
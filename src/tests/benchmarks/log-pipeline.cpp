@@ -0,0 +1,371 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   log-pipeline.cpp
+ *
+ * @brief  Micro-benchmarks of the log pipeline building blocks which
+ *         does not depend on D-Bus: the Events::Log and Events::Status
+ *         GVariant round trips, the LogWriter implementations and the
+ *         log event filtering.
+ *
+ *         The allocations per event are counted by wrapping the libc
+ *         malloc() functions, which covers both the C++ and glib
+ *         allocations.
+ *
+ *         The SyslogWriter and JournaldWriter send the log events to the
+ *         system logging services, so these are only benchmarked when
+ *         --system-log is given.  The RFC5424SyslogWriter is benchmarked
+ *         against a private syslog socket.
+ *
+ *         Usage: log-pipeline [--json] [--system-log] [EVENTS]
+ */
+
+#include "build-config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "events/log.hpp"
+#include "events/status.hpp"
+#include "log/ansicolours.hpp"
+#include "log/logfilter.hpp"
+#include "log/logmetadata.hpp"
+#include "log/logtag.hpp"
+#include "log/logwriters/implementations.hpp"
+#include "benchmark-utils.hpp"
+
+
+//
+//  Allocation counting.  These wrappers replace the libc functions for
+//  the whole program and forward to the glibc implementation.
+//
+static std::atomic<uint64_t> alloc_count{0};
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+
+
+
+/**
+ *  A syslog socket in a temporary directory, discarding everything
+ *  received.  Used as the destination for the RFC5424SyslogWriter.
+ */
+class TestSyslogSocket
+{
+  public:
+    TestSyslogSocket()
+    {
+        char tmpl[] = "/tmp/log-pipeline-XXXXXX";
+        if (!mkdtemp(tmpl))
+        {
+            throw std::runtime_error("Could not create temporary directory");
+        }
+        dir = tmpl;
+        path = dir + "/log";
+
+        fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (fd < 0
+            || bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            throw std::runtime_error("Could not create syslog test socket: "
+                                     + std::string(strerror(errno)));
+        }
+
+        receiver = std::thread(
+            [this]()
+            {
+                char buf[8192];
+                struct pollfd pfd = {fd, POLLIN, 0};
+                while (!stop)
+                {
+                    if (poll(&pfd, 1, 100) > 0)
+                    {
+                        while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+                        {
+                            ++received;
+                        }
+                    }
+                }
+            });
+    }
+
+    ~TestSyslogSocket()
+    {
+        stop = true;
+        receiver.join();
+        close(fd);
+        unlink(path.c_str());
+        rmdir(dir.c_str());
+    }
+
+    std::string path;
+    std::atomic<uint64_t> received{0};
+
+  private:
+    std::string dir;
+    int fd = -1;
+    std::atomic<bool> stop{false};
+    std::thread receiver;
+};
+
+
+
+/**
+ *  Runs the plain, LogTag and LogTag + meta data variants of the
+ *  LogWriter benchmark
+ *
+ * @param bench   Benchmark::Runner collecting the results
+ * @param name    std::string with the LogWriter name
+ * @param events  uint64_t with the number of events per benchmark
+ * @param writer  LogWriter to benchmark
+ */
+static void run_logwriter(Benchmark::Runner &bench,
+                          const std::string &name,
+                          const uint64_t events,
+                          LogWriter &writer)
+{
+    Events::Log ev(LogGroup::CLIENT,
+                   LogCategory::INFO,
+                   "Connected via UDPv4 to 192.0.2.1:1194");
+    Events::Log ev_tagged(ev);
+    ev_tagged.AddLogTag(LogTag::Create(":1.42", "net.openvpn.v3.backends"));
+
+    auto meta = LogMetaData::Create();
+    meta->AddMeta("sender", ":1.42");
+    meta->AddMeta("object_path", "/net/openvpn/v3/sessions/be0123456789abcdef");
+    meta->AddMeta("interface", "net.openvpn.v3.backends");
+    auto rendered = RenderedLogMetaData::Create(meta);
+
+    writer.EnableTimestamp(false);
+    writer.EnableLogMeta(false);
+    bench.Run("logwriter." + name,
+              events,
+              [&]()
+              {
+                  writer.Write(ev);
+              });
+    bench.Run("logwriter." + name + ".logtag",
+              events,
+              [&]()
+              {
+                  writer.Write(ev_tagged);
+              });
+
+    writer.EnableLogMeta(true);
+    bench.Run("logwriter." + name + ".logtag+meta",
+              events,
+              [&]()
+              {
+                  writer.AddMetaRendered(rendered);
+                  writer.Write(ev_tagged);
+              });
+}
+
+
+static void run_event_roundtrips(Benchmark::Runner &bench, const uint64_t events)
+{
+    Events::Log logev(LogGroup::CLIENT,
+                      LogCategory::INFO,
+                      "be0123456789abcdef",
+                      "Connected via UDPv4 to 192.0.2.1:1194");
+    bench.Run("events.log.tuple_roundtrip",
+              events,
+              [&]()
+              {
+                  GVariant *v = logev.GetGVariantTuple();
+                  Events::Log parsed(v);
+                  g_variant_unref(v);
+              });
+    bench.Run("events.log.dict_roundtrip",
+              events,
+              [&]()
+              {
+                  GVariant *v = logev.GetGVariantDict();
+                  Events::Log parsed(v);
+                  g_variant_unref(v);
+              });
+
+    Events::Status status(StatusMajor::CONNECTION,
+                          StatusMinor::CONN_CONNECTED,
+                          "Connected");
+    bench.Run("events.status.tuple_roundtrip",
+              events,
+              [&]()
+              {
+                  GVariant *v = status.GetGVariantTuple();
+                  Events::Status parsed(v);
+                  g_variant_unref(v);
+              });
+    bench.Run("events.status.dict_roundtrip",
+              events,
+              [&]()
+              {
+                  GVariant *v = status.GetGVariantDict();
+                  Events::Status parsed(v);
+                  g_variant_unref(v);
+              });
+}
+
+
+static void run_eventfilter(Benchmark::Runner &bench, const uint64_t events)
+{
+    // Alternate between allowed and filtered categories
+    std::vector<Events::Log> logevs;
+    for (auto ctg : {LogCategory::DEBUG, LogCategory::INFO, LogCategory::VERB2, LogCategory::ERROR})
+    {
+        logevs.emplace_back(LogGroup::CLIENT, ctg, "Log filter test");
+    }
+
+    auto filter = Log::EventFilter::Create(3);
+    size_t idx = 0;
+    uint64_t allowed = 0;
+    bench.Run("eventfilter.allow",
+              events,
+              [&]()
+              {
+                  allowed += filter->Allow(logevs[idx++ & 3]);
+              });
+
+    bench.Run("eventfilter.allow_path.no_filter",
+              events,
+              [&]()
+              {
+                  allowed += filter->AllowPath("/net/openvpn/v3/sessions/be0123456789abcdef");
+              });
+    for (int i = 0; i < 8; ++i)
+    {
+        filter->AddPathFilter("/net/openvpn/v3/sessions/be" + std::to_string(i));
+    }
+    bench.Run("eventfilter.allow_path.8_paths",
+              events,
+              [&]()
+              {
+                  allowed += filter->AllowPath("/net/openvpn/v3/sessions/be0123456789abcdef");
+              });
+
+    // Ensure the filter calls are not optimized away
+    if (0 == allowed)
+    {
+        std::cerr << "No log events allowed by the filter" << std::endl;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    bool system_log = false;
+    uint64_t events = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ("--json" == arg)
+        {
+            json = true;
+        }
+        else if ("--system-log" == arg)
+        {
+            system_log = true;
+        }
+        else if (0 == (events = std::strtoull(argv[i], nullptr, 10)))
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json] [--system-log] [EVENTS]" << std::endl;
+            return 1;
+        }
+    }
+
+    Benchmark::Runner bench("log-pipeline",
+                            json,
+                            []()
+                            {
+                                return alloc_count.load(std::memory_order_relaxed);
+                            });
+
+    run_event_roundtrips(bench, events);
+    run_eventfilter(bench, events);
+
+    Benchmark::NullBuffer nullbuf;
+    std::ostream nullstream(&nullbuf);
+    {
+        StreamLogWriter writer(nullstream);
+        run_logwriter(bench, "stream", events, writer);
+    }
+    {
+        ANSIColours colours;
+        ColourStreamWriter writer(nullstream, &colours);
+        run_logwriter(bench, "colour", events, writer);
+    }
+
+    try
+    {
+        // The writer enqueues the messages for a background thread;
+        // messages are dropped if the queue is full, so this measures
+        // the cost added to the caller
+        TestSyslogSocket sock;
+        RFC5424SyslogWriter writer("log-pipeline", LOG_DAEMON, sock.path);
+        run_logwriter(bench, "rfc5424", events, writer);
+    }
+    catch (const std::exception &excp)
+    {
+        std::cerr << "Skipping RFC5424SyslogWriter: " << excp.what() << std::endl;
+    }
+
+    if (system_log)
+    {
+        // Limit the amount of messages sent to the system logs
+        const uint64_t sys_events = std::min<uint64_t>(events, 10000);
+        SyslogWriter syslog_writer("log-pipeline", LOG_USER);
+        run_logwriter(bench, "syslog", sys_events, syslog_writer);
+#ifdef HAVE_SYSTEMD
+        JournaldWriter journal_writer("log-pipeline");
+        run_logwriter(bench, "journald", sys_events, journal_writer);
+#endif
+    }
+
+    bench.Finish();
+    return 0;
+}
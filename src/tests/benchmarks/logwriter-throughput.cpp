@@ -0,0 +1,104 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   logwriter-throughput.cpp
+ *
+ * @brief  Micro-benchmark of the LogWriter throughput with LogTags
+ *         enabled.  The log lines are written to a stream discarding
+ *         all data, so only the formatting cost is measured.
+ *
+ *         Usage: logwriter-throughput [--json] [EVENTS]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "events/log.hpp"
+#include "log/logmetadata.hpp"
+#include "log/logtag.hpp"
+#include "log/logwriters/streamwriter.hpp"
+
+#include "benchmark-utils.hpp"
+
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    uint64_t events = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ("--json" == arg)
+        {
+            json = true;
+        }
+        else if (0 == (events = std::strtoull(argv[i], nullptr, 10)))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json] [EVENTS]" << std::endl;
+            return 1;
+        }
+    }
+
+    Benchmark::NullBuffer nullbuf;
+    std::ostream nullstream(&nullbuf);
+    StreamLogWriter writer(nullstream);
+    writer.EnableTimestamp(false);
+
+    auto tag = LogTag::Create(":1.42", "net.openvpn.v3.backends");
+    Events::Log ev(LogGroup::CLIENT,
+                   LogCategory::INFO,
+                   "Connected via UDPv4 to 192.0.2.1:1194");
+    ev.AddLogTag(tag);
+
+    auto meta = LogMetaData::Create();
+    meta->AddMeta("sender", ":1.42");
+    meta->AddMeta("object_path", "/net/openvpn/v3/sessions/be0123456789abcdef");
+    meta->AddMeta("interface", "net.openvpn.v3.backends");
+    auto rendered = RenderedLogMetaData::Create(meta);
+
+    Benchmark::Runner bench("logwriter-throughput", json);
+
+    writer.EnableLogMeta(false);
+    bench.Run("logtag",
+              events,
+              [&]()
+              {
+                  writer.Write(ev);
+              });
+
+    writer.EnableLogMeta(true);
+    bench.Run("logtag + meta data copy",
+              events,
+              [&]()
+              {
+                  writer.AddMetaCopy(meta);
+                  writer.Write(ev);
+              });
+
+    bench.Run("logtag + rendered meta data",
+              events,
+              [&]()
+              {
+                  writer.AddMetaRendered(rendered);
+                  writer.Write(ev);
+              });
+
+    writer.EnableMessagePrepend(false);
+    bench.Run("rendered meta data, no prefix",
+              events,
+              [&]()
+              {
+                  writer.AddMetaRendered(rendered);
+                  writer.Write(ev);
+              });
+    bench.Finish();
+
+    return 0;
+}
@@ -22,8 +22,9 @@
 #  in the output.
 #
 #  Once the NewTunnel() method have been called, a session path is returned.
-#  At that point, it is also possible to introspect that object path in the
-#  the same net.openvpn.v3.sessions service (destination).
+#  When the backend VPN client has registered the session, it is also
+#  possible to introspect that object path in the the same
+#  net.openvpn.v3.sessions service (destination).
 #
 
 import sys
@@ -49,7 +50,12 @@ sessmgr_interface = dbus.Interface(manager_object,
 # Prepare the tunnel (type casting string to D-Bus objet path variable)
 session_path = sessmgr_interface.NewTunnel(dbus.ObjectPath(sys.argv[1]))
 print("Session path: " + session_path)
-time.sleep(1) # Wait for things to settle down
+
+# Wait for the backend VPN client to register the session
+for i in range(100):
+    if session_path in sessmgr_interface.FetchAvailableSessions():
+        break
+    time.sleep(0.1)
 
 # Get access to the session object
 session_object = bus.get_object('net.openvpn.v3.sessions', session_path)
@@ -0,0 +1,473 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   fake-backend.cpp
+ *
+ * @brief  Synthetic VPN client backend, implementing the
+ *         net.openvpn.v3.backends interface without connecting to any
+ *         VPN server.  This is a drop-in replacement for
+ *         openvpn3-service-client, used by the loadgen test program.
+ *
+ *         Start openvpn3-service-backendstart (debug build) with
+ *         --client-binary pointing at this program.  The behaviour is
+ *         controlled via environment variables, which can be set with
+ *         the --client-setenv option:
+ *
+ *           FAKE_BACKEND_LOG_RATE          Log events per second sent
+ *                                          while connected (default: 10)
+ *           FAKE_BACKEND_CONNECT_DELAY_MS  Time from Connect() until
+ *                                          CONN_CONNECTED (default: 0)
+ */
+
+#include "build-config.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <glib.h>
+#include <gdbuspp/connection.hpp>
+#include <gdbuspp/object/base.hpp>
+#include <gdbuspp/service.hpp>
+
+#include "client/backend-signals.hpp"
+#include "common/cmdargparser.hpp"
+#include "common/timeline.hpp"
+#include "common/utils.hpp"
+#include "dbus/constants.hpp"
+#include "log/proxy-log.hpp"
+
+
+/**
+ *  Reads an unsigned integer environment variable
+ *
+ * @param name  const char * with the variable name
+ * @param dflt  unsigned int default value, if not set
+ * @return unsigned int
+ */
+static unsigned int env_uint(const char *name, const unsigned int dflt)
+{
+    const char *v = std::getenv(name);
+    return (v && *v ? static_cast<unsigned int>(std::strtoul(v, nullptr, 10)) : dflt);
+}
+
+
+
+/**
+ *  The net.openvpn.v3.backends object of a single synthetic VPN session
+ */
+class FakeBackendObject : public DBus::Object::Base
+{
+  public:
+    using Ptr = std::shared_ptr<FakeBackendObject>;
+
+    FakeBackendObject(DBus::Connection::Ptr conn,
+                      const std::string &bus_name,
+                      const std::string &session_token_,
+                      const uint32_t log_level)
+        : DBus::Object::Base(Constants::GenPath("backends/session"),
+                             Constants::GenInterface("backends")),
+          session_token(session_token_),
+          log_rate(env_uint("FAKE_BACKEND_LOG_RATE", 10)),
+          connect_delay_ms(env_uint("FAKE_BACKEND_CONNECT_DELAY_MS", 0))
+    {
+        signal = DBus::Signals::Group::Create<BackendSignals>(conn,
+                                                              LogGroup::CLIENT,
+                                                              session_token,
+                                                              nullptr);
+        RegisterSignals(signal);
+        signal->SetLogLevel(log_level);
+        timeline = ConnectTimeline::Create("client");
+
+        auto regconf = AddMethod("RegistrationConfirmation",
+                                 [this](DBus::Object::Method::Arguments::Ptr args)
+                                 {
+                                     GVariant *params = args->GetMethodParameters();
+                                     glib2::Utils::checkParams(__func__, params, "(soo)");
+                                     if (session_token != glib2::Value::Extract<std::string>(params, 0))
+                                     {
+                                         throw DBus::Object::Method::Exception("Invalid session token");
+                                     }
+                                     session_path = glib2::Value::Extract<DBus::Object::Path>(params, 1);
+                                     args->SetMethodReturn(glib2::Value::CreateTupleWrapped(std::string("fake-backend")));
+                                 });
+        regconf->AddInput("token", "s");
+        regconf->AddInput("session_path", "o");
+        regconf->AddInput("config_path", "o");
+        regconf->AddOutput("config_name", "s");
+
+        auto ping = AddMethod("Ping",
+                              [](DBus::Object::Method::Arguments::Ptr args)
+                              {
+                                  args->SetMethodReturn(glib2::Value::CreateTupleWrapped(true));
+                              });
+        ping->AddOutput("alive", "b");
+
+        AddMethod("Ready",
+                  [](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      args->SetMethodReturn(nullptr);
+                  });
+
+        AddMethod("Connect",
+                  [this](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      timeline->Begin("connect");
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTING);
+                      g_timeout_add(connect_delay_ms, cb_connected, this);
+                      args->SetMethodReturn(nullptr);
+                  });
+
+        auto pause = AddMethod("Pause",
+                               [this](DBus::Object::Method::Arguments::Ptr args)
+                               {
+                                   stop_log_timer();
+                                   signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_PAUSED);
+                                   args->SetMethodReturn(nullptr);
+                               });
+        pause->AddInput("reason", "s");
+
+        AddMethod("Resume",
+                  [this](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RESUMING);
+                      g_timeout_add(connect_delay_ms, cb_connected, this);
+                      args->SetMethodReturn(nullptr);
+                  });
+
+        AddMethod("Restart",
+                  [this](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      stop_log_timer();
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RECONNECTING);
+                      g_timeout_add(connect_delay_ms, cb_connected, this);
+                      args->SetMethodReturn(nullptr);
+                  });
+
+        AddMethod("Disconnect",
+                  [this](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      stop_log_timer();
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DISCONNECTING);
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DONE);
+                      args->SetMethodReturn(nullptr);
+                      kill(getpid(), SIGTERM);
+                  });
+
+        AddMethod("ForceShutdown",
+                  [this](DBus::Object::Method::Arguments::Ptr args)
+                  {
+                      stop_log_timer();
+                      signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DONE);
+                      args->SetMethodReturn(nullptr);
+                      kill(getpid(), SIGTERM);
+                  });
+
+        AddProperty("session_path", session_path, false);
+        AddProperty("dco", dco, true);
+
+        AddPropertyBySpec("device_path",
+                          glib2::DataType::DBus<DBus::Object::Path>(),
+                          [](const DBus::Object::Property::BySpec &prop)
+                          {
+                              return glib2::Value::Create(DBus::Object::Path());
+                          });
+        AddPropertyBySpec("device_name",
+                          "s",
+                          [](const DBus::Object::Property::BySpec &prop)
+                          {
+                              return glib2::Value::Create(std::string("fake0"));
+                          });
+        AddPropertyBySpec("session_name",
+                          "s",
+                          [](const DBus::Object::Property::BySpec &prop)
+                          {
+                              return glib2::Value::Create(std::string("fake-backend"));
+                          });
+
+        AddPropertyBySpec(
+            "log_level",
+            glib2::DataType::DBus<uint32_t>(),
+            [this](const DBus::Object::Property::BySpec &prop)
+            {
+                return glib2::Value::Create(signal->GetLogLevel());
+            },
+            [this](const DBus::Object::Property::BySpec &prop, GVariant *value)
+            {
+                signal->SetLogLevel(glib2::Value::Get<uint32_t>(value));
+                auto upd = prop.PrepareUpdate();
+                upd->AddValue(signal->GetLogLevel());
+                return upd;
+            });
+
+        AddPropertyBySpec("statistics",
+                          "a{sx}",
+                          [this](const DBus::Object::Property::BySpec &prop)
+                          {
+                              std::lock_guard<std::mutex> guard(mtx);
+                              GVariantBuilder *res = glib2::Builder::Create("a{sx}");
+                              for (const auto &[key, value] : stats)
+                              {
+                                  g_variant_builder_add(res, "{sx}", key.c_str(), value);
+                              }
+                              return glib2::Builder::Finish(res);
+                          });
+
+        AddPropertyBySpec("status",
+                          "(uus)",
+                          [this](const DBus::Object::Property::BySpec &prop)
+                          {
+                              return signal->GetLastStatusChange();
+                          });
+
+        AddPropertyBySpec("last_log_line",
+                          "a{sv}",
+                          [this](const DBus::Object::Property::BySpec &prop)
+                          {
+                              Events::Log l = signal->GetLastLogEvent();
+                              if (!l.empty())
+                              {
+                                  l.RemoveToken();
+                                  return l.GetGVariantDict();
+                              }
+                              return glib2::Builder::CreateEmpty("a{sv}");
+                          });
+
+        AddPropertyBySpec("connect_timeline",
+                          "a(sstt)",
+                          [this](const DBus::Object::Property::BySpec &prop)
+                          {
+                              return timeline->GetGVariant();
+                          });
+
+        signal->RegistrationRequest(bus_name, session_token, getpid());
+    }
+
+    ~FakeBackendObject() noexcept
+    {
+        stop_log_timer();
+    }
+
+    const bool Authorize(const DBus::Authz::Request::Ptr authzreq) override
+    {
+        return true;
+    }
+
+
+  private:
+    const std::string session_token;
+    const unsigned int log_rate;
+    const unsigned int connect_delay_ms;
+    BackendSignals::Ptr signal = nullptr;
+    ConnectTimeline::Ptr timeline = nullptr;
+    DBus::Object::Path session_path{};
+    bool dco = false;
+
+    std::mutex mtx{};
+    std::map<std::string, int64_t> stats{{"BYTES_IN", 0},
+                                         {"BYTES_OUT", 0},
+                                         {"PACKETS_IN", 0},
+                                         {"PACKETS_OUT", 0}};
+    guint log_timer = 0;
+    uint64_t log_start_usec = 0;
+    uint64_t log_seq = 0;
+
+
+    static gboolean cb_connected(gpointer data)
+    {
+        auto self = static_cast<FakeBackendObject *>(data);
+        self->timeline->End("connect");
+        self->signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTED);
+        self->start_log_timer();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    void start_log_timer()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (0 == log_rate || log_timer > 0)
+        {
+            return;
+        }
+        log_start_usec = ConnectTimeline::Now();
+        log_seq = 0;
+        log_timer = g_timeout_add(10, cb_log_timer, this);
+    }
+
+
+    void stop_log_timer() noexcept
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (log_timer > 0)
+        {
+            g_source_remove(log_timer);
+            log_timer = 0;
+        }
+    }
+
+
+    /**
+     *  Sends the log events due since the last timer tick.  Each log
+     *  message carries a sequence number and the CLOCK_MONOTONIC send
+     *  time, which lets the receiver calculate the delivery latency.
+     */
+    static gboolean cb_log_timer(gpointer data)
+    {
+        auto self = static_cast<FakeBackendObject *>(data);
+        const uint64_t now = ConnectTimeline::Now();
+        const uint64_t due = (now - self->log_start_usec) * self->log_rate / 1000000;
+
+        while (self->log_seq < due)
+        {
+            ++self->log_seq;
+            self->signal->LogInfo("loadgen seq=" + std::to_string(self->log_seq)
+                                  + " t=" + std::to_string(ConnectTimeline::Now()));
+
+            std::lock_guard<std::mutex> guard(self->mtx);
+            self->stats["BYTES_IN"] += 1400;
+            self->stats["BYTES_OUT"] += 120;
+            self->stats["PACKETS_IN"] += 1;
+            self->stats["PACKETS_OUT"] += 1;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+};
+
+
+
+class FakeBackendService : public DBus::Service
+{
+  public:
+    FakeBackendService(DBus::Connection::Ptr dbuscon_,
+                       const std::string &sesstoken,
+                       const uint32_t log_level_)
+        : DBus::Service(dbuscon_, Constants::GenServiceName("backends.be") + std::to_string(getpid())),
+          dbuscon(dbuscon_), session_token(sesstoken), log_level(log_level_)
+    {
+        logservice = LogServiceProxy::Create(dbuscon);
+    }
+
+    ~FakeBackendService() noexcept
+    {
+        try
+        {
+            logservice->Detach(Constants::GenInterface("backends"));
+        }
+        catch (const std::exception &excp)
+        {
+            std::cerr << "** ERROR **  Failed detaching from the log service: "
+                      << excp.what() << std::endl;
+        }
+    }
+
+    void BusNameAcquired(const std::string &busname) override
+    {
+        logservice->Attach(Constants::GenInterface("backends"));
+        CreateServiceHandler<FakeBackendObject>(dbuscon,
+                                                busname,
+                                                session_token,
+                                                log_level);
+    }
+
+    void BusNameLost(const std::string &busname) override
+    {
+        throw DBus::Service::Exception("fake-backend lost the '"
+                                       + busname + "' registration on the D-Bus");
+    }
+
+  private:
+    DBus::Connection::Ptr dbuscon = nullptr;
+    const std::string session_token;
+    const uint32_t log_level;
+    LogServiceProxy::Ptr logservice = nullptr;
+};
+
+
+
+static void run_fake_backend(const std::string &sesstoken, const uint32_t log_level)
+{
+    try
+    {
+        auto dbuscon = DBus::Connection::Create(DBus::BusType::SYSTEM);
+        auto srv = DBus::Service::Create<FakeBackendService>(dbuscon,
+                                                             sesstoken,
+                                                             log_level);
+        srv->Run();
+    }
+    catch (const DBus::Exception &excp)
+    {
+        std::cerr << "** ERROR **  " << excp.GetRawError() << std::endl;
+    }
+}
+
+
+static int fake_backend(ParsedArgs::Ptr args)
+{
+    auto extra = args->GetAllExtraArgs();
+    if (extra.size() != 1)
+    {
+        std::cout << "** ERROR ** Invalid usage: " << args->GetArgv0()
+                  << " <session registration token>" << std::endl;
+        return 1;
+    }
+
+    uint32_t log_level = 3;
+    if (args->Present("log-level"))
+    {
+        log_level = std::atoi(args->GetValue("log-level", 0).c_str());
+    }
+
+    if (args->Present("no-fork"))
+    {
+        run_fake_backend(extra[0], log_level);
+        return 0;
+    }
+
+    // Like openvpn3-service-client, the StartClient call to the
+    // backend starter returns once the child process is running
+    if (!args->Present("no-setsid"))
+    {
+        setsid();
+    }
+    pid_t pid = fork();
+    if (0 == pid)
+    {
+        run_fake_backend(extra[0], log_level);
+        return 0;
+    }
+    return (pid > 0 ? 0 : 3);
+}
+
+
+int main(int argc, char **argv)
+{
+    SingleCommand argparser(argv[0], "Synthetic VPN client backend for load tests", fake_backend);
+    argparser.AddOption("log-level",
+                        "LOG-LEVEL",
+                        true,
+                        "Sets the default log verbosity level (default 3)");
+
+    // Options openvpn3-service-backendstart may pass to the real client
+    argparser.AddOption("log-file", "FILE", true, "Ignored");
+    argparser.AddOption("colour", 0, "Ignored");
+    argparser.AddOption("disable-protect-socket", 0, "Ignored");
+    argparser.AddOption("no-fork", 0, "Do not fork a child to be run in the background");
+    argparser.AddOption("no-setsid", 0, "Do not call setsid(3) before forking");
+
+    try
+    {
+        return argparser.RunCommand(simple_basename(argv[0]), argc, argv);
+    }
+    catch (CommandException &excp)
+    {
+        std::cout << excp.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,686 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   loadgen.cpp
+ *
+ * @brief  Load generator for the session manager, log service and
+ *         netcfg service.  It starts many VPN sessions in parallel,
+ *         served by the fake-backend program instead of real VPN
+ *         client processes, and reports the throughput and latency
+ *         percentiles of the operations involved.
+ *
+ *         This is expected to be run against services on a private
+ *         D-Bus daemon; see run-loadgen.sh.
+ */
+
+#include "build-config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <json/json.h>
+#include <gdbuspp/connection.hpp>
+#include <gdbuspp/glib2/utils.hpp>
+#include <gdbuspp/mainloop.hpp>
+#include <gdbuspp/proxy.hpp>
+#include <gdbuspp/proxy/utils.hpp>
+#include <gdbuspp/signals/subscriptionmgr.hpp>
+#include <gdbuspp/signals/target.hpp>
+
+#include "common/cmdargparser.hpp"
+#include "common/timeline.hpp"
+#include "common/utils.hpp"
+#include "configmgr/proxy-configmgr.hpp"
+#include "dbus/constants.hpp"
+#include "dbus/signals/log.hpp"
+#include "dbus/signals/statuschange.hpp"
+#include "netcfg/proxy-netcfg-device.hpp"
+#include "netcfg/proxy-netcfg-mgr.hpp"
+#include "sessionmgr/proxy-sessionmgr.hpp"
+#include "sessionmgr/sessionmgr-events.hpp"
+
+
+/**
+ *  Configuration profile imported when --config is not used.  The
+ *  fake-backend never parses it, so the remote does not need to exist.
+ */
+static const std::string DEFAULT_PROFILE = "client\n"
+                                           "dev tun\n"
+                                           "remote 192.0.2.1 1194 udp\n"
+                                           "auth-user-pass\n";
+
+
+/**
+ *  Collects latency samples of a single operation
+ */
+class LatencyRecorder
+{
+  public:
+    void Add(const std::string &operation, const double msec)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        samples[operation].push_back(msec);
+    }
+
+    void Count(const std::string &counter, const uint64_t val = 1)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        counters[counter] += val;
+    }
+
+    uint64_t GetCount(const std::string &counter)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        return counters[counter];
+    }
+
+    /**
+     *  Time a single operation
+     *
+     * @param operation  std::string with the operation name
+     * @param func       The operation to run
+     */
+    void Measure(const std::string &operation, std::function<void()> func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            func();
+        }
+        catch (const std::exception &)
+        {
+            Count(operation + ".errors");
+            throw;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        Add(operation, elapsed.count());
+    }
+
+    /**
+     *  Build the report of all the operations and counters
+     *
+     * @param duration  double with the time in seconds the counters
+     *                  were collected over
+     * @return Json::Value
+     */
+    Json::Value Report(const double duration)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        Json::Value ret;
+        for (auto &[op, lat] : samples)
+        {
+            std::sort(lat.begin(), lat.end());
+            Json::Value &r = ret["operations"][op];
+            r["count"] = static_cast<Json::UInt64>(lat.size());
+            r["p50_ms"] = percentile(lat, 50);
+            r["p90_ms"] = percentile(lat, 90);
+            r["p99_ms"] = percentile(lat, 99);
+            r["max_ms"] = lat.back();
+        }
+        for (const auto &[name, val] : counters)
+        {
+            ret["counters"][name] = static_cast<Json::UInt64>(val);
+            if (duration > 0)
+            {
+                ret["rates_per_sec"][name] = val / duration;
+            }
+        }
+        return ret;
+    }
+
+  private:
+    std::mutex mtx;
+    std::map<std::string, std::vector<double>> samples;
+    std::map<std::string, uint64_t> counters;
+
+    static double percentile(const std::vector<double> &sorted, unsigned int p)
+    {
+        size_t idx = std::min(sorted.size() - 1, sorted.size() * p / 100);
+        return sorted[idx];
+    }
+};
+
+
+
+/**
+ *  Tracks the state of all the sessions via the SessionManagerEvent
+ *  signals and the StatusChange and Log signals forwarded by the log
+ *  service
+ */
+class SessionTracker
+{
+  public:
+    struct State
+    {
+        bool created = false;
+        bool connected = false;
+        bool destroyed = false;
+        bool failed = false;
+    };
+
+    SessionTracker(DBus::Connection::Ptr conn, LatencyRecorder &rec)
+        : recorder(rec)
+    {
+        auto prxqry = DBus::Proxy::Utils::DBusServiceQuery::Create(conn);
+        auto log_busname = prxqry->GetNameOwner(Constants::GenServiceName("log"));
+
+        submgr = DBus::Signals::SubscriptionManager::Create(conn);
+        sessmgr_tgt = DBus::Signals::Target::Create("",
+                                                    Constants::GenPath("sessions"),
+                                                    Constants::GenInterface("sessions"));
+        submgr->Subscribe(sessmgr_tgt,
+                          "SessionManagerEvent",
+                          [this](DBus::Signals::Event::Ptr &event)
+                          {
+                              SessionManager::Event ev(event->params);
+                              update(ev.path,
+                                     [&ev](State &st)
+                                     {
+                                         st.created |= (SessionManager::EventType::SESS_CREATED == ev.type);
+                                         st.destroyed |= (SessionManager::EventType::SESS_DESTROYED == ev.type);
+                                         st.failed |= (SessionManager::EventType::SESS_START_FAILED == ev.type);
+                                     });
+                          });
+
+        logfwd_tgt = DBus::Signals::Target::Create(log_busname, "", "");
+        sig_statuschg = Signals::ReceiveStatusChange::Create(
+            submgr,
+            logfwd_tgt,
+            [this](const std::string &sender, const DBus::Object::Path &path, const std::string &interface, Events::Status status)
+            {
+                recorder.Count("sessionmgr.status_events");
+                if (StatusMajor::CONNECTION != status.major)
+                {
+                    return;
+                }
+                update(path,
+                       [&status](State &st)
+                       {
+                           st.connected |= (StatusMinor::CONN_CONNECTED == status.minor);
+                           st.failed |= (StatusMinor::CONN_FAILED == status.minor);
+                       });
+            });
+
+        sig_log = Signals::ReceiveLog::Create(
+            submgr,
+            logfwd_tgt,
+            [this](Events::Log logev)
+            {
+                // The fake-backend log messages carry the send time,
+                // based on the same clock as ConnectTimeline::Now()
+                auto pos = logev.message.find(" t=");
+                if (logev.message.rfind("loadgen seq=", 0) != 0 || std::string::npos == pos)
+                {
+                    return;
+                }
+                uint64_t sent = std::stoull(logev.message.substr(pos + 3));
+                uint64_t now = ConnectTimeline::Now();
+                recorder.Count("log.events_received");
+                recorder.Add("log.delivery", (now - sent) / 1000.0);
+            });
+    }
+
+
+    /**
+     *  Wait until a session reaches a certain state
+     *
+     * @param path     DBus::Object::Path of the session
+     * @param pred     Function checking the session state
+     * @param timeout  std::chrono::milliseconds maximum time to wait
+     * @return bool    true if the state was reached, false on timeout
+     *                 or if the session failed
+     */
+    bool Wait(const DBus::Object::Path &path,
+              std::function<bool(const State &)> pred,
+              const std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        bool ok = cv.wait_for(lock,
+                              timeout,
+                              [&]()
+                              {
+                                  const auto &st = sessions[path];
+                                  return st.failed || pred(st);
+                              });
+        return ok && !sessions[path].failed;
+    }
+
+  private:
+    LatencyRecorder &recorder;
+    DBus::Signals::SubscriptionManager::Ptr submgr = nullptr;
+    DBus::Signals::Target::Ptr sessmgr_tgt = nullptr;
+    DBus::Signals::Target::Ptr logfwd_tgt = nullptr;
+    Signals::ReceiveStatusChange::Ptr sig_statuschg = nullptr;
+    Signals::ReceiveLog::Ptr sig_log = nullptr;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::map<DBus::Object::Path, State> sessions;
+
+    void update(const DBus::Object::Path &path, std::function<void(State &)> func)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            func(sessions[path]);
+        }
+        cv.notify_all();
+    }
+};
+
+
+
+/**
+ *  Runs func(index) for all indexes in [0, count), using a number of
+ *  parallel threads
+ */
+static void run_parallel(const unsigned int count,
+                         const unsigned int parallel,
+                         std::function<void(unsigned int)> func)
+{
+    std::atomic<unsigned int> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < std::max(1u, parallel); ++t)
+    {
+        workers.emplace_back(
+            [&]()
+            {
+                for (unsigned int i = next++; i < count; i = next++)
+                {
+                    func(i);
+                }
+            });
+    }
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+}
+
+
+static void print_report(const Json::Value &report)
+{
+    std::cout << std::endl
+              << std::left << std::setw(36) << "Operation"
+              << std::right << std::setw(8) << "count"
+              << std::setw(10) << "p50 ms"
+              << std::setw(10) << "p90 ms"
+              << std::setw(10) << "p99 ms"
+              << std::setw(10) << "max ms" << std::endl;
+    const auto &ops = report["operations"];
+    for (auto it = ops.begin(); it != ops.end(); ++it)
+    {
+        std::cout << std::left << std::setw(36) << it.key().asString()
+                  << std::right << std::setw(8) << (*it)["count"].asUInt64()
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(10) << (*it)["p50_ms"].asDouble()
+                  << std::setw(10) << (*it)["p90_ms"].asDouble()
+                  << std::setw(10) << (*it)["p99_ms"].asDouble()
+                  << std::setw(10) << (*it)["max_ms"].asDouble() << std::endl;
+    }
+
+    std::cout << std::endl
+              << std::left << std::setw(36) << "Counter"
+              << std::right << std::setw(12) << "total"
+              << std::setw(14) << "per second" << std::endl;
+    const auto &counters = report["counters"];
+    for (auto it = counters.begin(); it != counters.end(); ++it)
+    {
+        std::cout << std::left << std::setw(36) << it.key().asString()
+                  << std::right << std::setw(12) << it->asUInt64()
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(14) << report["rates_per_sec"][it.key().asString()].asDouble()
+                  << std::endl;
+    }
+}
+
+
+/**
+ *  Create and tear down netcfg virtual interfaces.  The interfaces are
+ *  not activated, so no tun devices are created.
+ */
+static void netcfg_load(DBus::Connection::Ptr conn,
+                        LatencyRecorder &rec,
+                        const unsigned int count,
+                        const unsigned int parallel)
+{
+    auto netcfg = NetCfgProxy::Manager::Create(conn);
+    run_parallel(count,
+                 parallel,
+                 [&](unsigned int i)
+                 {
+                     try
+                     {
+                         DBus::Object::Path devpath;
+                         rec.Measure("netcfg.create_interface",
+                                     [&]()
+                                     {
+                                         devpath = netcfg->CreateVirtualInterface("loadgen" + std::to_string(i));
+                                     });
+                         NetCfgProxy::Device dev(conn, devpath);
+                         rec.Measure("netcfg.add_ip_address",
+                                     [&]()
+                                     {
+                                         dev.AddIPAddress("10.200." + std::to_string(i / 256 % 256)
+                                                              + "." + std::to_string(i % 256),
+                                                          16,
+                                                          "10.200.0.1",
+                                                          false);
+                                     });
+                         rec.Measure("netcfg.add_dns",
+                                     [&]()
+                                     {
+                                         dev.AddDNS({"192.0.2.53"});
+                                     });
+                         rec.Measure("netcfg.destroy",
+                                     [&]()
+                                     {
+                                         dev.Destroy();
+                                     });
+                     }
+                     catch (const std::exception &excp)
+                     {
+                         std::cerr << "netcfg: " << excp.what() << std::endl;
+                     }
+                 });
+}
+
+
+static int loadgen(ParsedArgs::Ptr args)
+{
+    const unsigned int sessions = (args->Present("sessions")
+                                       ? std::stoul(args->GetValue("sessions", 0))
+                                       : 100);
+    const unsigned int parallel = (args->Present("parallel")
+                                       ? std::stoul(args->GetValue("parallel", 0))
+                                       : 10);
+    const unsigned int duration = (args->Present("duration")
+                                       ? std::stoul(args->GetValue("duration", 0))
+                                       : 10);
+    const unsigned int stats_rate = (args->Present("stats-rate")
+                                         ? std::stoul(args->GetValue("stats-rate", 0))
+                                         : 50);
+    const unsigned int netcfg_ops = (args->Present("netcfg")
+                                         ? std::stoul(args->GetValue("netcfg", 0))
+                                         : 0);
+    const std::chrono::milliseconds timeout(args->Present("timeout")
+                                                ? std::stoul(args->GetValue("timeout", 0)) * 1000
+                                                : 30000);
+
+    std::string profile = DEFAULT_PROFILE;
+    if (args->Present("config"))
+    {
+        std::ifstream cfg(args->GetValue("config", 0));
+        std::stringstream buf;
+        buf << cfg.rdbuf();
+        profile = buf.str();
+    }
+
+    auto conn = DBus::Connection::Create(DBus::BusType::SYSTEM);
+    auto mainloop = DBus::MainLoop::Create();
+    std::thread mainloop_thread(
+        [mainloop]()
+        {
+            mainloop->Run();
+        });
+
+    LatencyRecorder rec;
+    SessionTracker tracker(conn, rec);
+
+    // Prepare the configuration profile all the sessions will use
+    OpenVPN3ConfigurationProxy cfgmgr(conn, Constants::GenPath("configuration"));
+    DBus::Object::Path cfgpath;
+    rec.Measure("configmgr.import",
+                [&]()
+                {
+                    cfgpath = cfgmgr.Import("loadgen-" + std::to_string(getpid()), profile, false, false);
+                });
+
+    // Start all the sessions.  The NewTunnel() call is done directly,
+    // since the proxy implementation polls until the backend has registered;
+    // the SESS_CREATED event is used instead
+    auto sessmgr = SessionManager::Proxy::Manager::Create(conn);
+    auto sessmgr_prx = DBus::Proxy::Client::Create(conn, Constants::GenServiceName("sessions"));
+    auto sessmgr_tgt = DBus::Proxy::TargetPreset::Create(Constants::GenPath("sessions"),
+                                                         Constants::GenInterface("sessions"));
+
+    std::mutex started_mtx;
+    std::vector<SessionManager::Proxy::Session::Ptr> started;
+    std::cout << "Starting " << sessions << " sessions, " << parallel
+              << " in parallel" << std::endl;
+
+    auto start_phase = std::chrono::steady_clock::now();
+    run_parallel(
+        sessions,
+        parallel,
+        [&](unsigned int)
+        {
+            try
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                DBus::Object::Path path;
+                rec.Measure("sessionmgr.new_tunnel",
+                            [&]()
+                            {
+                                GVariant *r = sessmgr_prx->Call(sessmgr_tgt,
+                                                                "NewTunnel",
+                                                                glib2::Value::CreateTupleWrapped(cfgpath));
+                                path = glib2::Value::Extract<DBus::Object::Path>(r, 0);
+                                g_variant_unref(r);
+                            });
+                if (!tracker.Wait(path,
+                                  [](const SessionTracker::State &st)
+                                  {
+                                      return st.created;
+                                  },
+                                  timeout))
+                {
+                    rec.Count("sessionmgr.start_failures");
+                    return;
+                }
+                std::chrono::duration<double, std::milli> reg = std::chrono::steady_clock::now() - t0;
+                rec.Add("sessionmgr.backend_registered", reg.count());
+
+                auto session = sessmgr->Retrieve(path);
+                rec.Measure("sessionmgr.log_forward",
+                            [&]()
+                            {
+                                session->LogForward(true);
+                            });
+                rec.Measure("sessionmgr.ready",
+                            [&]()
+                            {
+                                session->Ready();
+                            });
+                auto t1 = std::chrono::steady_clock::now();
+                rec.Measure("sessionmgr.connect",
+                            [&]()
+                            {
+                                session->Connect();
+                            });
+                if (!tracker.Wait(path,
+                                  [](const SessionTracker::State &st)
+                                  {
+                                      return st.connected;
+                                  },
+                                  timeout))
+                {
+                    rec.Count("sessionmgr.connect_failures");
+                }
+                else
+                {
+                    std::chrono::duration<double, std::milli> conn_time = std::chrono::steady_clock::now() - t1;
+                    rec.Add("sessionmgr.connected", conn_time.count());
+                }
+
+                for (const auto &phase : session->GetConnectTimeline())
+                {
+                    if (phase.end_usec >= phase.start_usec)
+                    {
+                        rec.Add("timeline." + phase.source + "." + phase.name,
+                                (phase.end_usec - phase.start_usec) / 1000.0);
+                    }
+                }
+
+                std::lock_guard<std::mutex> guard(started_mtx);
+                started.push_back(session);
+            }
+            catch (const std::exception &excp)
+            {
+                rec.Count("sessionmgr.start_failures");
+                std::cerr << "Session start: " << excp.what() << std::endl;
+            }
+        });
+    std::chrono::duration<double> start_time = std::chrono::steady_clock::now() - start_phase;
+    std::cout << started.size() << " sessions started in "
+              << std::fixed << std::setprecision(2) << start_time.count() << " seconds" << std::endl;
+
+    // Steady state: the backends send log events while the statistics
+    // of the sessions are polled via the session manager
+    std::cout << "Running for " << duration << " seconds" << std::endl;
+    const uint64_t log_before = rec.GetCount("log.events_received");
+    auto steady_start = std::chrono::steady_clock::now();
+    auto steady_end = steady_start + std::chrono::seconds(duration);
+    if (!started.empty() && stats_rate > 0)
+    {
+        const auto interval = std::chrono::microseconds(1000000 / stats_rate);
+        auto next = steady_start;
+        for (size_t i = 0; std::chrono::steady_clock::now() < steady_end; ++i)
+        {
+            auto &session = started[i % started.size()];
+            try
+            {
+                rec.Measure("sessionmgr.statistics",
+                            [&]()
+                            {
+                                (void)session->GetConnectionStats();
+                            });
+            }
+            catch (const std::exception &)
+            {
+            }
+            next += interval;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    std::this_thread::sleep_until(steady_end);
+    rec.Count("log.events_steady_state", rec.GetCount("log.events_received") - log_before);
+
+    if (netcfg_ops > 0)
+    {
+        std::cout << "Running " << netcfg_ops << " netcfg interface setups" << std::endl;
+        try
+        {
+            netcfg_load(conn, rec, netcfg_ops, parallel);
+        }
+        catch (const std::exception &excp)
+        {
+            std::cerr << "netcfg: " << excp.what() << std::endl;
+        }
+    }
+
+    // Tear down all the sessions
+    std::cout << "Disconnecting " << started.size() << " sessions" << std::endl;
+    run_parallel(started.size(),
+                 parallel,
+                 [&](unsigned int i)
+                 {
+                     auto &session = started[i];
+                     const auto path = session->GetPath();
+                     try
+                     {
+                         auto t0 = std::chrono::steady_clock::now();
+                         rec.Measure("sessionmgr.disconnect",
+                                     [&]()
+                                     {
+                                         session->Disconnect();
+                                     });
+                         if (tracker.Wait(path,
+                                          [](const SessionTracker::State &st)
+                                          {
+                                              return st.destroyed;
+                                          },
+                                          timeout))
+                         {
+                             std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - t0;
+                             rec.Add("sessionmgr.destroyed", d.count());
+                         }
+                     }
+                     catch (const std::exception &excp)
+                     {
+                         std::cerr << "Disconnect " << path << ": " << excp.what() << std::endl;
+                     }
+                 });
+
+    try
+    {
+        OpenVPN3ConfigurationProxy cfg(conn, cfgpath);
+        cfg.Remove();
+    }
+    catch (const std::exception &excp)
+    {
+        std::cerr << "Removing configuration profile: " << excp.what() << std::endl;
+    }
+
+    mainloop->Stop();
+    mainloop_thread.join();
+
+    Json::Value report = rec.Report(duration);
+    report["sessions"]["requested"] = sessions;
+    report["sessions"]["started"] = static_cast<Json::UInt64>(started.size());
+    report["sessions"]["start_seconds"] = start_time.count();
+    if (args->Present("json"))
+    {
+        std::cout << report << std::endl;
+    }
+    else
+    {
+        print_report(report);
+    }
+
+    return (started.size() == sessions ? 0 : 1);
+}
+
+
+int main(int argc, char **argv)
+{
+    SingleCommand argparser(argv[0], "Load generator for the OpenVPN 3 Linux services", loadgen);
+    argparser.AddOption("sessions", 'n', "COUNT", true, "Number of sessions to start (default 100)");
+    argparser.AddOption("parallel", 'p', "COUNT", true, "Number of parallel requests (default 10)");
+    argparser.AddOption("duration", 'd', "SECONDS", true, "Time to run with all sessions started (default 10)");
+    argparser.AddOption("stats-rate", 's', "RATE", true, "Session statistics requests per second in total (default 50)");
+    argparser.AddOption("netcfg", 'N', "COUNT", true, "Number of netcfg virtual interfaces to set up and tear down (default 0)");
+    argparser.AddOption("config", 'c', "FILE", true, "Configuration profile to import (default: a built-in profile)");
+    argparser.AddOption("timeout", 't', "SECONDS", true, "Time to wait for each session state change (default 30)");
+    argparser.AddOption("json", 'j', "Write the report as JSON");
+
+    try
+    {
+        return argparser.RunCommand(simple_basename(argv[0]), argc, argv);
+    }
+    catch (const DBus::Exception &excp)
+    {
+        std::cerr << "** ERROR ** " << excp.GetRawError() << std::endl;
+        return 2;
+    }
+    catch (CommandException &excp)
+    {
+        std::cerr << excp.what() << std::endl;
+        return 2;
+    }
+}
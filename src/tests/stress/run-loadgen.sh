@@ -0,0 +1,134 @@
+#!/bin/bash
+#
+#  OpenVPN 3 Linux client -- Next generation OpenVPN client
+#
+#  SPDX-License-Identifier: AGPL-3.0-only
+#
+#  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+#  Copyright (C)  David Sommerseth <davids@openvpn.net>
+#
+
+##
+# @file  run-loadgen.sh
+#
+# @brief Runs the loadgen program against the session manager, log,
+#        configuration manager and optionally the netcfg services.
+#
+#        All services are started on a private D-Bus daemon, so this
+#        does not interfere with the system bus.  VPN sessions are
+#        served by the fake-backend program instead of
+#        openvpn3-service-client, which requires the services to be
+#        built with -Ddebug_options=true.
+#
+#        This must be run as root, from the build directory.  The
+#        services are run as the openvpn user, like when started via
+#        D-Bus activation.  All arguments are passed to loadgen; see
+#        ./src/tests/loadgen --help.
+#
+#        Environment variables:
+#          FAKE_BACKEND_LOG_RATE          Log events per second sent
+#                                         by each session (default 10)
+#          FAKE_BACKEND_CONNECT_DELAY_MS  Time the sessions use to
+#                                         connect (default 0)
+#          LOADGEN_NETCFG                 Set to 1 to also start the
+#                                         netcfg service
+#          OPENVPN_USERNAME               User running the services
+#                                         (default: openvpn)
+#
+
+set -e
+
+BUILDDIR="$(pwd)"
+SRCDIR="$(dirname "$(readlink -f "$0")")"
+SVCUSER="${OPENVPN_USERNAME:-openvpn}"
+
+if [ "$(id -u)" != "0" ]; then
+    echo "$0 must be run as root" >&2
+    exit 3
+fi
+for bin in src/log/openvpn3-service-log \
+           src/configmgr/openvpn3-service-configmgr \
+           src/sessionmgr/openvpn3-service-sessionmgr \
+           src/client/openvpn3-service-backendstart \
+           src/tests/fake-backend src/tests/loadgen; do
+    if [ ! -x "$BUILDDIR/$bin" ]; then
+        echo "Missing $bin; run this from the build directory" >&2
+        exit 3
+    fi
+done
+
+WORKDIR="$(mktemp -d /tmp/openvpn3-loadgen.XXXXXX)"
+chown "$SVCUSER" "$WORKDIR"
+PIDS=""
+
+cleanup()
+{
+    local status=$?
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    wait 2>/dev/null
+    [ -n "$DBUS_PID" ] && kill "$DBUS_PID" 2>/dev/null
+    # The service logs are kept if something failed
+    if [ $status -eq 0 ]; then
+        rm -rf "$WORKDIR"
+    fi
+}
+trap cleanup EXIT
+
+# Start the private D-Bus daemon; all the D-Bus clients below will
+# use it as the system bus
+eval "$(dbus-daemon --config-file="$SRCDIR/loadgen-dbus.conf" --fork \
+        --print-address=1 --print-pid=1 \
+        | { read addr; read pid; echo "DBUS_ADDR='$addr'; DBUS_PID=$pid"; })"
+export DBUS_SYSTEM_BUS_ADDRESS="$DBUS_ADDR"
+chmod 0777 "$(echo "$DBUS_ADDR" | sed -n 's/^unix:path=\([^,]*\).*/\1/p')" 2>/dev/null || true
+
+start_service()
+{
+    local name="$1"
+    shift
+    "$@" --log-file "$WORKDIR/$name.log" &
+    PIDS="$PIDS $!"
+}
+
+# For services without the --log-file option; the console output
+# is logged instead
+start_service_console()
+{
+    local name="$1"
+    shift
+    "$@" > "$WORKDIR/$name.log" 2>&1 &
+    PIDS="$PIDS $!"
+}
+
+as_svcuser()
+{
+    runuser -u "$SVCUSER" -- env DBUS_SYSTEM_BUS_ADDRESS="$DBUS_SYSTEM_BUS_ADDRESS" "$@"
+}
+
+start_service log as_svcuser "$BUILDDIR/src/log/openvpn3-service-log" \
+        --idle-exit 0 --log-level 3 --state-dir "$WORKDIR"
+start_service configmgr as_svcuser "$BUILDDIR/src/configmgr/openvpn3-service-configmgr" \
+        --idle-exit 0 --state-dir "$WORKDIR"
+start_service_console backendstart as_svcuser "$BUILDDIR/src/client/openvpn3-service-backendstart" \
+        --idle-exit 0 \
+        --client-binary "$BUILDDIR/src/tests/fake-backend" \
+        --client-setenv "DBUS_SYSTEM_BUS_ADDRESS=$DBUS_SYSTEM_BUS_ADDRESS" \
+        --client-setenv "FAKE_BACKEND_LOG_RATE=${FAKE_BACKEND_LOG_RATE:-10}" \
+        --client-setenv "FAKE_BACKEND_CONNECT_DELAY_MS=${FAKE_BACKEND_CONNECT_DELAY_MS:-0}"
+start_service sessionmgr as_svcuser "$BUILDDIR/src/sessionmgr/openvpn3-service-sessionmgr" \
+        --idle-exit 0 --state-dir "$WORKDIR"
+if [ "${LOADGEN_NETCFG:-0}" = "1" ]; then
+    start_service netcfg "$BUILDDIR/src/netcfg/openvpn3-service-netcfg" \
+            --idle-exit 0 --state-dir "$WORKDIR"
+fi
+
+# Give the services time to acquire their bus names
+sleep 2
+
+rc=0
+"$BUILDDIR/src/tests/loadgen" "$@" || rc=$?
+if [ $rc -ne 0 ]; then
+    echo "loadgen failed; service logs are available in $WORKDIR:" >&2
+    tail -n 20 "$WORKDIR"/*.log >&2
+fi
+exit $rc
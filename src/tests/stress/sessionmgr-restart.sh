@@ -0,0 +1,149 @@
+#!/bin/bash
+#
+#  OpenVPN 3 Linux client -- Next generation OpenVPN client
+#
+#  SPDX-License-Identifier: AGPL-3.0-only
+#
+#  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+#  Copyright (C)  David Sommerseth <davids@openvpn.net>
+#
+
+##
+# @file  sessionmgr-restart.sh
+#
+# @brief Checks that a running VPN session keeps working after the
+#        session manager has been restarted.  A session is started,
+#        the session manager is killed and started again, and the
+#        re-adopted session is paused.  The test passes when the
+#        StatusChange signal of the backend reaches the new session
+#        manager.
+#
+#        The services are started on a private D-Bus daemon, like
+#        run-loadgen.sh, and the session is served by the fake-backend
+#        program, which requires the services to be built with
+#        -Ddebug_options=true.
+#
+#        This must be run as root, from the build directory.  The test
+#        is skipped (exit code 77) if this is not possible.
+#
+#        Environment variables:
+#          OPENVPN_USERNAME               User running the services
+#                                         (default: openvpn)
+#
+
+set -e
+
+BUILDDIR="$(pwd)"
+SRCDIR="$(dirname "$(readlink -f "$0")")"
+SVCUSER="${OPENVPN_USERNAME:-openvpn}"
+SESSIONMGR="$BUILDDIR/src/sessionmgr/openvpn3-service-sessionmgr"
+OPENVPN3="$BUILDDIR/src/ovpn3cli/openvpn3"
+
+if [ "$(id -u)" != "0" ]; then
+    echo "$0 must be run as root, skipping" >&2
+    exit 77
+fi
+if ! id "$SVCUSER" > /dev/null 2>&1; then
+    echo "User $SVCUSER does not exist, skipping" >&2
+    exit 77
+fi
+for bin in src/log/openvpn3-service-log \
+           src/configmgr/openvpn3-service-configmgr \
+           src/sessionmgr/openvpn3-service-sessionmgr \
+           src/client/openvpn3-service-backendstart \
+           src/ovpn3cli/openvpn3 \
+           src/tests/fake-backend; do
+    if [ ! -x "$BUILDDIR/$bin" ]; then
+        echo "Missing $bin, skipping" >&2
+        exit 77
+    fi
+done
+
+WORKDIR="$(mktemp -d /tmp/openvpn3-sessionmgr-restart.XXXXXX)"
+chown "$SVCUSER" "$WORKDIR"
+PIDS=""
+
+cleanup()
+{
+    local status=$?
+    [ -n "$PIDS" ] && kill $PIDS 2>/dev/null
+    pkill -KILL -f "$BUILDDIR/src/tests/fake-backend" 2>/dev/null
+    wait 2>/dev/null
+    [ -n "$DBUS_PID" ] && kill "$DBUS_PID" 2>/dev/null
+    # The service logs are kept if something failed
+    if [ $status -eq 0 ]; then
+        rm -rf "$WORKDIR"
+    else
+        echo "Service logs are available in $WORKDIR:" >&2
+        tail -n 20 "$WORKDIR"/*.log >&2
+    fi
+}
+trap cleanup EXIT
+
+eval "$(dbus-daemon --config-file="$SRCDIR/loadgen-dbus.conf" --fork \
+        --print-address=1 --print-pid=1 \
+        | { read addr; read pid; echo "DBUS_ADDR='$addr'; DBUS_PID=$pid"; })"
+export DBUS_SYSTEM_BUS_ADDRESS="$DBUS_ADDR"
+chmod 0777 "$(echo "$DBUS_ADDR" | sed -n 's/^unix:path=\([^,]*\).*/\1/p')" 2>/dev/null || true
+
+as_svcuser()
+{
+    runuser -u "$SVCUSER" -- env DBUS_SYSTEM_BUS_ADDRESS="$DBUS_SYSTEM_BUS_ADDRESS" "$@"
+}
+
+start_sessionmgr()
+{
+    as_svcuser "$SESSIONMGR" --idle-exit 0 --state-dir "$WORKDIR" \
+            --log-file "$WORKDIR/sessionmgr-$1.log" &
+    PIDS="$PIDS $!"
+}
+
+# Waits until the session status printed by sessions-list matches
+wait_status()
+{
+    local pattern="$1"
+    for i in $(seq 1 20); do
+        if "$OPENVPN3" sessions-list | grep -q "$pattern"; then
+            return 0
+        fi
+        sleep 0.5
+    done
+    echo "Session status did not change to '$pattern'" >&2
+    "$OPENVPN3" sessions-list >&2
+    return 1
+}
+
+as_svcuser "$BUILDDIR/src/log/openvpn3-service-log" \
+        --idle-exit 0 --state-dir "$WORKDIR" --log-file "$WORKDIR/log.log" &
+PIDS="$PIDS $!"
+as_svcuser "$BUILDDIR/src/configmgr/openvpn3-service-configmgr" \
+        --idle-exit 0 --state-dir "$WORKDIR" --log-file "$WORKDIR/configmgr.log" &
+PIDS="$PIDS $!"
+as_svcuser "$BUILDDIR/src/client/openvpn3-service-backendstart" \
+        --idle-exit 0 \
+        --client-binary "$BUILDDIR/src/tests/fake-backend" \
+        --client-setenv "DBUS_SYSTEM_BUS_ADDRESS=$DBUS_SYSTEM_BUS_ADDRESS" \
+        > "$WORKDIR/backendstart.log" 2>&1 &
+PIDS="$PIDS $!"
+start_sessionmgr 1
+sleep 2
+
+# The fake-backend never parses the profile
+printf 'client\ndev tun\nremote 192.0.2.1 1194 udp\n' > "$WORKDIR/restart-test.ovpn"
+"$OPENVPN3" config-import --config "$WORKDIR/restart-test.ovpn" --name restart-test
+"$OPENVPN3" session-start --config restart-test
+wait_status "Client connected"
+SESSION_PATH="$("$OPENVPN3" sessions-list | sed -n 's/^ *Path: *//p' | head -n 1)"
+
+# Simulate a crash of the session manager and start it again; the
+# running session is re-adopted from the session journal
+pkill -KILL -f "$SESSIONMGR"
+sleep 1
+start_sessionmgr 2
+sleep 2
+
+"$OPENVPN3" session-manage --path "$SESSION_PATH" --pause
+wait_status "Client connection paused"
+
+"$OPENVPN3" session-manage --path "$SESSION_PATH" --disconnect
+echo "StatusChange received by the restarted session manager"
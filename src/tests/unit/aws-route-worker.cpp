@@ -0,0 +1,234 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   aws-route-worker.cpp
+ *
+ * @brief  Unit tests for the route worker and credentials cache of the
+ *         AWS VPC addon, using a mock EC2 API
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "addons/aws/route-worker.hpp"
+
+
+namespace unittest {
+
+/**
+ *  Mock of the EC2 API calls, recording all the route changes.  Changes
+ *  to the "blocked" route waits until Release() is called, to be able
+ *  to queue up more changes while the worker threads are busy.
+ */
+class MockEC2
+{
+  public:
+    std::vector<std::pair<VPC::Action, std::string>> calls;
+    std::vector<std::string> errors;
+    std::atomic<unsigned int> running{0};
+    std::atomic<unsigned int> max_running{0};
+
+    void Call(const VPC::Action action, const VPC::Route &route)
+    {
+        unsigned int r = ++running;
+        unsigned int m = max_running;
+        while (r > m && !max_running.compare_exchange_weak(m, r))
+        {
+        }
+
+        if ("blocked" == route.cidr)
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            gate.wait(lock,
+                      [this]()
+                      {
+                          return released;
+                      });
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            calls.emplace_back(action, route.cidr);
+        }
+        --running;
+        if ("fail" == route.cidr)
+        {
+            throw std::runtime_error("InvalidRoute.NotFound");
+        }
+    }
+
+    void Report(const VPC::Action action, const VPC::Route &route, const std::string &error)
+    {
+        if (!error.empty())
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            errors.push_back(route.cidr + ": " + error);
+        }
+    }
+
+    void Release()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            released = true;
+        }
+        gate.notify_all();
+    }
+
+    VPC::RouteWorker::Ptr CreateWorker(const unsigned int parallel)
+    {
+        return VPC::RouteWorker::Create(
+            [this](const VPC::Action action, const VPC::Route &route)
+            {
+                Call(action, route);
+            },
+            [this](const VPC::Action action, const VPC::Route &route, const std::string &error)
+            {
+                Report(action, route, error);
+            },
+            parallel);
+    }
+
+  private:
+    std::mutex mtx;
+    std::condition_variable gate;
+    bool released = false;
+};
+
+
+static std::vector<std::string> added_routes(VPC::RouteWorker::Ptr worker)
+{
+    std::vector<std::string> ret;
+    for (const auto &r : worker->GetAddedRoutes())
+    {
+        ret.push_back(r.cidr + (r.ipv6 ? " (v6)" : ""));
+    }
+    return ret;
+}
+
+
+TEST(AWSRouteWorker, coalesce)
+{
+    MockEC2 ec2;
+    auto worker = ec2.CreateWorker(1);
+
+    worker->Queue(VPC::Action::ADD, {"10.0.0.0/24", false});
+    worker->Flush();
+
+    // Keep the only worker thread busy while more changes are queued
+    worker->Queue(VPC::Action::ADD, {"blocked", false});
+    while (0 == ec2.running)
+    {
+        std::this_thread::yield();
+    }
+
+    // Added and removed again; never sent
+    worker->Queue(VPC::Action::ADD, {"10.0.1.0/24", false});
+    worker->Queue(VPC::Action::REMOVE, {"10.0.1.0/24", false});
+
+    // Removed and added again while already in the VPC; never sent
+    worker->Queue(VPC::Action::REMOVE, {"10.0.0.0/24", false});
+    worker->Queue(VPC::Action::ADD, {"10.0.0.0/24", false});
+
+    // Duplicated changes are only sent once
+    worker->Queue(VPC::Action::ADD, {"fd00::/64", true});
+    worker->Queue(VPC::Action::ADD, {"fd00::/64", true});
+
+    // Changes of the route in progress are not merged with it
+    worker->Queue(VPC::Action::REMOVE, {"blocked", false});
+
+    ec2.Release();
+    worker->Flush();
+
+    ASSERT_EQ(ec2.calls.size(), 4);
+    EXPECT_EQ(ec2.calls[0].second, "10.0.0.0/24");
+    EXPECT_EQ(ec2.calls[1].second, "blocked");
+    EXPECT_EQ(ec2.calls[2].second, "fd00::/64");
+    EXPECT_EQ(ec2.calls[3].first, VPC::Action::REMOVE);
+    EXPECT_EQ(ec2.calls[3].second, "blocked");
+    EXPECT_EQ(added_routes(worker),
+              std::vector<std::string>({"10.0.0.0/24", "fd00::/64 (v6)"}));
+    EXPECT_TRUE(ec2.errors.empty());
+}
+
+
+TEST(AWSRouteWorker, parallel)
+{
+    MockEC2 ec2;
+    auto worker = ec2.CreateWorker(3);
+    for (int i = 0; i < 30; ++i)
+    {
+        worker->Queue(VPC::Action::ADD, {"10.1." + std::to_string(i) + ".0/24", false});
+    }
+    worker->Queue(VPC::Action::ADD, {"fail", false});
+    worker->Flush();
+
+    EXPECT_EQ(ec2.calls.size(), 31);
+    EXPECT_LE(ec2.max_running, 3);
+    EXPECT_EQ(worker->GetAddedRoutes().size(), 30);
+    ASSERT_EQ(ec2.errors.size(), 1);
+    EXPECT_EQ(ec2.errors[0], "fail: InvalidRoute.NotFound");
+
+    // All changes are applied before the worker is destroyed
+    worker->Queue(VPC::Action::REMOVE, {"10.1.0.0/24", false});
+    worker.reset();
+    EXPECT_EQ(ec2.calls.size(), 32);
+}
+
+
+TEST(AWSRouteWorker, credentials_cache)
+{
+    int fetched = 0;
+    bool fail = false;
+    auto cache = VPC::CredentialsCache<std::string>::Create(
+        [&]()
+        {
+            if (fail)
+            {
+                throw std::runtime_error("IMDS unavailable");
+            }
+            return "token-" + std::to_string(++fetched);
+        },
+        std::chrono::hours(1));
+
+    EXPECT_EQ(cache->Get(), "token-1");
+    EXPECT_EQ(cache->Get(), "token-1");
+
+    cache->Invalidate();
+    EXPECT_EQ(cache->Get(), "token-2");
+
+    cache->Invalidate();
+    fail = true;
+    EXPECT_THROW(cache->Get(), std::runtime_error);
+    fail = false;
+    EXPECT_EQ(cache->Get(), "token-3");
+
+    auto expired = VPC::CredentialsCache<int>::Create(
+        [&]()
+        {
+            return ++fetched;
+        },
+        std::chrono::seconds(0));
+    int first = expired->Get();
+    EXPECT_EQ(expired->Get(), first + 1);
+}
+
+} // namespace unittest
@@ -0,0 +1,145 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   cmdargparser.cpp
+ *
+ * @brief  Unit tests for the Commands registry and command line splitting
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "common/cmdargparser.hpp"
+
+
+namespace unittest {
+
+static int prepared_first = 0;
+static int prepared_second = 0;
+static std::vector<std::string> last_args;
+static std::string last_value;
+
+
+static int cmd_record(ParsedArgs::Ptr args)
+{
+    last_args = args->GetAllExtraArgs();
+    last_value = (args->Present("value") ? args->GetValue("value", 0) : "");
+    return 0;
+}
+
+
+static SingleCommand::Ptr prepare_first()
+{
+    ++prepared_first;
+    auto cmd = std::make_shared<SingleCommand>("first", "First command", cmd_record);
+    cmd->AddOption("value", 'v', "VALUE", true, "A value");
+    cmd->SetAliasCommand("primary");
+    return cmd;
+}
+
+
+static SingleCommand::Ptr prepare_second()
+{
+    ++prepared_second;
+    return std::make_shared<SingleCommand>("second", "Second command", cmd_record);
+}
+
+
+/**
+ *  Runs a command line through Commands::ProcessCommandLine()
+ */
+static int run(Commands &cmds, std::vector<std::string> args)
+{
+    std::vector<char *> argv;
+    for (auto &a : args)
+    {
+        argv.push_back(a.data());
+    }
+    argv.push_back(nullptr);
+    return cmds.ProcessCommandLine(static_cast<int>(args.size()), argv.data());
+}
+
+
+TEST(Commands, lazy_registration)
+{
+    prepared_first = 0;
+    prepared_second = 0;
+
+    Commands cmds("test", "Unit test");
+    cmds.RegisterCommand("first", prepare_first, "primary");
+    cmds.RegisterCommand("second", prepare_second);
+    ASSERT_EQ(prepared_first, 0);
+    ASSERT_EQ(prepared_second, 0);
+
+    // Only the invoked command is prepared, and only once
+    ASSERT_EQ(run(cmds, {"test", "first", "-v", "one", "extra"}), 0);
+    ASSERT_EQ(last_value, "one");
+    ASSERT_EQ(last_args, std::vector<std::string>{"extra"});
+    ASSERT_EQ(run(cmds, {"test", "primary", "--value", "two"}), 0);
+    ASSERT_EQ(last_value, "two");
+    ASSERT_TRUE(last_args.empty());
+    ASSERT_EQ(prepared_first, 1);
+    ASSERT_EQ(prepared_second, 0);
+
+    // All commands are needed for the shell completion
+    auto all = cmds.GetAllCommandObjects();
+    ASSERT_EQ(all.size(), 3);
+    ASSERT_EQ(prepared_first, 1);
+    ASSERT_EQ(prepared_second, 1);
+}
+
+
+TEST(Commands, registration_mismatch)
+{
+    Commands cmds("test", "Unit test");
+    cmds.RegisterCommand("other", prepare_second);
+    ASSERT_THROW(run(cmds, {"test", "other"}), CommandException);
+}
+
+
+TEST(Commands, repeated_parsing)
+{
+    Commands cmds("test", "Unit test");
+    cmds.RegisterCommand("first", prepare_first, "primary");
+
+    // getopt_long() must not keep any state between the parsing
+    // of different command lines
+    ASSERT_EQ(run(cmds, {"test", "first", "arg1", "-vone", "arg2"}), 0);
+    ASSERT_EQ(last_value, "one");
+    ASSERT_EQ(last_args, (std::vector<std::string>{"arg1", "arg2"}));
+    ASSERT_EQ(run(cmds, {"test", "first", "-v", "two"}), 0);
+    ASSERT_EQ(last_value, "two");
+    ASSERT_TRUE(last_args.empty());
+}
+
+
+TEST(SplitCommandLine, arguments)
+{
+    using Args = std::vector<std::string>;
+
+    ASSERT_EQ(SplitCommandLine(""), Args{});
+    ASSERT_EQ(SplitCommandLine("  \t "), Args{});
+    ASSERT_EQ(SplitCommandLine("sessions-list"), Args{"sessions-list"});
+    ASSERT_EQ(SplitCommandLine("  session-stats   --config  vpn1 "),
+              (Args{"session-stats", "--config", "vpn1"}));
+    ASSERT_EQ(SplitCommandLine("config-dump -c 'My VPN profile'"),
+              (Args{"config-dump", "-c", "My VPN profile"}));
+    ASSERT_EQ(SplitCommandLine("config-dump -c \"My \\\"VPN\\\" profile\""),
+              (Args{"config-dump", "-c", "My \"VPN\" profile"}));
+    ASSERT_EQ(SplitCommandLine("a\\ b 'c\\d' \"e\\f\" ''"),
+              (Args{"a b", "c\\d", "e\\f", ""}));
+    ASSERT_EQ(SplitCommandLine("pre'quoted text'post"),
+              Args{"prequoted textpost"});
+
+    ASSERT_THROW(SplitCommandLine("config-dump -c 'My VPN"), CommandArgBaseException);
+    ASSERT_THROW(SplitCommandLine("config-dump -c \"My VPN"), CommandArgBaseException);
+}
+
+} // namespace unittest
@@ -0,0 +1,141 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   configmgr-profilecache.cpp
+ *
+ * @brief  Unit tests for the configuration manager ProfileCache
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "configmgr/profile-cache.hpp"
+
+
+namespace unittest {
+
+static const std::string test_profile = "client\n"
+                                        "dev tun\n"
+                                        "remote vpn.example.org 1194\n"
+                                        "<ca>\n"
+                                        "-----BEGIN CERTIFICATE-----\n"
+                                        "-----END CERTIFICATE-----\n"
+                                        "</ca>\n";
+
+
+TEST(ProfileCache, normalize)
+{
+    using ConfigManager::ProfileCache;
+
+    ASSERT_EQ(ProfileCache::Normalize(test_profile),
+              test_profile.substr(0, test_profile.size() - 1));
+    ASSERT_EQ(ProfileCache::Normalize("\n  \n\t\n" + test_profile + "\n\n  "),
+              ProfileCache::Normalize(test_profile));
+
+    // Indentation on the first line with content is kept
+    ASSERT_EQ(ProfileCache::Normalize("\n  client\n"), "  client");
+    ASSERT_EQ(ProfileCache::Normalize(""), "");
+    ASSERT_EQ(ProfileCache::Normalize(" \n\t "), "");
+}
+
+
+TEST(ProfileCache, shared_profiles)
+{
+    auto cache = ConfigManager::ProfileCache::Create();
+
+    auto p1 = cache->Parse(test_profile);
+    auto p2 = cache->Parse("\n" + test_profile + "\n\n");
+    ASSERT_EQ(p1, p2);
+    ASSERT_TRUE(p1->Valid());
+    ASSERT_TRUE(p1->GetValidationError().empty());
+
+    auto p3 = cache->Parse("client\ndev tun\n");
+    ASSERT_NE(p1, p3);
+    ASSERT_FALSE(p3->Valid());
+
+    // The JSON import of a profile is cached separately
+    auto j1 = cache->Import(p1->GetOptions()->json_export());
+    auto j2 = cache->Import(p1->GetOptions()->json_export());
+    ASSERT_EQ(j1, j2);
+    ASSERT_NE(j1, p1);
+    ASSERT_EQ(j1->GetOptions()->string_export(), p1->GetOptions()->string_export());
+
+    auto stats = cache->GetStatistics();
+    ASSERT_EQ(stats.entries, 3);
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.misses, 3);
+    ASSERT_EQ(stats.evictions, 0);
+}
+
+
+TEST(ProfileCache, evict_unused)
+{
+    auto cache = ConfigManager::ProfileCache::Create(1);
+
+    auto used = cache->Parse(test_profile);
+    cache->Parse("client\ndev tun\n");
+    cache->Parse("client\ndev tap\n");
+
+    // A newly parsed profile is not evicted before the caller has
+    // had a chance to use it
+    auto stats = cache->GetStatistics();
+    ASSERT_EQ(stats.entries, 3);
+    ASSERT_EQ(stats.evictions, 0);
+
+    // The profile still in use is kept, only one unused profile is kept
+    cache->SetMaxUnused(1);
+    stats = cache->GetStatistics();
+    ASSERT_EQ(stats.entries, 2);
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_EQ(cache->Parse(test_profile), used);
+
+    cache->SetMaxUnused(0);
+    stats = cache->GetStatistics();
+    ASSERT_EQ(stats.entries, 1);
+    ASSERT_EQ(stats.evictions, 2);
+
+    used.reset();
+    cache->SetMaxUnused(0);
+    ASSERT_EQ(cache->GetStatistics().entries, 0);
+}
+
+TEST(ProfileCache, compact_profiles)
+{
+    auto full = ConfigManager::ProfileCache::Create();
+    auto compact = ConfigManager::ProfileCache::Create();
+    compact->SetCompact(true);
+
+    const std::string profile = test_profile
+                                + "route 192.0.2.0 255.255.255.0\n"
+                                + "setenv opt block-outside-dns\n";
+    auto p_full = full->Parse(profile);
+    auto p_compact = compact->Parse(profile);
+    ASSERT_FALSE(p_full->Compact());
+    ASSERT_TRUE(p_compact->Compact());
+    ASSERT_TRUE(p_compact->Valid());
+    ASSERT_EQ(p_compact->GetOptions()->string_export(),
+              p_full->GetOptions()->string_export());
+    ASSERT_EQ(p_compact->GetOptions()->json_export(),
+              p_full->GetOptions()->json_export());
+    ASSERT_LT(p_compact->MemoryUsage(), p_full->MemoryUsage());
+
+    // The CA certificate is shared between different profiles
+    auto p2 = compact->Parse(profile + "verb 4\n");
+    ASSERT_NE(p_compact, p2);
+    auto mem = compact->GetMemoryUsage();
+    ASSERT_EQ(mem.shared_blobs, 1);
+    ASSERT_EQ(mem.profile_bytes, p_compact->MemoryUsage() + p2->MemoryUsage());
+
+    auto p3 = compact->Parse(std::string("client\ndev tun\n")
+                             + "<ca>\n-----BEGIN CERTIFICATE-----\n</ca>\n");
+    ASSERT_EQ(compact->GetMemoryUsage().shared_blobs, 2);
+}
+
+} // namespace unittest
@@ -0,0 +1,129 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   devposture-profileindex.cpp
+ *
+ * @brief  Unit tests for the device posture protocol profile index
+ */
+
+#include <sstream>
+#include <string>
+#include <json/json.h>
+
+#include <gtest/gtest.h>
+
+#include "addons/devposture/profile-index.hpp"
+
+
+namespace unittest {
+
+using namespace DevPosture;
+
+
+/**
+ *  Device posture module returning a fixed value
+ */
+class FixedModule : public Module
+{
+  public:
+    FixedModule(const std::string &value_)
+        : value(value_)
+    {
+    }
+
+    Dictionary Run(const Dictionary &) override
+    {
+        return {{"value", value}};
+    }
+
+    std::string name() const override
+    {
+        return "fixed";
+    }
+
+    std::string type() const override
+    {
+        return "test";
+    }
+
+    uint16_t version() const override
+    {
+        return 1;
+    }
+
+  private:
+    std::string value;
+};
+
+
+static Json::Value create_profile(const std::string &appcontrol_id,
+                                  const std::string &version,
+                                  const std::string &check)
+{
+    Json::Value profile;
+    profile["appcontrol_id"] = appcontrol_id;
+    profile["ver"] = version;
+    profile["control_mapping"][check]["module"] = "/modules/fixed";
+    profile["control_mapping"][check]["result_mapping"]["result"] = "value";
+    return profile;
+}
+
+
+static Json::Value parse_response(const std::string &response)
+{
+    Json::Value json;
+    std::istringstream instr(response);
+    instr >> json;
+    return json["dpc_response"];
+}
+
+
+static std::string create_request(const std::string &version)
+{
+    return "{\"dpc_request\": {\"ver\": \"" + version + "\", "
+           "\"correlation_id\": \"1234\", "
+           "\"check_v1\": true, \"check_v2\": true}}";
+}
+
+
+TEST(DevPostureProfileIndex, protocol_versions)
+{
+    auto fixed = CachedModule::Create(Module::Create<FixedModule>("ok"));
+    auto index = ProfileIndex::Create(
+        [fixed](const std::string &path) -> CachedModule::Ptr
+        {
+            return ("/modules/fixed" == path ? fixed : nullptr);
+        });
+
+    // Both profiles support the same protocol, with different versions
+    index->AddProfile("profile-a", create_profile("dpc:other", "1.0", "check_v1"));
+    index->AddProfile("profile-b", create_profile("dpc", "2.0", "check_v2"));
+
+    auto v1 = parse_response(index->RunChecks("dpc", create_request("1.0")));
+    EXPECT_EQ(v1["ver"].asString(), "1.0");
+    EXPECT_EQ(v1["correlation_id"].asString(), "1234");
+    EXPECT_EQ(v1["check_v1"]["result"].asString(), "ok");
+    EXPECT_FALSE(v1.isMember("check_v2"));
+
+    auto v2 = parse_response(index->RunChecks("dpc", create_request("2.0")));
+    EXPECT_EQ(v2["ver"].asString(), "2.0");
+    EXPECT_EQ(v2["check_v2"]["result"].asString(), "ok");
+    EXPECT_FALSE(v2.isMember("check_v1"));
+
+    // The second protocol of profile-a
+    auto other = parse_response(index->RunChecks("other", create_request("1.0")));
+    EXPECT_EQ(other["check_v1"]["result"].asString(), "ok");
+
+    EXPECT_THROW(index->RunChecks("dpc", create_request("3.0")), CheckException);
+    EXPECT_THROW(index->RunChecks("other", create_request("2.0")), CheckException);
+    EXPECT_THROW(index->RunChecks("unknown", create_request("1.0")), CheckException);
+    EXPECT_THROW(index->RunChecks("dpc", "{ invalid"), InvalidRequest);
+}
+
+} // namespace unittest
@@ -245,4 +245,57 @@ TEST(LogMetaData, GetMetaDataRecords)
                                  "LOGTAG=" + tag->str(false)});
 }
 
+
+TEST(LogMetaData, GetStructuredDataParams)
+{
+    auto lmd = LogMetaData::Create();
+    EXPECT_TRUE(lmd->GetStructuredDataParams().empty());
+
+    lmd->AddMeta("label_A", "Value A");
+    lmd->AddMeta("label skip", "Value \"skip\"", true);
+    lmd->AddMeta("path", "C:\\[dir]");
+
+    LogTag::Ptr tag = LogTag::Create("dummysender", "dummyinterface");
+    lmd->AddMeta("logtag", tag);
+
+    EXPECT_EQ(lmd->GetStructuredDataParams(),
+              " label_A=\"Value A\""
+              " label_skip=\"Value \\\"skip\\\"\""
+              " path=\"C:\\\\[dir\\]\""
+              " logtag=\""
+                  + tag->str(false) + "\"");
+}
+
+
+TEST(RenderedLogMetaData, Create)
+{
+    auto lmd = LogMetaData::Create();
+    lmd->AddMeta("label_A", "Value A");
+    lmd->AddMeta("label_skip", "Value skip", true);
+
+    LogTag::Ptr tag = LogTag::Create("dummysender", "dummyinterface");
+    lmd->AddMeta("logtag", tag);
+
+    auto rendered = RenderedLogMetaData::Create(lmd);
+    ASSERT_FALSE(rendered->empty());
+    compare_logmetadata_records(rendered->GetJournaldFields(),
+                                {"O3_LABEL_A=Value A",
+                                 "O3_LABEL_SKIP=Value skip",
+                                 "O3_LOGTAG=" + tag->str(false)});
+
+    std::stringstream s;
+    s << lmd;
+    EXPECT_EQ(rendered->GetText(), s.str());
+    EXPECT_EQ(rendered->GetStructuredDataParams(),
+              lmd->GetStructuredDataParams());
+
+    // Later changes to the source container does not change the
+    // rendered meta data
+    lmd->clear();
+    EXPECT_EQ(rendered->GetJournaldFields().size(), 3);
+    EXPECT_EQ(rendered->GetText(), s.str());
+
+    EXPECT_TRUE(RenderedLogMetaData::Create(nullptr)->empty());
+}
+
 } // namespace unittest
@@ -0,0 +1,138 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   logwriter-rfc5424.cpp
+ *
+ * @brief  Unit tests for RFC5424SyslogWriter, using a local datagram
+ *         socket instead of /dev/log
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <gtest/gtest.h>
+
+#include "log/logwriters/rfc5424.hpp"
+
+
+namespace unittest {
+
+class RFC5424Writer : public ::testing::Test
+{
+  protected:
+    std::string sockpath;
+    int sockfd = -1;
+
+    void SetUp() override
+    {
+        char tmpl[] = "/tmp/o3-rfc5424-XXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        sockpath = std::string(tmpl) + "/log";
+
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        sockpath.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+        sockfd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        ASSERT_GE(sockfd, 0);
+        ASSERT_EQ(bind(sockfd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    }
+
+    void TearDown() override
+    {
+        close(sockfd);
+        unlink(sockpath.c_str());
+        rmdir(sockpath.substr(0, sockpath.rfind('/')).c_str());
+    }
+
+    std::vector<std::string> receive()
+    {
+        std::vector<std::string> ret;
+        char buf[4096];
+        ssize_t len = 0;
+        while ((len = recv(sockfd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        {
+            ret.emplace_back(buf, static_cast<size_t>(len));
+        }
+        return ret;
+    }
+};
+
+
+TEST_F(RFC5424Writer, missing_socket)
+{
+    EXPECT_THROW(RFC5424SyslogWriter("test", LOG_DAEMON, sockpath + ".missing"),
+                 SyslogException);
+}
+
+
+TEST_F(RFC5424Writer, messages)
+{
+    auto tag = LogTag::Create(":1.42", "net.openvpn.v3.test");
+    {
+        RFC5424SyslogWriter w("/usr/sbin/openvpn3-service-log", LOG_LOCAL1, sockpath);
+        w.EnableLogMeta(true);
+        w.Write("plain line");
+
+        auto md = LogMetaData::Create();
+        md->AddMeta("object path", "/net/openvpn/v3/\"test\"]");
+        w.AddMetaCopy(md);
+        Events::Log ev(LogGroup::LOGGER, LogCategory::ERROR, "log event");
+        ev.AddLogTag(tag);
+        w.Write(ev);
+        // The writer is flushed when destroyed
+    }
+
+    auto msgs = receive();
+    ASSERT_EQ(msgs.size(), 2);
+
+    // <LOG_LOCAL1 | LOG_INFO>1 TIMESTAMP HOSTNAME APP-NAME PROCID - - MSG
+    const std::string pid = " " + std::to_string(getpid()) + " - ";
+    EXPECT_EQ(msgs[0].substr(0, 7), "<142>1 ");
+    EXPECT_EQ(msgs[0][33], 'Z');
+    EXPECT_NE(msgs[0].find(" openvpn3-service-log" + pid + "- plain line"),
+              std::string::npos);
+
+    EXPECT_EQ(msgs[1].substr(0, 7), "<139>1 ");
+    const std::string sd = pid
+                           + "[openvpn3 object_path=\"/net/openvpn/v3/\\\"test\\\"\\]\"] "
+                           + tag->str(true) + " " + LogPrefix(LogGroup::LOGGER, LogCategory::ERROR)
+                           + "log event";
+    ASSERT_GT(msgs[1].size(), sd.size());
+    EXPECT_EQ(msgs[1].substr(msgs[1].size() - sd.size()), sd);
+}
+
+
+TEST_F(RFC5424Writer, oversized_message)
+{
+    {
+        RFC5424SyslogWriter w("test", LOG_DAEMON, sockpath);
+        w.Write("before");
+        // Larger than any datagram the socket accepts
+        w.Write(std::string(1024 * 1024, 'x'));
+        w.Write("after");
+    }
+
+    // Only the oversized message is skipped, not the rest of the batch
+    bool before = false;
+    bool after = false;
+    for (const auto &m : receive())
+    {
+        EXPECT_LT(m.size(), 4096);
+        before |= (m.find(" - - before") != std::string::npos);
+        after |= (m.find(" - - after") != std::string::npos);
+    }
+    EXPECT_TRUE(before);
+    EXPECT_TRUE(after);
+}
+
+} // namespace unittest
@@ -0,0 +1,82 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-configdiff.cpp
+ *
+ * @brief  Unit tests for NetCfg::DiffLists()
+ */
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "netcfg/netcfg-configdiff.hpp"
+
+
+namespace unittest {
+
+struct Route
+{
+    std::string address;
+    unsigned int prefix;
+
+    bool operator<(const Route &other) const
+    {
+        return std::tie(address, prefix) < std::tie(other.address, other.prefix);
+    }
+
+    bool operator==(const Route &other) const
+    {
+        return std::tie(address, prefix) == std::tie(other.address, other.prefix);
+    }
+};
+
+
+TEST(NetCfgConfigDiff, unchanged)
+{
+    std::vector<Route> prev{{"10.0.0.0", 8}, {"192.168.1.0", 24}};
+    std::vector<Route> next{{"192.168.1.0", 24}, {"10.0.0.0", 8}};
+
+    auto diff = NetCfg::DiffLists(prev, next);
+    ASSERT_TRUE(diff.empty());
+}
+
+
+TEST(NetCfgConfigDiff, changed)
+{
+    std::vector<Route> prev{{"10.0.0.0", 8}, {"192.168.1.0", 24}};
+    std::vector<Route> next{{"10.0.0.0", 8}, {"192.168.1.0", 25}, {"172.16.0.0", 12}};
+
+    auto diff = NetCfg::DiffLists(prev, next);
+    ASSERT_FALSE(diff.empty());
+    ASSERT_EQ(diff.removed.size(), 1);
+    ASSERT_EQ(diff.removed[0], (Route{"192.168.1.0", 24}));
+    ASSERT_EQ(diff.added.size(), 2);
+    ASSERT_EQ(diff.added[0], (Route{"172.16.0.0", 12}));
+    ASSERT_EQ(diff.added[1], (Route{"192.168.1.0", 25}));
+}
+
+
+TEST(NetCfgConfigDiff, duplicates)
+{
+    std::vector<std::string> prev{"a", "a", "b"};
+    std::vector<std::string> next{"a", "b", "b"};
+
+    auto diff = NetCfg::DiffLists(prev, next);
+    ASSERT_EQ(diff.removed, std::vector<std::string>{"a"});
+    ASSERT_EQ(diff.added, std::vector<std::string>{"b"});
+
+    diff = NetCfg::DiffLists(std::vector<std::string>{}, next);
+    ASSERT_TRUE(diff.removed.empty());
+    ASSERT_EQ(diff.added.size(), 3);
+}
+
+} // namespace unittest
@@ -0,0 +1,86 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-dco-engine.cpp
+ *
+ * @brief  Unit tests for the shared DCO event loop pool
+ */
+
+#include "build-config.h"
+
+#ifdef ENABLE_OVPNDCO
+#include <atomic>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "netcfg/netcfg-dco-engine.hpp"
+
+
+namespace unittest {
+
+TEST(NetCfgDCOEngine, attach_balanced)
+{
+    auto engine = NetCfgDCOEngine::Create(2);
+    ASSERT_EQ(engine->GetStatistics().threads, 0);
+
+    auto q1 = engine->Attach();
+    auto q2 = engine->Attach();
+    auto q3 = engine->Attach();
+    ASSERT_EQ(engine->GetStatistics().threads, 2);
+    ASSERT_EQ(engine->GetStatistics().devices, 3);
+    ASSERT_NE(q1->GetStatistics().worker, q2->GetStatistics().worker);
+
+    q3.reset();
+    ASSERT_EQ(engine->GetStatistics().devices, 2);
+
+    // A new device goes to the worker which now has the fewest devices
+    auto q4 = engine->Attach();
+    ASSERT_EQ(engine->GetStatistics().devices, 3);
+}
+
+
+TEST(NetCfgDCOEngine, queue_tasks)
+{
+    auto engine = NetCfgDCOEngine::Create(1);
+    auto queue = engine->Attach();
+
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 100; ++i)
+    {
+        queue->Post([&counter]()
+                    {
+                        ++counter;
+                    });
+    }
+    queue->Post([]()
+                {
+                    throw std::runtime_error("task failed");
+                });
+    queue->Drain();
+    ASSERT_EQ(counter.load(), 100);
+
+    auto stats = queue->GetStatistics();
+    ASSERT_EQ(stats.executed, 101);
+    ASSERT_EQ(stats.failed, 1);
+    ASSERT_EQ(stats.pending, 0);
+    ASSERT_GE(stats.pending_max, 1);
+
+    // The worker keeps running as long as devices are attached
+    engine.reset();
+    queue->Post([&counter]()
+                {
+                    ++counter;
+                });
+    queue->Drain();
+    ASSERT_EQ(counter.load(), 101);
+}
+
+} // namespace unittest
+#endif // ENABLE_OVPNDCO
@@ -0,0 +1,65 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-qdisc.cpp
+ *
+ * @brief  Unit tests for parsing the NetCfg::Qdisc specifications
+ */
+
+#include <gtest/gtest.h>
+
+#include "netcfg/netcfg-qdisc.hpp"
+
+
+namespace unittest {
+
+TEST(NetCfgQdisc, parse_empty)
+{
+    auto q = NetCfg::Qdisc::Parse("");
+    ASSERT_TRUE(q.empty());
+    ASSERT_EQ(q.str(), "");
+}
+
+
+TEST(NetCfgQdisc, parse_kind)
+{
+    auto q = NetCfg::Qdisc::Parse("fq");
+    ASSERT_FALSE(q.empty());
+    ASSERT_EQ(q.kind, "fq");
+    ASSERT_TRUE(q.params.empty());
+    ASSERT_EQ(q.str(), "fq");
+}
+
+
+TEST(NetCfgQdisc, parse_params)
+{
+    auto q = NetCfg::Qdisc::Parse("fq_codel:target=5000,interval=100000");
+    ASSERT_EQ(q.kind, "fq_codel");
+    ASSERT_EQ(q.params.size(), 2);
+    ASSERT_EQ(q.params["target"], 5000);
+    ASSERT_EQ(q.params["interval"], 100000);
+    ASSERT_EQ(q.str(), "fq_codel:interval=100000,target=5000");
+
+    // The textual representation must parse back to the same result
+    ASSERT_EQ(NetCfg::Qdisc::Parse(q.str()).str(), q.str());
+}
+
+
+TEST(NetCfgQdisc, parse_invalid)
+{
+    ASSERT_THROW(NetCfg::Qdisc::Parse("cake"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("fq:target=5000"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("fq:maxrate"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("fq:maxrate=fast"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("fq:maxrate=-1"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("fq:maxrate=10M"), NetCfg::QdiscException);
+    ASSERT_THROW(NetCfg::Qdisc::Parse("pfifo_fast:limit=10"), NetCfg::QdiscException);
+}
+
+} // namespace unittest
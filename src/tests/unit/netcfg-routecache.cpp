@@ -0,0 +1,176 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   netcfg-routecache.cpp
+ *
+ * @brief  Unit tests for NetCfgRouteCache
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/rtnetlink.h>
+
+#include <gtest/gtest.h>
+
+#include "netcfg/netcfg-routecache.hpp"
+
+
+namespace unittest {
+
+class RouteCacheTest : public ::testing::Test
+{
+  protected:
+    unsigned int lookups = 0;
+    NetCfgRouteCache::Ptr cache = nullptr;
+
+    void SetUp() override
+    {
+        cache = NetCfgRouteCache::Create(
+            [this](const std::string &remote, bool ipv6)
+            {
+                ++lookups;
+                return std::string(ipv6 ? "eth6" : "eth4");
+            },
+            false);
+    }
+
+    void invalidate(int family, const std::string &prefix, unsigned int len)
+    {
+        uint8_t addr[16] = {};
+        ASSERT_EQ(inet_pton(family, prefix.c_str(), addr), 1);
+        cache->InvalidatePrefix(family, addr, len);
+    }
+
+    void link_event(const std::string &ifname, unsigned int flags)
+    {
+        std::vector<char> buf(NLMSG_SPACE(sizeof(struct ifinfomsg))
+                              + RTA_SPACE(ifname.size() + 1));
+        auto nlh = reinterpret_cast<struct nlmsghdr *>(buf.data());
+        nlh->nlmsg_len = buf.size();
+        nlh->nlmsg_type = RTM_NEWLINK;
+        auto ifi = static_cast<struct ifinfomsg *>(NLMSG_DATA(nlh));
+        ifi->ifi_flags = flags;
+        auto rta = IFLA_RTA(ifi);
+        rta->rta_type = IFLA_IFNAME;
+        rta->rta_len = RTA_LENGTH(ifname.size() + 1);
+        memcpy(RTA_DATA(rta), ifname.c_str(), ifname.size() + 1);
+        cache->ProcessNetlinkMessage(nlh);
+    }
+
+    // Reports a new default route in a routing table
+    void route_event(int family, uint8_t table)
+    {
+        std::vector<char> buf(NLMSG_SPACE(sizeof(struct rtmsg)));
+        auto nlh = reinterpret_cast<struct nlmsghdr *>(buf.data());
+        nlh->nlmsg_len = buf.size();
+        nlh->nlmsg_type = RTM_NEWROUTE;
+        auto rtm = static_cast<struct rtmsg *>(NLMSG_DATA(nlh));
+        rtm->rtm_family = family;
+        rtm->rtm_table = table;
+        cache->ProcessNetlinkMessage(nlh);
+    }
+};
+
+
+TEST_F(RouteCacheTest, cache_hits)
+{
+    ASSERT_EQ(cache->GetBestDevice("192.0.2.1", false), "eth4");
+    ASSERT_EQ(cache->GetBestDevice("192.0.2.1", false), "eth4");
+    ASSERT_EQ(cache->GetBestDevice("2001:db8::1", true), "eth6");
+    ASSERT_EQ(cache->GetBestDevice("2001:db8::1", true), "eth6");
+    ASSERT_EQ(lookups, 2);
+
+    auto stats = cache->GetStatistics();
+    ASSERT_EQ(stats.entries, 2);
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.misses, 2);
+}
+
+
+TEST_F(RouteCacheTest, invalidate_prefix)
+{
+    cache->GetBestDevice("192.0.2.1", false);
+    cache->GetBestDevice("192.0.2.200", false);
+    cache->GetBestDevice("198.51.100.1", false);
+    cache->GetBestDevice("2001:db8::1", true);
+
+    // Only covering 192.0.2.1
+    invalidate(AF_INET, "192.0.2.0", 25);
+    ASSERT_EQ(cache->GetStatistics().entries, 3);
+
+    // Only covering 192.0.2.200
+    invalidate(AF_INET, "192.0.2.128", 25);
+    ASSERT_EQ(cache->GetStatistics().entries, 2);
+
+    // Not covering any of the remaining cached addresses
+    invalidate(AF_INET, "192.0.2.1", 32);
+    ASSERT_EQ(cache->GetStatistics().entries, 2);
+
+    // A default route covers all addresses of the same family
+    invalidate(AF_INET, "0.0.0.0", 0);
+    ASSERT_EQ(cache->GetStatistics().entries, 1);
+
+    invalidate(AF_INET6, "2001:db8::", 32);
+    ASSERT_EQ(cache->GetStatistics().entries, 0);
+    ASSERT_EQ(cache->GetStatistics().invalidated, 4);
+}
+
+
+TEST_F(RouteCacheTest, flush)
+{
+    cache->GetBestDevice("192.0.2.1", false);
+    cache->GetBestDevice("2001:db8::1", true);
+    cache->Flush();
+    ASSERT_EQ(cache->GetStatistics().entries, 0);
+
+    cache->GetBestDevice("192.0.2.1", false);
+    ASSERT_EQ(lookups, 3);
+}
+
+
+TEST_F(RouteCacheTest, link_down)
+{
+    cache->GetBestDevice("192.0.2.1", false);
+    cache->GetBestDevice("198.51.100.1", false);
+    cache->GetBestDevice("2001:db8::1", true);
+
+    // The kernel does not report the routes removed with the link,
+    // so all the entries using the device are removed
+    link_event("eth4", 0);
+    ASSERT_EQ(cache->GetStatistics().entries, 1);
+    ASSERT_EQ(cache->GetStatistics().invalidated, 2);
+
+    link_event("eth0", 0);
+    ASSERT_EQ(cache->GetStatistics().entries, 1);
+
+    // A link coming up may provide a better route to any host
+    link_event("eth4", IFF_UP | IFF_RUNNING);
+    ASSERT_EQ(cache->GetStatistics().entries, 0);
+}
+
+
+TEST_F(RouteCacheTest, route_table)
+{
+    cache->GetBestDevice("192.0.2.1", false);
+    cache->GetBestDevice("2001:db8::1", true);
+
+    // Routes outside the main routing table are not used by the lookup
+    route_event(AF_INET, 100);
+    route_event(AF_INET, RT_TABLE_LOCAL);
+    ASSERT_EQ(cache->GetStatistics().entries, 2);
+
+    route_event(AF_INET, RT_TABLE_MAIN);
+    ASSERT_EQ(cache->GetStatistics().entries, 1);
+}
+
+} // namespace unittest
@@ -0,0 +1,106 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   requiresqueue.cpp
+ *
+ * @brief  Unit tests for the service side lookups of RequiresQueue
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/requiresqueue.hpp"
+
+
+namespace unittest {
+
+static const auto CRED = ClientAttentionType::CREDENTIALS;
+static const auto USERPASS = ClientAttentionGroup::USER_PASSWORD;
+static const auto CHALLENGE = ClientAttentionGroup::CHALLENGE_STATIC;
+
+
+RequiresQueue::Ptr prepare_queue()
+{
+    auto q = RequiresQueue::Create();
+    EXPECT_EQ(q->RequireAdd(CRED, USERPASS, "username", "Auth User name", false), 0);
+    EXPECT_EQ(q->RequireAdd(CRED, USERPASS, "password", "Auth Password", true), 1);
+    EXPECT_EQ(q->RequireAdd(CRED, CHALLENGE, "static_challenge", "Enter PIN", true), 0);
+    return q;
+}
+
+
+TEST(RequiresQueue, lookups)
+{
+    auto q = prepare_queue();
+    EXPECT_EQ(q->QueueCount(CRED, USERPASS), 2);
+    EXPECT_EQ(q->QueueCount(CRED, CHALLENGE), 1);
+    EXPECT_EQ(q->QueueCount(CRED, ClientAttentionGroup::PK_PASSPHRASE), 0);
+
+    auto tg = q->QueueCheckTypeGroup();
+    ASSERT_EQ(tg.size(), 2);
+    EXPECT_EQ(tg[0], std::make_tuple(CRED, USERPASS));
+    EXPECT_EQ(tg[1], std::make_tuple(CRED, CHALLENGE));
+
+    q->UpdateEntry(CRED, USERPASS, 1, "secret");
+    EXPECT_EQ(q->QueueCheck(CRED, USERPASS), std::vector<uint32_t>{0});
+    EXPECT_EQ(q->GetResponse(CRED, USERPASS, 1), "secret");
+    EXPECT_EQ(q->GetResponse(CRED, USERPASS, "password"), "secret");
+    EXPECT_THROW(q->GetResponse(CRED, USERPASS, "username"), RequiresQueueException);
+    EXPECT_THROW(q->GetResponse(CRED, USERPASS, 2), RequiresQueueException);
+    EXPECT_THROW(q->UpdateEntry(CRED, USERPASS, 1, "again"), RequiresQueueException);
+    EXPECT_THROW(q->UpdateEntry(CRED, USERPASS, 5, "value"), RequiresQueueException);
+}
+
+
+TEST(RequiresQueue, done_and_reset)
+{
+    auto q = prepare_queue();
+    EXPECT_FALSE(q->QueueAllDone());
+
+    q->UpdateEntry(CRED, USERPASS, 0, "user");
+    q->UpdateEntry(CRED, USERPASS, 1, "pass");
+    EXPECT_TRUE(q->QueueDone(CRED, USERPASS));
+    EXPECT_FALSE(q->QueueAllDone());
+    EXPECT_EQ(q->QueueCheckTypeGroup().size(), 1);
+
+    q->UpdateEntry(CRED, CHALLENGE, 0, "1234");
+    EXPECT_TRUE(q->QueueAllDone());
+    EXPECT_TRUE(q->QueueCheckTypeGroup().empty());
+
+    q->ResetValue(CRED, USERPASS, 1);
+    q->ResetValue(CRED, USERPASS, 1);
+    EXPECT_FALSE(q->QueueAllDone());
+    EXPECT_EQ(q->QueueCheck(CRED, USERPASS), std::vector<uint32_t>{1});
+
+    q->ClearAll();
+    EXPECT_TRUE(q->QueueAllDone());
+    EXPECT_EQ(q->QueueCount(CRED, USERPASS), 0);
+    EXPECT_EQ(q->RequireAdd(CRED, USERPASS, "username", "Auth User name", false), 0);
+}
+
+
+TEST(RequiresQueue, fetch_all)
+{
+    auto q = prepare_queue();
+    q->UpdateEntry(CRED, USERPASS, 0, "user");
+
+    auto pending = q->QueueFetchAll();
+    ASSERT_EQ(pending.size(), 2);
+    EXPECT_EQ(pending[0].group, USERPASS);
+    EXPECT_EQ(pending[0].id, 1);
+    EXPECT_EQ(pending[0].name, "password");
+    EXPECT_TRUE(pending[0].hidden_input);
+    EXPECT_EQ(pending[1].group, CHALLENGE);
+    EXPECT_EQ(pending[1].id, 0);
+    EXPECT_EQ(pending[1].user_description, "Enter PIN");
+}
+
+} // namespace unittest
@@ -77,6 +77,12 @@ TEST(SessionManagerEvent, init_with_values)
     chk3 << ev3;
     std::string expect3("Session destroyed; owner: 456, path: /net/openvpn/v3/test/3");
     ASSERT_EQ(chk3.str(), expect3);
+
+    Event ev4{"/net/openvpn/v3/test/4", EventType::SESS_START_FAILED, 567};
+    ASSERT_FALSE(ev4.empty()) << "Not initialized properly with EventType::SESS_START_FAILED";
+    ASSERT_EQ(ev4.type, EventType::SESS_START_FAILED);
+    ASSERT_EQ(Event::TypeStr(ev4.type), std::string("Session start failed"));
+    ASSERT_EQ(Event::TypeStr(ev4.type, true), "SESS_START_FAILED");
 }
 
 TEST(SessionManagerEvent, init_with_gvariant_valid)
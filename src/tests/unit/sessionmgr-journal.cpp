@@ -0,0 +1,133 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   sessionmgr-journal.cpp
+ *
+ * @brief  Unit tests for SessionManager::SessionJournal
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "sessionmgr/session-journal.hpp"
+
+
+using namespace SessionManager;
+
+namespace unittest {
+
+static std::string journal_filename(const std::string &test)
+{
+    return "/tmp/sessionmgr-journal-" + test + "-" + std::to_string(getpid());
+}
+
+
+static JournalRecord create_record(const std::string &id, pid_t pid)
+{
+    JournalRecord rec;
+    rec.session_path = "/net/openvpn/v3/sessions/" + id;
+    rec.config_path = "/net/openvpn/v3/configuration/" + id;
+    rec.config_name = "config-" + id;
+    rec.backend_busname = "net.openvpn.v3.backends.be" + std::to_string(pid);
+    rec.backend_pid = pid;
+    rec.owner = 1000;
+    rec.created = 1234567890;
+    return rec;
+}
+
+
+TEST(SessionManagerJournal, record_export_import)
+{
+    JournalRecord rec = create_record("abc", 4321);
+    rec.acl = {1001, 1002};
+    rec.public_access = true;
+    rec.restrict_log_access = false;
+
+    JournalRecord chk = JournalRecord::Import(rec.Export());
+    ASSERT_EQ(chk.session_path, rec.session_path);
+    ASSERT_EQ(chk.config_path, rec.config_path);
+    ASSERT_EQ(chk.config_name, rec.config_name);
+    ASSERT_EQ(chk.backend_busname, rec.backend_busname);
+    ASSERT_EQ(chk.backend_pid, rec.backend_pid);
+    ASSERT_EQ(chk.owner, rec.owner);
+    ASSERT_EQ(chk.created, rec.created);
+    ASSERT_EQ(chk.acl, rec.acl);
+    ASSERT_EQ(chk.public_access, rec.public_access);
+    ASSERT_EQ(chk.restrict_log_access, rec.restrict_log_access);
+}
+
+
+TEST(SessionManagerJournal, replay_lifecycle)
+{
+    const std::string fname = journal_filename("lifecycle");
+    std::remove(fname.c_str());
+
+    {
+        auto journal = SessionJournal::Create(fname);
+        ASSERT_TRUE(journal->Replay().empty());
+
+        journal->Created(create_record("s1", 100));
+        journal->Created(create_record("s2", 200));
+        journal->Created(create_record("s3", 300));
+
+        auto upd = create_record("s2", 200);
+        upd.acl = {2000};
+        journal->Updated(upd);
+        journal->Removed("/net/openvpn/v3/sessions/s1");
+    }
+
+    auto journal = SessionJournal::Create(fname);
+    auto records = journal->Replay();
+    ASSERT_EQ(records.size(), 2);
+    ASSERT_EQ(journal->GetSkippedLines(), 0);
+    ASSERT_EQ(records.count("/net/openvpn/v3/sessions/s1"), 0);
+    ASSERT_EQ(records["/net/openvpn/v3/sessions/s2"].acl, std::vector<uid_t>{2000});
+    ASSERT_EQ(records["/net/openvpn/v3/sessions/s3"].backend_pid, 300);
+
+    // The journal is compacted on replay; a second replay
+    // must give the same result
+    auto records2 = SessionJournal::Create(fname)->Replay();
+    ASSERT_EQ(records2.size(), 2);
+    std::remove(fname.c_str());
+}
+
+
+TEST(SessionManagerJournal, replay_torn_write)
+{
+    const std::string fname = journal_filename("torn");
+    std::remove(fname.c_str());
+
+    {
+        auto journal = SessionJournal::Create(fname);
+        (void)journal->Replay();
+        journal->Created(create_record("s1", 100));
+    }
+
+    // Simulate a crash in the middle of writing a record
+    {
+        std::ofstream f(fname, std::ios_base::app);
+        f << "{\"op\":\"created\",\"session\":{\"session_pa";
+    }
+
+    auto journal = SessionJournal::Create(fname);
+    auto records = journal->Replay();
+    ASSERT_EQ(records.size(), 1);
+    ASSERT_EQ(journal->GetSkippedLines(), 1);
+
+    // New records must still be appended properly after compaction
+    journal->Created(create_record("s2", 200));
+    ASSERT_EQ(SessionJournal::Create(fname)->Replay().size(), 2);
+    std::remove(fname.c_str());
+}
+
+} // namespace unittest
@@ -0,0 +1,100 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   timeline.cpp
+ *
+ * @brief  Unit tests for ConnectTimeline
+ */
+
+#include <sstream>
+#include <string>
+#include <json/json.h>
+
+#include <gtest/gtest.h>
+
+#include "common/timeline.hpp"
+
+
+namespace unittest {
+
+TEST(ConnectTimeline, phases)
+{
+    auto tl = ConnectTimeline::Create("client");
+    tl->Record("registration", 100, 250);
+    tl->Begin("connect");
+    tl->Begin("core.resolve");
+    tl->End("core.resolve");
+    tl->End("unknown");
+
+    auto phases = tl->GetPhases();
+    ASSERT_EQ(phases.size(), 3);
+    EXPECT_EQ(phases[0].name, "registration");
+    EXPECT_EQ(phases[0].source, "client");
+    EXPECT_EQ(phases[0].end_usec - phases[0].start_usec, 150);
+    EXPECT_EQ(phases[1].name, "connect");
+    EXPECT_EQ(phases[1].end_usec, 0);
+    EXPECT_EQ(phases[2].name, "core.resolve");
+    EXPECT_GE(phases[2].end_usec, phases[2].start_usec);
+
+    tl->End("connect");
+    EXPECT_GT(tl->GetPhases()[1].end_usec, 0);
+
+    tl->Clear();
+    EXPECT_TRUE(tl->GetPhases().empty());
+}
+
+
+TEST(ConnectTimeline, import)
+{
+    auto netcfg = ConnectTimeline::Create("netcfg");
+    netcfg->Record("netcfg.tun_setup", 2000, 2500);
+
+    auto client = ConnectTimeline::Create("client");
+    client->Record("netcfg.establish", 1900, 2600);
+    GVariant *data = netcfg->GetGVariant();
+    client->Import(data);
+    g_variant_unref(data);
+
+    auto phases = client->GetPhases();
+    ASSERT_EQ(phases.size(), 2);
+    EXPECT_EQ(phases[1].name, "netcfg.tun_setup");
+    EXPECT_EQ(phases[1].source, "netcfg");
+    EXPECT_EQ(phases[1].start_usec, 2000);
+    EXPECT_EQ(phases[1].end_usec, 2500);
+
+    EXPECT_TRUE(ConnectTimeline::Parse(nullptr).empty());
+}
+
+
+TEST(ConnectTimeline, chrome_trace)
+{
+    ConnectTimeline::PhaseList phases{{"new_tunnel", "sessionmgr", 1000, 1200},
+                                      {"connect", "client", 1500, 4000},
+                                      {"core.tls_auth", "client", 2000, 0}};
+    std::string json = ConnectTimeline::ChromeTrace(phases, "/net/openvpn/v3/sessions/abc");
+
+    Json::Value trace;
+    std::istringstream(json) >> trace;
+    EXPECT_EQ(trace["otherData"]["trace_id"].asString(), "/net/openvpn/v3/sessions/abc");
+
+    const Json::Value &ev = trace["traceEvents"];
+    ASSERT_EQ(ev.size(), 5);
+    EXPECT_EQ(ev[0]["ph"].asString(), "M");
+    EXPECT_EQ(ev[0]["args"]["name"].asString(), "sessionmgr");
+    EXPECT_EQ(ev[1]["name"].asString(), "new_tunnel");
+    EXPECT_EQ(ev[1]["ph"].asString(), "X");
+    EXPECT_EQ(ev[1]["ts"].asUInt64(), 0);
+    EXPECT_EQ(ev[1]["dur"].asUInt64(), 200);
+    EXPECT_EQ(ev[2]["args"]["name"].asString(), "client");
+    EXPECT_EQ(ev[3]["pid"].asUInt(), 2);
+    EXPECT_EQ(ev[3]["ts"].asUInt64(), 500);
+    EXPECT_EQ(ev[4]["ph"].asString(), "i");
+}
+
+} // namespace unittest
@@ -0,0 +1,113 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  SPDX-License-Identifier: AGPL-3.0-only
+//
+//  Copyright (C)  OpenVPN Inc <sales@openvpn.net>
+//  Copyright (C)  David Sommerseth <davids@openvpn.net>
+//
+
+/**
+ * @file   worker-pool.cpp
+ *
+ * @brief  Unit tests for the WorkerPool
+ */
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "common/worker-pool.hpp"
+
+
+namespace unittest {
+
+TEST(WorkerPool, execute_tasks)
+{
+    auto pool = WorkerPool::Create(4);
+
+    std::atomic<int> counter{0};
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 100; ++i)
+    {
+        results.push_back(pool->Submit([&counter]()
+                                       {
+                                           ++counter;
+                                       }));
+        // Keep the queue below its limit
+        if (results.size() % 32 == 0)
+        {
+            for (auto &r : results)
+            {
+                r.wait();
+            }
+        }
+    }
+    for (auto &r : results)
+    {
+        r.get();
+    }
+    ASSERT_EQ(counter.load(), 100);
+
+    pool->RunLimited([&counter]()
+                     {
+                         ++counter;
+                     });
+    ASSERT_EQ(counter.load(), 101);
+
+    auto stats = pool->GetStatistics();
+    ASSERT_EQ(stats.threads, 4);
+    ASSERT_EQ(stats.queue_depth, 0);
+    ASSERT_EQ(stats.rejected, 0);
+    ASSERT_GE(stats.queue_depth_max, 1);
+}
+
+
+TEST(WorkerPool, run_limited_exception)
+{
+    auto pool = WorkerPool::Create(1);
+    ASSERT_THROW(pool->RunLimited([]()
+                                  {
+                                      throw std::runtime_error("task failed");
+                                  }),
+                 std::runtime_error);
+
+    auto res = pool->Submit([]()
+                            {
+                                throw std::runtime_error("task failed");
+                            });
+    ASSERT_THROW(res.get(), std::runtime_error);
+}
+
+
+TEST(WorkerPool, queue_full)
+{
+    auto pool = WorkerPool::Create(1, 1);
+
+    std::promise<void> started;
+    std::promise<void> release;
+    auto release_fut = release.get_future().share();
+
+    // Occupy the only worker thread
+    auto busy = pool->Submit([&started, release_fut]()
+                             {
+                                 started.set_value();
+                                 release_fut.wait();
+                             });
+    started.get_future().wait();
+
+    // Fills up the queue
+    auto queued = pool->Submit([]() {});
+
+    ASSERT_THROW(pool->Submit([]() {}), WorkerPoolException);
+    ASSERT_EQ(pool->GetStatistics().rejected, 1);
+    ASSERT_EQ(pool->GetStatistics().queue_depth, 1);
+
+    release.set_value();
+    busy.get();
+    queued.get();
+    ASSERT_EQ(pool->GetStatistics().queue_depth, 0);
+}
+
+} // namespace unittest